@@ -19,6 +19,12 @@
 #include "headers/utils.h"
 #include "headers/game_timer.h"
 #include "headers/dds_loader.h"
+#include "headers/mesh_loader.h"
+#include "headers/vertex_compression.h"
+#include "headers/meshlet.h"
+#include "headers/asset_loader.h"
+#include "headers/render_item_culling.h"
+#include "headers/screen_coverage.h"
 
 #include <imgui/imgui.h>
 #include <imgui/imgui_impl_win32.h>
@@ -44,6 +50,16 @@
 #define ENABLE_DEBUG_LAYER 0
 #endif
 
+// Times TextMesh_LoadSerial vs TextMesh_Load at startup (results go to the debug output)
+#define ENABLE_MESH_PARSE_BENCHMARK 0
+
+// Load textures, meshes and shaders on worker threads at startup (0 runs the same task graph serially)
+#define ENABLE_PARALLEL_STARTUP 1
+
+// Per-mesh vertex layout: VERTEX_ENCODING_FLOAT32 (Vertex, 44 bytes) or VERTEX_ENCODING_QUANTIZED (PackedVertex, 20 bytes)
+#define SKULL_VERTEX_ENCODING   VERTEX_ENCODING_QUANTIZED
+#define GRID_VERTEX_ENCODING    VERTEX_ENCODING_QUANTIZED
+
 #define NUM_BACKBUFFERS         2
 #define NUM_QUEUING_FRAMES      3
 
@@ -63,6 +79,11 @@ enum RENDER_LAYER : int {
     LAYER_SSAO,
     LAYER_SSAO_BLUR,
 
+    // variants of the passes drawing opaque_ritems for meshes with quantized vertices
+    LAYER_OPAQUE_QUANTIZED,
+    LAYER_SHADOW_OPAQUE_QUANTIZED,
+    LAYER_DRAW_NORMALS_QUANTIZED,
+
     _COUNT_RENDERCOMPUTE_LAYER
 };
 enum ALL_RENDERITEMS {
@@ -117,22 +138,32 @@ enum SHADERS_CODE {
     SHADER_SSAO_PS,
     SHADER_SSAO_BLUR_VS,
     SHADER_SSAO_BLUR_PS,
+    SHADER_STANDARD_QUANTIZED_VS,
+    SHADER_SHADOW_QUANTIZED_VS,
+    SHADER_DRAW_NORMALS_QUANTIZED_VS,
 
     _COUNT_SHADERS
 };
 enum GEOM_INDEX {
     GEOM_SKULL = 0,
     GEOM_SHAPES = 1,
+    GEOM_GRID = 2,
 
     _COUNT_GEOM
 };
 enum SUBMESH_INDEX {
     _BOX_ID,
-    _GRID_ID,
     _SPHERE_ID,
     _CYLINDER_ID,
     _QUAD_ID
 };
+// Views meshlets are culled against every frame
+enum MESHLET_VIEW {
+    MESHLET_VIEW_CAMERA = 0,    // main and normal/depth passes
+    MESHLET_VIEW_LIGHT = 1,     // shadow pass
+
+    _COUNT_MESHLET_VIEW
+};
 enum MAT_INDEX {
     MAT_BRICK = 0,
     MAT_TILE = 1,
@@ -208,6 +239,20 @@ bool g_resizing;
 bool g_mouse_active;
 SceneContext g_scene_ctx;
 
+// per frame culling of opaque_ritems for the camera and as shadow casters (see headers/render_item_culling.h)
+struct RenderItemCulling {
+    RenderItemBounds    bounds;
+    bool                camera_visible [_COUNT_RENDERITEM];     // indexed like opaque_ritems
+    bool                caster_visible [_COUNT_RENDERITEM];
+    UINT                camera_visible_count;
+    UINT                caster_visible_count;
+};
+bool g_ritem_culling_enabled = true;
+bool g_coverage_culling_enabled = true;        // drop items too small on screen, and casters too small to cast a visible shadow
+float g_coverage_min_pixels = COVERAGE_MIN_PIXELS;
+float g_shadow_min_pixels = COVERAGE_SHADOW_MIN_PIXELS;
+RenderItemCulling g_ritem_culling;
+
 //
 // global ui params
 bool g_ssao_enabled = true;
@@ -216,11 +261,26 @@ float g_accessiblity_power = 4.0f;
 float g_occlusion_addend = 0.1f;
 bool g_show_smap_debug = false;
 bool g_show_ssao_debug = false;
+bool g_meshlet_culling_enabled = true;
+
+//
+// startup timings (QueryPerformanceCounter ticks / milliseconds)
+int64_t g_startup_begin;
+double g_startup_assets_ms;
+double g_time_to_first_frame_ms;
 
 struct RenderItemArray {
     RenderItem  ritems[_COUNT_RENDERITEM];
     uint32_t    size;
 };
+// Result of culling the meshlets for one view: render items whose submesh has meshlets
+// draw index_count indices from start_index in the current frame's meshlet_ib
+struct MeshletDrawList {
+    D3D12_INDEX_BUFFER_VIEW ibv;
+    UINT                    start_index [_COUNT_RENDERITEM];   // indexed by obj_cbuffer_index
+    UINT                    index_count [_COUNT_RENDERITEM];
+    MeshletCullStats        stats;
+};
 struct D3DRenderContext {
 
     bool msaa4x_state;
@@ -283,6 +343,9 @@ struct D3DRenderContext {
 
     MeshGeometry                    geom[_COUNT_GEOM];
 
+    MeshletDrawList                 meshlet_draws[_COUNT_MESHLET_VIEW];
+    UINT                            meshlet_ib_capacity;    // in indices
+
     // Synchronization stuff
     UINT                            frame_index;
     HANDLE                          fence_event;
@@ -300,22 +363,25 @@ struct D3DRenderContext {
     Texture                         textures[_COUNT_TEX];
     IDxcBlob *                      shaders[_COUNT_SHADERS];
 };
+// A texture read by a startup task, waiting for its upload to be recorded
+struct TextureLoad {
+    ID3D12Device *              device;
+    Texture *                   texture;
+
+    uint8_t *                   dds_data;
+    D3D12_SUBRESOURCE_DATA *    subresources;
+    UINT                        n_subresources;
+};
+// Reads the dds file and creates the texture and its upload heap (no command recording, so any thread)
 static void
-load_texture (
-    ID3D12Device * device,
-    ID3D12GraphicsCommandList * cmd_list,
-    wchar_t const * tex_path,
-    Texture * out_texture
-) {
+read_texture (TextureLoad * load) {
+    Texture * out_texture = load->texture;
+    load->n_subresources = 0;
 
-    uint8_t * ddsData;
-    D3D12_SUBRESOURCE_DATA * subresources;
-    UINT n_subresources = 0;
-
-    LoadDDSTextureFromFile(device, tex_path, &out_texture->resource, &ddsData, &subresources, &n_subresources);
+    LoadDDSTextureFromFile(load->device, out_texture->filename, &out_texture->resource, &load->dds_data, &load->subresources, &load->n_subresources);
 
     UINT64 upload_buffer_size = get_required_intermediate_size(out_texture->resource, 0,
-        n_subresources);
+        load->n_subresources);
 
 // Create the GPU upload buffer.
     D3D12_HEAP_PROPERTIES heap_props = {};
@@ -339,7 +405,7 @@ load_texture (
     desc.Layout = D3D12_TEXTURE_LAYOUT_ROW_MAJOR;
     desc.Flags = D3D12_RESOURCE_FLAG_NONE;
 
-    device->CreateCommittedResource(
+    load->device->CreateCommittedResource(
         &heap_props,
         D3D12_HEAP_FLAG_NONE,
         &desc,
@@ -347,11 +413,16 @@ load_texture (
         nullptr,
         IID_PPV_ARGS(&out_texture->upload_heap)
     );
+}
+// Records the copy of a texture read by read_texture to its resource
+static void
+upload_texture (ID3D12GraphicsCommandList * cmd_list, TextureLoad * load) {
+    Texture * out_texture = load->texture;
 
     // Use Heap-allocating UpdateSubresources implementation for variable number of subresources (which is the case for textures).
     update_subresources_heap(
         cmd_list, out_texture->resource, out_texture->upload_heap,
-        0, 0, n_subresources, subresources
+        0, 0, load->n_subresources, load->subresources
     );
 
     resource_usage_transition(
@@ -360,8 +431,8 @@ load_texture (
         D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE
     );
 
-    ::free(subresources);
-    ::free(ddsData);
+    ::free(load->subresources);
+    ::free(load->dds_data);
 }
 static void
 create_materials (Material out_materials []) {
@@ -414,57 +485,85 @@ create_materials (Material out_materials []) {
     out_materials[MAT_SKY].mat_transform = Identity4x4();
     out_materials[MAT_SKY].n_frames_dirty = NUM_QUEUING_FRAMES;
 }
-static void
-create_skull_geometry (D3DRenderContext * render_ctx) {
-#pragma region Read_Data_File
+#if ENABLE_MESH_PARSE_BENCHMARK > 0
+// Writes a (side x side) quad grid in the VertexCount:/TriangleCount: text format
+static bool
+write_synthetic_text_mesh (char const * path, UINT n_triangles) {
+    UINT side = (UINT)sqrtf(0.5f * n_triangles);
+    UINT vcount = (side + 1) * (side + 1);
+    UINT tcount = 2 * side * side;
+
     FILE * f = nullptr;
-    errno_t err = fopen_s(&f, "./models/skull.txt", "r");
-    if (0 == f || err != 0) {
-        MessageBox(0, _T("Could not open file"), 0, 0);
-        return;
+    errno_t err = fopen_s(&f, path, "w");
+    if (0 == f || err != 0)
+        return false;
+    fprintf(f, "VertexCount: %u\nTriangleCount: %u\nVertexList (pos, normal)\n{\n", vcount, tcount);
+    for (UINT i = 0; i <= side; ++i)
+        for (UINT j = 0; j <= side; ++j)
+            fprintf(f, "\t%g %g %g 0 1 0\n", j * 0.01f, sinf(i * 0.05f) * cosf(j * 0.05f), i * 0.01f);
+    fprintf(f, "}\nTriangleList\n{\n");
+    for (UINT i = 0; i < side; ++i) {
+        for (UINT j = 0; j < side; ++j) {
+            UINT v0 = i * (side + 1) + j;
+            UINT v1 = v0 + side + 1;
+            fprintf(f, "\t%u %u %u\n\t%u %u %u\n", v0, v1, v0 + 1, v0 + 1, v1, v1 + 1);
+        }
     }
-    char linebuf[100];
-    int cnt = 0;
-    unsigned vcount = 0;
-    unsigned tcount = 0;
-    // -- read 1st line
-    if (fgets(linebuf, sizeof(linebuf), f))
-        cnt = sscanf_s(linebuf, "%*s %d", &vcount);
-    if (cnt != 1) {
-        MessageBox(0, _T("Read error"), 0, 0);
-        return;
+    fprintf(f, "}\n");
+    fclose(f);
+    return true;
+}
+// Best-of-n wall time in milliseconds
+static float
+time_text_mesh_load (bool (*load_fn) (char const *, TextMesh *), char const * path, int n_runs, bool * out_ok) {
+    LARGE_INTEGER freq;
+    QueryPerformanceFrequency(&freq);
+    float best = FLT_MAX;
+    *out_ok = true;
+    for (int i = 0; i < n_runs; ++i) {
+        TextMesh mesh = {};
+        LARGE_INTEGER t0, t1;
+        QueryPerformanceCounter(&t0);
+        *out_ok &= load_fn(path, &mesh);
+        QueryPerformanceCounter(&t1);
+        TextMesh_Free(&mesh);
+        float ms = 1000.0f * (float)(t1.QuadPart - t0.QuadPart) / (float)freq.QuadPart;
+        best = ms < best ? ms : best;
     }
-    // -- read 2nd line
-    if (fgets(linebuf, sizeof(linebuf), f))
-        cnt = sscanf_s(linebuf, "%*s %d", &tcount);
-    if (cnt != 1) {
-        MessageBox(0, _T("Read error"), 0, 0);
-        return;
+    return best;
+}
+static void
+benchmark_mesh_parsers () {
+    char const * synthetic_path = "./models/synthetic_10m.txt";
+    if (INVALID_FILE_ATTRIBUTES == GetFileAttributesA(synthetic_path))
+        write_synthetic_text_mesh(synthetic_path, 10000000);
+
+    struct {
+        char const * path;
+        int n_runs;
+    } files [] = {
+        {"./models/skull.txt", 10},
+        {synthetic_path, 2},
+    };
+    for (int i = 0; i < _countof(files); ++i) {
+        bool serial_ok, parallel_ok;
+        float serial_ms = time_text_mesh_load(TextMesh_LoadSerial, files[i].path, files[i].n_runs, &serial_ok);
+        float parallel_ms = time_text_mesh_load(TextMesh_Load, files[i].path, files[i].n_runs, &parallel_ok);
+        DBG_PRINT(_T("[mesh parse] %hs: fgets/sscanf_s %.2f ms (%hs), parallel %.2f ms (%hs), speedup %.1fx\n"),
+                  files[i].path, serial_ms, serial_ok ? "ok" : "failed", parallel_ms, parallel_ok ? "ok" : "failed",
+                  serial_ms / parallel_ms);
     }
-    // -- skip two lines
-    fgets(linebuf, sizeof(linebuf), f);
-    fgets(linebuf, sizeof(linebuf), f);
-
-    // -- vmin and vmax for AABB construction
-    XMFLOAT3 vminf3(+FLT_MAX, +FLT_MAX, +FLT_MAX);
-    XMFLOAT3 vmaxf3(-FLT_MAX, -FLT_MAX, -FLT_MAX);
-
-    XMVECTOR vmin = XMLoadFloat3(&vminf3);
-    XMVECTOR vmax = XMLoadFloat3(&vmaxf3);
-
-    // -- read vertices
-    Vertex * vertices = (Vertex *)calloc(vcount, sizeof(Vertex));
-    for (unsigned i = 0; i < vcount; i++) {
-        fgets(linebuf, sizeof(linebuf), f);
-        cnt = sscanf_s(
-            linebuf, "%f %f %f %f %f %f",
-            &vertices[i].position.x, &vertices[i].position.y, &vertices[i].position.z,
-            &vertices[i].normal.x, &vertices[i].normal.y, &vertices[i].normal.z
-        );
+}
+#endif // ENABLE_MESH_PARSE_BENCHMARK > 0
+static void
+build_skull_vertices (TextMesh const * src, void * out_vertices) {
+    Vertex * vertices = (Vertex *)out_vertices;
+    for (UINT i = 0; i < src->vertex_count; i++) {
+        vertices[i].position = src->positions[i];
+        vertices[i].normal = src->normals[i];
 
         // generating tangent vector
         vertices[i].texc = {0.0f, 0.0f};
-        XMVECTOR P = XMLoadFloat3(&vertices[i].position);
         XMVECTOR N = XMLoadFloat3(&vertices[i].normal);
         // NOTE(omid): We aren't applying a texture map to the skull,
         // so we just need any tangent vector
@@ -479,11 +578,6 @@ create_skull_geometry (D3DRenderContext * render_ctx) {
             XMStoreFloat3(&vertices[i].tangent_u, T);
         }
 
-        if (cnt != 6) {
-            MessageBox(0, _T("Read error"), 0, 0);
-            return;
-        }
-
 #pragma region skull texture coordinates calculations (Legacy Code)
         // Project point onto unit sphere and generate spherical texture coordinates.
         /*XMVECTOR P = XMLoadFloat3(&vertices[i].position);
@@ -503,73 +597,56 @@ create_skull_geometry (D3DRenderContext * render_ctx) {
 
         vertices[i].texc = {u, v};*/
 #pragma endregion
-
-        // -- calculate vmin, vmax
-        vmin = XMVectorMin(vmin, P);
-        vmax = XMVectorMax(vmax, P);
-    }
-
-    // -- construct bounding box (AABB)
-    BoundingBox bounds;
-    XMStoreFloat3(&bounds.Center, 0.5f * (vmin + vmax));
-    XMStoreFloat3(&bounds.Extents, 0.5f * (vmax - vmin));
-
-    // -- skip three lines
-    fgets(linebuf, sizeof(linebuf), f);
-    fgets(linebuf, sizeof(linebuf), f);
-    fgets(linebuf, sizeof(linebuf), f);
-    // -- read indices
-    uint32_t * indices = (uint32_t *)calloc(static_cast<size_t>(tcount) * 3, sizeof(uint32_t));
-    for (unsigned i = 0; i < tcount; i++) {
-        fgets(linebuf, sizeof(linebuf), f);
-        cnt = sscanf_s(
-            linebuf, "%d %d %d",
-            &indices[i * 3 + 0], &indices[i * 3 + 1], &indices[i * 3 + 2]
-        );
-        if (cnt != 3) {
-            MessageBox(0, _T("Read error"), 0, 0);
-            return;
-        }
     }
+}
+// Fills vb_cpu in the requested [encoding] (see upload_geometry for the GPU copy).
+// [bounds] must contain every vertex (quantized positions are relative to it).
+static void
+create_vertex_buffer (
+    D3DRenderContext * render_ctx, MeshGeometry * geom,
+    Vertex const * vertices, UINT vertex_count, BoundingBox const & bounds,
+    VERTEX_ENCODING encoding, char const * name
+) {
+    UINT stride = (VERTEX_ENCODING_QUANTIZED == encoding) ? sizeof(PackedVertex) : sizeof(Vertex);
+    UINT vb_byte_size = vertex_count * stride;
 
-    // -- remember to free heap-allocated memory
-    /*
-    free(vertices);
-    free(indices);
-    */
-    fclose(f);
-#pragma endregion   Read_Data_File
-
-    UINT vb_byte_size = vcount * sizeof(Vertex);
-    UINT ib_byte_size = (tcount * 3) * sizeof(uint32_t);
+    D3DCreateBlob(vb_byte_size, &geom->vb_cpu);
+    if (VERTEX_ENCODING_QUANTIZED == encoding)
+        pack_vertices(vertices, vertex_count, bounds, (PackedVertex *)geom->vb_cpu->GetBufferPointer());
+    else
+        CopyMemory(geom->vb_cpu->GetBufferPointer(), vertices, vb_byte_size);
 
-    // -- Fill out render_ctx geom[GEOM_SKULL] (skull)
-    D3DCreateBlob(vb_byte_size, &render_ctx->geom[GEOM_SKULL].vb_cpu);
-    CopyMemory(render_ctx->geom[GEOM_SKULL].vb_cpu->GetBufferPointer(), vertices, vb_byte_size);
+    geom->vb_byte_stide = stride;
+    geom->vb_byte_size = vb_byte_size;
+    geom->vertex_encoding = encoding;
 
-    D3DCreateBlob(ib_byte_size, &render_ctx->geom[GEOM_SKULL].ib_cpu);
-    CopyMemory(render_ctx->geom[GEOM_SKULL].ib_cpu->GetBufferPointer(), indices, ib_byte_size);
+    DBG_PRINT(_T("[vertex] %hs: %u vertices, %u -> %u bytes\n"), name, vertex_count, vertex_count * (UINT)sizeof(Vertex), vb_byte_size);
+}
+// Returns false if the skull mesh could not be loaded (runs as an asset task, so no UI here)
+static bool
+create_skull_geometry (D3DRenderContext * render_ctx) {
 
-    create_default_buffer(render_ctx->device, render_ctx->direct_cmd_list, vertices, vb_byte_size, &render_ctx->geom[GEOM_SKULL].vb_uploader, &render_ctx->geom[GEOM_SKULL].vb_gpu);
-    create_default_buffer(render_ctx->device, render_ctx->direct_cmd_list, indices, ib_byte_size, &render_ctx->geom[GEOM_SKULL].ib_uploader, &render_ctx->geom[GEOM_SKULL].ib_gpu);
+    // -- map the binary mesh (created from the text file on first load)
+    MeshCacheView mesh = {};
+    if (!load_mesh_cached("./models/skull.mesh", "./models/skull.txt", sizeof(Vertex), build_skull_vertices, &mesh))
+        return false;
 
-    render_ctx->geom[GEOM_SKULL].vb_byte_stide = sizeof(Vertex);
-    render_ctx->geom[GEOM_SKULL].vb_byte_size = vb_byte_size;
-    render_ctx->geom[GEOM_SKULL].ib_byte_size = ib_byte_size;
-    render_ctx->geom[GEOM_SKULL].index_format = DXGI_FORMAT_R32_UINT;
+    // -- Fill out render_ctx geom[GEOM_SKULL] (skull)
+    create_vertex_buffer(render_ctx, &render_ctx->geom[GEOM_SKULL], (Vertex const *)mesh.vertices, mesh.vertex_count, mesh.bounds, SKULL_VERTEX_ENCODING, "skull");
 
-    SubmeshGeometry submesh = {};
-    submesh.index_count = tcount * 3;
-    submesh.start_index_location = 0;
-    submesh.base_vertex_location = 0;
-    submesh.bounds = bounds;
+    // narrowest index format that still draws the skull as a single submesh
+    Mesh_CreateIndexBuffer(&render_ctx->geom[GEOM_SKULL], mesh.indices, mesh.index_count, mesh.vertices, sizeof(Vertex), 1, "skull");
 
+    // quantized positions decode with the bounds they were packed against
+    render_ctx->geom[GEOM_SKULL].submesh_geoms[0].bounds = mesh.bounds;
     render_ctx->geom[GEOM_SKULL].submesh_names[0] = "skull";
-    render_ctx->geom[GEOM_SKULL].submesh_geoms[0] = submesh;
+
+    // reorders ib_cpu, so upload the indices afterwards
+    Mesh_BuildMeshlets(&render_ctx->geom[GEOM_SKULL], 0, mesh.vertices, sizeof(Vertex), mesh.vertex_count, "skull");
 
     // -- cleanup
-    free(vertices);
-    free(indices);
+    MeshCache_Release(&mesh);
+    return true;
 }
 #define _BOX_VTX_CNT   24
 #define _BOX_IDX_CNT   36
@@ -586,9 +663,50 @@ create_skull_geometry (D3DRenderContext * render_ctx) {
 #define _QUAD_VTX_CNT   4
 #define _QUAD_IDX_CNT   6
 
-#define _TOTAL_VTX_CNT  (_BOX_VTX_CNT + _GRID_VTX_CNT + _SPHERE_VTX_CNT + _CYLINDER_VTX_CNT + _QUAD_VTX_CNT)
-#define _TOTAL_IDX_CNT  (_BOX_IDX_CNT + _GRID_IDX_CNT + _SPHERE_IDX_CNT + _CYLINDER_IDX_CNT + _QUAD_IDX_CNT)
+#define _TOTAL_VTX_CNT  (_BOX_VTX_CNT + _SPHERE_VTX_CNT + _CYLINDER_VTX_CNT + _QUAD_VTX_CNT)
+#define _TOTAL_IDX_CNT  (_BOX_IDX_CNT + _SPHERE_IDX_CNT + _CYLINDER_IDX_CNT + _QUAD_IDX_CNT)
 
+static void
+create_grid_geometry (D3DRenderContext * render_ctx) {
+    GeomVertex *    grid_vertices = (GeomVertex *)::malloc(sizeof(GeomVertex) * _GRID_VTX_CNT);
+    uint16_t *      indices = (uint16_t *)::malloc(sizeof(uint16_t) * _GRID_IDX_CNT);
+    Vertex *        vertices = (Vertex *)::malloc(sizeof(Vertex) * _GRID_VTX_CNT);
+
+    create_grid16(20.0f, 30.0f, 60, 40, grid_vertices, indices);
+    for (size_t i = 0; i < _GRID_VTX_CNT; ++i) {
+        vertices[i].position = grid_vertices[i].Position;
+        vertices[i].normal = grid_vertices[i].Normal;
+        vertices[i].texc = grid_vertices[i].TexC;
+        vertices[i].tangent_u = grid_vertices[i].TangentU;
+    }
+    // reorder before the vertices are (possibly) quantized
+    optimize_overdraw_and_fetch("grid", vertices, sizeof(Vertex), _GRID_VTX_CNT, indices, _GRID_IDX_CNT);
+
+    SubmeshGeometry grid_submesh = {};
+    grid_submesh.index_count = _GRID_IDX_CNT;
+    grid_submesh.start_index_location = 0;
+    grid_submesh.base_vertex_location = 0;
+    BoundingBox::CreateFromPoints(grid_submesh.bounds, _GRID_VTX_CNT, &vertices[0].position, sizeof(Vertex));
+
+    UINT ib_byte_size = _GRID_IDX_CNT * sizeof(uint16_t);
+
+    // -- Fill out render_ctx geom[GEOM_GRID] (grid)
+    create_vertex_buffer(render_ctx, &render_ctx->geom[GEOM_GRID], vertices, _GRID_VTX_CNT, grid_submesh.bounds, GRID_VERTEX_ENCODING, "grid");
+
+    D3DCreateBlob(ib_byte_size, &render_ctx->geom[GEOM_GRID].ib_cpu);
+    CopyMemory(render_ctx->geom[GEOM_GRID].ib_cpu->GetBufferPointer(), indices, ib_byte_size);
+
+    render_ctx->geom[GEOM_GRID].ib_byte_size = ib_byte_size;
+    render_ctx->geom[GEOM_GRID].index_format = DXGI_FORMAT_R16_UINT;
+
+    render_ctx->geom[GEOM_GRID].submesh_names[0] = "grid";
+    render_ctx->geom[GEOM_GRID].submesh_geoms[0] = grid_submesh;
+
+    // -- cleanup
+    free(vertices);
+    free(indices);
+    free(grid_vertices);
+}
 static void
 create_shapes_geometry (D3DRenderContext * render_ctx) {
 
@@ -599,11 +717,8 @@ create_shapes_geometry (D3DRenderContext * render_ctx) {
     // box
     UINT bsz = sizeof(GeomVertex) * _BOX_VTX_CNT;
     UINT bsz_id = bsz + sizeof(uint16_t) * _BOX_IDX_CNT;
-    // grid
-    UINT gsz = bsz_id + sizeof(GeomVertex) * _GRID_VTX_CNT;
-    UINT gsz_id = gsz + sizeof(uint16_t) * _GRID_IDX_CNT;
     // sphere
-    UINT ssz = gsz_id + sizeof(GeomVertex) * _SPHERE_VTX_CNT;
+    UINT ssz = bsz_id + sizeof(GeomVertex) * _SPHERE_VTX_CNT;
     UINT ssz_id = ssz + sizeof(uint16_t) * _SPHERE_IDX_CNT;
     // cylinder
     UINT csz = ssz_id + sizeof(GeomVertex) * _CYLINDER_VTX_CNT;
@@ -611,15 +726,12 @@ create_shapes_geometry (D3DRenderContext * render_ctx) {
 
     GeomVertex *    box_vertices = reinterpret_cast<GeomVertex *>(scratch);
     uint16_t *      box_indices = reinterpret_cast<uint16_t *>(scratch + bsz);
-    GeomVertex *    grid_vertices = reinterpret_cast<GeomVertex *>(scratch + bsz_id);
-    uint16_t *      grid_indices = reinterpret_cast<uint16_t *>(scratch + gsz);
-    GeomVertex *    sphere_vertices = reinterpret_cast<GeomVertex *>(scratch + gsz_id);
+    GeomVertex *    sphere_vertices = reinterpret_cast<GeomVertex *>(scratch + bsz_id);
     uint16_t *      sphere_indices = reinterpret_cast<uint16_t *>(scratch + ssz);
     GeomVertex *    cylinder_vertices = reinterpret_cast<GeomVertex *>(scratch + ssz_id);
     uint16_t *      cylinder_indices = reinterpret_cast<uint16_t *>(scratch + csz);
 
     create_box(1.0f, 1.0f, 1.0f, box_vertices, box_indices);
-    create_grid16(20.0f, 30.0f, 60, 40, grid_vertices, grid_indices);
     create_sphere(0.5f, sphere_vertices, sphere_indices);
     create_cylinder(0.5f, 0.3f, 3.0f, cylinder_vertices, cylinder_indices);
 
@@ -632,15 +744,13 @@ create_shapes_geometry (D3DRenderContext * render_ctx) {
 
     // Cache the vertex offsets to each object in the concatenated vertex buffer.
     UINT box_vertex_offset = 0;
-    UINT grid_vertex_offset = _BOX_VTX_CNT;
-    UINT sphere_vertex_offset = grid_vertex_offset + _GRID_VTX_CNT;
+    UINT sphere_vertex_offset = _BOX_VTX_CNT;
     UINT cylinder_vertex_offset = sphere_vertex_offset + _SPHERE_VTX_CNT;
     UINT quad_vertex_offset = cylinder_vertex_offset + _CYLINDER_VTX_CNT;
 
     // Cache the starting index for each object in the concatenated index buffer.
     UINT box_index_offset = 0;
-    UINT grid_index_offset = _BOX_IDX_CNT;
-    UINT sphere_index_offset = grid_index_offset + _GRID_IDX_CNT;
+    UINT sphere_index_offset = _BOX_IDX_CNT;
     UINT cylinder_index_offsett = sphere_index_offset + _SPHERE_IDX_CNT;
     UINT quad_index_offset = cylinder_index_offsett + _CYLINDER_IDX_CNT;
 
@@ -651,11 +761,6 @@ create_shapes_geometry (D3DRenderContext * render_ctx) {
     box_submesh.start_index_location = box_index_offset;
     box_submesh.base_vertex_location = box_vertex_offset;
 
-    SubmeshGeometry grid_submesh = {};
-    grid_submesh.index_count = _GRID_IDX_CNT;
-    grid_submesh.start_index_location = grid_index_offset;
-    grid_submesh.base_vertex_location = grid_vertex_offset;
-
     SubmeshGeometry sphere_submesh = {};
     sphere_submesh.index_count = _SPHERE_IDX_CNT;
     sphere_submesh.start_index_location = sphere_index_offset;
@@ -671,6 +776,12 @@ create_shapes_geometry (D3DRenderContext * render_ctx) {
     quad_submesh.start_index_location = quad_index_offset;
     quad_submesh.base_vertex_location = quad_vertex_offset;
 
+    // local bounds of the shapes (for culling their render items)
+    BoundingBox::CreateFromPoints(box_submesh.bounds, _BOX_VTX_CNT, &box_vertices[0].Position, sizeof(GeomVertex));
+    BoundingBox::CreateFromPoints(sphere_submesh.bounds, _SPHERE_VTX_CNT, &sphere_vertices[0].Position, sizeof(GeomVertex));
+    BoundingBox::CreateFromPoints(cylinder_submesh.bounds, _CYLINDER_VTX_CNT, &cylinder_vertices[0].Position, sizeof(GeomVertex));
+    BoundingBox::CreateFromPoints(quad_submesh.bounds, _QUAD_VTX_CNT, &quad_verts[0].Position, sizeof(GeomVertex));
+
     // Extract the vertex elements we are interested in and pack the
     // vertices of all the meshes into one vertex buffer.
 
@@ -681,12 +792,6 @@ create_shapes_geometry (D3DRenderContext * render_ctx) {
         vertices[k].texc = box_vertices[i].TexC;
         vertices[k].tangent_u = box_vertices[i].TangentU;
     }
-    for (size_t i = 0; i < _GRID_VTX_CNT; ++i, ++k) {
-        vertices[k].position = grid_vertices[i].Position;
-        vertices[k].normal = grid_vertices[i].Normal;
-        vertices[k].texc = grid_vertices[i].TexC;
-        vertices[k].tangent_u = grid_vertices[i].TangentU;
-    }
     for (size_t i = 0; i < _SPHERE_VTX_CNT; ++i, ++k) {
         vertices[k].position = sphere_vertices[i].Position;
         vertices[k].normal = sphere_vertices[i].Normal;
@@ -711,8 +816,6 @@ create_shapes_geometry (D3DRenderContext * render_ctx) {
     k = 0;
     for (size_t i = 0; i < _BOX_IDX_CNT; ++i, ++k)
         indices[k] = box_indices[i];
-    for (size_t i = 0; i < _GRID_IDX_CNT; ++i, ++k)
-        indices[k] = grid_indices[i];
     for (size_t i = 0; i < _SPHERE_IDX_CNT; ++i, ++k)
         indices[k] = sphere_indices[i];
     for (size_t i = 0; i < _CYLINDER_IDX_CNT; ++i, ++k)
@@ -732,9 +835,6 @@ create_shapes_geometry (D3DRenderContext * render_ctx) {
     if (indices)
         CopyMemory(render_ctx->geom[GEOM_SHAPES].ib_cpu->GetBufferPointer(), indices, ib_byte_size);
 
-    create_default_buffer(render_ctx->device, render_ctx->direct_cmd_list, vertices, vb_byte_size, &render_ctx->geom[GEOM_SHAPES].vb_uploader, &render_ctx->geom[GEOM_SHAPES].vb_gpu);
-    create_default_buffer(render_ctx->device, render_ctx->direct_cmd_list, indices, ib_byte_size, &render_ctx->geom[GEOM_SHAPES].ib_uploader, &render_ctx->geom[GEOM_SHAPES].ib_gpu);
-
     render_ctx->geom[GEOM_SHAPES].vb_byte_stide = sizeof(Vertex);
     render_ctx->geom[GEOM_SHAPES].vb_byte_size = vb_byte_size;
     render_ctx->geom[GEOM_SHAPES].ib_byte_size = ib_byte_size;
@@ -742,8 +842,6 @@ create_shapes_geometry (D3DRenderContext * render_ctx) {
 
     render_ctx->geom[GEOM_SHAPES].submesh_names[_BOX_ID] = "box";
     render_ctx->geom[GEOM_SHAPES].submesh_geoms[_BOX_ID] = box_submesh;
-    render_ctx->geom[GEOM_SHAPES].submesh_names[_GRID_ID] = "grid";
-    render_ctx->geom[GEOM_SHAPES].submesh_geoms[_GRID_ID] = grid_submesh;
     render_ctx->geom[GEOM_SHAPES].submesh_names[_SPHERE_ID] = "shpere";
     render_ctx->geom[GEOM_SHAPES].submesh_geoms[_SPHERE_ID] = sphere_submesh;
     render_ctx->geom[GEOM_SHAPES].submesh_names[_CYLINDER_ID] = "cylinder";
@@ -751,11 +849,40 @@ create_shapes_geometry (D3DRenderContext * render_ctx) {
     render_ctx->geom[GEOM_SHAPES].submesh_names[_QUAD_ID] = "quad";
     render_ctx->geom[GEOM_SHAPES].submesh_geoms[_QUAD_ID] = quad_submesh;
 
+    // -- reorder every shape for overdraw and vertex fetch (upload_geometry copies the optimized blobs)
+    Mesh_OptimizeCpuBuffers(&render_ctx->geom[GEOM_SHAPES], _QUAD_ID + 1, "shapes");
+
     // -- cleanup
     free(scratch);
     free(indices);
     free(vertices);
 }
+// Records the copies of a geometry's CPU blobs to its default buffers.
+// The upload heaps are sized by the blobs, so they shrink with the vertex encoding and index format.
+static void
+upload_geometry (D3DRenderContext * render_ctx, MeshGeometry * geom) {
+    if (nullptr == geom->vb_cpu || nullptr == geom->ib_cpu)
+        return;     // failed to load
+    create_default_buffer(render_ctx->device, render_ctx->direct_cmd_list, geom->vb_cpu->GetBufferPointer(), geom->vb_byte_size, &geom->vb_uploader, &geom->vb_gpu);
+    create_default_buffer(render_ctx->device, render_ctx->direct_cmd_list, geom->ib_cpu->GetBufferPointer(), geom->ib_byte_size, &geom->ib_uploader, &geom->ib_gpu);
+}
+// Finds the submesh with meshlets each item draws, once, so the draws don't have to search for it
+static void
+render_item_meshlets_from_submeshes (RenderItem * ritems, UINT count) {
+    for (UINT i = 0; i < count; ++i) {
+        ritems[i].meshlet_submesh = nullptr;
+        if (!ritems[i].initialized)
+            continue;
+        for (UINT s = 0; s < MAX_SUBMESH_COUNT; ++s) {
+            SubmeshGeometry const * submesh = &ritems[i].geometry->submesh_geoms[s];
+            if (submesh->meshlet_count > 0 &&
+                submesh->start_index_location == ritems[i].start_index_loc && submesh->index_count == ritems[i].index_count) {
+                ritems[i].meshlet_submesh = submesh;
+                break;
+            }
+        }
+    }
+}
 static void
 create_render_items (D3DRenderContext * render_ctx) {
     // sky
@@ -850,6 +977,7 @@ create_render_items (D3DRenderContext * render_ctx) {
     render_ctx->all_ritems.ritems[RITEM_SKULL].index_count = render_ctx->geom[GEOM_SKULL].submesh_geoms[0].index_count;
     render_ctx->all_ritems.ritems[RITEM_SKULL].start_index_loc = render_ctx->geom[GEOM_SKULL].submesh_geoms[0].start_index_location;
     render_ctx->all_ritems.ritems[RITEM_SKULL].base_vertex_loc = render_ctx->geom[GEOM_SKULL].submesh_geoms[0].base_vertex_location;
+    render_ctx->all_ritems.ritems[RITEM_SKULL].bounds = render_ctx->geom[GEOM_SKULL].submesh_geoms[0].bounds;
     render_ctx->all_ritems.ritems[RITEM_SKULL].n_frames_dirty = NUM_QUEUING_FRAMES;
     render_ctx->all_ritems.ritems[RITEM_SKULL].mat->n_frames_dirty = NUM_QUEUING_FRAMES;
     render_ctx->all_ritems.ritems[RITEM_SKULL].initialized = true;
@@ -860,12 +988,13 @@ create_render_items (D3DRenderContext * render_ctx) {
     render_ctx->all_ritems.ritems[RITEM_GRID].world = Identity4x4();
     XMStoreFloat4x4(&render_ctx->all_ritems.ritems[RITEM_GRID].tex_transform, XMMatrixScaling(8.0f, 8.0f, 1.0f));
     render_ctx->all_ritems.ritems[RITEM_GRID].obj_cbuffer_index = 6;
-    render_ctx->all_ritems.ritems[RITEM_GRID].geometry = &render_ctx->geom[GEOM_SHAPES];
+    render_ctx->all_ritems.ritems[RITEM_GRID].geometry = &render_ctx->geom[GEOM_GRID];
     render_ctx->all_ritems.ritems[RITEM_GRID].mat = &render_ctx->materials[MAT_TILE];
     render_ctx->all_ritems.ritems[RITEM_GRID].primitive_type = D3D_PRIMITIVE_TOPOLOGY_TRIANGLELIST;
-    render_ctx->all_ritems.ritems[RITEM_GRID].index_count = render_ctx->geom[GEOM_SHAPES].submesh_geoms[_GRID_ID].index_count;
-    render_ctx->all_ritems.ritems[RITEM_GRID].start_index_loc = render_ctx->geom[GEOM_SHAPES].submesh_geoms[_GRID_ID].start_index_location;
-    render_ctx->all_ritems.ritems[RITEM_GRID].base_vertex_loc = render_ctx->geom[GEOM_SHAPES].submesh_geoms[_GRID_ID].base_vertex_location;
+    render_ctx->all_ritems.ritems[RITEM_GRID].index_count = render_ctx->geom[GEOM_GRID].submesh_geoms[0].index_count;
+    render_ctx->all_ritems.ritems[RITEM_GRID].start_index_loc = render_ctx->geom[GEOM_GRID].submesh_geoms[0].start_index_location;
+    render_ctx->all_ritems.ritems[RITEM_GRID].base_vertex_loc = render_ctx->geom[GEOM_GRID].submesh_geoms[0].base_vertex_location;
+    render_ctx->all_ritems.ritems[RITEM_GRID].bounds = render_ctx->geom[GEOM_GRID].submesh_geoms[0].bounds;
     render_ctx->all_ritems.ritems[RITEM_GRID].n_frames_dirty = NUM_QUEUING_FRAMES;
     render_ctx->all_ritems.ritems[RITEM_GRID].mat->n_frames_dirty = NUM_QUEUING_FRAMES;
     render_ctx->all_ritems.ritems[RITEM_GRID].initialized = true;
@@ -948,18 +1077,49 @@ create_render_items (D3DRenderContext * render_ctx) {
         _curr++;
     }
     _ASSERT_EXPR(_curr == _COUNT_RENDERITEM, _T("Invalid render items creation"));
+
+    render_item_bounds_from_submeshes(render_ctx->all_ritems.ritems, render_ctx->all_ritems.size);
+    render_item_bounds_from_submeshes(render_ctx->opaque_ritems.ritems, render_ctx->opaque_ritems.size);
+
+    render_item_meshlets_from_submeshes(render_ctx->all_ritems.ritems, render_ctx->all_ritems.size);
+    render_item_meshlets_from_submeshes(render_ctx->opaque_ritems.ritems, render_ctx->opaque_ritems.size);
+    render_item_meshlets_from_submeshes(render_ctx->environment_ritems.ritems, render_ctx->environment_ritems.size);
+    render_item_meshlets_from_submeshes(render_ctx->debug_ritems_smap.ritems, render_ctx->debug_ritems_smap.size);
+    render_item_meshlets_from_submeshes(render_ctx->debug_ritems_ssao.ritems, render_ctx->debug_ritems_ssao.size);
 }
+// [encoding_psos] (optional) holds one PSO per VERTEX_ENCODING of the pass;
+// the caller must have already set the VERTEX_ENCODING_FLOAT32 one.
+// [meshlet_draws] (optional) replaces the index range of items with meshlets by their visible meshlets.
+// [visible] (optional) skips the items whose flag is false (indexed like ritem_array->ritems)
 static void
 draw_render_items (
     ID3D12GraphicsCommandList * cmd_list,
     ID3D12Resource * obj_cb,
-    RenderItemArray * ritem_array
+    RenderItemArray * ritem_array,
+    ID3D12PipelineState * const encoding_psos [] = nullptr,
+    MeshletDrawList const * meshlet_draws = nullptr,
+    bool const * visible = nullptr
 ) {
     size_t obj_cbuffer_size = sizeof(ObjectConstants);
+    VERTEX_ENCODING curr_encoding = VERTEX_ENCODING_FLOAT32;
     for (size_t i = 0; i < ritem_array->size; ++i) {
-        if (ritem_array->ritems[i].initialized) {
+        if (ritem_array->ritems[i].initialized && (nullptr == visible || visible[i])) {
+            VERTEX_ENCODING encoding = ritem_array->ritems[i].geometry->vertex_encoding;
+            if (encoding_psos && encoding != curr_encoding) {
+                cmd_list->SetPipelineState(encoding_psos[encoding]);
+                curr_encoding = encoding;
+            }
             D3D12_VERTEX_BUFFER_VIEW vbv = Mesh_GetVertexBufferView(ritem_array->ritems[i].geometry);
             D3D12_INDEX_BUFFER_VIEW ibv = Mesh_GetIndexBufferView(ritem_array->ritems[i].geometry);
+            UINT index_count = ritem_array->ritems[i].index_count;
+            UINT start_index_loc = ritem_array->ritems[i].start_index_loc;
+            if (meshlet_draws && ritem_array->ritems[i].meshlet_submesh) {
+                ibv = meshlet_draws->ibv;
+                index_count = meshlet_draws->index_count[ritem_array->ritems[i].obj_cbuffer_index];
+                start_index_loc = meshlet_draws->start_index[ritem_array->ritems[i].obj_cbuffer_index];
+                if (0 == index_count)
+                    continue;
+            }
             cmd_list->IASetVertexBuffers(0, 1, &vbv);
             cmd_list->IASetIndexBuffer(&ibv);
             cmd_list->IASetPrimitiveTopology(ritem_array->ritems[i].primitive_type);
@@ -970,9 +1130,9 @@ draw_render_items (
             cmd_list->SetGraphicsRootConstantBufferView(0, obj_cb_address);
 
             cmd_list->DrawIndexedInstanced(
-                ritem_array->ritems[i].index_count,
+                index_count,
                 1,
-                ritem_array->ritems[i].start_index_loc, ritem_array->ritems[i].base_vertex_loc, 0);
+                start_index_loc, ritem_array->ritems[i].base_vertex_loc, 0);
         }
     }
 }
@@ -1506,7 +1666,7 @@ create_root_signature_ssao (ID3D12Device * device, ID3D12RootSignature ** root_s
     device->CreateRootSignature(0, serialized_root_sig->GetBufferPointer(), serialized_root_sig->GetBufferSize(), IID_PPV_ARGS(root_signature));
 }
 static HRESULT
-compile_shader (wchar_t * path, wchar_t const * entry_point, wchar_t const * shader_model, DxcDefine defines [], int n_defines, IDxcBlob ** out_shader_ptr) {
+compile_shader (wchar_t const * path, wchar_t const * entry_point, wchar_t const * shader_model, DxcDefine defines [], int n_defines, IDxcBlob ** out_shader_ptr) {
     // -- using DXC shader compiler [https://asawicki.info/news_1719_two_shader_compilers_of_direct3d_12]
     HRESULT ret = E_FAIL;
 
@@ -1752,6 +1912,172 @@ create_pso (D3DRenderContext * render_ctx) {
     ssao_blur_pso_desc.PS.BytecodeLength = render_ctx->shaders[SHADER_SSAO_BLUR_PS]->GetBufferSize();
     render_ctx->device->CreateGraphicsPipelineState(&ssao_blur_pso_desc, IID_PPV_ARGS(&render_ctx->psos[LAYER_SSAO_BLUR]));
 
+    //
+    // -- PSOs for meshes with quantized vertices (same states, different input layout and VS)
+    D3D12_INPUT_ELEMENT_DESC packed_input_desc[4];
+    get_packed_vertex_input_desc(packed_input_desc);
+    D3D12_INPUT_LAYOUT_DESC packed_input_layout = {packed_input_desc, ARRAY_COUNT(packed_input_desc)};
+
+    D3D12_GRAPHICS_PIPELINE_STATE_DESC opaque_quantized_pso_desc = opaque_pso_desc;
+    opaque_quantized_pso_desc.InputLayout = packed_input_layout;
+    opaque_quantized_pso_desc.VS.pShaderBytecode = render_ctx->shaders[SHADER_STANDARD_QUANTIZED_VS]->GetBufferPointer();
+    opaque_quantized_pso_desc.VS.BytecodeLength = render_ctx->shaders[SHADER_STANDARD_QUANTIZED_VS]->GetBufferSize();
+    render_ctx->device->CreateGraphicsPipelineState(&opaque_quantized_pso_desc, IID_PPV_ARGS(&render_ctx->psos[LAYER_OPAQUE_QUANTIZED]));
+
+    D3D12_GRAPHICS_PIPELINE_STATE_DESC smap_quantized_pso_desc = smap_pso_desc;
+    smap_quantized_pso_desc.InputLayout = packed_input_layout;
+    smap_quantized_pso_desc.VS.pShaderBytecode = render_ctx->shaders[SHADER_SHADOW_QUANTIZED_VS]->GetBufferPointer();
+    smap_quantized_pso_desc.VS.BytecodeLength = render_ctx->shaders[SHADER_SHADOW_QUANTIZED_VS]->GetBufferSize();
+    render_ctx->device->CreateGraphicsPipelineState(&smap_quantized_pso_desc, IID_PPV_ARGS(&render_ctx->psos[LAYER_SHADOW_OPAQUE_QUANTIZED]));
+
+    D3D12_GRAPHICS_PIPELINE_STATE_DESC draw_normals_quantized_pso = draw_normals_pso;
+    draw_normals_quantized_pso.InputLayout = packed_input_layout;
+    draw_normals_quantized_pso.VS.pShaderBytecode = render_ctx->shaders[SHADER_DRAW_NORMALS_QUANTIZED_VS]->GetBufferPointer();
+    draw_normals_quantized_pso.VS.BytecodeLength = render_ctx->shaders[SHADER_DRAW_NORMALS_QUANTIZED_VS]->GetBufferSize();
+    render_ctx->device->CreateGraphicsPipelineState(&draw_normals_quantized_pso, IID_PPV_ARGS(&render_ctx->psos[LAYER_DRAW_NORMALS_QUANTIZED]));
+}
+//
+// Startup tasks
+//
+struct StartupTexture {
+    TEX_INDEX       index;
+    char const *    name;
+    wchar_t const * filename;
+};
+static StartupTexture const g_startup_textures [] = {
+    {BRICK_DIFFUSE_MAP,     "tex_brick",        L"../Textures/bricks2.dds"},
+    {TILE_DIFFUSE_MAP,      "tex_tile",         L"../Textures/tile.dds"},
+    {WHITE1x1_DIFFUSE_MAP,  "tex_default",      L"../Textures/white1x1.dds"},
+    {BRICK_NORMAL_MAP,      "bricks nmap",      L"../Textures/bricks2_nmap.dds"},
+    {TILE_NORMAL_MAP,       "tile nmap",        L"../Textures/tile_nmap.dds"},
+    {WHITE1x1_NORMAL_MAP,   "default nmap",     L"../Textures/default_nmap.dds"},
+    {TEX_SKY_CUBEMAP0,      "tex_sky_cubemap",  L"../Textures/grasscube1024.dds"},
+    {TEX_SKY_CUBEMAP1,      "tex_sky_cubemap1", L"../Textures/desertcube1024.dds"},
+    {TEX_SKY_CUBEMAP2,      "tex_sky_cubemap2", L"../Textures/snowcube1024.dds"},
+    {TEX_SKY_CUBEMAP3,      "tex_sky_cubemap3", L"../Textures/sunsetcube1024.dds"},
+};
+
+static DxcDefine g_defines_fog [] = {{.Name = _T("FOG"), .Value = _T("1")}};
+static DxcDefine g_defines_alphatest [] = {{.Name = _T("ALPHA_TEST"), .Value = _T("1")}};
+static DxcDefine g_defines_quantized [] = {{.Name = _T("QUANTIZED_VERTEX"), .Value = _T("1")}};
+
+struct ShaderJob {
+    char const *    name;
+    SHADERS_CODE    index;
+    wchar_t const * path;
+    wchar_t const * entry_point;
+    wchar_t const * shader_model;
+    DxcDefine *     defines;
+    int             n_defines;
+
+    IDxcBlob **     out_shader;
+};
+static ShaderJob g_shader_jobs [] = {
+    {"standard VS",             SHADER_STANDARD_VS,                 _T("./shaders/default.hlsl"),       _T("VertexShader_Main"),    _T("vs_6_0"), nullptr, 0},
+    {"opaque PS",               SHADER_OPAQUE_PS,                   _T("./shaders/default.hlsl"),       _T("PixelShader_Main"),     _T("ps_6_0"), g_defines_fog, _countof(g_defines_fog)},
+    {"shadow VS",               SHADER_SHADOW_VS,                   _T("./shaders/shadows.hlsl"),       _T("VS"),                   _T("vs_6_0"), nullptr, 0},
+    {"shadow opaque PS",        SHADER_SHADOW_OPAQUE_PS,            _T("./shaders/shadows.hlsl"),       _T("PS"),                   _T("ps_6_0"), nullptr, 0},
+    {"shadow alphatested PS",   SHADER_SHADOW_ALPHATESTED_PS,       _T("./shaders/shadows.hlsl"),       _T("PS"),                   _T("ps_6_0"), g_defines_alphatest, _countof(g_defines_alphatest)},
+    {"debug smap VS",           SHADER_DEBUG_SMAP_VS,               _T("./shaders/shadow_debug.hlsl"),  _T("VS"),                   _T("vs_6_0"), nullptr, 0},
+    {"debug smap PS",           SHADER_DEBUG_SMAP_PS,               _T("./shaders/shadow_debug.hlsl"),  _T("PS"),                   _T("ps_6_0"), nullptr, 0},
+    {"debug ssao VS",           SHADER_DEBUG_SSAO_VS,               _T("./shaders/ssao_debug.hlsl"),    _T("VS"),                   _T("vs_6_0"), nullptr, 0},
+    {"debug ssao PS",           SHADER_DEBUG_SSAO_PS,               _T("./shaders/ssao_debug.hlsl"),    _T("PS"),                   _T("ps_6_0"), nullptr, 0},
+    {"sky VS",                  SHADER_SKY_VS,                      _T("./shaders/sky.hlsl"),           _T("VS"),                   _T("vs_6_0"), nullptr, 0},
+    {"sky PS",                  SHADER_SKY_PS,                      _T("./shaders/sky.hlsl"),           _T("PS"),                   _T("ps_6_0"), nullptr, 0},
+    {"draw normals VS",         SHADER_DRAW_NORMALS_VS,             _T("./shaders/draw_normals.hlsl"),  _T("VS"),                   _T("vs_6_0"), nullptr, 0},
+    {"draw normals PS",         SHADER_DRAW_NORMALS_PS,             _T("./shaders/draw_normals.hlsl"),  _T("PS"),                   _T("ps_6_0"), nullptr, 0},
+    {"ssao VS",                 SHADER_SSAO_VS,                     _T("./shaders/ssao.hlsl"),          _T("VS"),                   _T("vs_6_0"), nullptr, 0},
+    {"ssao PS",                 SHADER_SSAO_PS,                     _T("./shaders/ssao.hlsl"),          _T("PS"),                   _T("ps_6_0"), nullptr, 0},
+    {"ssao blur VS",            SHADER_SSAO_BLUR_VS,                _T("./shaders/ssao_blur.hlsl"),     _T("VS"),                   _T("vs_6_0"), nullptr, 0},
+    {"ssao blur PS",            SHADER_SSAO_BLUR_PS,                _T("./shaders/ssao_blur.hlsl"),     _T("PS"),                   _T("ps_6_0"), nullptr, 0},
+    // vertex shaders for quantized vertices
+    {"standard quantized VS",   SHADER_STANDARD_QUANTIZED_VS,       _T("./shaders/default.hlsl"),       _T("VertexShader_Main"),    _T("vs_6_0"), g_defines_quantized, _countof(g_defines_quantized)},
+    {"shadow quantized VS",     SHADER_SHADOW_QUANTIZED_VS,         _T("./shaders/shadows.hlsl"),       _T("VS"),                   _T("vs_6_0"), g_defines_quantized, _countof(g_defines_quantized)},
+    {"normals quantized VS",    SHADER_DRAW_NORMALS_QUANTIZED_VS,   _T("./shaders/draw_normals.hlsl"),  _T("VS"),                   _T("vs_6_0"), g_defines_quantized, _countof(g_defines_quantized)},
+};
+static_assert(_countof(g_shader_jobs) == _COUNT_SHADERS, "Every shader needs a ShaderJob");
+static_assert(_countof(g_startup_textures) == _COUNT_TEX, "Every texture needs a StartupTexture");
+
+static bool
+startup_read_texture (void * param) {
+    read_texture((TextureLoad *)param);
+    return true;
+}
+static bool
+startup_compile_shader (void * param) {
+    ShaderJob * job = (ShaderJob *)param;
+    compile_shader(job->path, job->entry_point, job->shader_model, job->defines, job->n_defines, job->out_shader);
+    return true;
+}
+static bool
+startup_create_skull (void * param) {
+    return create_skull_geometry((D3DRenderContext *)param);
+}
+static bool
+startup_create_shapes (void * param) {
+    create_shapes_geometry((D3DRenderContext *)param);
+    return true;
+}
+static bool
+startup_create_grid (void * param) {
+    create_grid_geometry((D3DRenderContext *)param);
+    return true;
+}
+static bool
+startup_create_materials (void * param) {
+    create_materials(((D3DRenderContext *)param)->materials);
+    return true;
+}
+static bool
+startup_create_render_items (void * param) {
+    create_render_items((D3DRenderContext *)param);
+    return true;
+}
+static bool
+startup_create_root_signatures (void * param) {
+    D3DRenderContext * render_ctx = (D3DRenderContext *)param;
+    create_root_signature(render_ctx->device, &render_ctx->root_signature);
+    create_root_signature_ssao(render_ctx->device, &render_ctx->root_signature_ssao);
+    return true;
+}
+static bool
+startup_create_psos (void * param) {
+    create_pso((D3DRenderContext *)param);
+    return true;
+}
+// Builds the startup graph: CPU work and device object creation only, the uploads
+// of [texture_loads] and the geometries are recorded by the joining thread.
+static void
+add_startup_tasks (AssetGraph * graph, D3DRenderContext * render_ctx, TextureLoad texture_loads []) {
+    AssetGraph_Init(graph);
+
+    for (unsigned i = 0; i < _COUNT_TEX; ++i) {
+        StartupTexture const * tex = &g_startup_textures[i];
+        strcpy_s(render_ctx->textures[tex->index].name, tex->name);
+        wcscpy_s(render_ctx->textures[tex->index].filename, tex->filename);
+        texture_loads[i] = {.device = render_ctx->device, .texture = &render_ctx->textures[tex->index]};
+        AssetGraph_AddTask(graph, tex->name, startup_read_texture, &texture_loads[i]);
+    }
+
+    UINT skull = AssetGraph_AddTask(graph, "skull geometry", startup_create_skull, render_ctx);
+    UINT shapes = AssetGraph_AddTask(graph, "shapes geometry", startup_create_shapes, render_ctx);
+    UINT grid = AssetGraph_AddTask(graph, "grid geometry", startup_create_grid, render_ctx);
+    UINT materials = AssetGraph_AddTask(graph, "materials", startup_create_materials, render_ctx);
+    UINT ritems = AssetGraph_AddTask(graph, "render items", startup_create_render_items, render_ctx);
+    AssetGraph_AddDependency(graph, ritems, skull);
+    AssetGraph_AddDependency(graph, ritems, shapes);
+    AssetGraph_AddDependency(graph, ritems, grid);
+    AssetGraph_AddDependency(graph, ritems, materials);
+
+    UINT root_sigs = AssetGraph_AddTask(graph, "root signatures", startup_create_root_signatures, render_ctx);
+    UINT psos = AssetGraph_AddTask(graph, "psos", startup_create_psos, render_ctx);
+    AssetGraph_AddDependency(graph, psos, root_sigs);
+    for (unsigned i = 0; i < _COUNT_SHADERS; ++i) {
+        ShaderJob * job = &g_shader_jobs[i];
+        job->out_shader = &render_ctx->shaders[job->index];
+        UINT shader = AssetGraph_AddTask(graph, job->name, startup_compile_shader, job);
+        AssetGraph_AddDependency(graph, psos, shader);
+    }
 }
 static void
 handle_keyboard_input (SceneContext * scene_ctx, GameTimer * gt) {
@@ -1802,6 +2128,69 @@ handle_mouse_down (
     }
 }
 
+// Culls the meshlets of every render item against the camera (frustum and normal cones)
+// and the shadow casting light (normal cones only, its volume encloses the whole scene),
+// and writes the surviving indices to the current frame's meshlet_ib.
+static void
+update_meshlet_culling (D3DRenderContext * render_ctx) {
+    FrameResource * frame = &render_ctx->frame_resources[render_ctx->frame_index];
+    UINT * out_indices = (UINT *)frame->meshlet_ib_ptr;
+    UINT n_out = 0;
+
+    XMMATRIX view = Camera_GetView(g_camera);
+    XMVECTOR det_view = XMMatrixDeterminant(view);
+    XMMATRIX inv_view = XMMatrixInverse(&det_view, view);
+    BoundingFrustum camera_frustum;
+    BoundingFrustum::CreateFromMatrix(camera_frustum, Camera_GetProj(g_camera));
+    XMVECTOR eye_pos = Camera_GetPosition(g_camera);
+    XMVECTOR light_dir = XMLoadFloat3(&g_scene_ctx.rotated_light_dirs[0]);
+
+    for (UINT v = 0; v < _COUNT_MESHLET_VIEW; ++v) {
+        render_ctx->meshlet_draws[v].ibv.BufferLocation = frame->meshlet_ib->GetGPUVirtualAddress();
+        render_ctx->meshlet_draws[v].ibv.SizeInBytes = render_ctx->meshlet_ib_capacity * sizeof(UINT);
+        render_ctx->meshlet_draws[v].ibv.Format = DXGI_FORMAT_R32_UINT;
+        render_ctx->meshlet_draws[v].stats = {};
+    }
+    for (UINT i = 0; i < render_ctx->all_ritems.size; ++i) {
+        RenderItem * ritem = &render_ctx->all_ritems.ritems[i];
+        if (!ritem->initialized)
+            continue;
+        SubmeshGeometry const * submesh = ritem->meshlet_submesh;
+        if (nullptr == submesh)
+            continue;
+
+        // -- views in object space
+        XMMATRIX world = XMLoadFloat4x4(&ritem->world);
+        XMVECTOR det_world = XMMatrixDeterminant(world);
+        XMMATRIX inv_world = XMMatrixInverse(&det_world, world);
+
+        BoundingFrustum local_frustum;
+        camera_frustum.Transform(local_frustum, inv_view * inv_world);
+        BoundingFrustum const * frustums [_COUNT_MESHLET_VIEW] = {&local_frustum, nullptr};
+
+        XMFLOAT4 view_points [_COUNT_MESHLET_VIEW];
+        XMStoreFloat4(&view_points[MESHLET_VIEW_CAMERA], XMVector3TransformCoord(eye_pos, inv_world));
+        view_points[MESHLET_VIEW_CAMERA].w = 1.0f;
+        XMStoreFloat4(&view_points[MESHLET_VIEW_LIGHT], XMVector3Normalize(XMVector3TransformNormal(light_dir, inv_world)));
+        view_points[MESHLET_VIEW_LIGHT].w = 0.0f;
+
+        Meshlet const * meshlets = ritem->geometry->meshlets + submesh->meshlet_offset;
+        void const * indices = ritem->geometry->ib_cpu->GetBufferPointer();
+        for (UINT v = 0; v < _COUNT_MESHLET_VIEW; ++v) {
+            MeshletDrawList * list = &render_ctx->meshlet_draws[v];
+            UINT n = 0;
+            if (DXGI_FORMAT_R16_UINT == ritem->geometry->index_format)
+                n = cull_meshlets(meshlets, submesh->meshlet_count, (uint16_t const *)indices + submesh->start_index_location,
+                                  frustums[v], view_points[v], out_indices + n_out, &list->stats);
+            else
+                n = cull_meshlets(meshlets, submesh->meshlet_count, (uint32_t const *)indices + submesh->start_index_location,
+                                  frustums[v], view_points[v], out_indices + n_out, &list->stats);
+            list->start_index[ritem->obj_cbuffer_index] = n_out;
+            list->index_count[ritem->obj_cbuffer_index] = n;
+            n_out += n;
+        }
+    }
+}
 static void
 update_object_cbuffer (D3DRenderContext * render_ctx) {
     UINT frame_index = render_ctx->frame_index;
@@ -1816,6 +2205,11 @@ update_object_cbuffer (D3DRenderContext * render_ctx) {
             XMStoreFloat4x4(&data.world, XMMatrixTranspose(world));
             XMStoreFloat4x4(&data.tex_transform, XMMatrixTranspose(tex_transform));
             data.mat_index = render_ctx->all_ritems.ritems[i].mat->mat_cbuffer_index;
+            if (VERTEX_ENCODING_QUANTIZED == render_ctx->all_ritems.ritems[i].geometry->vertex_encoding) {
+                PositionDecode dec = position_decode_from_bounds(render_ctx->all_ritems.ritems[i].bounds);
+                data.pos_decode_bias = dec.bias;
+                data.pos_decode_scale = dec.scale;
+            }
 
             uint8_t * obj_ptr = obj_begin_ptr + (obj_cbuffer_size * render_ctx->all_ritems.ritems[i].obj_cbuffer_index);
             memcpy(obj_ptr, &data, obj_cbuffer_size);
@@ -1949,6 +2343,40 @@ update_shadow_transform (GameTimer * timer) {
     XMStoreFloat4x4(&g_scene_ctx.light_proj_mat, light_proj);
     XMStoreFloat4x4(&g_scene_ctx.shadow_transform, S);
 }
+// Culls opaque_ritems against the camera frustum, and as shadow casters against the light volume
+// intersected with the camera frustum extruded toward the light
+static void
+update_render_item_culling (D3DRenderContext * render_ctx) {
+    RenderItemArray const * opaque = &render_ctx->opaque_ritems;
+    RenderItemBounds_Update(&g_ritem_culling.bounds, opaque->ritems, opaque->size);
+
+    XMMATRIX view_proj = XMMatrixMultiply(Camera_GetView(g_camera), Camera_GetProj(g_camera));
+    CullPlaneSet camera_planes = {};
+    CullPlaneSet_AddFrustum(&camera_planes, view_proj);
+    g_ritem_culling.camera_visible_count = RenderItemBounds_Cull(&g_ritem_culling.bounds, &camera_planes, g_ritem_culling.camera_visible);
+
+    XMMATRIX light_view_proj = XMMatrixMultiply(XMLoadFloat4x4(&g_scene_ctx.light_view_mat), XMLoadFloat4x4(&g_scene_ctx.light_proj_mat));
+    CullPlaneSet caster_planes = {};
+    CullPlaneSet_AddFrustum(&caster_planes, light_view_proj);
+    CullPlaneSet_AddShadowCasters(&caster_planes, view_proj, XMLoadFloat3(&g_scene_ctx.rotated_light_dirs[0]));
+    g_ritem_culling.caster_visible_count = RenderItemBounds_Cull(&g_ritem_culling.bounds, &caster_planes, g_ritem_culling.caster_visible);
+
+    if (g_coverage_culling_enabled) {
+        ScreenCoverageParams coverage = {};
+        coverage.eye_pos = Camera_GetPosition3f(g_camera);
+        coverage.proj_scale = coverage_projection_scale(Camera_GetProj4x4f(g_camera), (float)g_scene_ctx.height);
+        coverage.min_pixels = g_coverage_min_pixels;
+        coverage.shadow_min_pixels = g_shadow_min_pixels;
+        cull_render_items_by_coverage(opaque->ritems, opaque->size, coverage, g_ritem_culling.camera_visible, g_ritem_culling.caster_visible);
+
+        g_ritem_culling.camera_visible_count = 0;
+        g_ritem_culling.caster_visible_count = 0;
+        for (UINT i = 0; i < opaque->size; ++i) {
+            g_ritem_culling.camera_visible_count += g_ritem_culling.camera_visible[i];
+            g_ritem_culling.caster_visible_count += g_ritem_culling.caster_visible[i];
+        }
+    }
+}
 static void
 update_shadow_pass_cb(ShadowMap * smap, D3DRenderContext * render_ctx, GameTimer * timer) {
     XMMATRIX view = XMLoadFloat4x4(&g_scene_ctx.light_view_mat);
@@ -2123,7 +2551,10 @@ draw_scene_to_shadow_map (ShadowMap * smap, D3DRenderContext * render_ctx) {
 
     cmdlist->SetPipelineState(render_ctx->psos[LAYER_SHADOW_OPAQUE]);
 
-    draw_render_items(cmdlist, render_ctx->frame_resources[frame_index].obj_cb, &render_ctx->opaque_ritems);
+    ID3D12PipelineState * encoding_psos [_COUNT_VERTEX_ENCODING] = {render_ctx->psos[LAYER_SHADOW_OPAQUE], render_ctx->psos[LAYER_SHADOW_OPAQUE_QUANTIZED]};
+    MeshletDrawList const * meshlet_draws = g_meshlet_culling_enabled ? &render_ctx->meshlet_draws[MESHLET_VIEW_LIGHT] : nullptr;
+    draw_render_items(cmdlist, render_ctx->frame_resources[frame_index].obj_cb, &render_ctx->opaque_ritems, encoding_psos, meshlet_draws,
+                      g_ritem_culling_enabled ? g_ritem_culling.caster_visible : nullptr);
 
     // change back to generic read so texture can be read in shader
     resource_usage_transition(
@@ -2166,10 +2597,14 @@ draw_normals_and_depth (SSAO * ssao, D3DRenderContext * render_ctx) {
     cmdlist->SetGraphicsRootConstantBufferView(1, pass_cb->GetGPUVirtualAddress());
 
     cmdlist->SetPipelineState(render_ctx->psos[LAYER_DRAW_NORMALS]);
+    ID3D12PipelineState * encoding_psos [_COUNT_VERTEX_ENCODING] = {render_ctx->psos[LAYER_DRAW_NORMALS], render_ctx->psos[LAYER_DRAW_NORMALS_QUANTIZED]};
     draw_render_items(
         cmdlist,
         render_ctx->frame_resources[frame_index].obj_cb,
-        &render_ctx->opaque_ritems
+        &render_ctx->opaque_ritems,
+        encoding_psos,
+        g_meshlet_culling_enabled ? &render_ctx->meshlet_draws[MESHLET_VIEW_CAMERA] : nullptr,
+        g_ritem_culling_enabled ? g_ritem_culling.camera_visible : nullptr
     );
 
     resource_usage_transition(
@@ -2302,10 +2737,14 @@ draw_main (D3DRenderContext * render_ctx, ShadowMap * smap, SSAO * ssao) {
 
     // 1. draw opaque objs
     cmdlist->SetPipelineState(render_ctx->psos[LAYER_OPAQUE]);
+    ID3D12PipelineState * encoding_psos [_COUNT_VERTEX_ENCODING] = {render_ctx->psos[LAYER_OPAQUE], render_ctx->psos[LAYER_OPAQUE_QUANTIZED]};
     draw_render_items(
         cmdlist,
         render_ctx->frame_resources[frame_index].obj_cb,
-        &render_ctx->opaque_ritems
+        &render_ctx->opaque_ritems,
+        encoding_psos,
+        g_meshlet_culling_enabled ? &render_ctx->meshlet_draws[MESHLET_VIEW_CAMERA] : nullptr,
+        g_ritem_culling_enabled ? g_ritem_culling.camera_visible : nullptr
     );
 
     // 2. draw debug quad for smap
@@ -2718,6 +3157,8 @@ main_win_cb (HWND hwnd, UINT uMsg, WPARAM wParam, LPARAM lParam) {
 INT WINAPI
 WinMain(_In_ HINSTANCE hInstance, _In_opt_ HINSTANCE, _In_ LPSTR, _In_ INT) {
 
+    QueryPerformanceCounter((LARGE_INTEGER *)&g_startup_begin);
+
     SceneContext_Init(&g_scene_ctx, 1280, 720);
     D3DRenderContext * render_ctx = (D3DRenderContext *)::malloc(sizeof(D3DRenderContext));
     RenderContext_Init(render_ctx);
@@ -2884,8 +3325,19 @@ WinMain(_In_ HINSTANCE hInstance, _In_opt_ HINSTANCE, _In_ LPSTR, _In_ INT) {
     g_ssao = (SSAO *)malloc(sizeof(SSAO));
     SSAO_Init(g_ssao, render_ctx->device, render_ctx->direct_cmd_list, g_scene_ctx.width, g_scene_ctx.height);
 
-
-
+    //
+    // Startup assets: the workers read, condition and compile while this thread
+    // finishes the device setup, then it joins and records the uploads.
+    AssetGraph * startup_graph = (AssetGraph *)::malloc(sizeof(AssetGraph));
+    TextureLoad texture_loads[_COUNT_TEX] = {};
+    add_startup_tasks(startup_graph, render_ctx, texture_loads);
+#if ENABLE_PARALLEL_STARTUP > 0
+    SYSTEM_INFO sys_info;
+    GetSystemInfo(&sys_info);
+    AssetGraph_Start(startup_graph, sys_info.dwNumberOfProcessors);
+#else
+    AssetGraph_Start(startup_graph, 0);
+#endif
 
     DXGI_MODE_DESC backbuffer_desc = {};
     backbuffer_desc.Width = g_scene_ctx.width;
@@ -2921,86 +3373,19 @@ WinMain(_In_ HINSTANCE hInstance, _In_opt_ HINSTANCE, _In_ LPSTR, _In_ INT) {
 
 // ========================================================================================================
 #pragma region Load Textures
-    // brick tex
-    strcpy_s(render_ctx->textures[BRICK_DIFFUSE_MAP].name, "tex_brick");
-    wcscpy_s(render_ctx->textures[BRICK_DIFFUSE_MAP].filename, L"../Textures/bricks2.dds");
-    load_texture(
-        render_ctx->device, render_ctx->direct_cmd_list,
-        render_ctx->textures[BRICK_DIFFUSE_MAP].filename,
-        &render_ctx->textures[BRICK_DIFFUSE_MAP]
-    );
-    // tile tex
-    strcpy_s(render_ctx->textures[TILE_DIFFUSE_MAP].name, "tex_tile");
-    wcscpy_s(render_ctx->textures[TILE_DIFFUSE_MAP].filename, L"../Textures/tile.dds");
-    load_texture(
-        render_ctx->device, render_ctx->direct_cmd_list,
-        render_ctx->textures[TILE_DIFFUSE_MAP].filename,
-        &render_ctx->textures[TILE_DIFFUSE_MAP]
-    );
-    // default tex
-    strcpy_s(render_ctx->textures[WHITE1x1_DIFFUSE_MAP].name, "tex_default");
-    wcscpy_s(render_ctx->textures[WHITE1x1_DIFFUSE_MAP].filename, L"../Textures/white1x1.dds");
-    load_texture(
-        render_ctx->device, render_ctx->direct_cmd_list,
-        render_ctx->textures[WHITE1x1_DIFFUSE_MAP].filename,
-        &render_ctx->textures[WHITE1x1_DIFFUSE_MAP]
-    );
-    // bricks normal map
-    strcpy_s(render_ctx->textures[BRICK_NORMAL_MAP].name, "bricks nmap");
-    wcscpy_s(render_ctx->textures[BRICK_NORMAL_MAP].filename, L"../Textures/bricks2_nmap.dds");
-    load_texture(
-        render_ctx->device, render_ctx->direct_cmd_list,
-        render_ctx->textures[BRICK_NORMAL_MAP].filename,
-        &render_ctx->textures[BRICK_NORMAL_MAP]
-    );
-    // tile normal map
-    strcpy_s(render_ctx->textures[TILE_NORMAL_MAP].name, "tile nmap");
-    wcscpy_s(render_ctx->textures[TILE_NORMAL_MAP].filename, L"../Textures/tile_nmap.dds");
-    load_texture(
-        render_ctx->device, render_ctx->direct_cmd_list,
-        render_ctx->textures[TILE_NORMAL_MAP].filename,
-        &render_ctx->textures[TILE_NORMAL_MAP]
-    );
-    // default normal map
-    strcpy_s(render_ctx->textures[WHITE1x1_NORMAL_MAP].name, "default nmap");
-    wcscpy_s(render_ctx->textures[WHITE1x1_NORMAL_MAP].filename, L"../Textures/default_nmap.dds");
-    load_texture(
-        render_ctx->device, render_ctx->direct_cmd_list,
-        render_ctx->textures[WHITE1x1_NORMAL_MAP].filename,
-        &render_ctx->textures[WHITE1x1_NORMAL_MAP]
-    );
-    // sky cube-map tex0
-    strcpy_s(render_ctx->textures[TEX_SKY_CUBEMAP0].name, "tex_sky_cubemap");
-    wcscpy_s(render_ctx->textures[TEX_SKY_CUBEMAP0].filename, L"../Textures/grasscube1024.dds");
-    load_texture(
-        render_ctx->device, render_ctx->direct_cmd_list,
-        render_ctx->textures[TEX_SKY_CUBEMAP0].filename,
-        &render_ctx->textures[TEX_SKY_CUBEMAP0]
-    );
-    // sky cube-map tex1
-    strcpy_s(render_ctx->textures[TEX_SKY_CUBEMAP1].name, "tex_sky_cubemap1");
-    wcscpy_s(render_ctx->textures[TEX_SKY_CUBEMAP1].filename, L"../Textures/desertcube1024.dds");
-    load_texture(
-        render_ctx->device, render_ctx->direct_cmd_list,
-        render_ctx->textures[TEX_SKY_CUBEMAP1].filename,
-        &render_ctx->textures[TEX_SKY_CUBEMAP1]
-    );
-    // sky cube-map tex2
-    strcpy_s(render_ctx->textures[TEX_SKY_CUBEMAP2].name, "tex_sky_cubemap2");
-    wcscpy_s(render_ctx->textures[TEX_SKY_CUBEMAP2].filename, L"../Textures/snowcube1024.dds");
-    load_texture(
-        render_ctx->device, render_ctx->direct_cmd_list,
-        render_ctx->textures[TEX_SKY_CUBEMAP2].filename,
-        &render_ctx->textures[TEX_SKY_CUBEMAP2]
-    );
-    // sky cube-map tex3
-    strcpy_s(render_ctx->textures[TEX_SKY_CUBEMAP3].name, "tex_sky_cubemap3");
-    wcscpy_s(render_ctx->textures[TEX_SKY_CUBEMAP3].filename, L"../Textures/sunsetcube1024.dds");
-    load_texture(
-        render_ctx->device, render_ctx->direct_cmd_list,
-        render_ctx->textures[TEX_SKY_CUBEMAP3].filename,
-        &render_ctx->textures[TEX_SKY_CUBEMAP3]
-    );
+    // -- the single join: everything below can use the startup assets
+    AssetGraph_Join(startup_graph);
+    g_startup_assets_ms = AssetGraph_Milliseconds(startup_graph->begin, startup_graph->end);
+    for (UINT i = 0; i < startup_graph->task_count; ++i)
+        if (startup_graph->tasks[i].failed) {
+            char msg[128];
+            sprintf_s(msg, sizeof(msg), "Could not create %s", startup_graph->tasks[i].name);
+            MessageBoxA(0, msg, 0, 0);
+        }
+    ::free(startup_graph);
+
+    for (unsigned i = 0; i < _COUNT_TEX; ++i)
+        upload_texture(render_ctx->direct_cmd_list, &texture_loads[i]);
 #pragma endregion
 
 #if 1   // For SSAO, dsv and depth buffer should be created before SSAO descriptors setup
@@ -3093,10 +3478,12 @@ WinMain(_In_ HINSTANCE hInstance, _In_opt_ HINSTANCE, _In_ LPSTR, _In_ INT) {
 #pragma endregion
 
 #pragma region Shapes_And_Renderitem_Creation
-    create_skull_geometry(render_ctx);
-    create_shapes_geometry(render_ctx);
-    create_materials(render_ctx->materials);
-    create_render_items(render_ctx);
+#if ENABLE_MESH_PARSE_BENCHMARK > 0
+    benchmark_mesh_parsers();
+#endif
+    // geometries and render items were created by the startup tasks
+    for (unsigned i = 0; i < _COUNT_GEOM; ++i)
+        upload_geometry(render_ctx, &render_ctx->geom[i]);
 
 #pragma endregion 
 
@@ -3105,6 +3492,10 @@ WinMain(_In_ HINSTANCE hInstance, _In_opt_ HINSTANCE, _In_ LPSTR, _In_ INT) {
     UINT mat_data_size = sizeof(MaterialData);
     UINT pass_cb_size = sizeof(PassConstants);
     UINT ssao_cb_size = sizeof(SSAOConstants);
+    // worst case: nothing culled in any view
+    for (UINT i = 0; i < render_ctx->all_ritems.size; ++i)
+        if (render_ctx->all_ritems.ritems[i].initialized && render_ctx->all_ritems.ritems[i].meshlet_submesh)
+            render_ctx->meshlet_ib_capacity += render_ctx->all_ritems.ritems[i].index_count * _COUNT_MESHLET_VIEW;
     for (UINT i = 0; i < NUM_QUEUING_FRAMES; ++i) {
         // -- create a cmd-allocator for each frame
         res = render_ctx->device->CreateCommandAllocator(D3D12_COMMAND_LIST_TYPE::D3D12_COMMAND_LIST_TYPE_DIRECT, IID_PPV_ARGS(&render_ctx->frame_resources[i].cmd_list_alloc));
@@ -3116,78 +3507,14 @@ WinMain(_In_ HINSTANCE hInstance, _In_opt_ HINSTANCE, _In_ LPSTR, _In_ INT) {
         create_upload_buffer(render_ctx->device, (UINT64)pass_cb_size * 2, &render_ctx->frame_resources[i].pass_cb_ptr, &render_ctx->frame_resources[i].pass_cb);
 
         create_upload_buffer(render_ctx->device, (UINT64)ssao_cb_size * 1, &render_ctx->frame_resources[i].ssao_ptr, &render_ctx->frame_resources[i].ssao_cb);
-    }
-#pragma endregion
-
-    // ========================================================================================================
-#pragma region Root_Signature_Creation
-    create_root_signature(render_ctx->device, &render_ctx->root_signature);
-
-    create_root_signature_ssao(render_ctx->device, &render_ctx->root_signature_ssao);
 
-#pragma endregion Root_Signature_Creation
-
-    // Load and compile shaders
-
-#pragma region Compile Shaders
-    TCHAR standard_shader_path [] = _T("./shaders/default.hlsl");
-    TCHAR sky_shader_path [] = _T("./shaders/sky.hlsl");
-    TCHAR shadow_shader_path [] = _T("./shaders/shadows.hlsl");
-    TCHAR debug_smap_shader_path [] = _T("./shaders/shadow_debug.hlsl");
-    TCHAR debug_ssao_shader_path [] = _T("./shaders/ssao_debug.hlsl");
-    TCHAR draw_normals_shader_path [] = _T("./shaders/draw_normals.hlsl");
-    TCHAR ssao_shader_path [] = _T("./shaders/ssao.hlsl");
-    TCHAR ssao_blur_shader_path [] = _T("./shaders/ssao_blur.hlsl");
-
-    {   // standard shaders
-        compile_shader(standard_shader_path, _T("VertexShader_Main"), _T("vs_6_0"), nullptr, 0, &render_ctx->shaders[SHADER_STANDARD_VS]);
-
-        int const n_define_fog = 1;
-        DxcDefine defines_fog[n_define_fog] = {};
-        defines_fog[0] = {.Name = _T("FOG"), .Value = _T("1")};
-        compile_shader(standard_shader_path, _T("PixelShader_Main"), _T("ps_6_0"), defines_fog, n_define_fog, &render_ctx->shaders[SHADER_OPAQUE_PS]);
-    }
-    {   // shadow shaders
-        compile_shader(shadow_shader_path, _T("VS"), _T("vs_6_0"), nullptr, 0, &render_ctx->shaders[SHADER_SHADOW_VS]);
-        compile_shader(shadow_shader_path, _T("PS"), _T("ps_6_0"), nullptr, 0, &render_ctx->shaders[SHADER_SHADOW_OPAQUE_PS]);
-
-        int const n_define_alphatest = 1;
-        DxcDefine defines_alphatest[n_define_alphatest] = {};
-        defines_alphatest[0] = {.Name = _T("ALPHA_TEST"), .Value = _T("1")};
-        compile_shader(shadow_shader_path, _T("PS"), _T("ps_6_0"), defines_alphatest, n_define_alphatest, &render_ctx->shaders[SHADER_SHADOW_ALPHATESTED_PS]);
-    }
-    {   // shadow debug shaders
-        compile_shader(debug_smap_shader_path, _T("VS"), _T("vs_6_0"), nullptr, 0, &render_ctx->shaders[SHADER_DEBUG_SMAP_VS]);
-        compile_shader(debug_smap_shader_path, _T("PS"), _T("ps_6_0"), nullptr, 0, &render_ctx->shaders[SHADER_DEBUG_SMAP_PS]);
-    }
-    {   // ssao debug shaders
-        compile_shader(debug_ssao_shader_path, _T("VS"), _T("vs_6_0"), nullptr, 0, &render_ctx->shaders[SHADER_DEBUG_SSAO_VS]);
-        compile_shader(debug_ssao_shader_path, _T("PS"), _T("ps_6_0"), nullptr, 0, &render_ctx->shaders[SHADER_DEBUG_SSAO_PS]);
-    }
-    {   // sky shaders
-        compile_shader(sky_shader_path, _T("VS"), _T("vs_6_0"), nullptr, 0, &render_ctx->shaders[SHADER_SKY_VS]);
-
-        compile_shader(sky_shader_path, _T("PS"), _T("ps_6_0"), nullptr, 0, &render_ctx->shaders[SHADER_SKY_PS]);
-    }
-    {   // draw normals shaders
-        compile_shader(draw_normals_shader_path, _T("VS"), _T("vs_6_0"), nullptr, 0, &render_ctx->shaders[SHADER_DRAW_NORMALS_VS]);
-
-        compile_shader(draw_normals_shader_path, _T("PS"), _T("ps_6_0"), nullptr, 0, &render_ctx->shaders[SHADER_DRAW_NORMALS_PS]);
-    }
-    {   // ssao shaders
-        compile_shader(ssao_shader_path, _T("VS"), _T("vs_6_0"), nullptr, 0, &render_ctx->shaders[SHADER_SSAO_VS]);
-
-        compile_shader(ssao_shader_path, _T("PS"), _T("ps_6_0"), nullptr, 0, &render_ctx->shaders[SHADER_SSAO_PS]);
-    }
-    {   // ssao blur shaders
-        compile_shader(ssao_blur_shader_path, _T("VS"), _T("vs_6_0"), nullptr, 0, &render_ctx->shaders[SHADER_SSAO_BLUR_VS]);
-
-        compile_shader(ssao_blur_shader_path, _T("PS"), _T("ps_6_0"), nullptr, 0, &render_ctx->shaders[SHADER_SSAO_BLUR_PS]);
+        create_upload_buffer(render_ctx->device, (UINT64)sizeof(UINT) * render_ctx->meshlet_ib_capacity, &render_ctx->frame_resources[i].meshlet_ib_ptr, &render_ctx->frame_resources[i].meshlet_ib);
     }
 #pragma endregion
 
+    // ========================================================================================================
 
-    create_pso(render_ctx);
+    // root signatures, shaders and PSOs were created by the startup tasks
     SSAO_SetPSOs(g_ssao, render_ctx->psos[LAYER_SSAO], render_ctx->psos[LAYER_SSAO_BLUR]);
 
 
@@ -3317,9 +3644,29 @@ WinMain(_In_ HINSTANCE hInstance, _In_opt_ HINSTANCE, _In_ LPSTR, _In_ INT) {
                 ImGui::Checkbox("Show Shadow Mapping Debug Window", &g_show_smap_debug);
                 ImGui::Checkbox("Show SSAO Debug Window", &g_show_ssao_debug);
 
+                ImGui::Separator();
+                ImGui::Checkbox("Enable Meshlet Culling", &g_meshlet_culling_enabled);
+                if (g_meshlet_culling_enabled) {
+                    MeshletCullStats const & cam = render_ctx->meshlet_draws[MESHLET_VIEW_CAMERA].stats;
+                    MeshletCullStats const & light = render_ctx->meshlet_draws[MESHLET_VIEW_LIGHT].stats;
+                    ImGui::Text("Camera meshlets: %u visible, %u outside frustum, %u backfacing",
+                        cam.visible, cam.frustum_culled, cam.backface_culled);
+                    ImGui::Text("Light meshlets: %u visible, %u backfacing", light.visible, light.backface_culled);
+                }
+                ImGui::Checkbox("Enable Render Item Culling", &g_ritem_culling_enabled);
+                if (g_ritem_culling_enabled)
+                    ImGui::Text("Opaque items: %u / %u in view, %u shadow casters",
+                        g_ritem_culling.camera_visible_count, g_ritem_culling.bounds.count, g_ritem_culling.caster_visible_count);
+                ImGui::Checkbox("Screen Coverage Culling", &g_coverage_culling_enabled);
+                if (g_coverage_culling_enabled) {
+                    ImGui::SliderFloat("Min Pixels", &g_coverage_min_pixels, 0.25f, 64.0f, "%.2f");
+                    ImGui::SliderFloat("Shadow Min Pixels", &g_shadow_min_pixels, 0.25f, 64.0f, "%.2f");
+                }
+
                 ImGui::Text("\n\n");
                 ImGui::Separator();
                 ImGui::Text("Application average %.3f ms/frame (%.1f FPS)", 1000.0f / ImGui::GetIO().Framerate, ImGui::GetIO().Framerate);
+                ImGui::Text("Startup: assets %.1f ms, first frame %.1f ms", g_startup_assets_ms, g_time_to_first_frame_ms);
 
                 ImGui::End();
                 ImGui::Render();
@@ -3361,11 +3708,22 @@ WinMain(_In_ HINSTANCE hInstance, _In_opt_ HINSTANCE, _In_ LPSTR, _In_ INT) {
                 update_shadow_transform(&g_timer);
                 update_shadow_pass_cb(g_smap, render_ctx, &g_timer);
                 update_ssao_cb(g_ssao, render_ctx, &g_timer);
+                if (g_ritem_culling_enabled)
+                    update_render_item_culling(render_ctx);
 
                 update_object_cbuffer(render_ctx);
+                if (g_meshlet_culling_enabled)
+                    update_meshlet_culling(render_ctx);
 
                 draw_main(render_ctx, g_smap, g_ssao);
 
+                if (0.0 == g_time_to_first_frame_ms) {
+                    int64_t now;
+                    QueryPerformanceCounter((LARGE_INTEGER *)&now);
+                    g_time_to_first_frame_ms = AssetGraph_Milliseconds(g_startup_begin, now);
+                    DBG_PRINT(_T("[startup] first frame presented after %.2f ms (startup assets %.2f ms) "), g_time_to_first_frame_ms, g_startup_assets_ms);
+                }
+
             } else {
                 Sleep(100);
             }
@@ -3391,10 +3749,12 @@ WinMain(_In_ HINSTANCE hInstance, _In_opt_ HINSTANCE, _In_ LPSTR, _In_ INT) {
         render_ctx->frame_resources[i].material_sbuffer->Unmap(0, nullptr);
         render_ctx->frame_resources[i].pass_cb->Unmap(0, nullptr);
         render_ctx->frame_resources[i].ssao_cb->Unmap(0, nullptr);
+        render_ctx->frame_resources[i].meshlet_ib->Unmap(0, nullptr);
         render_ctx->frame_resources[i].obj_cb->Release();
         render_ctx->frame_resources[i].material_sbuffer->Release();
         render_ctx->frame_resources[i].pass_cb->Release();
         render_ctx->frame_resources[i].ssao_cb->Release();
+        render_ctx->frame_resources[i].meshlet_ib->Release();
 
         render_ctx->frame_resources[i].cmd_list_alloc->Release();
     }
@@ -3406,6 +3766,7 @@ WinMain(_In_ HINSTANCE hInstance, _In_opt_ HINSTANCE, _In_ LPSTR, _In_ INT) {
         render_ctx->geom[i].vb_uploader->Release();
         render_ctx->geom[i].vb_gpu->Release();
         render_ctx->geom[i].ib_gpu->Release();
+        ::free(render_ctx->geom[i].meshlets);
     }
 
     for (int i = 0; i < _COUNT_RENDERCOMPUTE_LAYER; ++i)
@@ -0,0 +1,203 @@
+/* ===========================================================
+   #File: asset_loader.h #
+   #Date: 17 Oct 2026 #
+   #Revision: 1.0 #
+   #Creator: Omid Miresmaeili #
+   #Description: startup asset tasks run on a worker pool in dependency order #
+   #Notice: (C) Copyright 2021 by Omid. All Rights Reserved. #
+   =========================================================== */
+#pragma once
+
+#include "common.h"
+
+//
+// Asset graph
+//
+// Startup work (file I/O, parsing, mesh conditioning, shader compilation, PSO creation)
+// split into tasks with dependencies. AssetGraph_Start launches the workers and returns,
+// AssetGraph_Join waits for all of them and reports per-task and total wall times.
+// Tasks must not record GPU commands: the command list stays with the thread that joins.
+// Tasks must not show UI either: they return false on failure, and the joining thread
+// reports the tasks marked failed. Dependents of a failed task still run.
+// With 0 workers every task runs on the joining thread, in the same dependency order.
+//
+#define ASSET_GRAPH_MAX_TASKS           64
+#define ASSET_GRAPH_MAX_DEPENDENTS      48
+#define ASSET_GRAPH_MAX_WORKERS         16
+
+typedef bool (*AssetTaskFunc)(void * param);     // false if the task failed
+
+struct AssetTask {
+    char const *    name;
+    AssetTaskFunc   func;
+    void *          param;
+
+    UINT            pending;        // dependencies not finished yet
+    UINT            dependents [ASSET_GRAPH_MAX_DEPENDENTS];
+    UINT            dependent_count;
+
+    bool            failed;
+
+    // QueryPerformanceCounter ticks and the worker that ran the task
+    int64_t         begin;
+    int64_t         end;
+    UINT            worker;
+};
+struct AssetWorkerParam {
+    struct AssetGraph * graph;
+    UINT                worker;
+};
+struct AssetGraph {
+    AssetTask           tasks [ASSET_GRAPH_MAX_TASKS];
+    UINT                task_count;
+
+    // Every task is queued exactly once, so the ready queue never wraps
+    SRWLOCK             lock;
+    CONDITION_VARIABLE  ready_cv;
+    UINT                ready [ASSET_GRAPH_MAX_TASKS];
+    UINT                ready_head;
+    UINT                ready_tail;
+    UINT                finished_count;
+
+    HANDLE              workers [ASSET_GRAPH_MAX_WORKERS];
+    AssetWorkerParam    worker_params [ASSET_GRAPH_MAX_WORKERS];
+    UINT                worker_count;
+
+    int64_t             begin;
+    int64_t             end;
+};
+inline void
+AssetGraph_Init (AssetGraph * graph) {
+    memset(graph, 0, sizeof(AssetGraph));
+    InitializeSRWLock(&graph->lock);
+    InitializeConditionVariable(&graph->ready_cv);
+}
+// Returns the task id to use with AssetGraph_AddDependency
+static UINT
+AssetGraph_AddTask (AssetGraph * graph, char const * name, AssetTaskFunc func, void * param) {
+    _ASSERT_EXPR(graph->task_count < ASSET_GRAPH_MAX_TASKS, _T("Too many asset tasks"));
+    UINT id = graph->task_count++;
+    AssetTask * task = &graph->tasks[id];
+    task->name = name;
+    task->func = func;
+    task->param = param;
+    return id;
+}
+// [task] starts after [dependency] has finished
+static void
+AssetGraph_AddDependency (AssetGraph * graph, UINT task, UINT dependency) {
+    AssetTask * dep = &graph->tasks[dependency];
+    _ASSERT_EXPR(dep->dependent_count < ASSET_GRAPH_MAX_DEPENDENTS, _T("Too many dependents for an asset task"));
+    dep->dependents[dep->dependent_count++] = task;
+    ++graph->tasks[task].pending;
+}
+static void
+asset_graph_run_tasks (AssetGraph * graph, UINT worker) {
+    AcquireSRWLockExclusive(&graph->lock);
+    for (;;) {
+        while (graph->ready_head == graph->ready_tail && graph->finished_count < graph->task_count)
+            SleepConditionVariableSRW(&graph->ready_cv, &graph->lock, INFINITE, 0);
+        if (graph->ready_head == graph->ready_tail)
+            break;      // everything finished
+        AssetTask * task = &graph->tasks[graph->ready[graph->ready_head++]];
+        ReleaseSRWLockExclusive(&graph->lock);
+
+        QueryPerformanceCounter((LARGE_INTEGER *)&task->begin);
+        task->failed = !task->func(task->param);
+        QueryPerformanceCounter((LARGE_INTEGER *)&task->end);
+        task->worker = worker;
+
+        AcquireSRWLockExclusive(&graph->lock);
+        ++graph->finished_count;
+        for (UINT i = 0; i < task->dependent_count; ++i)
+            if (0 == --graph->tasks[task->dependents[i]].pending)
+                graph->ready[graph->ready_tail++] = task->dependents[i];
+        WakeAllConditionVariable(&graph->ready_cv);
+    }
+    ReleaseSRWLockExclusive(&graph->lock);
+}
+// Kahn's algorithm on a copy of the pending counts: false if some task could never start
+static bool
+asset_graph_is_acyclic (AssetGraph const * graph) {
+    UINT pending [ASSET_GRAPH_MAX_TASKS];
+    UINT queue [ASSET_GRAPH_MAX_TASKS];
+    UINT head = 0, tail = 0;
+    for (UINT i = 0; i < graph->task_count; ++i) {
+        pending[i] = graph->tasks[i].pending;
+        if (0 == pending[i])
+            queue[tail++] = i;
+    }
+    while (head < tail) {
+        AssetTask const * task = &graph->tasks[queue[head++]];
+        for (UINT i = 0; i < task->dependent_count; ++i)
+            if (0 == --pending[task->dependents[i]])
+                queue[tail++] = task->dependents[i];
+    }
+    return tail == graph->task_count;
+}
+static DWORD WINAPI
+asset_worker (LPVOID param) {
+    AssetWorkerParam * p = (AssetWorkerParam *)param;
+    asset_graph_run_tasks(p->graph, p->worker);
+    return 0;
+}
+// Queues the tasks without dependencies and launches [n_workers] threads (none: run at join)
+static void
+AssetGraph_Start (AssetGraph * graph, UINT n_workers) {
+    _ASSERT_EXPR(asset_graph_is_acyclic(graph), _T("Asset graph has a dependency cycle"));
+
+    QueryPerformanceCounter((LARGE_INTEGER *)&graph->begin);
+    for (UINT i = 0; i < graph->task_count; ++i)
+        if (0 == graph->tasks[i].pending)
+            graph->ready[graph->ready_tail++] = i;
+
+    if (n_workers > ASSET_GRAPH_MAX_WORKERS)
+        n_workers = ASSET_GRAPH_MAX_WORKERS;
+    for (UINT i = 0; i < n_workers; ++i) {
+        graph->worker_params[i] = {.graph = graph, .worker = i + 1};
+        HANDLE t = CreateThread(nullptr, 0, asset_worker, &graph->worker_params[i], 0, nullptr);
+        if (t) graph->workers[graph->worker_count++] = t;
+    }
+}
+static void
+asset_graph_report (AssetGraph * graph) {
+    int64_t count_per_sec;
+    QueryPerformanceFrequency((LARGE_INTEGER *)&count_per_sec);
+    double ms_per_count = 1000.0 / (double)count_per_sec;
+
+    char buf[256];
+    double task_sum = 0.0;
+    for (UINT i = 0; i < graph->task_count; ++i) {
+        AssetTask * task = &graph->tasks[i];
+        double ms = (double)(task->end - task->begin) * ms_per_count;
+        task_sum += ms;
+        sprintf_s(buf, sizeof(buf), "[startup] %-24s %8.2f ms (at %8.2f ms, worker %u)%s\n",
+            task->name, ms, (double)(task->begin - graph->begin) * ms_per_count, task->worker, task->failed ? " FAILED" : "");
+        ::OutputDebugStringA(buf);
+    }
+    sprintf_s(buf, sizeof(buf), "[startup] %u tasks on %u worker(s): %.2f ms wall, %.2f ms of work\n",
+        graph->task_count, graph->worker_count ? graph->worker_count : 1,
+        (double)(graph->end - graph->begin) * ms_per_count, task_sum);
+    ::OutputDebugStringA(buf);
+}
+// The single join point: returns once every task has run, with the results visible to the caller
+static void
+AssetGraph_Join (AssetGraph * graph) {
+    if (graph->worker_count > 0) {
+        WaitForMultipleObjects(graph->worker_count, graph->workers, TRUE, INFINITE);
+        for (UINT i = 0; i < graph->worker_count; ++i)
+            CloseHandle(graph->workers[i]);
+    } else {
+        asset_graph_run_tasks(graph, 0);
+    }
+    QueryPerformanceCounter((LARGE_INTEGER *)&graph->end);
+
+    asset_graph_report(graph);
+}
+// Elapsed milliseconds between two QueryPerformanceCounter values
+inline double
+AssetGraph_Milliseconds (int64_t begin, int64_t end) {
+    int64_t count_per_sec;
+    QueryPerformanceFrequency((LARGE_INTEGER *)&count_per_sec);
+    return (double)(end - begin) * 1000.0 / (double)count_per_sec;
+}
@@ -0,0 +1,703 @@
+/* ===========================================================
+   #File: mesh_loader.h #
+   #Date: 17 Oct 2026 #
+   #Revision: 1.0 #
+   #Creator: Omid Miresmaeili #
+   #Description: Text mesh loader and binary mesh cache #
+   #Notice: (C) Copyright 2021 by Omid. All Rights Reserved. #
+   =========================================================== */
+#pragma once
+
+#include "common.h"
+#include "mesh_optimizer.h"
+#include "mesh_conditioning.h"
+
+using namespace DirectX;
+
+//
+// Binary mesh cache
+//
+// The text models (VertexCount:/TriangleCount:/VertexList/TriangleList) are parsed
+// once and the final vertex/index arrays are written to a binary file next to them.
+// Later runs memory-map that file and use the arrays in place (no parsing at all).
+//
+// File layout:
+//    [MeshCacheHeader][pad][vertices (vertex_stride * vertex_count)][pad][uint32 indices]
+// Both arrays start at 16-byte aligned offsets.
+//
+#define MESH_CACHE_MAGIC        0x4853454d  // 'MESH'
+#define MESH_CACHE_VERSION      4       // v4: welded vertices; v3: vertex cache, overdraw and vertex fetch optimized
+#define MESH_CACHE_ALIGNMENT    16
+
+struct MeshCacheHeader {
+    uint32_t magic;
+    uint32_t version;
+
+    uint32_t vertex_stride;
+    uint32_t vertex_count;
+    uint32_t index_stride;
+    uint32_t index_count;
+
+    uint64_t vertex_offset;
+    uint64_t index_offset;
+
+    // size and last-write time of the source text file, a mismatch invalidates the cache
+    uint64_t src_size;
+    uint64_t src_write_time;
+
+    // precomputed SubmeshGeometry::bounds
+    DirectX::XMFLOAT3 bounds_center;
+    DirectX::XMFLOAT3 bounds_extents;
+};
+
+// Raw contents of a text model (positions, normals and triangle list)
+struct TextMesh {
+    UINT vertex_count;
+    UINT index_count;
+
+    DirectX::XMFLOAT3 * positions;
+    DirectX::XMFLOAT3 * normals;
+    uint32_t * indices;
+
+    DirectX::BoundingBox bounds;
+};
+
+// Read-only view of a loaded mesh.
+// Data is either backed by a file mapping, or by heap memory when the cache couldn't be written.
+struct MeshCacheView {
+    void const * vertices;
+    uint32_t const * indices;
+
+    UINT vertex_stride;
+    UINT vertex_count;
+    UINT index_count;
+
+    DirectX::BoundingBox bounds;
+
+    HANDLE file;
+    HANDLE mapping;
+    void * mapped_ptr;
+
+    void * heap_vertices;
+    uint32_t * heap_indices;
+};
+
+// Fills [out_vertices] (vertex_count elements of the demo's own Vertex layout) from the text model
+typedef void (*MeshVertexBuilder) (TextMesh const * src, void * out_vertices);
+
+inline uint64_t
+mesh_cache_align (uint64_t offset) {
+    return (offset + (MESH_CACHE_ALIGNMENT - 1)) & ~(uint64_t)(MESH_CACHE_ALIGNMENT - 1);
+}
+static bool
+get_file_stamp (char const * path, uint64_t * out_size, uint64_t * out_write_time) {
+    WIN32_FILE_ATTRIBUTE_DATA attribs = {};
+    if (!GetFileAttributesExA(path, GetFileExInfoStandard, &attribs))
+        return false;
+    *out_size = ((uint64_t)attribs.nFileSizeHigh << 32) | attribs.nFileSizeLow;
+    *out_write_time = ((uint64_t)attribs.ftLastWriteTime.dwHighDateTime << 32) | attribs.ftLastWriteTime.dwLowDateTime;
+    return true;
+}
+static void
+TextMesh_Free (TextMesh * mesh) {
+    ::free(mesh->positions);
+    ::free(mesh->normals);
+    ::free(mesh->indices);
+    mesh->positions = nullptr;
+    mesh->normals = nullptr;
+    mesh->indices = nullptr;
+}
+// Reference line-by-line parser (fgets + sscanf_s), kept for benchmarking TextMesh_Load
+static bool
+TextMesh_LoadSerial (char const * path, TextMesh * out_mesh) {
+    FILE * f = nullptr;
+    errno_t err = fopen_s(&f, path, "r");
+    if (0 == f || err != 0)
+        return false;
+
+    char linebuf[100];
+    int cnt = 0;
+    unsigned vcount = 0;
+    unsigned tcount = 0;
+    // -- read 1st line
+    if (fgets(linebuf, sizeof(linebuf), f))
+        cnt = sscanf_s(linebuf, "%*s %d", &vcount);
+    if (cnt != 1) {
+        fclose(f);
+        return false;
+    }
+    // -- read 2nd line
+    cnt = 0;
+    if (fgets(linebuf, sizeof(linebuf), f))
+        cnt = sscanf_s(linebuf, "%*s %d", &tcount);
+    if (cnt != 1) {
+        fclose(f);
+        return false;
+    }
+    // -- skip two lines
+    fgets(linebuf, sizeof(linebuf), f);
+    fgets(linebuf, sizeof(linebuf), f);
+
+    out_mesh->vertex_count = vcount;
+    out_mesh->index_count = tcount * 3;
+    out_mesh->positions = (XMFLOAT3 *)::malloc(sizeof(XMFLOAT3) * vcount);
+    out_mesh->normals = (XMFLOAT3 *)::malloc(sizeof(XMFLOAT3) * vcount);
+    out_mesh->indices = (uint32_t *)::malloc(sizeof(uint32_t) * out_mesh->index_count);
+
+    // -- vmin and vmax for AABB construction
+    XMFLOAT3 vminf3(+FLT_MAX, +FLT_MAX, +FLT_MAX);
+    XMFLOAT3 vmaxf3(-FLT_MAX, -FLT_MAX, -FLT_MAX);
+
+    XMVECTOR vmin = XMLoadFloat3(&vminf3);
+    XMVECTOR vmax = XMLoadFloat3(&vmaxf3);
+
+    // -- read vertices
+    for (unsigned i = 0; i < vcount; i++) {
+        fgets(linebuf, sizeof(linebuf), f);
+        cnt = sscanf_s(
+            linebuf, "%f %f %f %f %f %f",
+            &out_mesh->positions[i].x, &out_mesh->positions[i].y, &out_mesh->positions[i].z,
+            &out_mesh->normals[i].x, &out_mesh->normals[i].y, &out_mesh->normals[i].z
+        );
+        if (cnt != 6) {
+            TextMesh_Free(out_mesh);
+            fclose(f);
+            return false;
+        }
+
+        // -- calculate vmin, vmax
+        XMVECTOR P = XMLoadFloat3(&out_mesh->positions[i]);
+        vmin = XMVectorMin(vmin, P);
+        vmax = XMVectorMax(vmax, P);
+    }
+
+    // -- construct bounding box (AABB)
+    XMStoreFloat3(&out_mesh->bounds.Center, 0.5f * (vmin + vmax));
+    XMStoreFloat3(&out_mesh->bounds.Extents, 0.5f * (vmax - vmin));
+
+    // -- skip three lines
+    fgets(linebuf, sizeof(linebuf), f);
+    fgets(linebuf, sizeof(linebuf), f);
+    fgets(linebuf, sizeof(linebuf), f);
+    // -- read indices
+    for (unsigned i = 0; i < tcount; i++) {
+        fgets(linebuf, sizeof(linebuf), f);
+        cnt = sscanf_s(
+            linebuf, "%d %d %d",
+            &out_mesh->indices[i * 3 + 0], &out_mesh->indices[i * 3 + 1], &out_mesh->indices[i * 3 + 2]
+        );
+        if (cnt != 3) {
+            TextMesh_Free(out_mesh);
+            fclose(f);
+            return false;
+        }
+    }
+
+    fclose(f);
+    return true;
+}
+//
+// Parallel text mesh parser
+//
+// The whole file is read at once, the vertex and triangle sections are split into chunks
+// on newline boundaries and the chunks are parsed on all cores in two passes:
+//   1. count the records (non-blank lines) of each chunk -> prefix sum gives each chunk's first record
+//   2. parse numbers straight into the output arrays, plus a per-chunk AABB for the vertex chunks
+//
+#define MESH_PARSE_MAX_THREADS      64
+#define MESH_PARSE_MIN_CHUNK_SIZE   (16 * 1024)
+
+enum MESH_CHUNK_KIND {
+    MESH_CHUNK_VERTICES = 0,
+    MESH_CHUNK_TRIANGLES = 1
+};
+struct MeshParseChunk {
+    char const * begin;
+    char const * end;
+    MESH_CHUNK_KIND kind;
+
+    UINT first_record;
+    UINT record_count;
+
+    XMFLOAT3 vmin;
+    XMFLOAT3 vmax;
+    bool ok;
+};
+struct MeshParseContext {
+    MeshParseChunk * chunks;
+    UINT chunk_count;
+    volatile LONG next_chunk;
+
+    TextMesh * mesh;
+    void (*process) (MeshParseContext * ctx, MeshParseChunk * chunk);
+};
+
+inline bool
+is_blank_char (char c) {
+    return ' ' == c || '\t' == c || '\r' == c || '\n' == c;
+}
+// Locale-free decimal parser: [+-]digits[.digits][(e|E)[+-]digits]
+// Keeps up to 19 significant digits in an integer mantissa and scales once in double precision.
+static char const *
+parse_float_fast (char const * p, char const * end, float * out) {
+    static double const pow10[] = {
+        1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10,
+        1e11, 1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+    };
+    while (p < end && (' ' == *p || '\t' == *p)) ++p;
+
+    bool neg = false;
+    if (p < end && ('-' == *p || '+' == *p)) {
+        neg = '-' == *p;
+        ++p;
+    }
+    uint64_t mantissa = 0;
+    int n_digits = 0;
+    int exp10 = 0;
+    bool any_digit = false;
+    for (; p < end && (unsigned)(*p - '0') < 10; ++p) {
+        if (n_digits < 19) {
+            mantissa = mantissa * 10 + (*p - '0');
+            n_digits += (mantissa != 0);
+        } else {
+            ++exp10;
+        }
+        any_digit = true;
+    }
+    if (p < end && '.' == *p) {
+        for (++p; p < end && (unsigned)(*p - '0') < 10; ++p) {
+            if (n_digits < 19) {
+                mantissa = mantissa * 10 + (*p - '0');
+                n_digits += (mantissa != 0);
+                --exp10;
+            }
+            any_digit = true;
+        }
+    }
+    if (!any_digit)
+        return nullptr;
+    if (p < end && ('e' == *p || 'E' == *p)) {
+        ++p;
+        bool exp_neg = false;
+        if (p < end && ('-' == *p || '+' == *p)) {
+            exp_neg = '-' == *p;
+            ++p;
+        }
+        int e = 0;
+        for (; p < end && (unsigned)(*p - '0') < 10; ++p)
+            if (e < 1000) e = e * 10 + (*p - '0');
+        exp10 += exp_neg ? -e : e;
+    }
+
+    double v = (double)mantissa;
+    if (exp10 < 0) {
+        for (; exp10 < -22; exp10 += 22) v /= 1e22;
+        v /= pow10[-exp10];
+    } else {
+        for (; exp10 > 22; exp10 -= 22) v *= 1e22;
+        v *= pow10[exp10];
+    }
+    *out = (float)(neg ? -v : v);
+    return p;
+}
+static char const *
+parse_uint_fast (char const * p, char const * end, uint32_t * out) {
+    while (p < end && (' ' == *p || '\t' == *p)) ++p;
+    if (p >= end || (unsigned)(*p - '0') >= 10)
+        return nullptr;
+    uint64_t v = 0;
+    for (; p < end && (unsigned)(*p - '0') < 10; ++p)
+        v = v * 10 + (*p - '0');
+    if (v > UINT32_MAX)
+        return nullptr;
+    *out = (uint32_t)v;
+    return p;
+}
+// Returns the start of the next line, or [end]
+inline char const *
+next_line (char const * p, char const * end) {
+    char const * nl = (char const *)memchr(p, '\n', end - p);
+    return nl ? nl + 1 : end;
+}
+// true if [line, line_end) holds anything but whitespace
+inline bool
+is_record_line (char const * line, char const * line_end) {
+    for (; line < line_end; ++line)
+        if (!is_blank_char(*line)) return true;
+    return false;
+}
+static void
+count_chunk_records (MeshParseContext *, MeshParseChunk * chunk) {
+    UINT n = 0;
+    for (char const * line = chunk->begin; line < chunk->end;) {
+        char const * line_end = next_line(line, chunk->end);
+        n += is_record_line(line, line_end);
+        line = line_end;
+    }
+    chunk->record_count = n;
+}
+static void
+parse_chunk_records (MeshParseContext * ctx, MeshParseChunk * chunk) {
+    TextMesh * mesh = ctx->mesh;
+    float vmin[3] = {+FLT_MAX, +FLT_MAX, +FLT_MAX};
+    float vmax[3] = {-FLT_MAX, -FLT_MAX, -FLT_MAX};
+    UINT record = chunk->first_record;
+    chunk->ok = true;
+
+    for (char const * line = chunk->begin; line < chunk->end && chunk->ok;) {
+        char const * line_end = next_line(line, chunk->end);
+        if (!is_record_line(line, line_end)) {
+            line = line_end;
+            continue;
+        }
+        char const * p = line;
+        if (MESH_CHUNK_VERTICES == chunk->kind) {
+            float v[6];
+            for (int k = 0; k < 6 && p; ++k)
+                p = parse_float_fast(p, line_end, &v[k]);
+            if (nullptr == p) {
+                chunk->ok = false;
+                break;
+            }
+            mesh->positions[record] = XMFLOAT3(v[0], v[1], v[2]);
+            mesh->normals[record] = XMFLOAT3(v[3], v[4], v[5]);
+            for (int k = 0; k < 3; ++k) {
+                vmin[k] = v[k] < vmin[k] ? v[k] : vmin[k];
+                vmax[k] = v[k] > vmax[k] ? v[k] : vmax[k];
+            }
+        } else {
+            uint32_t * tri = &mesh->indices[record * 3];
+            for (int k = 0; k < 3 && p; ++k)
+                p = parse_uint_fast(p, line_end, &tri[k]);
+            if (nullptr == p || tri[0] >= mesh->vertex_count || tri[1] >= mesh->vertex_count || tri[2] >= mesh->vertex_count) {
+                chunk->ok = false;
+                break;
+            }
+        }
+        ++record;
+        line = line_end;
+    }
+    chunk->vmin = XMFLOAT3(vmin[0], vmin[1], vmin[2]);
+    chunk->vmax = XMFLOAT3(vmax[0], vmax[1], vmax[2]);
+}
+static DWORD WINAPI
+mesh_parse_worker (LPVOID param) {
+    MeshParseContext * ctx = (MeshParseContext *)param;
+    for (;;) {
+        LONG i = InterlockedIncrement(&ctx->next_chunk) - 1;
+        if (i >= (LONG)ctx->chunk_count)
+            break;
+        ctx->process(ctx, &ctx->chunks[i]);
+    }
+    return 0;
+}
+// Runs ctx->process over all chunks, the calling thread participates as well
+static void
+run_mesh_parse_pass (MeshParseContext * ctx, UINT n_threads) {
+    HANDLE threads[MESH_PARSE_MAX_THREADS];
+    UINT n_spawned = 0;
+    ctx->next_chunk = 0;
+    for (UINT i = 1; i < n_threads; ++i) {
+        HANDLE t = CreateThread(nullptr, 0, mesh_parse_worker, ctx, 0, nullptr);
+        if (t) threads[n_spawned++] = t;
+    }
+    mesh_parse_worker(ctx);
+    if (n_spawned > 0)
+        WaitForMultipleObjects(n_spawned, threads, TRUE, INFINITE);
+    for (UINT i = 0; i < n_spawned; ++i)
+        CloseHandle(threads[i]);
+}
+// Finds [token] and returns the position right after it, or nullptr
+static char const *
+find_token (char const * p, char const * end, char const * token) {
+    size_t len = strlen(token);
+    for (; p + len <= end; ++p) {
+        p = (char const *)memchr(p, token[0], end - p);
+        if (nullptr == p || p + len > end)
+            return nullptr;
+        if (0 == memcmp(p, token, len))
+            return p + len;
+    }
+    return nullptr;
+}
+// Splits [begin, end) into up to [n] chunks starting on line boundaries
+static UINT
+split_mesh_section (char const * begin, char const * end, MESH_CHUNK_KIND kind, UINT n, MeshParseChunk * out_chunks) {
+    size_t size = end - begin;
+    if (n > size / MESH_PARSE_MIN_CHUNK_SIZE)
+        n = (UINT)(size / MESH_PARSE_MIN_CHUNK_SIZE);
+    if (n < 1)
+        n = 1;
+    UINT cnt = 0;
+    char const * chunk_begin = begin;
+    for (UINT i = 1; i <= n && chunk_begin < end; ++i) {
+        char const * chunk_end = (i == n) ? end : next_line(begin + size * i / n, end);
+        if (chunk_end <= chunk_begin)
+            continue;
+        out_chunks[cnt] = {};
+        out_chunks[cnt].begin = chunk_begin;
+        out_chunks[cnt].end = chunk_end;
+        out_chunks[cnt].kind = kind;
+        ++cnt;
+        chunk_begin = chunk_end;
+    }
+    return cnt;
+}
+static bool
+TextMesh_Load (char const * path, TextMesh * out_mesh) {
+    *out_mesh = {};
+
+    // -- read the whole file at once
+    FILE * f = nullptr;
+    errno_t err = fopen_s(&f, path, "rb");
+    if (0 == f || err != 0)
+        return false;
+    fseek(f, 0, SEEK_END);
+    long file_size = ftell(f);
+    fseek(f, 0, SEEK_SET);
+    if (file_size <= 0) {
+        fclose(f);
+        return false;
+    }
+    char * data = (char *)::malloc((size_t)file_size);
+    size_t n_read = fread(data, 1, (size_t)file_size, f);
+    fclose(f);
+    char const * end = data + n_read;
+
+    // -- header and section bounds
+    uint32_t vcount = 0;
+    uint32_t tcount = 0;
+    char const * p = find_token(data, end, "VertexCount:");
+    p = p ? parse_uint_fast(p, end, &vcount) : nullptr;
+    p = p ? find_token(p, end, "TriangleCount:") : nullptr;
+    p = p ? parse_uint_fast(p, end, &tcount) : nullptr;
+    char const * vbegin = p ? find_token(p, end, "{") : nullptr;
+    char const * vend = vbegin ? find_token(vbegin, end, "}") : nullptr;
+    char const * tbegin = vend ? find_token(vend, end, "{") : nullptr;
+    char const * tend = tbegin ? find_token(tbegin, end, "}") : nullptr;
+    if (nullptr == tend) {
+        ::free(data);
+        return false;
+    }
+    --vend;     // exclude the closing braces
+    --tend;
+
+    out_mesh->vertex_count = vcount;
+    out_mesh->index_count = tcount * 3;
+    out_mesh->positions = (XMFLOAT3 *)::malloc(sizeof(XMFLOAT3) * vcount);
+    out_mesh->normals = (XMFLOAT3 *)::malloc(sizeof(XMFLOAT3) * vcount);
+    out_mesh->indices = (uint32_t *)::malloc(sizeof(uint32_t) * out_mesh->index_count);
+
+    // -- chunk both sections
+    SYSTEM_INFO sys_info = {};
+    GetSystemInfo(&sys_info);
+    UINT n_threads = sys_info.dwNumberOfProcessors;
+    if (n_threads < 1)
+        n_threads = 1;
+    if (n_threads > MESH_PARSE_MAX_THREADS)
+        n_threads = MESH_PARSE_MAX_THREADS;
+
+    MeshParseChunk chunks[2 * MESH_PARSE_MAX_THREADS];
+    UINT n_chunks = split_mesh_section(vbegin, vend, MESH_CHUNK_VERTICES, n_threads, chunks);
+    n_chunks += split_mesh_section(tbegin, tend, MESH_CHUNK_TRIANGLES, n_threads, chunks + n_chunks);
+
+    MeshParseContext ctx = {};
+    ctx.chunks = chunks;
+    ctx.chunk_count = n_chunks;
+    ctx.mesh = out_mesh;
+
+    // -- pass 1: count records, then prefix sum per section
+    ctx.process = count_chunk_records;
+    run_mesh_parse_pass(&ctx, n_threads);
+
+    UINT n_records[2] = {};
+    for (UINT i = 0; i < n_chunks; ++i) {
+        chunks[i].first_record = n_records[chunks[i].kind];
+        n_records[chunks[i].kind] += chunks[i].record_count;
+    }
+    bool ok = (vcount == n_records[MESH_CHUNK_VERTICES]) && (tcount == n_records[MESH_CHUNK_TRIANGLES]);
+
+    // -- pass 2: parse numbers, then reduce per-chunk AABBs
+    if (ok) {
+        ctx.process = parse_chunk_records;
+        run_mesh_parse_pass(&ctx, n_threads);
+    }
+    XMFLOAT3 vminf3(+FLT_MAX, +FLT_MAX, +FLT_MAX);
+    XMFLOAT3 vmaxf3(-FLT_MAX, -FLT_MAX, -FLT_MAX);
+    XMVECTOR vmin = XMLoadFloat3(&vminf3);
+    XMVECTOR vmax = XMLoadFloat3(&vmaxf3);
+    for (UINT i = 0; i < n_chunks && ok; ++i) {
+        ok = chunks[i].ok;
+        if (MESH_CHUNK_VERTICES == chunks[i].kind) {
+            vmin = XMVectorMin(vmin, XMLoadFloat3(&chunks[i].vmin));
+            vmax = XMVectorMax(vmax, XMLoadFloat3(&chunks[i].vmax));
+        }
+    }
+    ::free(data);
+    if (!ok) {
+        TextMesh_Free(out_mesh);
+        return false;
+    }
+
+    // -- construct bounding box (AABB)
+    XMStoreFloat3(&out_mesh->bounds.Center, 0.5f * (vmin + vmax));
+    XMStoreFloat3(&out_mesh->bounds.Extents, 0.5f * (vmax - vmin));
+    return true;
+}
+static bool
+MeshCache_Write (
+    char const * cache_path, char const * src_path,
+    void const * vertices, UINT vertex_stride, UINT vertex_count,
+    uint32_t const * indices, UINT index_count,
+    DirectX::BoundingBox const * bounds
+) {
+    MeshCacheHeader header = {};
+    header.magic = MESH_CACHE_MAGIC;
+    header.version = MESH_CACHE_VERSION;
+    header.vertex_stride = vertex_stride;
+    header.vertex_count = vertex_count;
+    header.index_stride = sizeof(uint32_t);
+    header.index_count = index_count;
+    header.vertex_offset = mesh_cache_align(sizeof(MeshCacheHeader));
+    header.index_offset = mesh_cache_align(header.vertex_offset + (uint64_t)vertex_stride * vertex_count);
+    header.bounds_center = bounds->Center;
+    header.bounds_extents = bounds->Extents;
+    if (!get_file_stamp(src_path, &header.src_size, &header.src_write_time))
+        return false;
+
+    // -- write to a temp file first so a half-written cache never gets mapped
+    char tmp_path[MAX_PATH];
+    sprintf_s(tmp_path, "%s.tmp", cache_path);
+    HANDLE file = CreateFileA(tmp_path, GENERIC_WRITE, 0, nullptr, CREATE_ALWAYS, FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (INVALID_HANDLE_VALUE == file)
+        return false;
+
+    BYTE padding[MESH_CACHE_ALIGNMENT] = {};
+    DWORD vb_byte_size = vertex_stride * vertex_count;
+    DWORD ib_byte_size = sizeof(uint32_t) * index_count;
+    DWORD pad0 = (DWORD)(header.vertex_offset - sizeof(MeshCacheHeader));
+    DWORD pad1 = (DWORD)(header.index_offset - header.vertex_offset - vb_byte_size);
+    DWORD written = 0;
+    bool ok =
+        WriteFile(file, &header, sizeof(header), &written, nullptr) &&
+        WriteFile(file, padding, pad0, &written, nullptr) &&
+        WriteFile(file, vertices, vb_byte_size, &written, nullptr) &&
+        WriteFile(file, padding, pad1, &written, nullptr) &&
+        WriteFile(file, indices, ib_byte_size, &written, nullptr);
+    CloseHandle(file);
+
+    if (ok)
+        ok = MoveFileExA(tmp_path, cache_path, MOVEFILE_REPLACE_EXISTING);
+    if (!ok)
+        DeleteFileA(tmp_path);
+    return ok;
+}
+static void
+MeshCache_Release (MeshCacheView * view) {
+    if (view->mapped_ptr)
+        UnmapViewOfFile(view->mapped_ptr);
+    if (view->mapping)
+        CloseHandle(view->mapping);
+    if (view->file && INVALID_HANDLE_VALUE != view->file)
+        CloseHandle(view->file);
+    ::free(view->heap_vertices);
+    ::free(view->heap_indices);
+    *view = {};
+}
+// Maps an existing cache file.
+// Fails if the file is missing, malformed, built for another vertex layout, or older than the source text.
+// If the source text is not shipped (kiosk builds) the cache is trusted as is.
+static bool
+MeshCache_Map (char const * cache_path, char const * src_path, UINT vertex_stride, MeshCacheView * out_view) {
+    *out_view = {};
+    out_view->file = CreateFileA(cache_path, GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+    if (INVALID_HANDLE_VALUE == out_view->file) {
+        out_view->file = nullptr;
+        return false;
+    }
+    LARGE_INTEGER file_size = {};
+    if (!GetFileSizeEx(out_view->file, &file_size) || file_size.QuadPart < (LONGLONG)sizeof(MeshCacheHeader)) {
+        MeshCache_Release(out_view);
+        return false;
+    }
+    out_view->mapping = CreateFileMappingA(out_view->file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    if (nullptr == out_view->mapping) {
+        MeshCache_Release(out_view);
+        return false;
+    }
+    out_view->mapped_ptr = MapViewOfFile(out_view->mapping, FILE_MAP_READ, 0, 0, 0);
+    if (nullptr == out_view->mapped_ptr) {
+        MeshCache_Release(out_view);
+        return false;
+    }
+
+    // -- validate header
+    MeshCacheHeader const * header = (MeshCacheHeader const *)out_view->mapped_ptr;
+    uint64_t src_size = 0;
+    uint64_t src_write_time = 0;
+    bool valid =
+        MESH_CACHE_MAGIC == header->magic &&
+        MESH_CACHE_VERSION == header->version &&
+        vertex_stride == header->vertex_stride &&
+        sizeof(uint32_t) == header->index_stride &&
+        header->vertex_offset + (uint64_t)header->vertex_stride * header->vertex_count <= header->index_offset &&
+        header->index_offset + (uint64_t)header->index_stride * header->index_count <= (uint64_t)file_size.QuadPart;
+    if (valid && get_file_stamp(src_path, &src_size, &src_write_time))
+        valid = (src_size == header->src_size) && (src_write_time == header->src_write_time);
+    if (!valid) {
+        MeshCache_Release(out_view);
+        return false;
+    }
+
+    BYTE const * base = (BYTE const *)out_view->mapped_ptr;
+    out_view->vertices = base + header->vertex_offset;
+    out_view->indices = (uint32_t const *)(base + header->index_offset);
+    out_view->vertex_stride = header->vertex_stride;
+    out_view->vertex_count = header->vertex_count;
+    out_view->index_count = header->index_count;
+    out_view->bounds.Center = header->bounds_center;
+    out_view->bounds.Extents = header->bounds_extents;
+    return true;
+}
+// Maps [cache_path] if it is up-to-date, otherwise parses [src_path],
+// builds the vertices via [build_vertices] and (re)writes the cache.
+static bool
+load_mesh_cached (
+    char const * cache_path, char const * src_path, UINT vertex_stride,
+    MeshVertexBuilder build_vertices, MeshCacheView * out_view
+) {
+    if (MeshCache_Map(cache_path, src_path, vertex_stride, out_view))
+        return true;
+
+    TextMesh txt = {};
+    if (!TextMesh_Load(src_path, &txt))
+        return false;
+
+    void * vertices = ::calloc(txt.vertex_count, vertex_stride);
+    build_vertices(&txt, vertices);
+
+    // the cache stores the welded and optimized mesh, so this only runs when the cache is (re)built
+    UINT vertex_count = weld_mesh(src_path, vertices, txt.vertex_count, vertex_stride, txt.indices, txt.index_count);
+    optimize_vertex_cache_and_report(src_path, txt.indices, txt.index_count, vertex_count);
+    optimize_overdraw_and_fetch(src_path, vertices, vertex_stride, vertex_count, txt.indices, txt.index_count);
+
+    bool cached =
+        MeshCache_Write(cache_path, src_path, vertices, vertex_stride, vertex_count, txt.indices, txt.index_count, &txt.bounds) &&
+        MeshCache_Map(cache_path, src_path, vertex_stride, out_view);
+    if (cached) {
+        ::free(vertices);
+    } else {
+        // e.g., read-only models directory: keep going with the freshly built arrays
+        out_view->heap_vertices = vertices;
+        out_view->heap_indices = txt.indices;
+        out_view->vertices = vertices;
+        out_view->indices = txt.indices;
+        out_view->vertex_stride = vertex_stride;
+        out_view->vertex_count = vertex_count;
+        out_view->index_count = txt.index_count;
+        out_view->bounds = txt.bounds;
+        txt.indices = nullptr;
+    }
+    TextMesh_Free(&txt);
+    return true;
+}
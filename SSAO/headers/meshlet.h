@@ -0,0 +1,403 @@
+/* ===========================================================
+   #File: meshlet.h #
+   #Date: 17 Oct 2026 #
+   #Revision: 1.0 #
+   #Creator: Omid Miresmaeili #
+   #Description: meshlet partitioning, bounds and CPU cluster culling #
+   #Notice: (C) Copyright 2021 by Omid. All Rights Reserved. #
+   =========================================================== */
+#pragma once
+
+#include "common.h"
+#include "mesh_geometry.h"
+#include "mesh_optimizer.h"
+
+using namespace DirectX;
+
+//
+// Meshlets
+//
+// A submesh is split into clusters of at most MESHLET_MAX_VERTICES unique vertices
+// and MESHLET_MAX_TRIANGLES triangles. The index buffer is reordered so the triangles
+// of a meshlet are contiguous, so a meshlet is simply an index range that can be
+// culled as a whole (bounding sphere vs. frustum, normal cone vs. view point).
+// Reference: Zeux, meshoptimizer "buildMeshlets" and "computeMeshletBounds"
+//
+#define MESHLET_MAX_VERTICES    64
+#define MESHLET_MAX_TRIANGLES   124
+#define MESHLET_CONE_MIN_DOT    0.1f    // cones wider than acos(0.1) ~84 deg are not worth testing
+#define MESHLET_CONE_WEIGHT     0.75f    // 0: most compact meshlets, 1: tightest normal cones
+
+struct MeshletCullStats {
+    UINT visible;
+    UINT frustum_culled;
+    UINT backface_culled;
+};
+
+// Upper bound on the number of meshlets build_meshlets can produce: a meshlet is only
+// closed when the next triangle doesn't fit, i.e. with at least MESHLET_MAX_VERTICES - 2
+// vertices or MESHLET_MAX_TRIANGLES triangles
+inline UINT
+meshlet_bound (UINT index_count) {
+    UINT by_vertices = (index_count + MESHLET_MAX_VERTICES - 3) / (MESHLET_MAX_VERTICES - 2);
+    UINT by_triangles = (index_count / 3 + MESHLET_MAX_TRIANGLES - 1) / MESHLET_MAX_TRIANGLES;
+    return by_vertices > by_triangles ? by_vertices : by_triangles;
+}
+inline XMFLOAT3
+triangle_normal (XMFLOAT3 const * p0, XMFLOAT3 const * p1, XMFLOAT3 const * p2) {
+    XMFLOAT3 e1 = {p1->x - p0->x, p1->y - p0->y, p1->z - p0->z};
+    XMFLOAT3 e2 = {p2->x - p0->x, p2->y - p0->y, p2->z - p0->z};
+    return XMFLOAT3(e1.y * e2.z - e1.z * e2.y, e1.z * e2.x - e1.x * e2.z, e1.x * e2.y - e1.y * e2.x);
+}
+// Bounding sphere (around the AABB center) and normal cone of one meshlet
+template <typename T> static void
+compute_meshlet_bounds (Meshlet * meshlet, T const * indices, void const * vertices, UINT vertex_stride) {
+    T const * tris = indices + meshlet->start_index_location;
+    UINT tri_count = meshlet->index_count / 3;
+
+    XMFLOAT3 vmin = {FLT_MAX, FLT_MAX, FLT_MAX};
+    XMFLOAT3 vmax = {-FLT_MAX, -FLT_MAX, -FLT_MAX};
+    for (UINT i = 0; i < meshlet->index_count; ++i) {
+        XMFLOAT3 const * p = vertex_position(vertices, vertex_stride, tris[i]);
+        vmin = XMFLOAT3(fminf(vmin.x, p->x), fminf(vmin.y, p->y), fminf(vmin.z, p->z));
+        vmax = XMFLOAT3(fmaxf(vmax.x, p->x), fmaxf(vmax.y, p->y), fmaxf(vmax.z, p->z));
+    }
+    XMFLOAT3 center = {0.5f * (vmin.x + vmax.x), 0.5f * (vmin.y + vmax.y), 0.5f * (vmin.z + vmax.z)};
+    float radius_sq = 0.0f;
+    for (UINT i = 0; i < meshlet->index_count; ++i) {
+        XMFLOAT3 const * p = vertex_position(vertices, vertex_stride, tris[i]);
+        float dx = p->x - center.x, dy = p->y - center.y, dz = p->z - center.z;
+        radius_sq = fmaxf(radius_sq, dx * dx + dy * dy + dz * dz);
+    }
+    meshlet->center = center;
+    meshlet->radius = sqrtf(radius_sq);
+
+    // -- cone axis: average of the (normalized) triangle normals
+    XMFLOAT3 axis = {0.0f, 0.0f, 0.0f};
+    for (UINT t = 0; t < tri_count; ++t) {
+        XMFLOAT3 n = triangle_normal(
+            vertex_position(vertices, vertex_stride, tris[t * 3 + 0]),
+            vertex_position(vertices, vertex_stride, tris[t * 3 + 1]),
+            vertex_position(vertices, vertex_stride, tris[t * 3 + 2]));
+        float len = sqrtf(n.x * n.x + n.y * n.y + n.z * n.z);
+        if (len > 0.0f) {
+            axis.x += n.x / len; axis.y += n.y / len; axis.z += n.z / len;
+        }
+    }
+    float axis_len = sqrtf(axis.x * axis.x + axis.y * axis.y + axis.z * axis.z);
+
+    // degenerate cone: never backface culled
+    meshlet->cone_apex = center;
+    meshlet->cone_axis = XMFLOAT3(0.0f, 0.0f, 0.0f);
+    meshlet->cone_cutoff = 1.0f;
+    if (axis_len <= 0.0f)
+        return;
+    axis.x /= axis_len; axis.y /= axis_len; axis.z /= axis_len;
+
+    // -- cone spread: the least aligned triangle normal
+    float min_dot = 1.0f;
+    for (UINT t = 0; t < tri_count; ++t) {
+        XMFLOAT3 n = triangle_normal(
+            vertex_position(vertices, vertex_stride, tris[t * 3 + 0]),
+            vertex_position(vertices, vertex_stride, tris[t * 3 + 1]),
+            vertex_position(vertices, vertex_stride, tris[t * 3 + 2]));
+        float len = sqrtf(n.x * n.x + n.y * n.y + n.z * n.z);
+        if (len > 0.0f)
+            min_dot = fminf(min_dot, (n.x * axis.x + n.y * axis.y + n.z * axis.z) / len);
+    }
+    if (min_dot <= MESHLET_CONE_MIN_DOT)
+        return;
+
+    // -- cone apex: move back along the axis until every triangle plane is in front of it
+    float max_t = 0.0f;
+    for (UINT t = 0; t < tri_count; ++t) {
+        XMFLOAT3 const * p0 = vertex_position(vertices, vertex_stride, tris[t * 3 + 0]);
+        XMFLOAT3 n = triangle_normal(p0,
+            vertex_position(vertices, vertex_stride, tris[t * 3 + 1]),
+            vertex_position(vertices, vertex_stride, tris[t * 3 + 2]));
+        float dc = (center.x - p0->x) * n.x + (center.y - p0->y) * n.y + (center.z - p0->z) * n.z;
+        float dn = axis.x * n.x + axis.y * n.y + axis.z * n.z;
+        if (dn > 0.0f)
+            max_t = fmaxf(max_t, dc / dn);
+    }
+    meshlet->cone_apex = XMFLOAT3(center.x - axis.x * max_t, center.y - axis.y * max_t, center.z - axis.z * max_t);
+    meshlet->cone_axis = axis;
+    meshlet->cone_cutoff = sqrtf(1.0f - min_dot * min_dot);
+}
+// Closes [meshlet]: computes its bounds and reorders its triangles for the post-transform
+// cache (the growth order of build_meshlets ignores it). [slot] must be all 0xff.
+template <typename T> static void
+finish_meshlet (Meshlet * meshlet, T * indices, void const * vertices, UINT vertex_stride, uint8_t * slot) {
+    T * tris = indices + meshlet->start_index_location;
+    UINT meshlet_verts [MESHLET_MAX_VERTICES];
+    UINT local [MESHLET_MAX_TRIANGLES * 3];
+    UINT n_verts = 0;
+    for (UINT i = 0; i < meshlet->index_count; ++i) {
+        UINT v = tris[i];
+        if (0xff == slot[v]) {
+            slot[v] = (uint8_t)n_verts;
+            meshlet_verts[n_verts++] = v;
+        }
+        local[i] = slot[v];
+    }
+    optimize_vertex_cache(local, meshlet->index_count, n_verts);
+    for (UINT i = 0; i < meshlet->index_count; ++i)
+        tris[i] = (T)meshlet_verts[local[i]];
+    for (UINT i = 0; i < n_verts; ++i)
+        slot[meshlet_verts[i]] = 0xff;
+
+    compute_meshlet_bounds(meshlet, indices, vertices, vertex_stride);
+}
+// Greedily grows meshlets over shared vertices and reorders [indices] so every meshlet is contiguous.
+// Candidates adding fewer vertices come first; ties go to the triangle closest to the meshlet
+// and best aligned with its average normal (MESHLET_CONE_WEIGHT), which keeps the cones tight.
+// [out_meshlets] must hold meshlet_bound(index_count) elements. Returns the meshlet count.
+template <typename T> static UINT
+build_meshlets (T * indices, UINT index_count, void const * vertices, UINT vertex_stride, UINT vertex_count, Meshlet * out_meshlets) {
+    UINT tri_count = index_count / 3;
+    if (0 == tri_count)
+        return 0;
+
+    // -- vertex -> triangle adjacency
+    UINT * adj_offsets = (UINT *)::calloc(vertex_count + 1, sizeof(UINT));
+    UINT * adj_tris = (UINT *)::malloc(sizeof(UINT) * tri_count * 3);
+    UINT * live_count = (UINT *)::calloc(vertex_count, sizeof(UINT));     // unemitted triangles using the vertex
+    for (UINT i = 0; i < tri_count * 3; ++i)
+        ++live_count[indices[i]];
+    for (UINT v = 0; v < vertex_count; ++v)
+        adj_offsets[v + 1] = adj_offsets[v] + live_count[v];
+    UINT * fill = (UINT *)::calloc(vertex_count, sizeof(UINT));
+    for (UINT t = 0; t < tri_count; ++t)
+        for (UINT k = 0; k < 3; ++k) {
+            UINT v = indices[t * 3 + k];
+            adj_tris[adj_offsets[v] + fill[v]++] = t;
+        }
+    ::free(fill);
+
+    // -- triangle centroids and unit normals for scoring
+    XMFLOAT3 * tri_centroids = (XMFLOAT3 *)::malloc(sizeof(XMFLOAT3) * tri_count);
+    XMFLOAT3 * tri_normals = (XMFLOAT3 *)::malloc(sizeof(XMFLOAT3) * tri_count);
+    float mesh_area = 0.0f;
+    for (UINT t = 0; t < tri_count; ++t) {
+        XMFLOAT3 const * p0 = vertex_position(vertices, vertex_stride, indices[t * 3 + 0]);
+        XMFLOAT3 const * p1 = vertex_position(vertices, vertex_stride, indices[t * 3 + 1]);
+        XMFLOAT3 const * p2 = vertex_position(vertices, vertex_stride, indices[t * 3 + 2]);
+        XMFLOAT3 n = triangle_normal(p0, p1, p2);
+        float len = sqrtf(n.x * n.x + n.y * n.y + n.z * n.z);
+        float inv_len = len > 0.0f ? 1.0f / len : 0.0f;
+        tri_normals[t] = XMFLOAT3(n.x * inv_len, n.y * inv_len, n.z * inv_len);
+        tri_centroids[t] = XMFLOAT3((p0->x + p1->x + p2->x) / 3.0f, (p0->y + p1->y + p2->y) / 3.0f, (p0->z + p1->z + p2->z) / 3.0f);
+        mesh_area += 0.5f * len;
+    }
+    // radius of a full meshlet made of average triangles
+    float expected_radius = sqrtf(mesh_area / tri_count * MESHLET_MAX_TRIANGLES) * 0.5f;
+    float inv_expected_radius = expected_radius > 0.0f ? 1.0f / expected_radius : 0.0f;
+
+    bool * emitted = (bool *)::calloc(tri_count, sizeof(bool));
+    uint8_t * slot = (uint8_t *)::malloc(vertex_count);     // position in the current meshlet, 0xff if absent
+    memset(slot, 0xff, vertex_count);
+    UINT meshlet_verts [MESHLET_MAX_VERTICES];
+
+    T * out = (T *)::malloc(sizeof(T) * tri_count * 3);
+    UINT n_out = 0;
+    UINT n_meshlets = 0;
+    UINT cursor = 0;    // every triangle before it is emitted
+
+    Meshlet curr = {};
+    XMFLOAT3 curr_sum = {0.0f, 0.0f, 0.0f};         // sum of the meshlet's vertex positions
+    XMFLOAT3 curr_normal = {0.0f, 0.0f, 0.0f};      // sum of the meshlet's triangle normals
+    for (UINT n_emitted = 0; n_emitted < tri_count; ++n_emitted) {
+        UINT best_tri = UINT_MAX;
+        if (curr.vertex_count > 0) {
+            float inv_n = 1.0f / curr.vertex_count;
+            XMFLOAT3 c = {curr_sum.x * inv_n, curr_sum.y * inv_n, curr_sum.z * inv_n};
+            float axis_len = sqrtf(curr_normal.x * curr_normal.x + curr_normal.y * curr_normal.y + curr_normal.z * curr_normal.z);
+            float inv_axis_len = axis_len > 0.0f ? 1.0f / axis_len : 0.0f;
+            XMFLOAT3 axis = {curr_normal.x * inv_axis_len, curr_normal.y * inv_axis_len, curr_normal.z * inv_axis_len};
+
+            UINT best_priority = UINT_MAX;
+            float best_score = FLT_MAX;
+            for (UINT i = 0; i < curr.vertex_count; ++i) {
+                UINT v = meshlet_verts[i];
+                if (0 == live_count[v])
+                    continue;
+                for (UINT j = adj_offsets[v]; j < adj_offsets[v + 1]; ++j) {
+                    UINT t = adj_tris[j];
+                    if (emitted[t])
+                        continue;
+                    UINT a = indices[t * 3 + 0], b = indices[t * 3 + 1], d = indices[t * 3 + 2];
+                    UINT extra = (0xff == slot[a]) + (0xff == slot[b]) + (0xff == slot[d]);
+                    // triangles adding no vertex come first, then the last triangle of a vertex
+                    // (it would otherwise end up in a tiny meshlet of its own)
+                    UINT priority = 0;
+                    if (extra > 0)
+                        priority = (1 == live_count[a] || 1 == live_count[b] || 1 == live_count[d]) ? 1 : 1 + extra;
+                    if (priority > best_priority)
+                        continue;
+
+                    float dx = tri_centroids[t].x - c.x, dy = tri_centroids[t].y - c.y, dz = tri_centroids[t].z - c.z;
+                    float dist = sqrtf(dx * dx + dy * dy + dz * dz);
+                    float spread = tri_normals[t].x * axis.x + tri_normals[t].y * axis.y + tri_normals[t].z * axis.z;
+                    float score =
+                        (1.0f + dist * inv_expected_radius * (1.0f - MESHLET_CONE_WEIGHT)) *
+                        fmaxf(1.0f - spread * MESHLET_CONE_WEIGHT, 1e-3f);
+                    if (priority < best_priority || score < best_score) {
+                        best_tri = t;
+                        best_priority = priority;
+                        best_score = score;
+                    }
+                }
+            }
+            // -- no free triangle touches the meshlet: continue with the nearest one
+            if (UINT_MAX == best_tri) {
+                while (emitted[cursor])
+                    ++cursor;
+                float best_dist = FLT_MAX;
+                for (UINT t = cursor; t < tri_count; ++t) {
+                    if (emitted[t])
+                        continue;
+                    float dx = tri_centroids[t].x - c.x, dy = tri_centroids[t].y - c.y, dz = tri_centroids[t].z - c.z;
+                    float dist = dx * dx + dy * dy + dz * dz;
+                    if (dist < best_dist) {
+                        best_tri = t;
+                        best_dist = dist;
+                    }
+                }
+            }
+        } else {
+            while (emitted[cursor])
+                ++cursor;
+            best_tri = cursor;
+        }
+
+        // -- close the meshlet if the triangle doesn't fit
+        UINT extra =
+            (0xff == slot[indices[best_tri * 3 + 0]]) +
+            (0xff == slot[indices[best_tri * 3 + 1]]) +
+            (0xff == slot[indices[best_tri * 3 + 2]]);
+        if (curr.vertex_count + extra > MESHLET_MAX_VERTICES || curr.index_count == MESHLET_MAX_TRIANGLES * 3) {
+            for (UINT i = 0; i < curr.vertex_count; ++i)
+                slot[meshlet_verts[i]] = 0xff;
+            finish_meshlet(&curr, out, vertices, vertex_stride, slot);
+            out_meshlets[n_meshlets++] = curr;
+
+            curr = {};
+            curr.start_index_location = n_out;
+            curr_sum = XMFLOAT3(0.0f, 0.0f, 0.0f);
+            curr_normal = XMFLOAT3(0.0f, 0.0f, 0.0f);
+        }
+
+        // -- emit
+        emitted[best_tri] = true;
+        for (UINT k = 0; k < 3; ++k) {
+            UINT v = indices[best_tri * 3 + k];
+            out[n_out++] = (T)v;
+            --live_count[v];
+            if (0xff == slot[v]) {
+                slot[v] = (uint8_t)curr.vertex_count;
+                meshlet_verts[curr.vertex_count++] = v;
+                XMFLOAT3 const * p = vertex_position(vertices, vertex_stride, v);
+                curr_sum.x += p->x; curr_sum.y += p->y; curr_sum.z += p->z;
+            }
+        }
+        curr_normal.x += tri_normals[best_tri].x;
+        curr_normal.y += tri_normals[best_tri].y;
+        curr_normal.z += tri_normals[best_tri].z;
+        curr.index_count += 3;
+    }
+    for (UINT i = 0; i < curr.vertex_count; ++i)
+        slot[meshlet_verts[i]] = 0xff;
+    finish_meshlet(&curr, out, vertices, vertex_stride, slot);
+    out_meshlets[n_meshlets++] = curr;
+
+    memcpy(indices, out, sizeof(T) * n_out);
+
+    ::free(out);
+    ::free(slot);
+    ::free(emitted);
+    ::free(tri_normals);
+    ::free(tri_centroids);
+    ::free(live_count);
+    ::free(adj_tris);
+    ::free(adj_offsets);
+    return n_meshlets;
+}
+// [view_point] is in the meshlet's object space: w = 1 for a camera position (perspective),
+// w = 0 for a view direction (orthographic). True when no triangle of the meshlet can face the view.
+inline bool
+meshlet_is_backfacing (Meshlet const & meshlet, XMFLOAT4 const & view_point) {
+    XMFLOAT3 d = {
+        meshlet.cone_apex.x * view_point.w - view_point.x,
+        meshlet.cone_apex.y * view_point.w - view_point.y,
+        meshlet.cone_apex.z * view_point.w - view_point.z
+    };
+    if (0.0f == view_point.w) {
+        d.x = view_point.x; d.y = view_point.y; d.z = view_point.z;
+    }
+    float len = sqrtf(d.x * d.x + d.y * d.y + d.z * d.z);
+    if (len <= 0.0f)
+        return false;
+    return (d.x * meshlet.cone_axis.x + d.y * meshlet.cone_axis.y + d.z * meshlet.cone_axis.z) >= meshlet.cone_cutoff * len;
+}
+// Appends the indices of the meshlets that pass the frustum test ([frustum] in object space,
+// nullptr to skip it) and the backface test to [out_indices]. Returns the number of indices written.
+template <typename T> static UINT
+cull_meshlets (
+    Meshlet const * meshlets, UINT meshlet_count, T const * indices,
+    BoundingFrustum const * frustum, XMFLOAT4 const & view_point,
+    UINT * out_indices, MeshletCullStats * stats
+) {
+    UINT n_out = 0;
+    for (UINT m = 0; m < meshlet_count; ++m) {
+        Meshlet const & meshlet = meshlets[m];
+        if (frustum && DISJOINT == frustum->Contains(BoundingSphere(meshlet.center, meshlet.radius))) {
+            ++stats->frustum_culled;
+            continue;
+        }
+        if (meshlet_is_backfacing(meshlet, view_point)) {
+            ++stats->backface_culled;
+            continue;
+        }
+        ++stats->visible;
+        T const * src = indices + meshlet.start_index_location;
+        for (UINT i = 0; i < meshlet.index_count; ++i)
+            out_indices[n_out + i] = src[i];
+        n_out += meshlet.index_count;
+    }
+    return n_out;
+}
+// Partitions submesh [submesh_index] of [geom] (index buffer still in ib_cpu, not uploaded yet)
+// and appends its meshlets to geom->meshlets. [vertices] are the unquantized source vertices.
+static void
+Mesh_BuildMeshlets (MeshGeometry * geom, UINT submesh_index, void const * vertices, UINT vertex_stride, UINT vertex_count, char const * name) {
+    SubmeshGeometry * submesh = &geom->submesh_geoms[submesh_index];
+    UINT bound = meshlet_bound(submesh->index_count);
+    geom->meshlets = (Meshlet *)::realloc(geom->meshlets, sizeof(Meshlet) * (geom->meshlet_count + bound));
+
+    void const * submesh_vertices = (uint8_t const *)vertices + (INT64)submesh->base_vertex_location * vertex_stride;
+    UINT submesh_vertex_count = vertex_count - submesh->base_vertex_location;
+    Meshlet * meshlets = geom->meshlets + geom->meshlet_count;
+    UINT n = 0;
+    if (DXGI_FORMAT_R16_UINT == geom->index_format) {
+        uint16_t * indices = (uint16_t *)geom->ib_cpu->GetBufferPointer() + submesh->start_index_location;
+        n = build_meshlets(indices, submesh->index_count, submesh_vertices, vertex_stride, submesh_vertex_count, meshlets);
+    } else {
+        uint32_t * indices = (uint32_t *)geom->ib_cpu->GetBufferPointer() + submesh->start_index_location;
+        n = build_meshlets(indices, submesh->index_count, submesh_vertices, vertex_stride, submesh_vertex_count, meshlets);
+    }
+    submesh->meshlet_offset = geom->meshlet_count;
+    submesh->meshlet_count = n;
+    geom->meshlet_count += n;
+
+    UINT total_vertices = 0;
+    UINT n_culling_cones = 0;
+    for (UINT m = 0; m < n; ++m) {
+        total_vertices += meshlets[m].vertex_count;
+        n_culling_cones += meshlets[m].cone_cutoff < 1.0f;
+    }
+    char buf[256];
+    sprintf_s(buf, sizeof(buf),
+        "[meshlet] %s: %u meshlets, %.1f triangles / %.1f vertices per meshlet, %u with a usable normal cone\n",
+        name, n, n ? (float)submesh->index_count / 3 / n : 0.0f, n ? (float)total_vertices / n : 0.0f, n_culling_cones);
+    ::OutputDebugStringA(buf);
+}
@@ -0,0 +1,93 @@
+/* ===========================================================
+   #File: screen_coverage.h #
+   #Date: 17 Oct 2026 #
+   #Revision: 1.0 #
+   #Creator: Omid Miresmaeili #
+   #Description: projected screen size of bounding spheres for small object culling, LOD and shadow eligibility #
+   #Notice: (C) Copyright 2021 by Omid. All Rights Reserved. #
+   =========================================================== */
+#pragma once
+
+#include "common.h"
+#include "utils.h"
+
+using namespace DirectX;
+
+//
+// Screen coverage
+//
+// The bounding sphere of an object (its local box moved by its world matrix) is projected
+// at the distance of its nearest point, which gives one metric for three decisions:
+// objects smaller than min_pixels are not drawn, objects smaller than shadow_min_pixels
+// cast no shadow, and pixels_per_unit (object space units to pixels) picks the LOD the
+// same way the LOD error threshold does. A camera inside the sphere sees it infinitely large.
+//
+#define COVERAGE_MIN_PIXELS         1.0f
+#define COVERAGE_SHADOW_MIN_PIXELS  4.0f
+
+struct ScreenCoverageParams {
+    XMFLOAT3    eye_pos;
+    float       proj_scale;             // pixels per unit of length at distance 1
+    float       min_pixels;             // 0 keeps everything
+    float       shadow_min_pixels;
+};
+struct ScreenCoverage {
+    float       pixels;                 // projected diameter of the bounding sphere
+    float       pixels_per_unit;        // pixels per object space unit at its nearest point
+    bool        visible;
+    bool        casts_shadow;
+};
+
+// Pixels per unit of length at distance 1 (viewport_height / (2 * tan(fov_y / 2)))
+inline float
+coverage_projection_scale (XMFLOAT4X4 const & proj, float viewport_height) {
+    return 0.5f * viewport_height * proj.m[1][1];
+}
+inline ScreenCoverage
+screen_coverage (BoundingBox const & bounds, XMFLOAT4X4 const & world, ScreenCoverageParams const & params) {
+    // -- bounding sphere in world space (row vector convention)
+    XMFLOAT3 const & c = bounds.Center;
+    float cx = c.x * world.m[0][0] + c.y * world.m[1][0] + c.z * world.m[2][0] + world.m[3][0];
+    float cy = c.x * world.m[0][1] + c.y * world.m[1][1] + c.z * world.m[2][1] + world.m[3][1];
+    float cz = c.x * world.m[0][2] + c.y * world.m[1][2] + c.z * world.m[2][2] + world.m[3][2];
+    float scale_sq = 0.0f;
+    for (int r = 0; r < 3; ++r) {
+        float s = world.m[r][0] * world.m[r][0] + world.m[r][1] * world.m[r][1] + world.m[r][2] * world.m[r][2];
+        scale_sq = s > scale_sq ? s : scale_sq;
+    }
+    float scale = sqrtf(scale_sq);
+    XMFLOAT3 const & e = bounds.Extents;
+    float radius = scale * sqrtf(e.x * e.x + e.y * e.y + e.z * e.z);
+
+    float vx = cx - params.eye_pos.x, vy = cy - params.eye_pos.y, vz = cz - params.eye_pos.z;
+    float distance = sqrtf(vx * vx + vy * vy + vz * vz) - radius;
+
+    ScreenCoverage ret;
+    if (distance <= 0.0f) {
+        ret.pixels = FLT_MAX;
+        ret.pixels_per_unit = FLT_MAX;
+    } else {
+        float pixels_per_world_unit = params.proj_scale / distance;
+        ret.pixels = 2.0f * radius * pixels_per_world_unit;
+        ret.pixels_per_unit = scale * pixels_per_world_unit;
+    }
+    ret.visible = ret.pixels >= params.min_pixels;
+    ret.casts_shadow = ret.pixels >= params.shadow_min_pixels;
+    return ret;
+}
+// Clears visible[i] of the render items too small on screen, and casts_shadow[i] of those
+// too small to cast a shadow (either array may be null, both are indexed like [ritems])
+static void
+cull_render_items_by_coverage (
+    RenderItem const * ritems, UINT count, ScreenCoverageParams const & params, bool * visible, bool * casts_shadow
+) {
+    for (UINT i = 0; i < count; ++i) {
+        if (!ritems[i].initialized)
+            continue;
+        ScreenCoverage coverage = screen_coverage(ritems[i].bounds, ritems[i].world, params);
+        if (visible && !coverage.visible)
+            visible[i] = false;
+        if (casts_shadow && !coverage.casts_shadow)
+            casts_shadow[i] = false;
+    }
+}
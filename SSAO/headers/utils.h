@@ -10,6 +10,7 @@
 
 #include "common.h"
 #include "mesh_geometry.h"
+#include "mesh_optimizer.h"
 
 #define ARRAY_COUNT(arr)                sizeof(arr)/sizeof(arr[0])
 #define CLAMP_VALUE(val, lb, ub)        ((val) < (lb)) ? (lb) : ((val) > (ub) ? (ub) : (val))
@@ -36,7 +37,13 @@ struct ObjectConstants {
     UINT obj_pad1;
     UINT obj_pad2;
 
-    float padding[28];
+    // quantized vertices only
+    XMFLOAT3 pos_decode_bias;
+    UINT obj_pad3;
+    XMFLOAT3 pos_decode_scale;
+    UINT obj_pad4;
+
+    float padding[20];
 };
 static_assert(256 == sizeof(ObjectConstants), "Constant buffer size must be 256b aligned");
 
@@ -184,6 +191,10 @@ struct FrameResource {
     ID3D12Resource * ssao_cb;
     uint8_t * ssao_ptr;
 
+    // Indices of the meshlets that survived culling, written every frame (R32)
+    ID3D12Resource * meshlet_ib;
+    uint8_t * meshlet_ib_ptr;
+
     // Fence value to mark commands up to this fence point.  This lets us
     // check if these frame resources are still in use by the GPU.
     UINT64 fence;
@@ -221,6 +232,9 @@ struct RenderItem {
 
     Material * mat;
     MeshGeometry * geometry;
+
+    // Submesh of [geometry] this item draws if it was partitioned into meshlets, else nullptr
+    SubmeshGeometry const * meshlet_submesh;
 };
 
 inline XMFLOAT4X4
@@ -781,6 +795,9 @@ create_sphere (float radius, GeomVertex out_vtx [], uint16_t out_idx []) {
         out_idx[_idx_cnt++] = base_index + i;
         out_idx[_idx_cnt++] = base_index + i + 1;
     }
+
+    // bottom pole is stored at [n_vtx + 1]
+    optimize_vertex_cache_and_report("sphere", out_idx, _idx_cnt, n_vtx + 2);
 }
 static void
 create_cylinder (float bottom_radius, float top_radius, float height, GeomVertex out_vtx [], uint16_t out_idx []) {
@@ -916,6 +933,7 @@ create_cylinder (float bottom_radius, float top_radius, float height, GeomVertex
     }
 #pragma endregion build cylinder bottom
 
+    optimize_vertex_cache_and_report("cylinder", out_idx, _idx_cnt, _vtx_cnt);
 }
 static void
 create_grid16 (float width, float depth, UINT32 m, UINT32 n, GeomVertex out_vtx [], uint16_t out_idx []) {
@@ -964,6 +982,8 @@ create_grid16 (float width, float depth, UINT32 m, UINT32 n, GeomVertex out_vtx
             k += 6; // next quad
         }
     }
+
+    optimize_vertex_cache_and_report("grid16", out_idx, k, m * n);
 }
 static void
 create_grid32 (float width, float depth, UINT32 m, UINT32 n, GeomVertex out_vtx [], uint32_t out_idx []) {
@@ -1012,6 +1032,8 @@ create_grid32 (float width, float depth, UINT32 m, UINT32 n, GeomVertex out_vtx
             k += 6; // next quad
         }
     }
+
+    optimize_vertex_cache_and_report("grid32", out_idx, k, m * n);
 }
 static void
 create_quad (float x, float y, float w, float h, float depth, GeomVertex out_vtx [], uint16_t out_idx []) {
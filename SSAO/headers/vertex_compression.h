@@ -0,0 +1,130 @@
+/* ===========================================================
+   #File: vertex_compression.h #
+   #Date: 17 Oct 2026 #
+   #Revision: 1.0 #
+   #Creator: Omid Miresmaeili #
+   #Description: quantized vertex format (decoded in shaders/vertex_compression.hlsl) #
+   #Notice: (C) Copyright 2021 by Omid. All Rights Reserved. #
+   =========================================================== */
+#pragma once
+
+#include "common.h"
+#include "utils.h"
+#include <DirectXPackedVector.h>
+
+using namespace DirectX;
+
+//
+// 20 bytes per vertex instead of sizeof(Vertex) = 44
+//
+struct PackedVertex {
+    uint16_t position[4];   // R16G16B16A16_UNORM, relative to the submesh AABB (w unused)
+    int16_t normal[2];      // R16G16_SNORM, octahedral
+    int16_t tangent_u[2];   // R16G16_SNORM, octahedral
+    uint16_t texc[2];       // R16G16_FLOAT
+};
+static_assert(20 == sizeof(PackedVertex), "PackedVertex must match the quantized input layout");
+
+// Position decode: pos = bias + unorm16 * scale
+struct PositionDecode {
+    XMFLOAT3 bias;
+    XMFLOAT3 scale;
+};
+inline PositionDecode
+position_decode_from_bounds (BoundingBox const & bounds) {
+    PositionDecode ret;
+    ret.bias = XMFLOAT3(
+        bounds.Center.x - bounds.Extents.x, bounds.Center.y - bounds.Extents.y, bounds.Center.z - bounds.Extents.z);
+    ret.scale = XMFLOAT3(2.0f * bounds.Extents.x, 2.0f * bounds.Extents.y, 2.0f * bounds.Extents.z);
+    return ret;
+}
+inline uint16_t
+quantize_unorm16 (float v) {
+    v = v < 0.0f ? 0.0f : (v > 1.0f ? 1.0f : v);
+    return (uint16_t)(v * 65535.0f + 0.5f);
+}
+inline int16_t
+quantize_snorm16 (float v) {
+    v = v < -1.0f ? -1.0f : (v > 1.0f ? 1.0f : v);
+    return (int16_t)(v * 32767.0f + (v >= 0.0f ? 0.5f : -0.5f));
+}
+// Octahedral mapping of a unit vector onto [-1, 1]^2
+// Reference: Cigolle et al., "A Survey of Efficient Representations for Independent Unit Vectors" (2014)
+inline void
+oct_encode (XMFLOAT3 const & v, int16_t out [2]) {
+    float l1 = fabsf(v.x) + fabsf(v.y) + fabsf(v.z);
+    if (l1 <= 0.0f) {
+        out[0] = out[1] = 0;
+        return;
+    }
+    float x = v.x / l1;
+    float y = v.y / l1;
+    if (v.z < 0.0f) {
+        // fold the lower hemisphere over the diagonals
+        float fx = (1.0f - fabsf(y)) * (x >= 0.0f ? 1.0f : -1.0f);
+        float fy = (1.0f - fabsf(x)) * (y >= 0.0f ? 1.0f : -1.0f);
+        x = fx;
+        y = fy;
+    }
+    out[0] = quantize_snorm16(x);
+    out[1] = quantize_snorm16(y);
+}
+inline XMFLOAT3
+oct_decode (int16_t const in [2]) {
+    float x = in[0] / 32767.0f;
+    float y = in[1] / 32767.0f;
+    float z = 1.0f - fabsf(x) - fabsf(y);
+    if (z < 0.0f) {
+        float fx = (1.0f - fabsf(y)) * (x >= 0.0f ? 1.0f : -1.0f);
+        float fy = (1.0f - fabsf(x)) * (y >= 0.0f ? 1.0f : -1.0f);
+        x = fx;
+        y = fy;
+    }
+    float len = sqrtf(x * x + y * y + z * z);
+    return XMFLOAT3(x / len, y / len, z / len);
+}
+// Quantizes [count] vertices of a submesh whose positions lie within [bounds]
+static void
+pack_vertices (Vertex const * src, UINT count, BoundingBox const & bounds, PackedVertex * out) {
+    PositionDecode dec = position_decode_from_bounds(bounds);
+    // flat axes (e.g., the grid's y) decode to the bias for every vertex
+    float inv_sx = dec.scale.x > 0.0f ? 1.0f / dec.scale.x : 0.0f;
+    float inv_sy = dec.scale.y > 0.0f ? 1.0f / dec.scale.y : 0.0f;
+    float inv_sz = dec.scale.z > 0.0f ? 1.0f / dec.scale.z : 0.0f;
+    for (UINT i = 0; i < count; ++i) {
+        out[i].position[0] = quantize_unorm16((src[i].position.x - dec.bias.x) * inv_sx);
+        out[i].position[1] = quantize_unorm16((src[i].position.y - dec.bias.y) * inv_sy);
+        out[i].position[2] = quantize_unorm16((src[i].position.z - dec.bias.z) * inv_sz);
+        out[i].position[3] = 0;
+        oct_encode(src[i].normal, out[i].normal);
+        oct_encode(src[i].tangent_u, out[i].tangent_u);
+        out[i].texc[0] = PackedVector::XMConvertFloatToHalf(src[i].texc.x);
+        out[i].texc[1] = PackedVector::XMConvertFloatToHalf(src[i].texc.y);
+    }
+}
+static void
+get_packed_vertex_input_desc (D3D12_INPUT_ELEMENT_DESC out_desc [4]) {
+    out_desc[0] = {};
+    out_desc[0].SemanticName = "POSITION";
+    out_desc[0].Format = DXGI_FORMAT_R16G16B16A16_UNORM;
+    out_desc[0].AlignedByteOffset = 0;
+    out_desc[0].InputSlotClass = D3D12_INPUT_CLASSIFICATION_PER_VERTEX_DATA;
+
+    out_desc[1] = {};
+    out_desc[1].SemanticName = "NORMAL";
+    out_desc[1].Format = DXGI_FORMAT_R16G16_SNORM;
+    out_desc[1].AlignedByteOffset = 8;
+    out_desc[1].InputSlotClass = D3D12_INPUT_CLASSIFICATION_PER_VERTEX_DATA;
+
+    out_desc[2] = {};
+    out_desc[2].SemanticName = "TANGENT";
+    out_desc[2].Format = DXGI_FORMAT_R16G16_SNORM;
+    out_desc[2].AlignedByteOffset = 12;
+    out_desc[2].InputSlotClass = D3D12_INPUT_CLASSIFICATION_PER_VERTEX_DATA;
+
+    out_desc[3] = {};
+    out_desc[3].SemanticName = "TEXCOORD";
+    out_desc[3].Format = DXGI_FORMAT_R16G16_FLOAT;
+    out_desc[3].AlignedByteOffset = 16;
+    out_desc[3].InputSlotClass = D3D12_INPUT_CLASSIFICATION_PER_VERTEX_DATA;
+}
@@ -45,6 +45,12 @@ cbuffer PerObjBuffer : register(b0){
     uint obj_pad0;
     uint obj_pad1;
     uint obj_pad2;
+
+    // quantized vertices only (see vertex_compression.hlsl)
+    float3 g_pos_decode_bias;
+    uint obj_pad3;
+    float3 g_pos_decode_scale;
+    uint obj_pad4;
 }
 
 cbuffer PerPassConstantBuffer : register(b1){
@@ -9,13 +9,8 @@
 #endif
 
 #include "common.hlsl"
+#include "vertex_compression.hlsl"
 
-struct VertIn {
-    float3 pos_local : POSITION;
-    float3 normal_local : NORMAL;
-    float2 texc : TEXCOORD;
-    float3 tangent_u : TANGENT;
-};
 struct VertOut {
     float4 pos_h : SV_Position;
     float3 normal_world : NORMAL;
@@ -23,8 +18,9 @@ struct VertOut {
     float2 texc : TEXCOORD;
 };
 VertOut
-VS (VertIn vin, uint instance_id : SV_InstanceID) {
+VS (VertIn vin_raw, uint instance_id : SV_InstanceID) {
     VertOut ret = (VertOut)0.0f;
+    VertexAttribs vin = decode_vertex(vin_raw);
  
     // fetch material data
     MaterialData mat_data = g_mat_data[g_mat_index];
@@ -1,10 +1,6 @@
 
 #include "common.hlsl"
-
-struct VertexIn {
-    float3 pos_l : POSITION;
-    float2 texc : TEXCOORD;
-};
+#include "vertex_compression.hlsl"
 
 struct VertexOut {
     float4 pos_h : SV_POSITION;
@@ -12,13 +8,14 @@ struct VertexOut {
 };
 
 VertexOut
-VS (VertexIn vin) {
+VS (VertIn vin_raw) {
     VertexOut ret = (VertexOut)0.0f;
+    VertexAttribs vin = decode_vertex(vin_raw);
     
     MaterialData mat_data = g_mat_data[g_mat_index];
     
     // transform to world space
-    float4 pos_w = mul(float4(vin.pos_l, 1.0f), g_world);
+    float4 pos_w = mul(float4(vin.pos_local, 1.0f), g_world);
     
     // transform to homogenous clip space
     ret.pos_h = mul(pos_w, g_view_proj);
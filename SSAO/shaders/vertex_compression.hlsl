@@ -0,0 +1,53 @@
+// Vertex input shared by the VS of default.hlsl, draw_normals.hlsl and shadows.hlsl.
+// Compile with QUANTIZED_VERTEX defined for meshes using the PackedVertex layout (see headers/vertex_compression.h).
+// Must be included after common.hlsl (position decode parameters live in PerObjBuffer).
+
+#ifdef QUANTIZED_VERTEX
+struct VertIn {
+    float4 pos_q : POSITION;        // unorm16 relative to the submesh AABB
+    float2 normal_oct : NORMAL;     // snorm16 octahedral
+    float2 tangent_oct : TANGENT;   // snorm16 octahedral
+    float2 texc : TEXCOORD;         // half
+};
+#else
+struct VertIn {
+    float3 pos_local : POSITION;
+    float3 normal_local : NORMAL;
+    float2 texc : TEXCOORD;
+    float3 tangent_u : TANGENT;
+};
+#endif
+
+struct VertexAttribs {
+    float3 pos_local;
+    float3 normal_local;
+    float2 texc;
+    float3 tangent_u;
+};
+
+float3
+oct_decode (float2 e) {
+    float3 v = float3(e.x, e.y, 1.0f - abs(e.x) - abs(e.y));
+    if (v.z < 0.0f) {
+        // unfold the lower hemisphere
+        float2 sign_not_zero = step(0.0f, v.xy) * 2.0f - 1.0f;
+        v.xy = (1.0f - abs(v.yx)) * sign_not_zero;
+    }
+    return normalize(v);
+}
+VertexAttribs
+decode_vertex (VertIn vin) {
+    VertexAttribs ret;
+#ifdef QUANTIZED_VERTEX
+    ret.pos_local = g_pos_decode_bias + vin.pos_q.xyz * g_pos_decode_scale;
+    ret.normal_local = oct_decode(vin.normal_oct);
+    ret.tangent_u = oct_decode(vin.tangent_oct);
+    ret.texc = vin.texc;
+#else
+    ret.pos_local = vin.pos_local;
+    ret.normal_local = vin.normal_local;
+    ret.tangent_u = vin.tangent_u;
+    ret.texc = vin.texc;
+#endif
+    return ret;
+}
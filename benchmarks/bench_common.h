@@ -0,0 +1,110 @@
+/* ===========================================================
+   #File: bench_common.h #
+   #Date: 17 Oct 2026 #
+   #Revision: 1.0 #
+   #Creator: Omid Miresmaeili #
+   #Description: random numbers, models and command line helpers shared by the benchmarks #
+   #Notice: (C) Copyright 2021 by Omid. All Rights Reserved. #
+   =========================================================== */
+#pragma once
+
+#include "common.h"
+#include "mesh_loader.h"
+
+//
+// Random numbers (same sequence on every run)
+//
+struct BenchRandom {
+    uint64_t state;
+};
+inline UINT
+random_next (BenchRandom * rng) {
+    rng->state = rng->state * 6364136223846793005ull + 1442695040888963407ull;
+    return (UINT)(rng->state >> 33);
+}
+inline float
+random_float (BenchRandom * rng, float lo, float hi) {
+    return lo + (hi - lo) * (float)(random_next(rng) & 0xffffff) / (float)0x1000000;
+}
+
+//
+// Model
+//
+// Vertex of the model files (position and normal)
+struct BenchVertex {
+    XMFLOAT3    pos;
+    XMFLOAT3    normal;
+};
+struct BenchModel {
+    BenchVertex *   vertices;
+    UINT            vertex_count;
+    UINT *          indices;
+    UINT            tri_count;
+    XMFLOAT3        center;         // of the AABB
+    float           radius;         // of the sphere around the AABB
+};
+// Reads a text model of the demos with their parser (TextMesh_Load of mesh_loader.h).
+// The vertices and triangles are kept as in the file: no welding or reordering.
+static bool
+load_model (char const * path, BenchModel * model) {
+    *model = {};
+    TextMesh txt;
+    if (!TextMesh_Load(path, &txt))
+        return false;
+    if (0 == txt.index_count) {
+        TextMesh_Free(&txt);
+        return false;
+    }
+
+    model->vertex_count = txt.vertex_count;
+    model->vertices = (BenchVertex *)::malloc(sizeof(BenchVertex) * txt.vertex_count);
+    for (UINT i = 0; i < txt.vertex_count; ++i) {
+        model->vertices[i].pos = txt.positions[i];
+        model->vertices[i].normal = txt.normals[i];
+    }
+    model->tri_count = txt.index_count / 3;
+    model->indices = txt.indices;
+    txt.indices = nullptr;
+
+    model->center = txt.bounds.Center;
+    model->radius = XMVectorGetX(XMVector3Length(XMLoadFloat3(&txt.bounds.Extents)));
+    TextMesh_Free(&txt);
+    return true;
+}
+static void
+release_model (BenchModel * model) {
+    ::free(model->vertices);
+    ::free(model->indices);
+    *model = {};
+}
+
+//
+// Command line
+//
+// True if [name] is in the comma separated [list] (a null list holds everything)
+static bool
+list_contains (char const * list, char const * name) {
+    if (nullptr == list)
+        return true;
+    size_t len = strlen(name);
+    for (char const * p = list; *p;) {
+        char const * end = strchr(p, ',');
+        size_t n = end ? (size_t)(end - p) : strlen(p);
+        if (n == len && 0 == strncmp(p, name, len))
+            return true;
+        p += n + (end ? 1 : 0);
+    }
+    return false;
+}
+static void
+print_usage (char const * usage) {
+    fprintf(stderr, "usage: %s\n", usage);
+}
+// Prints the values an option takes as "[label]: a b c"
+static void
+print_names (char const * label, char const * const * names, UINT count) {
+    fprintf(stderr, "%s:", label);
+    for (UINT i = 0; i < count; ++i)
+        fprintf(stderr, " %s", names[i]);
+    fprintf(stderr, "\n");
+}
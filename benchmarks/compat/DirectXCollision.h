@@ -0,0 +1,215 @@
+/* ===========================================================
+   #File: DirectXCollision.h #
+   #Date: 17 Oct 2026 #
+   #Revision: 1.0 #
+   #Creator: Omid Miresmaeili #
+   #Description: BoundingBox and BoundingFrustum subset of DirectXCollision for Linux builds #
+   #Notice: (C) Copyright 2021 by Omid. All Rights Reserved. #
+   =========================================================== */
+#pragma once
+
+// Follows DirectXCollision's algorithms so the benchmarks time the same work as the
+// demos: a frustum is an origin, an orientation quaternion, four side slopes and the
+// near/far distances; Contains(BoundingBox) builds its six planes and tests the box.
+// TriangleTests::Intersects is its Moller-Trumbore test, which divides only for the distance.
+
+#include "DirectXMath.h"
+
+namespace DirectX {
+
+enum ContainmentType {
+    DISJOINT = 0,
+    INTERSECTS = 1,
+    CONTAINS = 2,
+};
+
+struct BoundingSphere {
+    XMFLOAT3    Center;
+    float       Radius;
+
+    BoundingSphere () : Center(0, 0, 0), Radius(1.0f) {}
+    BoundingSphere (XMFLOAT3 const & center, float radius) : Center(center), Radius(radius) {}
+};
+
+struct BoundingBox {
+    XMFLOAT3    Center;
+    XMFLOAT3    Extents;
+
+    BoundingBox () : Center(0, 0, 0), Extents(1.0f, 1.0f, 1.0f) {}
+    BoundingBox (XMFLOAT3 const & center, XMFLOAT3 const & extents) : Center(center), Extents(extents) {}
+
+    // AABB of the eight transformed corners
+    void
+    Transform (BoundingBox & out, XMMATRIX const & m) const {
+        XMVECTOR center = XMLoadFloat3(&Center);
+        XMVECTOR extents = XMLoadFloat3(&Extents);
+        XMVECTOR mn = _mm_set1_ps(FLT_MAX);
+        XMVECTOR mx = _mm_set1_ps(-FLT_MAX);
+        for (int i = 0; i < 8; ++i) {
+            XMVECTOR offset = XMVectorSet((i & 1) ? 1.0f : -1.0f, (i & 2) ? 1.0f : -1.0f, (i & 4) ? 1.0f : -1.0f, 0.0f);
+            XMVECTOR corner = XMVector3Transform(center + extents * offset, m);
+            mn = XMVectorMin(mn, corner);
+            mx = XMVectorMax(mx, corner);
+        }
+        XMStoreFloat3(&out.Center, (mn + mx) * 0.5f);
+        XMStoreFloat3(&out.Extents, (mx - mn) * 0.5f);
+    }
+    static void
+    CreateFromPoints (BoundingBox & out, size_t count, XMFLOAT3 const * points, size_t stride) {
+        XMVECTOR mn = XMLoadFloat3(points);
+        XMVECTOR mx = mn;
+        for (size_t i = 1; i < count; ++i) {
+            XMVECTOR p = XMLoadFloat3((XMFLOAT3 const *)((BYTE const *)points + i * stride));
+            mn = XMVectorMin(mn, p);
+            mx = XMVectorMax(mx, p);
+        }
+        XMStoreFloat3(&out.Center, (mn + mx) * 0.5f);
+        XMStoreFloat3(&out.Extents, (mx - mn) * 0.5f);
+    }
+    // Against planes with the outside on their positive side
+    ContainmentType
+    ContainedBy (XMVECTOR const * planes, int plane_count) const {
+        XMVECTOR center = XMVectorSetW(XMLoadFloat3(&Center), 1.0f);
+        XMVECTOR extents = XMLoadFloat3(&Extents);
+        bool inside_all = true;
+        for (int p = 0; p < plane_count; ++p) {
+            float dist = XMVectorGetX(XMVector4Dot(center, planes[p]));
+            float radius = XMVectorGetX(XMVector3Dot(extents, XMVectorAbs(planes[p])));
+            if (dist - radius > 0.0f)
+                return DISJOINT;
+            if (dist + radius > 0.0f)
+                inside_all = false;
+        }
+        return inside_all ? CONTAINS : INTERSECTS;
+    }
+};
+
+struct BoundingFrustum {
+    XMFLOAT3    Origin;
+    XMFLOAT4    Orientation;    // quaternion
+
+    float       RightSlope;     // x / z of the side planes
+    float       LeftSlope;
+    float       TopSlope;       // y / z
+    float       BottomSlope;
+    float       Near, Far;      // z of the near and far planes
+
+    BoundingFrustum () :
+        Origin(0, 0, 0), Orientation(0, 0, 0, 1),
+        RightSlope(1.0f), LeftSlope(-1.0f), TopSlope(1.0f), BottomSlope(-1.0f), Near(0.0f), Far(1.0f) {}
+
+    // Frustum of a perspective projection, in view space
+    static void
+    CreateFromMatrix (BoundingFrustum & out, XMMATRIX const & projection) {
+        XMVECTOR const homogenous [6] = {
+            XMVectorSet(1.0f, 0.0f, 1.0f, 1.0f),    // right (at far plane)
+            XMVectorSet(-1.0f, 0.0f, 1.0f, 1.0f),   // left
+            XMVectorSet(0.0f, 1.0f, 1.0f, 1.0f),    // top
+            XMVectorSet(0.0f, -1.0f, 1.0f, 1.0f),   // bottom
+            XMVectorSet(0.0f, 0.0f, 0.0f, 1.0f),    // near
+            XMVectorSet(0.0f, 0.0f, 1.0f, 1.0f),    // far
+        };
+        XMVECTOR det;
+        XMMATRIX inv = XMMatrixInverse(&det, projection);
+        XMVECTOR points [6];
+        for (int i = 0; i < 6; ++i)
+            points[i] = XMVector4Transform(homogenous[i], inv);
+
+        out.Origin = XMFLOAT3(0.0f, 0.0f, 0.0f);
+        out.Orientation = XMFLOAT4(0.0f, 0.0f, 0.0f, 1.0f);
+        for (int i = 0; i < 4; ++i)
+            points[i] = points[i] / XMVectorSplatZ(points[i]);
+        out.RightSlope = XMVectorGetX(points[0]);
+        out.LeftSlope = XMVectorGetX(points[1]);
+        out.TopSlope = XMVectorGetY(points[2]);
+        out.BottomSlope = XMVectorGetY(points[3]);
+        for (int i = 4; i < 6; ++i)
+            points[i] = points[i] / XMVectorSplatW(points[i]);
+        out.Near = XMVectorGetZ(points[4]);
+        out.Far = XMVectorGetZ(points[5]);
+    }
+    // Rotation and translation of [m] plus its largest axis scale (the frustum stays a frustum)
+    void
+    Transform (BoundingFrustum & out, XMMATRIX const & m) const {
+        XMMATRIX rotation = {{
+            XMVector3Normalize(m.r[0]),
+            XMVector3Normalize(m.r[1]),
+            XMVector3Normalize(m.r[2]),
+            XMVectorSet(0.0f, 0.0f, 0.0f, 1.0f)
+        }};
+        XMVECTOR orientation = XMQuaternionMultiply(XMLoadFloat4(&Orientation), XMQuaternionRotationMatrix(rotation));
+        XMStoreFloat4(&out.Orientation, orientation);
+        XMStoreFloat3(&out.Origin, XMVector3Transform(XMLoadFloat3(&Origin), m));
+
+        float sx = XMVectorGetX(XMVector3Length(m.r[0]));
+        float sy = XMVectorGetX(XMVector3Length(m.r[1]));
+        float sz = XMVectorGetX(XMVector3Length(m.r[2]));
+        float scale = fmaxf(sx, fmaxf(sy, sz));
+        out.Near = Near * scale;
+        out.Far = Far * scale;
+        out.RightSlope = RightSlope;
+        out.LeftSlope = LeftSlope;
+        out.TopSlope = TopSlope;
+        out.BottomSlope = BottomSlope;
+    }
+    ContainmentType
+    Contains (BoundingBox const & box) const {
+        XMVECTOR origin = XMLoadFloat3(&Origin);
+        XMVECTOR orientation = XMLoadFloat4(&Orientation);
+        XMVECTOR planes [6] = {
+            XMVectorSet(0.0f, 0.0f, -1.0f, Near),
+            XMVectorSet(0.0f, 0.0f, 1.0f, -Far),
+            XMVectorSet(1.0f, 0.0f, -RightSlope, 0.0f),
+            XMVectorSet(-1.0f, 0.0f, LeftSlope, 0.0f),
+            XMVectorSet(0.0f, 1.0f, -TopSlope, 0.0f),
+            XMVectorSet(0.0f, -1.0f, BottomSlope, 0.0f),
+        };
+        for (int p = 0; p < 6; ++p) {
+            XMVECTOR normal = XMVector3Rotate(planes[p], orientation);
+            float d = XMVectorGetW(planes[p]) - XMVectorGetX(XMVector3Dot(normal, origin));
+            planes[p] = XMPlaneNormalize(XMVectorSetW(normal, d));
+        }
+        return box.ContainedBy(planes, 6);
+    }
+};
+
+namespace TriangleTests {
+
+// Ray (origin, normalized direction) against the triangle (v0, v1, v2), either side facing
+inline bool
+Intersects (FXMVECTOR origin, FXMVECTOR direction, FXMVECTOR v0, GXMVECTOR v1, HXMVECTOR v2, float & dist) {
+    float const epsilon = 1e-20f;
+    XMVECTOR e1 = v1 - v0;
+    XMVECTOR e2 = v2 - v0;
+    XMVECTOR p = XMVector3Cross(direction, e2);
+    float det = XMVectorGetX(XMVector3Dot(e1, p));
+    XMVECTOR s = origin - v0;
+    float u = XMVectorGetX(XMVector3Dot(s, p));
+    XMVECTOR q = XMVector3Cross(s, e1);
+    float v = XMVectorGetX(XMVector3Dot(direction, q));
+    if (det >= epsilon) {
+        if (u < 0.0f || u > det || v < 0.0f || u + v > det) {
+            dist = 0.0f;
+            return false;
+        }
+    } else if (det <= -epsilon) {
+        if (u > 0.0f || u < det || v > 0.0f || u + v < det) {
+            dist = 0.0f;
+            return false;
+        }
+    } else {
+        dist = 0.0f;        // parallel
+        return false;
+    }
+    float t = XMVectorGetX(XMVector3Dot(e2, q)) / det;
+    if (t < 0.0f) {
+        dist = 0.0f;
+        return false;
+    }
+    dist = t;
+    return true;
+}
+
+} // namespace TriangleTests
+
+} // namespace DirectX
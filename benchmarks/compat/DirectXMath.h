@@ -0,0 +1,323 @@
+/* ===========================================================
+   #File: DirectXMath.h #
+   #Date: 17 Oct 2026 #
+   #Revision: 1.0 #
+   #Creator: Omid Miresmaeili #
+   #Description: SSE subset of DirectXMath for building the culling code on Linux #
+   #Notice: (C) Copyright 2021 by Omid. All Rights Reserved. #
+   =========================================================== */
+#pragma once
+
+// Same types, conventions (row vectors, left handed) and results as DirectXMath for the
+// functions the demos' CPU code calls. XMVECTOR is __m128 like in DirectXMath's SSE path;
+// the arithmetic operators are the compiler's vector extensions.
+
+#include <math.h>
+#include <xmmintrin.h>
+#include <emmintrin.h>
+
+namespace DirectX {
+
+typedef __m128 XMVECTOR;
+typedef XMVECTOR const FXMVECTOR;
+typedef XMVECTOR const GXMVECTOR;
+typedef XMVECTOR const HXMVECTOR;
+
+struct alignas(16) XMMATRIX {
+    XMVECTOR r [4];
+};
+
+struct XMFLOAT2 {
+    float x, y;
+    XMFLOAT2 () = default;
+    constexpr XMFLOAT2 (float _x, float _y) : x(_x), y(_y) {}
+};
+struct XMFLOAT3 {
+    float x, y, z;
+    XMFLOAT3 () = default;
+    constexpr XMFLOAT3 (float _x, float _y, float _z) : x(_x), y(_y), z(_z) {}
+};
+struct XMFLOAT4 {
+    float x, y, z, w;
+    XMFLOAT4 () = default;
+    constexpr XMFLOAT4 (float _x, float _y, float _z, float _w) : x(_x), y(_y), z(_z), w(_w) {}
+};
+struct XMFLOAT4X4 {
+    float m [4][4];
+    XMFLOAT4X4 () = default;
+    constexpr XMFLOAT4X4 (
+        float m00, float m01, float m02, float m03,
+        float m10, float m11, float m12, float m13,
+        float m20, float m21, float m22, float m23,
+        float m30, float m31, float m32, float m33
+    ) : m{{m00, m01, m02, m03}, {m10, m11, m12, m13}, {m20, m21, m22, m23}, {m30, m31, m32, m33}} {}
+};
+
+constexpr float XM_PI       = 3.141592654f;
+constexpr float XM_2PI      = 6.283185307f;
+constexpr float XM_PIDIV2   = 1.570796327f;
+
+inline constexpr float XMConvertToRadians (float degrees) { return degrees * (XM_PI / 180.0f); }
+
+//
+// Vectors
+//
+inline XMVECTOR XMVectorSet (float x, float y, float z, float w) { return _mm_set_ps(w, z, y, x); }
+inline XMVECTOR XMVectorReplicate (float s) { return _mm_set1_ps(s); }
+inline XMVECTOR XMVectorZero () { return _mm_setzero_ps(); }
+inline float XMVectorGetX (FXMVECTOR v) { return _mm_cvtss_f32(v); }
+inline float XMVectorGetY (FXMVECTOR v) { return _mm_cvtss_f32(_mm_shuffle_ps(v, v, _MM_SHUFFLE(1, 1, 1, 1))); }
+inline float XMVectorGetZ (FXMVECTOR v) { return _mm_cvtss_f32(_mm_shuffle_ps(v, v, _MM_SHUFFLE(2, 2, 2, 2))); }
+inline float XMVectorGetW (FXMVECTOR v) { return _mm_cvtss_f32(_mm_shuffle_ps(v, v, _MM_SHUFFLE(3, 3, 3, 3))); }
+inline XMVECTOR XMVectorSplatX (FXMVECTOR v) { return _mm_shuffle_ps(v, v, _MM_SHUFFLE(0, 0, 0, 0)); }
+inline XMVECTOR XMVectorSplatY (FXMVECTOR v) { return _mm_shuffle_ps(v, v, _MM_SHUFFLE(1, 1, 1, 1)); }
+inline XMVECTOR XMVectorSplatZ (FXMVECTOR v) { return _mm_shuffle_ps(v, v, _MM_SHUFFLE(2, 2, 2, 2)); }
+inline XMVECTOR XMVectorSplatW (FXMVECTOR v) { return _mm_shuffle_ps(v, v, _MM_SHUFFLE(3, 3, 3, 3)); }
+inline XMVECTOR XMVectorSetW (FXMVECTOR v, float w) { return _mm_shuffle_ps(v, _mm_unpackhi_ps(v, _mm_set1_ps(w)), _MM_SHUFFLE(3, 0, 1, 0)); }
+inline XMVECTOR XMVectorAbs (FXMVECTOR v) { return _mm_andnot_ps(_mm_set1_ps(-0.0f), v); }
+inline XMVECTOR XMVectorMin (FXMVECTOR a, FXMVECTOR b) { return _mm_min_ps(a, b); }
+inline XMVECTOR XMVectorMax (FXMVECTOR a, FXMVECTOR b) { return _mm_max_ps(a, b); }
+
+inline XMVECTOR XMLoadFloat3 (XMFLOAT3 const * p) { return _mm_set_ps(0.0f, p->z, p->y, p->x); }
+inline XMVECTOR XMLoadFloat4 (XMFLOAT4 const * p) { return _mm_loadu_ps(&p->x); }
+inline void XMStoreFloat3 (XMFLOAT3 * p, FXMVECTOR v) { p->x = XMVectorGetX(v); p->y = XMVectorGetY(v); p->z = XMVectorGetZ(v); }
+inline void XMStoreFloat4 (XMFLOAT4 * p, FXMVECTOR v) { _mm_storeu_ps(&p->x, v); }
+
+inline XMVECTOR
+XMVector3Dot (FXMVECTOR a, FXMVECTOR b) {
+    XMVECTOR m = _mm_mul_ps(a, b);
+    return _mm_set1_ps(XMVectorGetX(m) + XMVectorGetY(m) + XMVectorGetZ(m));
+}
+inline XMVECTOR
+XMVector4Dot (FXMVECTOR a, FXMVECTOR b) {
+    XMVECTOR m = _mm_mul_ps(a, b);
+    m = _mm_add_ps(m, _mm_shuffle_ps(m, m, _MM_SHUFFLE(2, 3, 0, 1)));
+    return _mm_add_ps(m, _mm_shuffle_ps(m, m, _MM_SHUFFLE(1, 0, 3, 2)));
+}
+inline XMVECTOR
+XMVector3Cross (FXMVECTOR a, FXMVECTOR b) {
+    XMVECTOR a_yzx = _mm_shuffle_ps(a, a, _MM_SHUFFLE(3, 0, 2, 1));
+    XMVECTOR b_yzx = _mm_shuffle_ps(b, b, _MM_SHUFFLE(3, 0, 2, 1));
+    XMVECTOR c = _mm_sub_ps(_mm_mul_ps(a, b_yzx), _mm_mul_ps(a_yzx, b));
+    return _mm_shuffle_ps(c, c, _MM_SHUFFLE(3, 0, 2, 1));
+}
+inline XMVECTOR XMVector3LengthSq (FXMVECTOR v) { return XMVector3Dot(v, v); }
+inline XMVECTOR XMVector3Length (FXMVECTOR v) { return _mm_sqrt_ps(XMVector3Dot(v, v)); }
+inline XMVECTOR
+XMVector3Normalize (FXMVECTOR v) {
+    XMVECTOR length = XMVector3Length(v);
+    return XMVectorGetX(length) > 0.0f ? _mm_div_ps(v, length) : v;
+}
+inline XMVECTOR
+XMPlaneNormalize (FXMVECTOR p) {
+    XMVECTOR length = XMVector3Length(p);
+    return XMVectorGetX(length) > 0.0f ? _mm_div_ps(p, length) : p;
+}
+
+//
+// Matrices
+//
+inline XMVECTOR
+XMVector4Transform (FXMVECTOR v, XMMATRIX const & m) {
+    XMVECTOR r = _mm_mul_ps(XMVectorSplatX(v), m.r[0]);
+    r = _mm_add_ps(r, _mm_mul_ps(XMVectorSplatY(v), m.r[1]));
+    r = _mm_add_ps(r, _mm_mul_ps(XMVectorSplatZ(v), m.r[2]));
+    return _mm_add_ps(r, _mm_mul_ps(XMVectorSplatW(v), m.r[3]));
+}
+inline XMVECTOR
+XMVector3Transform (FXMVECTOR v, XMMATRIX const & m) {
+    XMVECTOR r = _mm_mul_ps(XMVectorSplatX(v), m.r[0]);
+    r = _mm_add_ps(r, _mm_mul_ps(XMVectorSplatY(v), m.r[1]));
+    r = _mm_add_ps(r, _mm_mul_ps(XMVectorSplatZ(v), m.r[2]));
+    return _mm_add_ps(r, m.r[3]);
+}
+inline XMVECTOR
+XMVector3TransformCoord (FXMVECTOR v, XMMATRIX const & m) {
+    XMVECTOR r = XMVector3Transform(v, m);
+    return _mm_div_ps(r, XMVectorSplatW(r));
+}
+inline XMVECTOR
+XMVector3TransformNormal (FXMVECTOR v, XMMATRIX const & m) {
+    XMVECTOR r = _mm_mul_ps(XMVectorSplatX(v), m.r[0]);
+    r = _mm_add_ps(r, _mm_mul_ps(XMVectorSplatY(v), m.r[1]));
+    return _mm_add_ps(r, _mm_mul_ps(XMVectorSplatZ(v), m.r[2]));
+}
+inline XMMATRIX
+XMLoadFloat4x4 (XMFLOAT4X4 const * p) {
+    XMMATRIX m;
+    for (int i = 0; i < 4; ++i)
+        m.r[i] = _mm_loadu_ps(p->m[i]);
+    return m;
+}
+inline void
+XMStoreFloat4x4 (XMFLOAT4X4 * p, XMMATRIX const & m) {
+    for (int i = 0; i < 4; ++i)
+        _mm_storeu_ps(p->m[i], m.r[i]);
+}
+inline XMMATRIX
+XMMatrixIdentity () {
+    return {{XMVectorSet(1, 0, 0, 0), XMVectorSet(0, 1, 0, 0), XMVectorSet(0, 0, 1, 0), XMVectorSet(0, 0, 0, 1)}};
+}
+inline XMMATRIX
+XMMatrixMultiply (XMMATRIX const & a, XMMATRIX const & b) {
+    XMMATRIX r;
+    for (int i = 0; i < 4; ++i)
+        r.r[i] = XMVector4Transform(a.r[i], b);
+    return r;
+}
+inline XMMATRIX operator* (XMMATRIX const & a, XMMATRIX const & b) { return XMMatrixMultiply(a, b); }
+inline XMMATRIX
+XMMatrixTranspose (XMMATRIX const & m) {
+    XMMATRIX r = m;
+    _MM_TRANSPOSE4_PS(r.r[0], r.r[1], r.r[2], r.r[3]);
+    return r;
+}
+// 2x2 sub-determinants of the transposed matrix (Cramer's rule), as DirectXMath's scalar path
+inline XMVECTOR
+XMMatrixDeterminant (XMMATRIX const & m) {
+    float a [4][4];
+    for (int i = 0; i < 4; ++i)
+        _mm_storeu_ps(a[i], m.r[i]);
+    float s0 = a[2][2] * a[3][3] - a[2][3] * a[3][2];
+    float s1 = a[2][1] * a[3][3] - a[2][3] * a[3][1];
+    float s2 = a[2][1] * a[3][2] - a[2][2] * a[3][1];
+    float s3 = a[2][0] * a[3][3] - a[2][3] * a[3][0];
+    float s4 = a[2][0] * a[3][2] - a[2][2] * a[3][0];
+    float s5 = a[2][0] * a[3][1] - a[2][1] * a[3][0];
+    float det =
+        a[0][0] * (a[1][1] * s0 - a[1][2] * s1 + a[1][3] * s2) -
+        a[0][1] * (a[1][0] * s0 - a[1][2] * s3 + a[1][3] * s4) +
+        a[0][2] * (a[1][0] * s1 - a[1][1] * s3 + a[1][3] * s5) -
+        a[0][3] * (a[1][0] * s2 - a[1][1] * s4 + a[1][2] * s5);
+    return _mm_set1_ps(det);
+}
+inline XMMATRIX
+XMMatrixInverse (XMVECTOR * out_det, XMMATRIX const & m) {
+    float a [4][4];
+    for (int i = 0; i < 4; ++i)
+        _mm_storeu_ps(a[i], m.r[i]);
+    float s0 = a[0][0] * a[1][1] - a[1][0] * a[0][1];
+    float s1 = a[0][0] * a[1][2] - a[1][0] * a[0][2];
+    float s2 = a[0][0] * a[1][3] - a[1][0] * a[0][3];
+    float s3 = a[0][1] * a[1][2] - a[1][1] * a[0][2];
+    float s4 = a[0][1] * a[1][3] - a[1][1] * a[0][3];
+    float s5 = a[0][2] * a[1][3] - a[1][2] * a[0][3];
+    float c5 = a[2][2] * a[3][3] - a[3][2] * a[2][3];
+    float c4 = a[2][1] * a[3][3] - a[3][1] * a[2][3];
+    float c3 = a[2][1] * a[3][2] - a[3][1] * a[2][2];
+    float c2 = a[2][0] * a[3][3] - a[3][0] * a[2][3];
+    float c1 = a[2][0] * a[3][2] - a[3][0] * a[2][2];
+    float c0 = a[2][0] * a[3][1] - a[3][0] * a[2][1];
+    float det = s0 * c5 - s1 * c4 + s2 * c3 + s3 * c2 - s4 * c1 + s5 * c0;
+    if (out_det)
+        *out_det = _mm_set1_ps(det);
+    float inv_det = 1.0f / det;
+    XMFLOAT4X4 r (
+        ( a[1][1] * c5 - a[1][2] * c4 + a[1][3] * c3) * inv_det,
+        (-a[0][1] * c5 + a[0][2] * c4 - a[0][3] * c3) * inv_det,
+        ( a[3][1] * s5 - a[3][2] * s4 + a[3][3] * s3) * inv_det,
+        (-a[2][1] * s5 + a[2][2] * s4 - a[2][3] * s3) * inv_det,
+        (-a[1][0] * c5 + a[1][2] * c2 - a[1][3] * c1) * inv_det,
+        ( a[0][0] * c5 - a[0][2] * c2 + a[0][3] * c1) * inv_det,
+        (-a[3][0] * s5 + a[3][2] * s2 - a[3][3] * s1) * inv_det,
+        ( a[2][0] * s5 - a[2][2] * s2 + a[2][3] * s1) * inv_det,
+        ( a[1][0] * c4 - a[1][1] * c2 + a[1][3] * c0) * inv_det,
+        (-a[0][0] * c4 + a[0][1] * c2 - a[0][3] * c0) * inv_det,
+        ( a[3][0] * s4 - a[3][1] * s2 + a[3][3] * s0) * inv_det,
+        (-a[2][0] * s4 + a[2][1] * s2 - a[2][3] * s0) * inv_det,
+        (-a[1][0] * c3 + a[1][1] * c1 - a[1][2] * c0) * inv_det,
+        ( a[0][0] * c3 - a[0][1] * c1 + a[0][2] * c0) * inv_det,
+        (-a[3][0] * s3 + a[3][1] * s1 - a[3][2] * s0) * inv_det,
+        ( a[2][0] * s3 - a[2][1] * s1 + a[2][2] * s0) * inv_det
+    );
+    return XMLoadFloat4x4(&r);
+}
+inline XMMATRIX
+XMMatrixScaling (float x, float y, float z) {
+    return {{XMVectorSet(x, 0, 0, 0), XMVectorSet(0, y, 0, 0), XMVectorSet(0, 0, z, 0), XMVectorSet(0, 0, 0, 1)}};
+}
+inline XMMATRIX
+XMMatrixTranslation (float x, float y, float z) {
+    return {{XMVectorSet(1, 0, 0, 0), XMVectorSet(0, 1, 0, 0), XMVectorSet(0, 0, 1, 0), XMVectorSet(x, y, z, 1)}};
+}
+inline XMMATRIX
+XMMatrixRotationY (float angle) {
+    float s = sinf(angle), c = cosf(angle);
+    return {{XMVectorSet(c, 0, -s, 0), XMVectorSet(0, 1, 0, 0), XMVectorSet(s, 0, c, 0), XMVectorSet(0, 0, 0, 1)}};
+}
+inline XMMATRIX
+XMMatrixLookToLH (FXMVECTOR eye, FXMVECTOR look, FXMVECTOR up) {
+    XMVECTOR z = XMVector3Normalize(look);
+    XMVECTOR x = XMVector3Normalize(XMVector3Cross(up, z));
+    XMVECTOR y = XMVector3Cross(z, x);
+    XMMATRIX m = {{
+        XMVectorSetW(x, -XMVectorGetX(XMVector3Dot(x, eye))),
+        XMVectorSetW(y, -XMVectorGetX(XMVector3Dot(y, eye))),
+        XMVectorSetW(z, -XMVectorGetX(XMVector3Dot(z, eye))),
+        XMVectorSet(0, 0, 0, 1)
+    }};
+    return XMMatrixTranspose(m);
+}
+inline XMMATRIX
+XMMatrixLookAtLH (FXMVECTOR eye, FXMVECTOR at, FXMVECTOR up) {
+    return XMMatrixLookToLH(eye, _mm_sub_ps(at, eye), up);
+}
+inline XMMATRIX
+XMMatrixPerspectiveFovLH (float fov_y, float aspect, float near_z, float far_z) {
+    float h = 1.0f / tanf(0.5f * fov_y);
+    float range = far_z / (far_z - near_z);
+    return {{
+        XMVectorSet(h / aspect, 0, 0, 0),
+        XMVectorSet(0, h, 0, 0),
+        XMVectorSet(0, 0, range, 1),
+        XMVectorSet(0, 0, -range * near_z, 0)
+    }};
+}
+
+//
+// Quaternions (x, y, z, w), as used by BoundingFrustum
+//
+inline XMVECTOR
+XMQuaternionMultiply (FXMVECTOR q1, FXMVECTOR q2) {
+    // q1 then q2 (DirectXMath's order: the result is q2 * q1)
+    XMFLOAT4 a, b;
+    XMStoreFloat4(&a, q1);
+    XMStoreFloat4(&b, q2);
+    return XMVectorSet(
+        b.w * a.x + b.x * a.w + b.y * a.z - b.z * a.y,
+        b.w * a.y - b.x * a.z + b.y * a.w + b.z * a.x,
+        b.w * a.z + b.x * a.y - b.y * a.x + b.z * a.w,
+        b.w * a.w - b.x * a.x - b.y * a.y - b.z * a.z);
+}
+inline XMVECTOR
+XMQuaternionConjugate (FXMVECTOR q) {
+    return _mm_xor_ps(q, _mm_set_ps(0.0f, -0.0f, -0.0f, -0.0f));
+}
+inline XMVECTOR
+XMVector3Rotate (FXMVECTOR v, FXMVECTOR q) {
+    XMVECTOR p = XMVectorSetW(v, 0.0f);
+    return XMQuaternionMultiply(XMQuaternionMultiply(XMQuaternionConjugate(q), p), q);
+}
+inline XMVECTOR
+XMQuaternionRotationMatrix (XMMATRIX const & m) {
+    float a [4][4];
+    for (int i = 0; i < 4; ++i)
+        _mm_storeu_ps(a[i], m.r[i]);
+    float trace = a[0][0] + a[1][1] + a[2][2];
+    if (trace > 0.0f) {
+        float s = 2.0f * sqrtf(trace + 1.0f);
+        return XMVectorSet((a[1][2] - a[2][1]) / s, (a[2][0] - a[0][2]) / s, (a[0][1] - a[1][0]) / s, 0.25f * s);
+    }
+    if (a[0][0] > a[1][1] && a[0][0] > a[2][2]) {
+        float s = 2.0f * sqrtf(1.0f + a[0][0] - a[1][1] - a[2][2]);
+        return XMVectorSet(0.25f * s, (a[0][1] + a[1][0]) / s, (a[2][0] + a[0][2]) / s, (a[1][2] - a[2][1]) / s);
+    }
+    if (a[1][1] > a[2][2]) {
+        float s = 2.0f * sqrtf(1.0f + a[1][1] - a[0][0] - a[2][2]);
+        return XMVectorSet((a[0][1] + a[1][0]) / s, 0.25f * s, (a[1][2] + a[2][1]) / s, (a[2][0] - a[0][2]) / s);
+    }
+    float s = 2.0f * sqrtf(1.0f + a[2][2] - a[0][0] - a[1][1]);
+    return XMVectorSet((a[2][0] + a[0][2]) / s, (a[1][2] + a[2][1]) / s, 0.25f * s, (a[0][1] - a[1][0]) / s);
+}
+
+} // namespace DirectX
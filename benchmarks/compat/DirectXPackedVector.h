@@ -0,0 +1,48 @@
+/* ===========================================================
+   #File: DirectXPackedVector.h #
+   #Date: 17 Oct 2026 #
+   #Revision: 1.0 #
+   #Creator: Omid Miresmaeili #
+   #Description: half precision conversion of DirectXPackedVector for Linux builds #
+   #Notice: (C) Copyright 2021 by Omid. All Rights Reserved. #
+   =========================================================== */
+#pragma once
+
+#include <stdint.h>
+#include <string.h>
+
+namespace DirectX {
+namespace PackedVector {
+
+typedef uint16_t HALF;
+
+// DirectXMath's scalar conversion (round to nearest even, no F16C needed)
+inline HALF
+XMConvertFloatToHalf (float value) {
+    uint32_t bits;
+    memcpy(&bits, &value, sizeof(bits));
+    uint32_t sign = (bits & 0x80000000u) >> 16u;
+    bits &= 0x7fffffffu;
+    uint32_t result;
+    if (bits >= 0x47800000u) {
+        // too large: infinity, or NaN keeping its payload
+        result = 0x7c00u | ((bits > 0x7f800000u) ? (0x200u | ((bits >> 13u) & 0x3ffu)) : 0u);
+    } else if (bits <= 0x33000000u) {
+        result = 0;
+    } else if (bits < 0x38800000u) {
+        // too small for a normalized half: denormal
+        uint32_t shift = 125u - (bits >> 23u);
+        bits = 0x800000u | (bits & 0x7fffffu);
+        result = bits >> (shift + 1);
+        uint32_t sticky = (bits & ((1u << shift) - 1)) != 0;
+        result += (result | sticky) & ((bits >> shift) & 1u);
+    } else {
+        // rebias the exponent
+        bits += 0xc8000000u;
+        result = ((bits + 0x0fffu + ((bits >> 13u) & 1u)) >> 13u) & 0x7fffu;
+    }
+    return (HALF)(result | sign);
+}
+
+} // namespace PackedVector
+} // namespace DirectX
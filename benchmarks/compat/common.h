@@ -0,0 +1,276 @@
+/* ===========================================================
+   #File: common.h #
+   #Date: 17 Oct 2026 #
+   #Revision: 1.0 #
+   #Creator: Omid Miresmaeili #
+   #Description: Linux stand-in of the demos' common.h for the CPU only benchmarks #
+   #Notice: (C) Copyright 2021 by Omid. All Rights Reserved. #
+   =========================================================== */
+#pragma once
+
+// Only what the culling, picking and mesh loading headers and the benchmarks use: Win32
+// integer types, the assert macros, debug output, the CRT _s functions, threads / SRW locks /
+// condition variables on pthreads, the Win32 file calls of the mesh cache (which always fail,
+// so only the text parser runs), and the DirectXMath and DirectXCollision subsets in this directory.
+
+#include <stdint.h>
+#include <limits.h>
+#include <float.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+#include <math.h>
+#include <time.h>
+#include <unistd.h>
+#include <pthread.h>
+
+typedef uint8_t         BYTE;
+typedef int32_t         INT;
+typedef uint32_t        UINT;
+typedef uint16_t        UINT16;
+typedef uint32_t        UINT32;
+typedef uint64_t        UINT64;
+typedef int64_t         INT64;
+typedef uint32_t        DWORD;
+typedef int             BOOL;
+typedef long            LONG;
+typedef long long       LONGLONG;
+typedef void *          HANDLE;
+typedef void *          LPVOID;
+
+typedef union {
+    struct {
+        DWORD   LowPart;
+        LONG    HighPart;
+    };
+    LONGLONG    QuadPart;
+} LARGE_INTEGER;
+
+typedef int             errno_t;
+
+#define TRUE        1
+#define FALSE       0
+#define INFINITE    0xffffffff
+#define WINAPI
+#define MAX_PATH    260
+
+#define _T(x)                       x
+#define _ASSERT_EXPR(exp, msg)      assert((exp) && msg)
+#define UNREFERENCED_PARAMETER(p)   (void)(p)
+
+#define SIMPLE_ASSERT(exp, msg)  \
+    if(!(exp)) {            \
+        ::fprintf(stderr, "[ERROR] %s() failed at line %d. \n" #msg "\n", __FUNCTION__, __LINE__); \
+        ::abort();          \
+    }
+
+enum DXGI_FORMAT {
+    DXGI_FORMAT_UNKNOWN     = 0,
+    DXGI_FORMAT_R32_UINT    = 42,
+    DXGI_FORMAT_R16_UINT    = 57,
+};
+
+#include "DirectXMath.h"
+#include "DirectXCollision.h"
+
+//
+// Debug output
+//
+template <typename... Args> inline int
+sprintf_s (char * buffer, size_t size, char const * format, Args... args) {
+    return snprintf(buffer, size, format, args...);
+}
+template <size_t size, typename... Args> inline int
+sprintf_s (char (&buffer) [size], char const * format, Args... args) {
+    return snprintf(buffer, size, format, args...);
+}
+inline void
+OutputDebugStringA (char const * str) {
+    fputs(str, stderr);
+}
+
+//
+// CRT
+//
+inline errno_t
+fopen_s (FILE ** file, char const * path, char const * mode) {
+    *file = fopen(path, mode);
+    return *file ? 0 : -1;
+}
+// Only used with numeric conversions, which take no buffer sizes
+template <typename... Args> inline int
+sscanf_s (char const * buffer, char const * format, Args... args) {
+    return sscanf(buffer, format, args...);
+}
+
+//
+// Timer
+//
+inline BOOL
+QueryPerformanceCounter (LARGE_INTEGER * counter) {
+    timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    counter->QuadPart = (LONGLONG)ts.tv_sec * 1000000000ll + ts.tv_nsec;
+    return TRUE;
+}
+inline BOOL
+QueryPerformanceFrequency (LARGE_INTEGER * frequency) {
+    frequency->QuadPart = 1000000000ll;
+    return TRUE;
+}
+
+//
+// Threads
+//
+typedef DWORD (*LPTHREAD_START_ROUTINE)(LPVOID);
+
+struct CompatThread {
+    pthread_t               thread;
+    LPTHREAD_START_ROUTINE  func;
+    LPVOID                  param;
+};
+struct SYSTEM_INFO {
+    DWORD   dwNumberOfProcessors;
+};
+
+static void *
+compat_thread_main (void * param) {
+    CompatThread * t = (CompatThread *)param;
+    t->func(t->param);
+    return nullptr;
+}
+inline HANDLE
+CreateThread (void *, size_t, LPTHREAD_START_ROUTINE func, LPVOID param, DWORD, DWORD *) {
+    CompatThread * t = (CompatThread *)::malloc(sizeof(CompatThread));
+    t->func = func;
+    t->param = param;
+    if (0 != pthread_create(&t->thread, nullptr, compat_thread_main, t)) {
+        ::free(t);
+        return nullptr;
+    }
+    return t;
+}
+// Only waits for all of them (the benchmarks never wait for any single one)
+inline DWORD
+WaitForMultipleObjects (DWORD count, HANDLE const * handles, BOOL, DWORD) {
+    for (DWORD i = 0; i < count; ++i)
+        pthread_join(((CompatThread *)handles[i])->thread, nullptr);
+    return 0;
+}
+inline BOOL
+CloseHandle (HANDLE handle) {
+    ::free(handle);
+    return TRUE;
+}
+inline void
+GetSystemInfo (SYSTEM_INFO * info) {
+    info->dwNumberOfProcessors = (DWORD)sysconf(_SC_NPROCESSORS_ONLN);
+}
+inline LONG
+InterlockedIncrement (LONG volatile * value) {
+    return __atomic_add_fetch(value, 1, __ATOMIC_SEQ_CST);
+}
+
+//
+// SRW locks and condition variables (only the exclusive mode is used)
+//
+struct SRWLOCK {
+    pthread_mutex_t mutex;
+};
+struct CONDITION_VARIABLE {
+    pthread_cond_t  cond;
+};
+inline void
+InitializeSRWLock (SRWLOCK * lock) {
+    pthread_mutex_init(&lock->mutex, nullptr);
+}
+inline void
+AcquireSRWLockExclusive (SRWLOCK * lock) {
+    pthread_mutex_lock(&lock->mutex);
+}
+inline void
+ReleaseSRWLockExclusive (SRWLOCK * lock) {
+    pthread_mutex_unlock(&lock->mutex);
+}
+inline void
+InitializeConditionVariable (CONDITION_VARIABLE * cv) {
+    pthread_cond_init(&cv->cond, nullptr);
+}
+inline BOOL
+SleepConditionVariableSRW (CONDITION_VARIABLE * cv, SRWLOCK * lock, DWORD, unsigned long) {
+    pthread_cond_wait(&cv->cond, &lock->mutex);
+    return TRUE;
+}
+inline void
+WakeAllConditionVariable (CONDITION_VARIABLE * cv) {
+    pthread_cond_broadcast(&cv->cond);
+}
+
+//
+// Files (the binary mesh cache is never read or written by the benchmarks)
+//
+#define INVALID_HANDLE_VALUE        ((HANDLE)(intptr_t)-1)
+#define GENERIC_READ                0x80000000
+#define GENERIC_WRITE               0x40000000
+#define FILE_SHARE_READ             0x00000001
+#define CREATE_ALWAYS               2
+#define OPEN_EXISTING               3
+#define FILE_ATTRIBUTE_NORMAL       0x00000080
+#define FILE_FLAG_SEQUENTIAL_SCAN   0x08000000
+#define MOVEFILE_REPLACE_EXISTING   0x00000001
+#define PAGE_READONLY               0x02
+#define FILE_MAP_READ               0x0004
+
+struct FILETIME {
+    DWORD   dwLowDateTime;
+    DWORD   dwHighDateTime;
+};
+struct WIN32_FILE_ATTRIBUTE_DATA {
+    DWORD       dwFileAttributes;
+    FILETIME    ftCreationTime;
+    FILETIME    ftLastAccessTime;
+    FILETIME    ftLastWriteTime;
+    DWORD       nFileSizeHigh;
+    DWORD       nFileSizeLow;
+};
+enum GET_FILEEX_INFO_LEVELS {
+    GetFileExInfoStandard
+};
+
+inline BOOL
+GetFileAttributesExA (char const *, GET_FILEEX_INFO_LEVELS, void *) {
+    return FALSE;
+}
+inline HANDLE
+CreateFileA (char const *, DWORD, DWORD, void *, DWORD, DWORD, HANDLE) {
+    return INVALID_HANDLE_VALUE;
+}
+inline BOOL
+GetFileSizeEx (HANDLE, LARGE_INTEGER *) {
+    return FALSE;
+}
+inline BOOL
+WriteFile (HANDLE, void const *, DWORD, DWORD *, void *) {
+    return FALSE;
+}
+inline BOOL
+MoveFileExA (char const *, char const *, DWORD) {
+    return FALSE;
+}
+inline BOOL
+DeleteFileA (char const *) {
+    return FALSE;
+}
+inline HANDLE
+CreateFileMappingA (HANDLE, void *, DWORD, DWORD, DWORD, char const *) {
+    return nullptr;
+}
+inline void *
+MapViewOfFile (HANDLE, DWORD, DWORD, DWORD, size_t) {
+    return nullptr;
+}
+inline BOOL
+UnmapViewOfFile (void const *) {
+    return FALSE;
+}
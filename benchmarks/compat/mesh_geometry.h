@@ -0,0 +1,60 @@
+/* ===========================================================
+   #File: mesh_geometry.h #
+   #Date: 17 Oct 2026 #
+   #Revision: 1.0 #
+   #Creator: Omid Miresmaeili #
+   #Description: submesh and system memory subset of the demos' mesh_geometry.h #
+   #Notice: (C) Copyright 2021 by Omid. All Rights Reserved. #
+   =========================================================== */
+#pragma once
+
+#include "common.h"
+
+// Only the fields triangle_bvh.h and mesh_loader.h read; the GPU buffers, meshlets and LODs are left out
+
+#define MAX_SUBMESH_COUNT    50
+
+enum VERTEX_ENCODING : UINT {
+    VERTEX_ENCODING_FLOAT32 = 0,
+    VERTEX_ENCODING_QUANTIZED = 1,
+
+    _COUNT_VERTEX_ENCODING
+};
+
+// System memory copy of a buffer (ID3DBlob). Release only frees blobs made by D3DCreateBlob.
+struct ID3DBlob {
+    void *  data;
+
+    void * GetBufferPointer () { return data; }
+    void Release () { ::free(data); ::free(this); }
+};
+inline int
+D3DCreateBlob (size_t size, ID3DBlob ** blob) {
+    *blob = (ID3DBlob *)::malloc(sizeof(ID3DBlob));
+    (*blob)->data = ::malloc(size);
+    return 0;
+}
+
+struct SubmeshGeometry {
+    UINT index_count;
+    UINT start_index_location;
+    INT base_vertex_location;
+
+    DirectX::BoundingBox bounds;
+};
+struct MeshGeometry {
+    UINT vb_byte_stide;
+    UINT vb_byte_size;
+    UINT ib_byte_size;
+
+    ID3DBlob * vb_cpu;
+    ID3DBlob * ib_cpu;
+
+    struct TriangleBvh * triangle_bvh;
+
+    DXGI_FORMAT index_format;
+    VERTEX_ENCODING vertex_encoding;
+
+    char const *    submesh_names [MAX_SUBMESH_COUNT];
+    SubmeshGeometry submesh_geoms [MAX_SUBMESH_COUNT];
+};
@@ -0,0 +1,32 @@
+/* ===========================================================
+   #File: utils.h #
+   #Date: 17 Oct 2026 #
+   #Revision: 1.0 #
+   #Creator: Omid Miresmaeili #
+   #Description: shader data and render item subset of the instancing demo's utils.h #
+   #Notice: (C) Copyright 2021 by Omid. All Rights Reserved. #
+   =========================================================== */
+#pragma once
+
+#include "common.h"
+
+using namespace DirectX;
+
+// Must stay identical to InstanceData in instancing_and_frustum_culling/headers/utils.h
+// (packed by pack_instance_data, see instance_compression.h)
+struct InstanceData {
+    XMFLOAT4 world_rows[3];     // transposed affine world matrix (3x4)
+
+    UINT tex_scale;             // half2, texture transform scale
+    UINT tex_offset;            // half2, texture transform offset
+    UINT mat_index_flags;       // material index (low 16 bits), INSTANCE_FLAG_* (high 16 bits)
+    UINT instance_pad0;
+};
+// Only the fields the culling code reads
+struct RenderItem {
+    bool initialized;
+    XMFLOAT4X4 world;
+    UINT index_count;
+    UINT instance_count;
+    BoundingBox bounds;
+};
@@ -0,0 +1,556 @@
+/* ===========================================================
+   #File: cull_bench.cpp #
+   #Date: 17 Oct 2026 #
+   #Revision: 1.0 #
+   #Creator: Omid Miresmaeili #
+   #Description: instance culling benchmark on synthetic scenes, without D3D #
+   #Notice: (C) Copyright 2021 by Omid. All Rights Reserved. #
+   =========================================================== */
+
+//
+// Culling benchmark
+//
+// Replays the instance update of the instancing demo (update_instance_buffer) on the
+// CPU with the demo's own headers: for every scene, instance count and culling strategy
+// a camera flies a fixed path while a few instances move each frame, and every frame
+// culls the instances and writes the survivors to an upload buffer (plain memory here).
+// Reports the time per instance, the visible counts and the bytes written as JSON.
+//
+// Usage: cull_bench [--max-instances N] [--frames N] [--threads N]
+//                   [--scenes a,b] [--strategies a,b] [--out file.json]
+//
+
+#include "bench_common.h"
+#include "utils.h"
+#include "instance_culling.h"
+#include "instance_bvh.h"
+#include "instance_compression.h"
+#include "cull_workers.h"
+#include "instance_upload.h"
+#include "screen_coverage.h"
+
+#define BENCH_QUEUING_FRAMES    3           // upload buffers in flight (NUM_QUEUING_FRAMES of the demo)
+#define BENCH_DEFAULT_FRAMES    32
+#define BENCH_VIEWPORT_WIDTH    1280
+#define BENCH_VIEWPORT_HEIGHT   720
+#define BENCH_GRID_SPACING      20.0f       // world units between grid instances (the demo's 200 / 9)
+#define BENCH_MOVED_PERCENT     1           // instances moved every frame
+
+// Strategy flags
+#define STRATEGY_LEGACY         (1u << 0)   // baseline: inverse world and frustum transform per instance
+#define STRATEGY_FRUSTUM        (1u << 1)   // frustum culling of the cached world AABBs
+#define STRATEGY_AVX2           (1u << 2)   // 8-wide kernel (when the CPU has it)
+#define STRATEGY_BVH            (1u << 3)   // instance BVH instead of the linear kernels
+#define STRATEGY_PARALLEL       (1u << 4)   // cull and write on the worker pool
+#define STRATEGY_COVERAGE       (1u << 5)   // small object culling by screen coverage
+
+struct CullStrategy {
+    char const *    name;
+    UINT            flags;
+};
+static CullStrategy const global_strategies [] = {
+    {"legacy_frustum",      STRATEGY_LEGACY},
+    {"no_culling",          0},
+    {"sse",                 STRATEGY_FRUSTUM},
+    {"avx2",                STRATEGY_FRUSTUM | STRATEGY_AVX2},
+    {"bvh",                 STRATEGY_FRUSTUM | STRATEGY_BVH},
+    {"sse_parallel",        STRATEGY_FRUSTUM | STRATEGY_PARALLEL},
+    {"avx2_parallel",       STRATEGY_FRUSTUM | STRATEGY_AVX2 | STRATEGY_PARALLEL},
+    {"avx2_coverage",       STRATEGY_FRUSTUM | STRATEGY_AVX2 | STRATEGY_PARALLEL | STRATEGY_COVERAGE},
+};
+#define STRATEGY_COUNT  (sizeof(global_strategies) / sizeof(global_strategies[0]))
+
+enum SceneKind {
+    SCENE_GRID,             // the demo's 3D grid, grown to the instance count
+    SCENE_CLUSTERS,         // dense random clusters with empty space between them
+    SCENE_LINE_OF_SIGHT,    // flat field of small objects behind rows of walls (most of it behind the walls)
+
+    _COUNT_SCENE
+};
+static char const * global_scene_names [_COUNT_SCENE] = {"grid", "clusters", "line_of_sight"};
+static UINT const global_instance_counts [] = {1000, 10000, 100000, 1000000};
+
+// Instance data of the baseline demo (two full matrices, before instance_compression.h)
+struct LegacyInstanceData {
+    XMFLOAT4X4  world;
+    XMFLOAT4X4  tex_transform;
+    UINT        mat_index;
+    UINT        pad0;
+    UINT        pad1;
+    UINT        pad2;
+};
+
+struct BenchCamera {
+    XMFLOAT3    position;
+    XMFLOAT4X4  view;
+    XMFLOAT4X4  proj;
+    XMFLOAT4X4  view_proj;
+};
+struct BenchWorker {
+    UINT    visible_offset;     // staged survivors in store.visible
+    UINT    visible_count;
+    UINT    slot_offset;        // first instance buffer slot
+    UINT    too_small_count;
+    UINT    slots_written;
+};
+struct BenchContext {
+    UINT                    flags;
+    CullWorkerPool *        pool;
+    BoundingBox             local_bounds;
+
+    InstanceStore           store;
+    InstanceBvh             bvh;
+    InstanceUploadRecord    upload_records [BENCH_QUEUING_FRAMES];
+    InstanceData *          instance_buffers [BENCH_QUEUING_FRAMES];
+    LegacyInstanceData *    legacy_buffer;
+
+    // current frame
+    UINT                    frame_index;
+    CullPlanes              planes;
+    ScreenCoverageParams    coverage;
+    bool                    cull_in_jobs;
+    BenchWorker             workers [CULL_MAX_WORKERS];
+};
+struct BenchResult {
+    double  ns_per_instance;
+    double  ms_per_frame;
+    double  visible_avg;
+    UINT    visible_min;
+    UINT    visible_max;
+    double  bytes_written_per_frame;
+    double  too_small_avg;
+};
+
+//
+// Scenes
+//
+inline XMFLOAT4X4
+scaled_translation (float sx, float sy, float sz, float x, float y, float z) {
+    return XMFLOAT4X4(
+        sx, 0.0f, 0.0f, 0.0f,
+        0.0f, sy, 0.0f, 0.0f,
+        0.0f, 0.0f, sz, 0.0f,
+        x, y, z, 1.0f);
+}
+static void
+generate_scene (InstanceStore * store, SceneKind kind, UINT count) {
+    BenchRandom rng = {0x5eed0000ull + kind};
+    XMFLOAT4X4 tex_transform;
+    XMStoreFloat4x4(&tex_transform, XMMatrixScaling(2.0f, 2.0f, 1.0f));
+    UINT dim = (UINT)ceil(cbrt((double)count));
+    float half_size = 0.5f * BENCH_GRID_SPACING * (float)dim;
+
+    switch (kind) {
+    case SCENE_GRID: {
+        for (UINT index = 0; index < count; ++index) {
+            UINT j = index % dim, i = (index / dim) % dim, k = index / (dim * dim);
+            store->world[index] = scaled_translation(1.0f, 1.0f, 1.0f,
+                -half_size + j * BENCH_GRID_SPACING, -half_size + i * BENCH_GRID_SPACING, -half_size + k * BENCH_GRID_SPACING);
+        }
+    } break;
+    case SCENE_CLUSTERS: {
+        UINT cluster_count = count / 256 > 4 ? count / 256 : 4;
+        cluster_count = cluster_count < 512 ? cluster_count : 512;
+        XMFLOAT3 centers [512];
+        for (UINT c = 0; c < cluster_count; ++c)
+            centers[c] = XMFLOAT3(random_float(&rng, -half_size, half_size), random_float(&rng, -half_size, half_size), random_float(&rng, -half_size, half_size));
+        float radius = half_size / cbrtf((float)cluster_count);
+        for (UINT index = 0; index < count; ++index) {
+            XMFLOAT3 const & c = centers[random_next(&rng) % cluster_count];
+            // sum of two uniforms: denser at the cluster center
+            float x = c.x + 0.5f * (random_float(&rng, -radius, radius) + random_float(&rng, -radius, radius));
+            float y = c.y + 0.5f * (random_float(&rng, -radius, radius) + random_float(&rng, -radius, radius));
+            float z = c.z + 0.5f * (random_float(&rng, -radius, radius) + random_float(&rng, -radius, radius));
+            float s = random_float(&rng, 0.5f, 1.5f);
+            store->world[index] = scaled_translation(s, s, s, x, y, z);
+        }
+    } break;
+    case SCENE_LINE_OF_SIGHT: {
+        // one wall row every 8 rows of objects, walls are 16 grid cells wide
+        UINT side = (UINT)ceil(sqrt((double)count));
+        float half_side = 0.5f * BENCH_GRID_SPACING * (float)side;
+        for (UINT index = 0; index < count; ++index) {
+            UINT col = index % side, row = index / side;
+            float x = -half_side + col * BENCH_GRID_SPACING;
+            float z = -half_side + row * BENCH_GRID_SPACING;
+            if (7 == row % 8 && 0 == col % 2)
+                store->world[index] = scaled_translation(0.5f * BENCH_GRID_SPACING, 8.0f, 0.5f, x, 8.0f, z);
+            else
+                store->world[index] = scaled_translation(1.0f, 1.0f, 1.0f, x + random_float(&rng, -4.0f, 4.0f), 1.0f, z);
+        }
+    } break;
+    default: break;
+    }
+    for (UINT index = 0; index < count; ++index) {
+        store->tex_transform[index] = tex_transform;
+        store->mat_index[index] = index % 8;
+        store->bounds_dirty[index] = true;
+    }
+    store->any_bounds_dirty = true;
+}
+// Camera of frame [frame]: walks through the scene while turning slowly
+static void
+scene_camera (SceneKind kind, UINT count, UINT frame, BenchCamera * out) {
+    float t = (float)frame;
+    float yaw = XMConvertToRadians(0.6f * t);
+    float pitch = SCENE_LINE_OF_SIGHT == kind ? 0.0f : XMConvertToRadians(10.0f);
+    XMVECTOR look = XMVectorSet(sinf(yaw) * cosf(pitch), -sinf(pitch), cosf(yaw) * cosf(pitch), 0.0f);
+    XMVECTOR pos;
+    if (SCENE_LINE_OF_SIGHT == kind) {
+        float half_side = 0.5f * BENCH_GRID_SPACING * (float)ceil(sqrt((double)count));
+        pos = XMVectorSet(3.0f, 3.0f, -0.5f * half_side + 0.7f * t, 1.0f);
+    } else {
+        pos = XMVectorSet(1.0f, 5.0f, 0.7f * t, 1.0f);
+    }
+    XMVECTOR right = XMVector3Normalize(XMVector3Cross(XMVectorSet(0.0f, 1.0f, 0.0f, 0.0f), look));
+    XMVECTOR up = XMVector3Cross(look, right);
+
+    float aspect = (float)BENCH_VIEWPORT_WIDTH / (float)BENCH_VIEWPORT_HEIGHT;
+    float fov_y = 0.25f * XM_PI;
+    float near_z = 1.0f, far_z = 1000.0f;
+    XMMATRIX view = XMMatrixLookToLH(pos, look, up);
+    XMMATRIX proj = XMMatrixPerspectiveFovLH(fov_y, aspect, near_z, far_z);
+
+    XMStoreFloat3(&out->position, pos);
+    XMStoreFloat4x4(&out->view, view);
+    XMStoreFloat4x4(&out->proj, proj);
+    XMStoreFloat4x4(&out->view_proj, XMMatrixMultiply(view, proj));
+}
+// Moves BENCH_MOVED_PERCENT of the instances by a small random offset
+static void
+move_instances (InstanceStore * store, UINT frame) {
+    BenchRandom rng = {0xa11ce000ull + frame};
+    UINT moved = store->count * BENCH_MOVED_PERCENT / 100;
+    moved = moved > 0 ? moved : 1;
+    for (UINT m = 0; m < moved; ++m) {
+        UINT i = random_next(&rng) % store->count;
+        XMFLOAT4X4 world = store->world[i];
+        world.m[3][0] += random_float(&rng, -0.5f, 0.5f);
+        world.m[3][1] += random_float(&rng, -0.5f, 0.5f);
+        world.m[3][2] += random_float(&rng, -0.5f, 0.5f);
+        InstanceStore_SetWorld(store, i, world);
+    }
+}
+
+//
+// Baseline update (update_instance_buffer before the culling rework)
+//
+static UINT
+legacy_update (BenchContext * ctx, BenchCamera const * camera, BoundingFrustum const & cam_frustum) {
+    UINT visible_instance_count = 0;
+    XMMATRIX view = XMLoadFloat4x4(&camera->view);
+    XMVECTOR det_view = XMMatrixDeterminant(view);
+    XMMATRIX inv_view = XMMatrixInverse(&det_view, view);
+
+    uint8_t * instance_begin_ptr = (uint8_t *)ctx->legacy_buffer;
+    for (UINT j = 0; j < ctx->store.count; ++j) {
+        XMMATRIX world = XMLoadFloat4x4(&ctx->store.world[j]);
+        XMMATRIX tex_transform = XMLoadFloat4x4(&ctx->store.tex_transform[j]);
+
+        XMVECTOR det_world = XMMatrixDeterminant(world);
+        XMMATRIX inv_world = XMMatrixInverse(&det_world, world);
+
+        // view space to obj's local space
+        XMMATRIX view_to_local = XMMatrixMultiply(inv_view, inv_world);
+
+        // transform camera frustum from view space to obj's local space
+        BoundingFrustum local_camfrustum;
+        cam_frustum.Transform(local_camfrustum, view_to_local);
+
+        // perform box/frustum intersection test in local space
+        if (local_camfrustum.Contains(ctx->local_bounds) != DirectX::DISJOINT) {
+            LegacyInstanceData data = {};
+            XMStoreFloat4x4(&data.world, XMMatrixTranspose(world));
+            XMStoreFloat4x4(&data.tex_transform, XMMatrixTranspose(tex_transform));
+            data.mat_index = ctx->store.mat_index[j];
+
+            uint8_t * instance_ptr = instance_begin_ptr + (sizeof(LegacyInstanceData) * visible_instance_count++);
+            memcpy(instance_ptr, &data, sizeof(LegacyInstanceData));
+        }
+    }
+    return visible_instance_count;
+}
+
+//
+// Current update (update_instance_buffer of the demo, without LOD groups)
+//
+inline bool
+bench_coverage_visible (BenchContext const * ctx, UINT j) {
+    if (0 == (ctx->flags & STRATEGY_COVERAGE))
+        return true;
+    return screen_coverage(ctx->local_bounds, ctx->store.world[j], ctx->coverage).visible;
+}
+static bool
+bench_write_slot (BenchContext * ctx, UINT slot, UINT j) {
+    UINT buffer = ctx->frame_index % BENCH_QUEUING_FRAMES;
+    if (!InstanceUploadRecord_Update(&ctx->upload_records[buffer], slot, j, ctx->store.version[j]))
+        return false;
+    pack_instance_data(ctx->store.world[j], ctx->store.tex_transform[j], ctx->store.mat_index[j], ctx->instance_buffers[buffer] + slot);
+    return true;
+}
+// Phase 1: frustum culling of a slice (or a share of the BVH survivors), then screen coverage
+static void
+bench_job_frustum (void * param, UINT worker, UINT worker_count) {
+    BenchContext * ctx = (BenchContext *)param;
+    BenchWorker * w = &ctx->workers[worker];
+    InstanceStore * store = &ctx->store;
+    if (ctx->cull_in_jobs) {
+        UINT per_worker = (store->count + worker_count - 1) / worker_count;
+        per_worker = (per_worker + INSTANCE_CULL_LANES - 1) / INSTANCE_CULL_LANES * INSTANCE_CULL_LANES;
+        UINT first = per_worker * worker < store->count ? per_worker * worker : store->count;
+        UINT last = first + per_worker < store->count ? first + per_worker : store->count;
+        w->visible_offset = first;
+        w->visible_count = cull_instance_range(store, &ctx->planes, first, last, store->visible + first, 0 != (ctx->flags & STRATEGY_AVX2));
+    } else {
+        UINT total = store->visible_count;
+        w->visible_offset = (UINT)((uint64_t)total * worker / worker_count);
+        w->visible_count = (UINT)((uint64_t)total * (worker + 1) / worker_count) - w->visible_offset;
+    }
+    w->too_small_count = 0;
+    UINT * staged = store->visible + w->visible_offset;
+    UINT kept = 0;
+    for (UINT v = 0; v < w->visible_count; ++v) {
+        UINT j = staged[v];
+        bool visible = bench_coverage_visible(ctx, j);
+        if (visible)
+            staged[kept++] = j;
+        else
+            ++w->too_small_count;
+    }
+    w->visible_count = kept;
+}
+// Phase 2: a worker's survivors to its slots of the upload buffer
+static void
+bench_job_write (void * param, UINT worker, UINT worker_count) {
+    UNREFERENCED_PARAMETER(worker_count);
+    BenchContext * ctx = (BenchContext *)param;
+    BenchWorker * w = &ctx->workers[worker];
+    w->slots_written = 0;
+    UINT slot = w->slot_offset;
+    for (UINT v = w->visible_offset; v < w->visible_offset + w->visible_count; ++v)
+        w->slots_written += bench_write_slot(ctx, slot++, ctx->store.visible[v]);
+    _mm_sfence();
+}
+// One frame of update_instance_buffer; returns the visible instance count
+static UINT
+bench_update (BenchContext * ctx, BenchCamera const * camera, BenchResult * totals) {
+    InstanceStore * store = &ctx->store;
+    bool parallel = 0 != (ctx->flags & STRATEGY_PARALLEL);
+    bool frustum = 0 != (ctx->flags & STRATEGY_FRUSTUM);
+    UINT worker_count = parallel ? ctx->pool->worker_count : 1;
+
+    ctx->coverage.eye_pos = camera->position;
+    ctx->coverage.proj_scale = coverage_projection_scale(camera->proj, (float)BENCH_VIEWPORT_HEIGHT);
+    ctx->coverage.min_pixels = COVERAGE_MIN_PIXELS;
+    ctx->coverage.shadow_min_pixels = COVERAGE_SHADOW_MIN_PIXELS;
+    cull_extract_planes(XMLoadFloat4x4(&camera->view_proj), &ctx->planes);
+
+    InstanceStore_UpdateBounds(store, ctx->local_bounds);
+    if (ctx->flags & STRATEGY_BVH)
+        InstanceBvh_Refit(&ctx->bvh, store);
+
+    ctx->cull_in_jobs = false;
+    if (frustum && (ctx->flags & STRATEGY_BVH))
+        InstanceBvh_Cull(&ctx->bvh, store, XMLoadFloat4x4(&camera->view_proj));
+    else if (frustum)
+        ctx->cull_in_jobs = true;
+    else
+        InstanceStore_NoCull(store);
+    CullWorkerPool_Run(ctx->pool, bench_job_frustum, ctx, parallel);
+    for (UINT w = 0; w < worker_count; ++w)
+        totals->too_small_avg += ctx->workers[w].too_small_count;
+
+    // -- slots in worker order, staged slices compacted
+    UINT slot = 0;
+    for (UINT w = 0; w < worker_count; ++w) {
+        BenchWorker * cw = &ctx->workers[w];
+        if (slot != cw->visible_offset)
+            memmove(store->visible + slot, store->visible + cw->visible_offset, sizeof(UINT) * cw->visible_count);
+        cw->visible_offset = slot;
+        cw->slot_offset = slot;
+        slot += cw->visible_count;
+    }
+    store->visible_count = slot;
+
+    CullWorkerPool_Run(ctx->pool, bench_job_write, ctx, parallel);
+    for (UINT w = 0; w < worker_count; ++w)
+        totals->bytes_written_per_frame += (double)ctx->workers[w].slots_written * sizeof(InstanceData);
+    return slot;
+}
+
+//
+// Runs
+//
+static void
+bench_init (BenchContext * ctx, CullStrategy const * strategy, SceneKind scene, UINT count, CullWorkerPool * pool) {
+    *ctx = {};
+    ctx->flags = strategy->flags;
+    if (!cull_cpu_has_avx2())
+        ctx->flags &= ~STRATEGY_AVX2;   // resolved here, the workers only read the flag
+    ctx->pool = pool;
+    ctx->local_bounds = BoundingBox(XMFLOAT3(0.0f, 0.0f, 0.0f), XMFLOAT3(1.0f, 1.0f, 1.0f));
+
+    InstanceStore_Init(&ctx->store, count);
+    generate_scene(&ctx->store, scene, count);
+    if (ctx->flags & STRATEGY_LEGACY) {
+        ctx->legacy_buffer = (LegacyInstanceData *)::aligned_alloc(64, sizeof(LegacyInstanceData) * ctx->store.capacity);
+        return;
+    }
+    InstanceStore_UpdateBounds(&ctx->store, ctx->local_bounds);
+    if (ctx->flags & STRATEGY_BVH) {
+        InstanceBvh_Init(&ctx->bvh, ctx->store.capacity);
+        for (UINT i = 0; i < count; ++i)
+            InstanceBvh_Insert(&ctx->bvh, &ctx->store, i);
+    }
+    for (UINT i = 0; i < BENCH_QUEUING_FRAMES; ++i) {
+        InstanceUploadRecord_Init(&ctx->upload_records[i], ctx->store.capacity);
+        ctx->instance_buffers[i] = (InstanceData *)::aligned_alloc(64, sizeof(InstanceData) * ctx->store.capacity);
+    }
+}
+static void
+bench_release (BenchContext * ctx) {
+    if (ctx->flags & STRATEGY_BVH)
+        InstanceBvh_Release(&ctx->bvh);
+    for (UINT i = 0; i < BENCH_QUEUING_FRAMES; ++i) {
+        if (ctx->upload_records[i].capacity)
+            InstanceUploadRecord_Release(&ctx->upload_records[i]);
+        ::free(ctx->instance_buffers[i]);
+    }
+    ::free(ctx->legacy_buffer);
+    InstanceStore_Release(&ctx->store);
+}
+static BenchResult
+bench_run (CullStrategy const * strategy, SceneKind scene, UINT count, UINT frames, CullWorkerPool * pool) {
+    static BenchContext ctx;
+    bench_init(&ctx, strategy, scene, count, pool);
+
+    BenchResult result = {};
+    result.visible_min = UINT_MAX;
+    double total_visible = 0.0;
+    int64_t total_ticks = 0;
+    for (UINT frame = 0; frame < frames; ++frame) {
+        BenchCamera camera;
+        scene_camera(scene, count, frame, &camera);
+        if (frame > 0)
+            move_instances(&ctx.store, frame);
+        ctx.frame_index = frame;
+
+        int64_t begin, end;
+        QueryPerformanceCounter((LARGE_INTEGER *)&begin);
+        UINT visible;
+        if (strategy->flags & STRATEGY_LEGACY) {
+            // global_cam_frustum is rebuilt from the projection on resize only
+            static BoundingFrustum cam_frustum;
+            if (0 == frame)
+                BoundingFrustum::CreateFromMatrix(cam_frustum, XMLoadFloat4x4(&camera.proj));
+            visible = legacy_update(&ctx, &camera, cam_frustum);
+            result.bytes_written_per_frame += (double)visible * sizeof(LegacyInstanceData);
+        } else {
+            visible = bench_update(&ctx, &camera, &result);
+        }
+        QueryPerformanceCounter((LARGE_INTEGER *)&end);
+        total_ticks += end - begin;
+
+        total_visible += visible;
+        result.visible_min = visible < result.visible_min ? visible : result.visible_min;
+        result.visible_max = visible > result.visible_max ? visible : result.visible_max;
+    }
+    bench_release(&ctx);
+
+    int64_t count_per_sec;
+    QueryPerformanceFrequency((LARGE_INTEGER *)&count_per_sec);
+    double total_ns = (double)total_ticks * 1e9 / (double)count_per_sec;
+    result.ns_per_instance = total_ns / ((double)frames * count);
+    result.ms_per_frame = total_ns * 1e-6 / frames;
+    result.visible_avg = total_visible / frames;
+    result.bytes_written_per_frame /= frames;
+    result.too_small_avg /= frames;
+    return result;
+}
+
+int
+main (int argc, char ** argv) {
+    UINT max_instances = 1000000;
+    UINT frames = BENCH_DEFAULT_FRAMES;
+    UINT threads = 0;
+    char const * scenes = nullptr;
+    char const * strategies = nullptr;
+    char const * out_path = nullptr;
+    for (int i = 1; i < argc; ++i) {
+        bool has_value = i + 1 < argc;
+        if (has_value && 0 == strcmp(argv[i], "--max-instances"))
+            max_instances = (UINT)strtoul(argv[++i], nullptr, 10);
+        else if (has_value && 0 == strcmp(argv[i], "--frames"))
+            frames = (UINT)strtoul(argv[++i], nullptr, 10);
+        else if (has_value && 0 == strcmp(argv[i], "--threads"))
+            threads = (UINT)strtoul(argv[++i], nullptr, 10);
+        else if (has_value && 0 == strcmp(argv[i], "--scenes"))
+            scenes = argv[++i];
+        else if (has_value && 0 == strcmp(argv[i], "--strategies"))
+            strategies = argv[++i];
+        else if (has_value && 0 == strcmp(argv[i], "--out"))
+            out_path = argv[++i];
+        else {
+            print_usage("cull_bench [--max-instances N] [--frames N] [--threads N] [--scenes a,b] [--strategies a,b] [--out file.json]");
+            print_names("scenes", global_scene_names, _COUNT_SCENE);
+            char const * strategy_names [STRATEGY_COUNT];
+            for (UINT s = 0; s < STRATEGY_COUNT; ++s)
+                strategy_names[s] = global_strategies[s].name;
+            print_names("strategies", strategy_names, STRATEGY_COUNT);
+            return 1;
+        }
+    }
+    if (0 == frames)
+        frames = 1;
+
+    FILE * out = stdout;
+    if (out_path && nullptr == (out = fopen(out_path, "w"))) {
+        fprintf(stderr, "cannot open %s\n", out_path);
+        return 1;
+    }
+
+    CullWorkerPool pool;
+    CullWorkerPool_Init(&pool, threads);
+
+    fprintf(out, "{\n");
+    fprintf(out, "  \"benchmark\": \"instance_culling\",\n");
+    fprintf(out, "  \"frames\": %u,\n", frames);
+    fprintf(out, "  \"worker_threads\": %u,\n", pool.worker_count);
+    fprintf(out, "  \"avx2\": %s,\n", cull_cpu_has_avx2() ? "true" : "false");
+    fprintf(out, "  \"moved_percent_per_frame\": %u,\n", BENCH_MOVED_PERCENT);
+    fprintf(out, "  \"instance_data_bytes\": %u,\n", (UINT)sizeof(InstanceData));
+    fprintf(out, "  \"legacy_instance_data_bytes\": %u,\n", (UINT)sizeof(LegacyInstanceData));
+    fprintf(out, "  \"results\": [");
+    bool first = true;
+    for (UINT scene = 0; scene < _COUNT_SCENE; ++scene) {
+        if (!list_contains(scenes, global_scene_names[scene]))
+            continue;
+        for (UINT c = 0; c < sizeof(global_instance_counts) / sizeof(global_instance_counts[0]); ++c) {
+            UINT count = global_instance_counts[c];
+            if (count > max_instances)
+                continue;
+            for (UINT s = 0; s < STRATEGY_COUNT; ++s) {
+                CullStrategy const * strategy = &global_strategies[s];
+                if (!list_contains(strategies, strategy->name))
+                    continue;
+                fprintf(stderr, "%-14s %8u  %-16s", global_scene_names[scene], count, strategy->name);
+                BenchResult r = bench_run(strategy, (SceneKind)scene, count, frames, &pool);
+                fprintf(stderr, "%9.3f ns/instance %10.0f visible\n", r.ns_per_instance, r.visible_avg);
+
+                fprintf(out, "%s\n    {\"scene\": \"%s\", \"instances\": %u, \"strategy\": \"%s\", ",
+                    first ? "" : ",", global_scene_names[scene], count, strategy->name);
+                fprintf(out, "\"ns_per_instance\": %.4f, \"ms_per_frame\": %.4f, ", r.ns_per_instance, r.ms_per_frame);
+                fprintf(out, "\"visible_avg\": %.1f, \"visible_min\": %u, \"visible_max\": %u, ", r.visible_avg, r.visible_min, r.visible_max);
+                fprintf(out, "\"too_small_avg\": %.1f, \"bytes_written_per_frame\": %.0f}", r.too_small_avg, r.bytes_written_per_frame);
+                fflush(out);
+                first = false;
+            }
+        }
+    }
+    fprintf(out, "\n  ]\n}\n");
+    if (out != stdout)
+        fclose(out);
+
+    CullWorkerPool_Release(&pool);
+    return 0;
+}
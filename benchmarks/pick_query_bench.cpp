@@ -0,0 +1,314 @@
+/* ===========================================================
+   #File: pick_query_bench.cpp #
+   #Date: 17 Oct 2026 #
+   #Revision: 1.0 #
+   #Creator: Omid Miresmaeili #
+   #Description: batched pick queries against one ray at a time on a scene of skulls, without D3D #
+   #Notice: (C) Copyright 2021 by Omid. All Rights Reserved. #
+   =========================================================== */
+
+//
+// Pick query benchmark
+//
+// Builds the triangle BVH of a model (skull.txt by default) and a pick scene of a grid of
+// its instances, each turned and scaled differently; every second one draws only half of
+// the index buffer and a few are not pickable. Then traces the same rays twice: in batches
+// with PickQuery_Run (sorted, packets where the rays are coherent) and one by one with
+// PickScene_Intersect, as ray_pick does. Two ray sets:
+//   hover   rays through a patch of pixels around a cursor moving over the screen
+//   random  rays from anywhere in the scene in any direction, every fifth one with a short t_max
+// Reports the time per ray of both, the packets, and the rays whose hit differs between them
+// as JSON. Exits with 1 if any does.
+//
+// Usage: pick_query_bench [--model skull.txt] [--rays N] [--out file.json]
+//
+
+#include "bench_common.h"
+#include "pick_query.h"
+
+#define BENCH_DEFAULT_RAYS      16384
+#define BENCH_BATCH_SIZE        256         // rays per PickQuery_Run, a 16 x 16 patch of pixels for hover
+#define BENCH_GRID_SIZE         12          // instances per side
+#define BENCH_GRID_SPACING      2.5f        // model radii between neighbours
+#define BENCH_SCREEN_WIDTH      1280
+#define BENCH_SCREEN_HEIGHT     720
+#define BENCH_FOV_Y             (0.25f * XM_PI)
+#define BENCH_SHORT_T_MAX       3.0f        // model radii, for the line of sight rays
+#define BENCH_T_TOLERANCE       1e-4f       // relative difference of two distances still counted as the same hit
+
+#ifndef RAY_TRI_BENCH_DEFAULT_MODEL
+#define RAY_TRI_BENCH_DEFAULT_MODEL "skull.txt"
+#endif
+
+enum RaySetKind {
+    RAY_SET_HOVER,
+    RAY_SET_RANDOM,
+
+    _COUNT_RAY_SET
+};
+static char const * global_ray_set_names [_COUNT_RAY_SET] = {"hover", "random"};
+
+// A model as the demos keep it, with the triangle BVH of its single submesh
+struct BenchGeometry {
+    ID3DBlob        vb_blob;
+    ID3DBlob        ib_blob;
+    MeshGeometry    geom;
+};
+struct BenchRays {
+    XMFLOAT3 *  origins;
+    XMFLOAT3 *  dirs;
+    float *     t_max;
+    UINT        count;
+};
+struct BenchResult {
+    double  batch_ns_per_ray;
+    double  single_ns_per_ray;
+    UINT    hits;
+    UINT    packet_count;
+    UINT    packet_ray_count;
+    UINT    single_ray_count;
+    UINT    mismatches;
+};
+
+//
+// Model
+//
+static void
+create_geometry (BenchModel * model, char const * name, BenchGeometry * geometry) {
+    *geometry = {};
+    MeshGeometry * geom = &geometry->geom;
+    geometry->vb_blob.data = model->vertices;
+    geometry->ib_blob.data = model->indices;
+    geom->vb_cpu = &geometry->vb_blob;
+    geom->ib_cpu = &geometry->ib_blob;
+    geom->vb_byte_stide = sizeof(BenchVertex);
+    geom->index_format = DXGI_FORMAT_R32_UINT;
+    geom->vertex_encoding = VERTEX_ENCODING_FLOAT32;
+    geom->submesh_geoms[0].index_count = 3 * model->tri_count;
+    BoundingBox::CreateFromPoints(geom->submesh_geoms[0].bounds, model->vertex_count, &model->vertices[0].pos, sizeof(BenchVertex));
+    Mesh_BuildTriangleBvh(geom, 1, name);
+}
+static void
+release_geometry (BenchGeometry * geometry) {
+    Mesh_ReleaseTriangleBvh(&geometry->geom);
+    *geometry = {};
+}
+
+//
+// Scene
+//
+// A grid of instances on the xz plane, centered on the origin
+static void
+create_scene (BenchModel const * model, BenchGeometry const * geometry, PickScene * scene) {
+    BenchRandom rng = {0x5eed};
+    UINT const count = BENCH_GRID_SIZE * BENCH_GRID_SIZE;
+    UINT const half = 3 * (model->tri_count / 2);
+    float const spacing = BENCH_GRID_SPACING * model->radius;
+    float const offset = -0.5f * spacing * (BENCH_GRID_SIZE - 1);
+    XMVECTOR center = XMLoadFloat3(&model->center);
+    PickScene_Init(scene, count);
+    for (UINT i = 0; i < count; ++i) {
+        float scale = random_float(&rng, 0.6f, 1.2f);
+        XMMATRIX world =
+            XMMatrixTranslation(-XMVectorGetX(center), -XMVectorGetY(center), -XMVectorGetZ(center)) *
+            XMMatrixScaling(scale, scale, scale) *
+            XMMatrixRotationY(random_float(&rng, -XM_PI, XM_PI)) *
+            XMMatrixTranslation(offset + spacing * (i % BENCH_GRID_SIZE), random_float(&rng, -0.2f, 0.2f) * spacing, offset + spacing * (i / BENCH_GRID_SIZE));
+        XMFLOAT4X4 w;
+        XMStoreFloat4x4(&w, world);
+        // -- every second item draws one half of the index buffer, as submeshes sharing a mesh do
+        UINT first_index = 0, index_count = 3 * model->tri_count;
+        if (1 == i % 2) {
+            first_index = 1 == i % 4 ? 0 : half;
+            index_count = 1 == i % 4 ? half : 3 * model->tri_count - half;
+        }
+        PickScene_AddInstance(scene, 1000 + i, w, geometry->geom.submesh_geoms[0].bounds, geometry->geom.triangle_bvh, first_index, index_count);
+    }
+    for (UINT i = 0; i < count; i += 13)
+        scene->instances[i].pickable = false;
+    PickScene_BuildTopLevel(scene);
+}
+
+//
+// Rays
+//
+static void
+create_rays (RaySetKind kind, BenchModel const * model, BenchRays * rays) {
+    BenchRandom rng = {0xc0ffee + (uint64_t)kind};
+    float const extent = 0.5f * BENCH_GRID_SPACING * model->radius * BENCH_GRID_SIZE;
+    if (RAY_SET_HOVER == kind) {
+        // -- a camera above one corner of the grid looking at its middle, the cursor jumps once per batch
+        XMVECTOR eye = XMVectorSet(-0.7f * extent, 0.4f * extent, -0.7f * extent, 1.0f);
+        XMVECTOR forward = XMVector3Normalize(XMVectorSet(0.0f, 0.0f, 0.0f, 1.0f) - eye);
+        XMVECTOR right = XMVector3Normalize(XMVector3Cross(XMVectorSet(0.0f, 1.0f, 0.0f, 0.0f), forward));
+        XMVECTOR up = XMVector3Cross(forward, right);
+        float const tan_y = tanf(0.5f * BENCH_FOV_Y);
+        float const tan_x = tan_y * BENCH_SCREEN_WIDTH / BENCH_SCREEN_HEIGHT;
+        UINT const patch = 16;
+        float cursor_x = 0.0f, cursor_y = 0.0f;
+        for (UINT i = 0; i < rays->count; ++i) {
+            if (0 == i % BENCH_BATCH_SIZE) {
+                cursor_x = random_float(&rng, 0.0f, (float)(BENCH_SCREEN_WIDTH - patch));
+                cursor_y = random_float(&rng, 0.0f, (float)(BENCH_SCREEN_HEIGHT - patch));
+            }
+            UINT pixel = i % BENCH_BATCH_SIZE;
+            float ndc_x = 2.0f * (cursor_x + (float)(pixel % patch) + 0.5f) / BENCH_SCREEN_WIDTH - 1.0f;
+            float ndc_y = 1.0f - 2.0f * (cursor_y + (float)(pixel / patch % patch) + 0.5f) / BENCH_SCREEN_HEIGHT;
+            XMStoreFloat3(&rays->origins[i], eye);
+            XMStoreFloat3(&rays->dirs[i], XMVector3Normalize(forward + right * (ndc_x * tan_x) + up * (ndc_y * tan_y)));
+            rays->t_max[i] = FLT_MAX;
+        }
+        return;
+    }
+    // -- line of sight and trace rays from inside the scene
+    for (UINT i = 0; i < rays->count; ++i) {
+        XMVECTOR origin = XMVectorSet(random_float(&rng, -extent, extent), random_float(&rng, -0.3f, 0.3f) * extent, random_float(&rng, -extent, extent), 1.0f);
+        XMVECTOR dir = XMVector3Normalize(XMVectorSet(random_float(&rng, -1.0f, 1.0f), random_float(&rng, -1.0f, 1.0f), random_float(&rng, -1.0f, 1.0f), 0.0f));
+        XMStoreFloat3(&rays->origins[i], origin);
+        XMStoreFloat3(&rays->dirs[i], dir);
+        rays->t_max[i] = 0 == i % 5 ? BENCH_SHORT_T_MAX * model->radius : FLT_MAX;
+    }
+}
+
+//
+// Runs
+//
+// Same hit: the same instance and triangle at the same distance, or another triangle at the
+// same distance (a shared edge)
+static bool
+same_hit (PickHit const & a, PickHit const & b) {
+    if (a.instance != b.instance)
+        return false;
+    bool close = fabsf(a.triangle.t - b.triangle.t) <= BENCH_T_TOLERANCE * fmaxf(1.0f, b.triangle.t);
+    if (PICK_NO_HIT == b.instance)
+        return close;
+    return close && a.item == b.item;
+}
+static BenchResult
+bench_run (PickScene const * scene, BenchRays const * rays) {
+    BenchResult result = {};
+    PickHit * batch_hits = (PickHit *)::malloc(sizeof(PickHit) * rays->count);
+    PickHit * single_hits = (PickHit *)::malloc(sizeof(PickHit) * rays->count);
+    PickQuery query;
+    PickQuery_Init(&query, BENCH_BATCH_SIZE);
+
+    int64_t begin, end, count_per_sec;
+    QueryPerformanceFrequency((LARGE_INTEGER *)&count_per_sec);
+    QueryPerformanceCounter((LARGE_INTEGER *)&begin);
+    for (UINT first = 0; first < rays->count; first += BENCH_BATCH_SIZE) {
+        UINT count = rays->count - first < BENCH_BATCH_SIZE ? rays->count - first : BENCH_BATCH_SIZE;
+        PickQuery_Run(&query, scene, count, &rays->origins[first], &rays->dirs[first], &rays->t_max[first], &batch_hits[first]);
+        result.packet_count += query.packet_count;
+        result.packet_ray_count += query.packet_ray_count;
+        result.single_ray_count += query.single_ray_count;
+    }
+    QueryPerformanceCounter((LARGE_INTEGER *)&end);
+    result.batch_ns_per_ray = (double)(end - begin) * 1e9 / (double)count_per_sec / rays->count;
+
+    QueryPerformanceCounter((LARGE_INTEGER *)&begin);
+    for (UINT i = 0; i < rays->count; ++i) {
+        PickHit * hit = &single_hits[i];
+        *hit = {};
+        hit->triangle.t = rays->t_max[i];
+        hit->triangle.index_location = PICK_NO_HIT;
+        hit->instance = PICK_NO_HIT;
+        hit->item = PICK_NO_HIT;
+        PickScene_Intersect(scene, XMLoadFloat3(&rays->origins[i]), XMLoadFloat3(&rays->dirs[i]), hit);
+    }
+    QueryPerformanceCounter((LARGE_INTEGER *)&end);
+    result.single_ns_per_ray = (double)(end - begin) * 1e9 / (double)count_per_sec / rays->count;
+
+    for (UINT i = 0; i < rays->count; ++i) {
+        if (PICK_NO_HIT != single_hits[i].instance)
+            ++result.hits;
+        if (!same_hit(batch_hits[i], single_hits[i])) {
+            if (result.mismatches < 4)
+                fprintf(stderr, "ray %u: batch instance %u t %g, single instance %u t %g\n", i,
+                    batch_hits[i].instance, batch_hits[i].triangle.t, single_hits[i].instance, single_hits[i].triangle.t);
+            ++result.mismatches;
+        }
+    }
+    PickQuery_Release(&query);
+    ::free(single_hits);
+    ::free(batch_hits);
+    return result;
+}
+
+int
+main (int argc, char ** argv) {
+    char const * model_path = RAY_TRI_BENCH_DEFAULT_MODEL;
+    UINT ray_count = BENCH_DEFAULT_RAYS;
+    char const * out_path = nullptr;
+    for (int i = 1; i < argc; ++i) {
+        bool has_value = i + 1 < argc;
+        if (has_value && 0 == strcmp(argv[i], "--model"))
+            model_path = argv[++i];
+        else if (has_value && 0 == strcmp(argv[i], "--rays"))
+            ray_count = (UINT)strtoul(argv[++i], nullptr, 10);
+        else if (has_value && 0 == strcmp(argv[i], "--out"))
+            out_path = argv[++i];
+        else {
+            print_usage("pick_query_bench [--model file.txt] [--rays N] [--out file.json]");
+            return 1;
+        }
+    }
+    if (0 == ray_count)
+        ray_count = 1;
+
+    BenchModel model;
+    if (!load_model(model_path, &model)) {
+        fprintf(stderr, "cannot load %s\n", model_path);
+        return 1;
+    }
+    FILE * out = stdout;
+    if (out_path && nullptr == (out = fopen(out_path, "w"))) {
+        fprintf(stderr, "cannot open %s\n", out_path);
+        return 1;
+    }
+    BenchGeometry geometry;
+    create_geometry(&model, model_path, &geometry);
+    PickScene scene;
+    create_scene(&model, &geometry, &scene);
+
+    BenchRays rays = {};
+    rays.count = ray_count;
+    rays.origins = (XMFLOAT3 *)::malloc(sizeof(XMFLOAT3) * ray_count);
+    rays.dirs = (XMFLOAT3 *)::malloc(sizeof(XMFLOAT3) * ray_count);
+    rays.t_max = (float *)::malloc(sizeof(float) * ray_count);
+
+    fprintf(out, "{\n");
+    fprintf(out, "  \"benchmark\": \"pick_query\",\n");
+    fprintf(out, "  \"model\": \"%s\",\n", model_path);
+    fprintf(out, "  \"triangles\": %u,\n", model.tri_count);
+    fprintf(out, "  \"instances\": %u,\n", scene.instance_count);
+    fprintf(out, "  \"rays\": %u,\n", ray_count);
+    fprintf(out, "  \"batch_size\": %u,\n", BENCH_BATCH_SIZE);
+    fprintf(out, "  \"avx2\": %s,\n", ray_tri_cpu_has_avx2() ? "true" : "false");
+    fprintf(out, "  \"results\": [");
+    UINT mismatches = 0;
+    for (UINT k = 0; k < _COUNT_RAY_SET; ++k) {
+        create_rays((RaySetKind)k, &model, &rays);
+        BenchResult r = bench_run(&scene, &rays);
+        mismatches += r.mismatches;
+        fprintf(stderr, "%-8s batch %8.1f ns/ray single %8.1f ns/ray %6u hits %5u packets (%6u rays) %4u mismatches\n",
+            global_ray_set_names[k], r.batch_ns_per_ray, r.single_ns_per_ray, r.hits, r.packet_count, r.packet_ray_count, r.mismatches);
+
+        fprintf(out, "%s\n    {\"rays\": \"%s\", ", 0 == k ? "" : ",", global_ray_set_names[k]);
+        fprintf(out, "\"batch_ns_per_ray\": %.2f, \"single_ns_per_ray\": %.2f, \"speedup\": %.2f, ",
+            r.batch_ns_per_ray, r.single_ns_per_ray, r.single_ns_per_ray / r.batch_ns_per_ray);
+        fprintf(out, "\"hits\": %u, \"packets\": %u, \"packet_rays\": %u, \"single_rays\": %u, \"mismatches\": %u}",
+            r.hits, r.packet_count, r.packet_ray_count, r.single_ray_count, r.mismatches);
+        fflush(out);
+    }
+    fprintf(out, "\n  ]\n}\n");
+    if (out != stdout)
+        fclose(out);
+
+    ::free(rays.t_max);
+    ::free(rays.dirs);
+    ::free(rays.origins);
+    PickScene_Release(&scene);
+    release_geometry(&geometry);
+    release_model(&model);
+    return 0 == mismatches ? 0 : 1;
+}
@@ -0,0 +1,247 @@
+/* ===========================================================
+   #File: ray_tri_bench.cpp #
+   #Date: 17 Oct 2026 #
+   #Revision: 1.0 #
+   #Creator: Omid Miresmaeili #
+   #Description: ray/triangle kernel benchmark on the skull model, without D3D #
+   #Notice: (C) Copyright 2021 by Omid. All Rights Reserved. #
+   =========================================================== */
+
+//
+// Ray / triangle benchmark
+//
+// Casts picking rays at every triangle of a model (skull.txt by default) the way ray_pick
+// did before the triangle BVH: one DirectX::TriangleTests::Intersects call per triangle,
+// reading the positions through the index buffer. Then casts the same rays with the block
+// kernels of ray_triangle.h over the model swizzled into RayTriangleBlocks, and reports the
+// time per ray and per triangle, the hits, and the rays whose nearest hit differs from the
+// per-triangle test as JSON.
+//
+// Usage: ray_tri_bench [--model skull.txt] [--rays N] [--kernels a,b] [--out file.json]
+//
+
+#include "bench_common.h"
+#include "ray_triangle.h"
+
+#define BENCH_DEFAULT_RAYS      2000
+#define BENCH_EYE_DISTANCE      2.5f        // eyes on a sphere of this many model radii
+#define BENCH_T_TOLERANCE       1e-4f       // relative difference of two distances still counted as the same hit
+
+#ifndef RAY_TRI_BENCH_DEFAULT_MODEL
+#define RAY_TRI_BENCH_DEFAULT_MODEL "skull.txt"
+#endif
+
+enum KernelKind {
+    KERNEL_SCALAR,          // TriangleTests::Intersects per triangle (the baseline)
+    KERNEL_SSE,             // RayTriangleBlock, two times 4 lanes
+    KERNEL_AVX2,            // RayTriangleBlock, 8 lanes (when the CPU has it)
+
+    _COUNT_KERNEL
+};
+static char const * global_kernel_names [_COUNT_KERNEL] = {"scalar", "sse", "avx2"};
+
+// Triangles of a model swizzled into blocks in index buffer order
+struct TriangleBlocks {
+    RayTriangleBlock *  blocks;
+    UINT                count;
+};
+struct BenchRay {
+    XMFLOAT3    origin;
+    XMFLOAT3    dir;
+};
+struct BenchResult {
+    double  ns_per_ray;
+    double  ns_per_triangle;
+    UINT    hits;
+    UINT    mismatches;
+};
+
+//
+// Model
+//
+static void
+create_blocks (BenchModel const * model, TriangleBlocks * blocks) {
+    blocks->count = (model->tri_count + RAY_TRI_LANES - 1) / RAY_TRI_LANES;
+    blocks->blocks = (RayTriangleBlock *)::malloc(sizeof(RayTriangleBlock) * blocks->count);
+    for (UINT b = 0; b < blocks->count; ++b)
+        RayTriangleBlock_Clear(&blocks->blocks[b]);
+    for (UINT t = 0; t < model->tri_count; ++t) {
+        UINT const * tri = &model->indices[3 * t];
+        RayTriangleBlock_Set(
+            &blocks->blocks[t / RAY_TRI_LANES], t % RAY_TRI_LANES,
+            model->vertices[tri[0]].pos, model->vertices[tri[1]].pos, model->vertices[tri[2]].pos, 3 * t);
+    }
+}
+static void
+release_blocks (TriangleBlocks * blocks) {
+    ::free(blocks->blocks);
+    *blocks = {};
+}
+// Rays from eyes around the model towards points inside its bounding sphere (most hit it)
+static void
+create_rays (BenchModel const * model, BenchRay * rays, UINT ray_count) {
+    BenchRandom rng = {0x5eed};
+    XMVECTOR center = XMLoadFloat3(&model->center);
+    for (UINT i = 0; i < ray_count; ++i) {
+        XMVECTOR eye_dir = XMVector3Normalize(XMVectorSet(random_float(&rng, -1.0f, 1.0f), random_float(&rng, -1.0f, 1.0f), random_float(&rng, -1.0f, 1.0f), 0.0f));
+        XMVECTOR eye = center + eye_dir * (BENCH_EYE_DISTANCE * model->radius);
+        XMVECTOR target = center + XMVectorSet(random_float(&rng, -1.0f, 1.0f), random_float(&rng, -1.0f, 1.0f), random_float(&rng, -1.0f, 1.0f), 0.0f) * (0.5f * model->radius);
+        XMStoreFloat3(&rays[i].origin, eye);
+        XMStoreFloat3(&rays[i].dir, XMVector3Normalize(target - eye));
+    }
+}
+
+//
+// Kernels
+//
+// Nearest hit of [ray] with every triangle of [model] ([blocks] for the block kernels)
+static bool
+intersect_model (KernelKind kernel, BenchModel const * model, TriangleBlocks const * blocks, BenchRay const * ray, RayTriangleHit * hit) {
+    hit->t = FLT_MAX;
+    bool any = false;
+    if (KERNEL_SCALAR == kernel) {
+        // -- ray_pick's loop before the BVH
+        XMVECTOR origin = XMLoadFloat3(&ray->origin);
+        XMVECTOR dir = XMLoadFloat3(&ray->dir);
+        for (UINT t = 0; t < model->tri_count; ++t) {
+            UINT const * tri = &model->indices[3 * t];
+            XMVECTOR v0 = XMLoadFloat3(&model->vertices[tri[0]].pos);
+            XMVECTOR v1 = XMLoadFloat3(&model->vertices[tri[1]].pos);
+            XMVECTOR v2 = XMLoadFloat3(&model->vertices[tri[2]].pos);
+            float dist = 0.0f;
+            if (TriangleTests::Intersects(origin, dir, v0, v1, v2, dist) && dist < hit->t) {
+                hit->t = dist;
+                hit->index_location = 3 * t;
+                any = true;
+            }
+        }
+        return any;
+    }
+    for (UINT b = 0; b < blocks->count; ++b) {
+        UINT lanes = model->tri_count - b * RAY_TRI_LANES;
+        int lane_mask = lanes >= RAY_TRI_LANES ? (1 << RAY_TRI_LANES) - 1 : (1 << lanes) - 1;
+        bool block_hit = KERNEL_AVX2 == kernel ?
+            ray_tri_block_avx2(&blocks->blocks[b], ray->origin, ray->dir, lane_mask, hit) :
+            ray_tri_block_sse(&blocks->blocks[b], ray->origin, ray->dir, lane_mask, hit);
+        any = any || block_hit;
+    }
+    return any;
+}
+static BenchResult
+bench_run (
+    KernelKind kernel, BenchModel const * model, TriangleBlocks const * blocks,
+    BenchRay const * rays, UINT ray_count, RayTriangleHit const * reference
+) {
+    BenchResult result = {};
+    RayTriangleHit * hits = (RayTriangleHit *)::malloc(sizeof(RayTriangleHit) * ray_count);
+    bool * hit_flags = (bool *)::malloc(sizeof(bool) * ray_count);
+
+    int64_t begin, end, count_per_sec;
+    QueryPerformanceCounter((LARGE_INTEGER *)&begin);
+    for (UINT i = 0; i < ray_count; ++i)
+        hit_flags[i] = intersect_model(kernel, model, blocks, &rays[i], &hits[i]);
+    QueryPerformanceCounter((LARGE_INTEGER *)&end);
+    QueryPerformanceFrequency((LARGE_INTEGER *)&count_per_sec);
+
+    double ns = (double)(end - begin) * 1e9 / (double)count_per_sec;
+    result.ns_per_ray = ns / ray_count;
+    result.ns_per_triangle = result.ns_per_ray / model->tri_count;
+    for (UINT i = 0; i < ray_count; ++i) {
+        if (hit_flags[i])
+            ++result.hits;
+        // -- same nearest hit as the per-triangle test (or the same distance within rounding)
+        bool ref_hit = FLT_MAX != reference[i].t;
+        if (ref_hit != hit_flags[i])
+            ++result.mismatches;
+        else if (ref_hit && reference[i].index_location != hits[i].index_location &&
+            fabsf(reference[i].t - hits[i].t) > BENCH_T_TOLERANCE * reference[i].t)
+            ++result.mismatches;
+    }
+    ::free(hit_flags);
+    ::free(hits);
+    return result;
+}
+
+int
+main (int argc, char ** argv) {
+    char const * model_path = RAY_TRI_BENCH_DEFAULT_MODEL;
+    UINT ray_count = BENCH_DEFAULT_RAYS;
+    char const * kernels = nullptr;
+    char const * out_path = nullptr;
+    for (int i = 1; i < argc; ++i) {
+        bool has_value = i + 1 < argc;
+        if (has_value && 0 == strcmp(argv[i], "--model"))
+            model_path = argv[++i];
+        else if (has_value && 0 == strcmp(argv[i], "--rays"))
+            ray_count = (UINT)strtoul(argv[++i], nullptr, 10);
+        else if (has_value && 0 == strcmp(argv[i], "--kernels"))
+            kernels = argv[++i];
+        else if (has_value && 0 == strcmp(argv[i], "--out"))
+            out_path = argv[++i];
+        else {
+            print_usage("ray_tri_bench [--model file.txt] [--rays N] [--kernels a,b] [--out file.json]");
+            print_names("kernels", global_kernel_names, _COUNT_KERNEL);
+            return 1;
+        }
+    }
+    if (0 == ray_count)
+        ray_count = 1;
+
+    BenchModel model;
+    if (!load_model(model_path, &model)) {
+        fprintf(stderr, "cannot load %s\n", model_path);
+        return 1;
+    }
+    FILE * out = stdout;
+    if (out_path && nullptr == (out = fopen(out_path, "w"))) {
+        fprintf(stderr, "cannot open %s\n", out_path);
+        return 1;
+    }
+    TriangleBlocks blocks;
+    create_blocks(&model, &blocks);
+
+    BenchRay * rays = (BenchRay *)::malloc(sizeof(BenchRay) * ray_count);
+    create_rays(&model, rays, ray_count);
+    RayTriangleHit * reference = (RayTriangleHit *)::malloc(sizeof(RayTriangleHit) * ray_count);
+    for (UINT i = 0; i < ray_count; ++i)
+        intersect_model(KERNEL_SCALAR, &model, &blocks, &rays[i], &reference[i]);
+
+    fprintf(out, "{\n");
+    fprintf(out, "  \"benchmark\": \"ray_triangle\",\n");
+    fprintf(out, "  \"model\": \"%s\",\n", model_path);
+    fprintf(out, "  \"triangles\": %u,\n", model.tri_count);
+    fprintf(out, "  \"blocks\": %u,\n", blocks.count);
+    fprintf(out, "  \"rays\": %u,\n", ray_count);
+    fprintf(out, "  \"avx2\": %s,\n", ray_tri_cpu_has_avx2() ? "true" : "false");
+    fprintf(out, "  \"results\": [");
+    bool first = true;
+    double scalar_ns = 0.0;
+    for (UINT k = 0; k < _COUNT_KERNEL; ++k) {
+        if (!list_contains(kernels, global_kernel_names[k]) && KERNEL_SCALAR != k)
+            continue;
+        if (KERNEL_AVX2 == k && !ray_tri_cpu_has_avx2())
+            continue;
+        BenchResult r = bench_run((KernelKind)k, &model, &blocks, rays, ray_count, reference);
+        if (KERNEL_SCALAR == k)
+            scalar_ns = r.ns_per_ray;
+        if (!list_contains(kernels, global_kernel_names[k]))
+            continue;       // the baseline only runs for the speedups
+        fprintf(stderr, "%-8s %10.1f ns/ray %8.3f ns/triangle %6u hits %4u mismatches\n",
+            global_kernel_names[k], r.ns_per_ray, r.ns_per_triangle, r.hits, r.mismatches);
+
+        fprintf(out, "%s\n    {\"kernel\": \"%s\", ", first ? "" : ",", global_kernel_names[k]);
+        fprintf(out, "\"ns_per_ray\": %.2f, \"ns_per_triangle\": %.4f, ", r.ns_per_ray, r.ns_per_triangle);
+        fprintf(out, "\"speedup\": %.2f, \"hits\": %u, \"mismatches\": %u}", scalar_ns / r.ns_per_ray, r.hits, r.mismatches);
+        fflush(out);
+        first = false;
+    }
+    fprintf(out, "\n  ]\n}\n");
+    if (out != stdout)
+        fclose(out);
+
+    ::free(reference);
+    ::free(rays);
+    release_blocks(&blocks);
+    release_model(&model);
+    return 0;
+}
@@ -22,6 +22,8 @@
 #include "headers/utils.h"
 #include "headers/game_timer.h"
 #include "headers/dds_loader.h"
+#include "headers/mesh_loader.h"
+#include "headers/cube_face_culling.h"
 
 #include <imgui/imgui.h>
 #include <imgui/imgui_impl_win32.h>
@@ -169,6 +171,7 @@ bool global_paused;
 bool global_resizing;
 bool global_mouse_active;
 SceneContext global_scene_ctx;
+bool global_cubemap_culling_enabled = true;
 
 struct RenderItemArray {
     RenderItem  ritems[_COUNT_RENDERITEM];
@@ -211,6 +214,7 @@ struct D3DRenderContext {
     D3D12_CPU_DESCRIPTOR_HANDLE     cube_dsv;
     ID3D12Resource *                cube_depth_stencil_buffer;
     Camera *                        cubemap_cameras[6];
+    CubeFaceCulling                 cubemap_culling;        // opaque_ritems seen by each face (probe and far planes of the face cameras)
     UINT                            cubemap_size;
     UINT                            dyn_tex_heap_index;
 
@@ -367,59 +371,11 @@ create_materials (Material out_materials []) {
     out_materials[MAT_SKY].refract_ratio = 1.0f;
 }
 static void
-create_skull_geometry (D3DRenderContext * render_ctx) {
-#pragma region Read_Data_File
-    FILE * f = nullptr;
-    errno_t err = fopen_s(&f, "./models/skull.txt", "r");
-    if (0 == f || err != 0) {
-        printf("could not open file\n");
-        return;
-    }
-    char linebuf[100];
-    int cnt = 0;
-    unsigned vcount = 0;
-    unsigned tcount = 0;
-    // -- read 1st line
-    if (fgets(linebuf, sizeof(linebuf), f))
-        cnt = sscanf_s(linebuf, "%*s %d", &vcount);
-    if (cnt != 1) {
-        printf("read error\n");
-        printf("read line: %s\n", linebuf);
-        return;
-    }
-    // -- read 2nd line
-    if (fgets(linebuf, sizeof(linebuf), f))
-        cnt = sscanf_s(linebuf, "%*s %d", &tcount);
-    if (cnt != 1) {
-        printf("read error\n");
-        printf("read line: %s\n", linebuf);
-        return;
-    }
-    // -- skip two lines
-    fgets(linebuf, sizeof(linebuf), f);
-    fgets(linebuf, sizeof(linebuf), f);
-
-    // -- vmin and vmax for AABB construction
-    XMFLOAT3 vminf3(+FLT_MAX, +FLT_MAX, +FLT_MAX);
-    XMFLOAT3 vmaxf3(-FLT_MAX, -FLT_MAX, -FLT_MAX);
-
-    XMVECTOR vmin = XMLoadFloat3(&vminf3);
-    XMVECTOR vmax = XMLoadFloat3(&vmaxf3);
-
-    // -- read vertices
-    Vertex * vertices = (Vertex *)calloc(vcount, sizeof(Vertex));
-    for (unsigned i = 0; i < vcount; i++) {
-        fgets(linebuf, sizeof(linebuf), f);
-        cnt = sscanf_s(
-            linebuf, "%f %f %f %f %f %f",
-            &vertices[i].position.x, &vertices[i].position.y, &vertices[i].position.z,
-            &vertices[i].normal.x, &vertices[i].normal.y, &vertices[i].normal.z
-        );
-        if (cnt != 6) {
-            printf("read error\n");
-            printf("read line: %s\n", linebuf);
-            return;
-        }
+build_skull_vertices (TextMesh const * src, void * out_vertices) {
+    Vertex * vertices = (Vertex *)out_vertices;
+    for (UINT i = 0; i < src->vertex_count; i++) {
+        vertices[i].position = src->positions[i];
+        vertices[i].normal = src->normals[i];
 
 #pragma region skull texture coordinates calculations
         XMVECTOR P = XMLoadFloat3(&vertices[i].position);
@@ -441,74 +397,38 @@ create_skull_geometry (D3DRenderContext * render_ctx) {
 
         vertices[i].texc = {u, v};
 #pragma endregion
-
-        // -- calculate vmin, vmax
-        vmin = XMVectorMin(vmin, P);
-        vmax = XMVectorMax(vmax, P);
     }
+}
+static void
+create_skull_geometry (D3DRenderContext * render_ctx) {
 
-    // -- construct bounding box (AABB)
-    BoundingBox bounds;
-    XMStoreFloat3(&bounds.Center, 0.5f * (vmin + vmax));
-    XMStoreFloat3(&bounds.Extents, 0.5f * (vmax - vmin));
-
-    // -- skip three lines
-    fgets(linebuf, sizeof(linebuf), f);
-    fgets(linebuf, sizeof(linebuf), f);
-    fgets(linebuf, sizeof(linebuf), f);
-    // -- read indices
-    uint32_t * indices = (uint32_t *)calloc(static_cast<size_t>(tcount) * 3, sizeof(uint32_t));
-    for (unsigned i = 0; i < tcount; i++) {
-        fgets(linebuf, sizeof(linebuf), f);
-        cnt = sscanf_s(
-            linebuf, "%d %d %d",
-            &indices[i * 3 + 0], &indices[i * 3 + 1], &indices[i * 3 + 2]
-        );
-        if (cnt != 3) {
-            printf("read error\n");
-            printf("read line: %s\n", linebuf);
-            return;
-        }
+    // -- map the binary mesh (created from the text file on first load)
+    MeshCacheView mesh = {};
+    if (!load_mesh_cached("./models/skull.mesh", "./models/skull.txt", sizeof(Vertex), build_skull_vertices, &mesh)) {
+        printf("could not load skull mesh\n");
+        return;
     }
 
-    // -- remember to free heap-allocated memory
-    /*
-    free(vertices);
-    free(indices);
-    */
-    fclose(f);
-#pragma endregion   Read_Data_File
-
-    UINT vb_byte_size = vcount * sizeof(Vertex);
-    UINT ib_byte_size = (tcount * 3) * sizeof(uint32_t);
+    UINT vb_byte_size = mesh.vertex_count * sizeof(Vertex);
 
     // -- Fill out render_ctx geom[GEOM_SKULL] (skull)
     D3DCreateBlob(vb_byte_size, &render_ctx->geom[GEOM_SKULL].vb_cpu);
-    CopyMemory(render_ctx->geom[GEOM_SKULL].vb_cpu->GetBufferPointer(), vertices, vb_byte_size);
+    CopyMemory(render_ctx->geom[GEOM_SKULL].vb_cpu->GetBufferPointer(), mesh.vertices, vb_byte_size);
 
-    D3DCreateBlob(ib_byte_size, &render_ctx->geom[GEOM_SKULL].ib_cpu);
-    CopyMemory(render_ctx->geom[GEOM_SKULL].ib_cpu->GetBufferPointer(), indices, ib_byte_size);
+    // narrowest index format that still draws the skull as a single submesh
+    Mesh_CreateIndexBuffer(&render_ctx->geom[GEOM_SKULL], mesh.indices, mesh.index_count, mesh.vertices, sizeof(Vertex), 1, "skull");
 
-    create_default_buffer(render_ctx->device, render_ctx->direct_cmd_list, vertices, vb_byte_size, &render_ctx->geom[GEOM_SKULL].vb_uploader, &render_ctx->geom[GEOM_SKULL].vb_gpu);
-    create_default_buffer(render_ctx->device, render_ctx->direct_cmd_list, indices, ib_byte_size, &render_ctx->geom[GEOM_SKULL].ib_uploader, &render_ctx->geom[GEOM_SKULL].ib_gpu);
+    create_default_buffer(render_ctx->device, render_ctx->direct_cmd_list, (void *)mesh.vertices, vb_byte_size, &render_ctx->geom[GEOM_SKULL].vb_uploader, &render_ctx->geom[GEOM_SKULL].vb_gpu);
+    create_default_buffer(render_ctx->device, render_ctx->direct_cmd_list, render_ctx->geom[GEOM_SKULL].ib_cpu->GetBufferPointer(), render_ctx->geom[GEOM_SKULL].ib_byte_size, &render_ctx->geom[GEOM_SKULL].ib_uploader, &render_ctx->geom[GEOM_SKULL].ib_gpu);
 
     render_ctx->geom[GEOM_SKULL].vb_byte_stide = sizeof(Vertex);
     render_ctx->geom[GEOM_SKULL].vb_byte_size = vb_byte_size;
-    render_ctx->geom[GEOM_SKULL].ib_byte_size = ib_byte_size;
-    render_ctx->geom[GEOM_SKULL].index_format = DXGI_FORMAT_R32_UINT;
-
-    SubmeshGeometry submesh = {};
-    submesh.index_count = tcount * 3;
-    submesh.start_index_location = 0;
-    submesh.base_vertex_location = 0;
-    submesh.bounds = bounds;
 
     render_ctx->geom[GEOM_SKULL].submesh_names[0] = "skull";
-    render_ctx->geom[GEOM_SKULL].submesh_geoms[0] = submesh;
+    render_ctx->geom[GEOM_SKULL].submesh_geoms[0].bounds = mesh.bounds;
 
     // -- cleanup
-    free(vertices);
-    free(indices);
+    MeshCache_Release(&mesh);
 }
 
 #define _BOX_VTX_CNT   24
@@ -597,6 +517,11 @@ create_shapes_geometry (D3DRenderContext * render_ctx) {
     cylinder_submesh.start_index_location = cylinder_index_offsett;
     cylinder_submesh.base_vertex_location = cylinder_vertex_offset;
 
+    BoundingBox::CreateFromPoints(box_submesh.bounds, _BOX_VTX_CNT, &box_vertices[0].Position, sizeof(GeomVertex));
+    BoundingBox::CreateFromPoints(grid_submesh.bounds, _GRID_VTX_CNT, &grid_vertices[0].Position, sizeof(GeomVertex));
+    BoundingBox::CreateFromPoints(sphere_submesh.bounds, _SPHERE_VTX_CNT, &sphere_vertices[0].Position, sizeof(GeomVertex));
+    BoundingBox::CreateFromPoints(cylinder_submesh.bounds, _CYLINDER_VTX_CNT, &cylinder_vertices[0].Position, sizeof(GeomVertex));
+
     // Extract the vertex elements we are interested in and pack the
     // vertices of all the meshes into one vertex buffer.
 
@@ -655,9 +580,6 @@ create_shapes_geometry (D3DRenderContext * render_ctx) {
     if (indices)
         CopyMemory(render_ctx->geom[GEOM_SHAPES].ib_cpu->GetBufferPointer(), indices, ib_byte_size);
 
-    create_default_buffer(render_ctx->device, render_ctx->direct_cmd_list, vertices, vb_byte_size, &render_ctx->geom[GEOM_SHAPES].vb_uploader, &render_ctx->geom[GEOM_SHAPES].vb_gpu);
-    create_default_buffer(render_ctx->device, render_ctx->direct_cmd_list, indices, ib_byte_size, &render_ctx->geom[GEOM_SHAPES].ib_uploader, &render_ctx->geom[GEOM_SHAPES].ib_gpu);
-
     render_ctx->geom[GEOM_SHAPES].vb_byte_stide = sizeof(Vertex);
     render_ctx->geom[GEOM_SHAPES].vb_byte_size = vb_byte_size;
     render_ctx->geom[GEOM_SHAPES].ib_byte_size = ib_byte_size;
@@ -672,6 +594,12 @@ create_shapes_geometry (D3DRenderContext * render_ctx) {
     render_ctx->geom[GEOM_SHAPES].submesh_names[_CYLINDER_ID] = "cylinder";
     render_ctx->geom[GEOM_SHAPES].submesh_geoms[_CYLINDER_ID] = cylinder_submesh;
 
+    // -- reorder every shape for overdraw and vertex fetch, then upload the optimized blobs
+    Mesh_OptimizeCpuBuffers(&render_ctx->geom[GEOM_SHAPES], _CYLINDER_ID + 1, "shapes");
+
+    create_default_buffer(render_ctx->device, render_ctx->direct_cmd_list, render_ctx->geom[GEOM_SHAPES].vb_cpu->GetBufferPointer(), vb_byte_size, &render_ctx->geom[GEOM_SHAPES].vb_uploader, &render_ctx->geom[GEOM_SHAPES].vb_gpu);
+    create_default_buffer(render_ctx->device, render_ctx->direct_cmd_list, render_ctx->geom[GEOM_SHAPES].ib_cpu->GetBufferPointer(), ib_byte_size, &render_ctx->geom[GEOM_SHAPES].ib_uploader, &render_ctx->geom[GEOM_SHAPES].ib_gpu);
+
     // -- cleanup
     free(scratch);
     free(indices);
@@ -707,6 +635,7 @@ create_render_items (D3DRenderContext * render_ctx) {
     render_ctx->all_ritems.ritems[RITEM_SKULL].index_count = render_ctx->geom[GEOM_SKULL].submesh_geoms[0].index_count;
     render_ctx->all_ritems.ritems[RITEM_SKULL].start_index_loc = render_ctx->geom[GEOM_SKULL].submesh_geoms[0].start_index_location;
     render_ctx->all_ritems.ritems[RITEM_SKULL].base_vertex_loc = render_ctx->geom[GEOM_SKULL].submesh_geoms[0].base_vertex_location;
+    render_ctx->all_ritems.ritems[RITEM_SKULL].bounds = render_ctx->geom[GEOM_SKULL].submesh_geoms[0].bounds;
     render_ctx->all_ritems.ritems[RITEM_SKULL].n_frames_dirty = NUM_QUEUING_FRAMES;
     render_ctx->all_ritems.ritems[RITEM_SKULL].mat->n_frames_dirty = NUM_QUEUING_FRAMES;
     render_ctx->all_ritems.ritems[RITEM_SKULL].initialized = true;
@@ -723,6 +652,7 @@ create_render_items (D3DRenderContext * render_ctx) {
     render_ctx->all_ritems.ritems[RITEM_BOX].index_count = render_ctx->geom[GEOM_SHAPES].submesh_geoms[_BOX_ID].index_count;
     render_ctx->all_ritems.ritems[RITEM_BOX].start_index_loc = render_ctx->geom[GEOM_SHAPES].submesh_geoms[_BOX_ID].start_index_location;
     render_ctx->all_ritems.ritems[RITEM_BOX].base_vertex_loc = render_ctx->geom[GEOM_SHAPES].submesh_geoms[_BOX_ID].base_vertex_location;
+    render_ctx->all_ritems.ritems[RITEM_BOX].bounds = render_ctx->geom[GEOM_SHAPES].submesh_geoms[_BOX_ID].bounds;
     render_ctx->all_ritems.ritems[RITEM_BOX].n_frames_dirty = NUM_QUEUING_FRAMES;
     render_ctx->all_ritems.ritems[RITEM_BOX].mat->n_frames_dirty = NUM_QUEUING_FRAMES;
     render_ctx->all_ritems.ritems[RITEM_BOX].initialized = false;   // hide box for now
@@ -739,6 +669,7 @@ create_render_items (D3DRenderContext * render_ctx) {
     render_ctx->all_ritems.ritems[RITEM_GRID].index_count = render_ctx->geom[GEOM_SHAPES].submesh_geoms[_GRID_ID].index_count;
     render_ctx->all_ritems.ritems[RITEM_GRID].start_index_loc = render_ctx->geom[GEOM_SHAPES].submesh_geoms[_GRID_ID].start_index_location;
     render_ctx->all_ritems.ritems[RITEM_GRID].base_vertex_loc = render_ctx->geom[GEOM_SHAPES].submesh_geoms[_GRID_ID].base_vertex_location;
+    render_ctx->all_ritems.ritems[RITEM_GRID].bounds = render_ctx->geom[GEOM_SHAPES].submesh_geoms[_GRID_ID].bounds;
     render_ctx->all_ritems.ritems[RITEM_GRID].n_frames_dirty = NUM_QUEUING_FRAMES;
     render_ctx->all_ritems.ritems[RITEM_GRID].mat->n_frames_dirty = NUM_QUEUING_FRAMES;
     render_ctx->all_ritems.ritems[RITEM_GRID].initialized = true;
@@ -755,6 +686,7 @@ create_render_items (D3DRenderContext * render_ctx) {
     render_ctx->all_ritems.ritems[RITEM_GLOBE].index_count = render_ctx->geom[GEOM_SHAPES].submesh_geoms[_SPHERE_ID].index_count;
     render_ctx->all_ritems.ritems[RITEM_GLOBE].start_index_loc = render_ctx->geom[GEOM_SHAPES].submesh_geoms[_SPHERE_ID].start_index_location;
     render_ctx->all_ritems.ritems[RITEM_GLOBE].base_vertex_loc = render_ctx->geom[GEOM_SHAPES].submesh_geoms[_SPHERE_ID].base_vertex_location;
+    render_ctx->all_ritems.ritems[RITEM_GLOBE].bounds = render_ctx->geom[GEOM_SHAPES].submesh_geoms[_SPHERE_ID].bounds;
     render_ctx->all_ritems.ritems[RITEM_GLOBE].n_frames_dirty = NUM_QUEUING_FRAMES;
     render_ctx->all_ritems.ritems[RITEM_GLOBE].mat->n_frames_dirty = NUM_QUEUING_FRAMES;
     render_ctx->all_ritems.ritems[RITEM_GLOBE].initialized = true;
@@ -781,6 +713,7 @@ create_render_items (D3DRenderContext * render_ctx) {
         render_ctx->all_ritems.ritems[_curr].index_count = render_ctx->geom[GEOM_SHAPES].submesh_geoms[_CYLINDER_ID].index_count;
         render_ctx->all_ritems.ritems[_curr].start_index_loc = render_ctx->geom[GEOM_SHAPES].submesh_geoms[_CYLINDER_ID].start_index_location;
         render_ctx->all_ritems.ritems[_curr].base_vertex_loc = render_ctx->geom[GEOM_SHAPES].submesh_geoms[_CYLINDER_ID].base_vertex_location;
+        render_ctx->all_ritems.ritems[_curr].bounds = render_ctx->geom[GEOM_SHAPES].submesh_geoms[_CYLINDER_ID].bounds;
         render_ctx->all_ritems.ritems[_curr].n_frames_dirty = NUM_QUEUING_FRAMES;
         render_ctx->all_ritems.ritems[_curr].mat->n_frames_dirty = NUM_QUEUING_FRAMES;
         render_ctx->all_ritems.ritems[_curr].initialized = true;
@@ -797,6 +730,7 @@ create_render_items (D3DRenderContext * render_ctx) {
         render_ctx->all_ritems.ritems[_curr].index_count = render_ctx->geom[GEOM_SHAPES].submesh_geoms[_CYLINDER_ID].index_count;
         render_ctx->all_ritems.ritems[_curr].start_index_loc = render_ctx->geom[GEOM_SHAPES].submesh_geoms[_CYLINDER_ID].start_index_location;
         render_ctx->all_ritems.ritems[_curr].base_vertex_loc = render_ctx->geom[GEOM_SHAPES].submesh_geoms[_CYLINDER_ID].base_vertex_location;
+        render_ctx->all_ritems.ritems[_curr].bounds = render_ctx->geom[GEOM_SHAPES].submesh_geoms[_CYLINDER_ID].bounds;
         render_ctx->all_ritems.ritems[_curr].n_frames_dirty = NUM_QUEUING_FRAMES;
         render_ctx->all_ritems.ritems[_curr].mat->n_frames_dirty = NUM_QUEUING_FRAMES;
         render_ctx->all_ritems.ritems[_curr].initialized = true;
@@ -813,6 +747,7 @@ create_render_items (D3DRenderContext * render_ctx) {
         render_ctx->all_ritems.ritems[_curr].index_count = render_ctx->geom[GEOM_SHAPES].submesh_geoms[_SPHERE_ID].index_count;
         render_ctx->all_ritems.ritems[_curr].start_index_loc = render_ctx->geom[GEOM_SHAPES].submesh_geoms[_SPHERE_ID].start_index_location;
         render_ctx->all_ritems.ritems[_curr].base_vertex_loc = render_ctx->geom[GEOM_SHAPES].submesh_geoms[_SPHERE_ID].base_vertex_location;
+        render_ctx->all_ritems.ritems[_curr].bounds = render_ctx->geom[GEOM_SHAPES].submesh_geoms[_SPHERE_ID].bounds;
         render_ctx->all_ritems.ritems[_curr].n_frames_dirty = NUM_QUEUING_FRAMES;
         render_ctx->all_ritems.ritems[_curr].mat->n_frames_dirty = NUM_QUEUING_FRAMES;
         render_ctx->all_ritems.ritems[_curr].initialized = true;
@@ -829,6 +764,7 @@ create_render_items (D3DRenderContext * render_ctx) {
         render_ctx->all_ritems.ritems[_curr].index_count = render_ctx->geom[GEOM_SHAPES].submesh_geoms[_SPHERE_ID].index_count;
         render_ctx->all_ritems.ritems[_curr].start_index_loc = render_ctx->geom[GEOM_SHAPES].submesh_geoms[_SPHERE_ID].start_index_location;
         render_ctx->all_ritems.ritems[_curr].base_vertex_loc = render_ctx->geom[GEOM_SHAPES].submesh_geoms[_SPHERE_ID].base_vertex_location;
+        render_ctx->all_ritems.ritems[_curr].bounds = render_ctx->geom[GEOM_SHAPES].submesh_geoms[_SPHERE_ID].bounds;
         render_ctx->all_ritems.ritems[_curr].n_frames_dirty = NUM_QUEUING_FRAMES;
         render_ctx->all_ritems.ritems[_curr].mat->n_frames_dirty = NUM_QUEUING_FRAMES;
         render_ctx->all_ritems.ritems[_curr].initialized = true;
@@ -838,15 +774,20 @@ create_render_items (D3DRenderContext * render_ctx) {
     }
     _ASSERT_EXPR(_curr == _COUNT_RENDERITEM, _T("Invalid render items creation"));
 }
+// [items] (optional) draws only ritem_array->ritems[items[0 .. item_count)]
 static void
 draw_render_items (
     ID3D12GraphicsCommandList * cmd_list,
     ID3D12Resource * obj_cb,
     UINT64 descriptor_increment_size,
-    RenderItemArray * ritem_array
+    RenderItemArray * ritem_array,
+    UINT const * items = nullptr,
+    UINT item_count = 0
 ) {
     size_t obj_cbuffer_size = sizeof(ObjectConstants);
-    for (size_t i = 0; i < ritem_array->size; ++i) {
+    size_t n = items ? item_count : ritem_array->size;
+    for (size_t k = 0; k < n; ++k) {
+        size_t i = items ? items[k] : k;
         if (ritem_array->ritems[i].initialized) {
             D3D12_VERTEX_BUFFER_VIEW vbv = Mesh_GetVertexBufferView(ritem_array->ritems[i].geometry);
             D3D12_INDEX_BUFFER_VIEW ibv = Mesh_GetIndexBufferView(ritem_array->ritems[i].geometry);
@@ -1015,6 +956,21 @@ create_cube_face_cameras (Camera * cams [], float x, float y, float z) {
         Camera_UpdateViewMatrix(cams[i]);
     }
 }
+// Limits how far face [face] of the probe sees (its camera lens and its culling)
+static void
+set_cube_face_far_plane (D3DRenderContext * render_ctx, int face, float far_z) {
+    Camera * cam = render_ctx->cubemap_cameras[face];
+    Camera_SetLens(cam, Camera_GetFovY(cam), Camera_GetAspect(cam), Camera_GetNearZ(cam), far_z);
+    render_ctx->cubemap_culling.far_z[face] = far_z;
+}
+// Culls opaque_ritems against the six face frusta at once; each face then draws its own list
+static void
+update_cubemap_culling (D3DRenderContext * render_ctx) {
+    CubeFaceCulling * cull = &render_ctx->cubemap_culling;
+    cull->center = Camera_GetPosition3f(render_ctx->cubemap_cameras[0]);
+    cull->near_z = Camera_GetNearZ(render_ctx->cubemap_cameras[0]);
+    CubeFaceCulling_Cull(cull, render_ctx->opaque_ritems.ritems, render_ctx->opaque_ritems.size);
+}
 static void
 create_cube_depth_stencil (D3DRenderContext * render_ctx) {
     // Create the depth/stencil buffer and view.
@@ -1097,12 +1053,21 @@ draw_scene_to_cubemap (D3DRenderContext * render_ctx) {
             frame_resource.pass_cb->GetGPUVirtualAddress() + (i + 1) * pass_cb_size;
         cmdlist->SetGraphicsRootConstantBufferView(1, pass_cb_address);
 
-        draw_render_items(
-        cmdlist,
-        frame_resource.obj_cb,
-        render_ctx->cbv_srv_uav_descriptor_size,
-        &render_ctx->opaque_ritems
-        );
+        if (global_cubemap_culling_enabled)
+            draw_render_items(
+                cmdlist,
+                frame_resource.obj_cb,
+                render_ctx->cbv_srv_uav_descriptor_size,
+                &render_ctx->opaque_ritems,
+                render_ctx->cubemap_culling.face_items[i], render_ctx->cubemap_culling.face_count[i]
+            );
+        else
+            draw_render_items(
+                cmdlist,
+                frame_resource.obj_cb,
+                render_ctx->cbv_srv_uav_descriptor_size,
+                &render_ctx->opaque_ritems
+            );
 
         cmdlist->SetPipelineState(render_ctx->psos[LAYER_SKY]);
         draw_render_items(
@@ -2399,6 +2364,8 @@ WinMain(_In_ HINSTANCE hInstance, _In_opt_ HINSTANCE, _In_ LPSTR, _In_ INT) {
         Camera_Init(render_ctx->cubemap_cameras[i]);
     }
     create_cube_face_cameras(render_ctx->cubemap_cameras, 0.0f, 2.0f, 0.0f);
+    for (int i = 0; i < 6; ++i)
+        render_ctx->cubemap_culling.far_z[i] = Camera_GetFarZ(render_ctx->cubemap_cameras[i]);
 
 
     create_descriptor_heaps(render_ctx);
@@ -2645,6 +2612,21 @@ WinMain(_In_ HINSTANCE hInstance, _In_opt_ HINSTANCE, _In_ LPSTR, _In_ INT) {
                     render_ctx->materials[MAT_MIRROR].n_frames_dirty = NUM_QUEUING_FRAMES;
                 };
 
+                ImGui::Checkbox("Cull Cube Map Faces", &global_cubemap_culling_enabled);
+                if (ImGui::TreeNode("Cube Map Face Far Planes")) {
+                    char const * face_names [6] = {"+X", "-X", "+Y", "-Y", "+Z", "-Z"};
+                    for (int i = 0; i < 6; ++i) {
+                        float far_z = render_ctx->cubemap_culling.far_z[i];
+                        if (ImGui::SliderFloat(face_names[i], &far_z, 5.0f, 1000.0f, "%.1f"))
+                            set_cube_face_far_plane(render_ctx, i, far_z);
+                        if (global_cubemap_culling_enabled) {
+                            ImGui::SameLine();
+                            ImGui::Text("%u items", render_ctx->cubemap_culling.face_count[i]);
+                        }
+                    }
+                    ImGui::TreePop();
+                }
+
                 ImGui::Text("\n");
                 ImGui::Separator();
                 ImGui::Text("Application average %.3f ms/frame (%.1f FPS)", 1000.0f / ImGui::GetIO().Framerate, ImGui::GetIO().Framerate);
@@ -2687,6 +2669,8 @@ WinMain(_In_ HINSTANCE hInstance, _In_opt_ HINSTANCE, _In_ LPSTR, _In_ INT) {
                 update_object_cbuffer(render_ctx);
 
                 update_cubemap_face_pass_cbuffers(render_ctx);
+                if (global_cubemap_culling_enabled)
+                    update_cubemap_culling(render_ctx);
 
                 draw_main(render_ctx);
 
@@ -0,0 +1,141 @@
+/* ===========================================================
+   #File: cube_face_culling.h #
+   #Date: 17 Oct 2026 #
+   #Revision: 1.0 #
+   #Creator: Omid Miresmaeili #
+   #Description: culling render items against the six faces of a cube map probe in one pass #
+   #Notice: (C) Copyright 2021 by Omid. All Rights Reserved. #
+   =========================================================== */
+#pragma once
+
+#include "common.h"
+#include "utils.h"
+#include <immintrin.h>
+
+using namespace DirectX;
+
+//
+// Cube face culling
+//
+// The six face frusta of a probe are 90 degree pyramids around the axes, so their side
+// planes are the six diagonal planes x = +-y, x = +-z and y = +-z, each one shared by
+// two faces (one face on each side). A box is tested once against these planes and the
+// near/far planes along the axes, and the results are combined into a 6-bit mask telling
+// which faces see it. Faces are ordered as the probe cameras: +X, -X, +Y, -Y, +Z, -Z.
+//
+#define CUBE_CULL_MAX_ITEMS     32
+#define CUBE_CULL_FACE_COUNT    6
+
+struct CubeFaceCulling {
+    XMFLOAT3            center;         // probe position
+    float               near_z;
+    float               far_z [CUBE_CULL_FACE_COUNT];
+
+    // world space AABBs relative to the probe (SoA)
+    alignas(16) float   center_x [CUBE_CULL_MAX_ITEMS];
+    alignas(16) float   center_y [CUBE_CULL_MAX_ITEMS];
+    alignas(16) float   center_z [CUBE_CULL_MAX_ITEMS];
+    alignas(16) float   extent_x [CUBE_CULL_MAX_ITEMS];
+    alignas(16) float   extent_y [CUBE_CULL_MAX_ITEMS];
+    alignas(16) float   extent_z [CUBE_CULL_MAX_ITEMS];
+
+    uint8_t             face_mask [CUBE_CULL_MAX_ITEMS];
+    UINT                face_items [CUBE_CULL_FACE_COUNT][CUBE_CULL_MAX_ITEMS];    // indices of the items each face draws
+    UINT                face_count [CUBE_CULL_FACE_COUNT];
+    UINT                item_count;
+};
+
+// Face masks of the four boxes starting at [i] (lanes past item_count are discarded by the caller)
+static __m128i
+CubeFaceCulling_TestBoxes (CubeFaceCulling const * cull, UINT i) {
+    __m128 zero = _mm_setzero_ps();
+    __m128 cx = _mm_load_ps(cull->center_x + i);
+    __m128 cy = _mm_load_ps(cull->center_y + i);
+    __m128 cz = _mm_load_ps(cull->center_z + i);
+    __m128 ex = _mm_load_ps(cull->extent_x + i);
+    __m128 ey = _mm_load_ps(cull->extent_y + i);
+    __m128 ez = _mm_load_ps(cull->extent_z + i);
+
+    // diagonal planes: the box reaches their positive side if (center + radius) >= 0,
+    // and their negative side if (center - radius) <= 0
+    __m128 exy = _mm_add_ps(ex, ey);
+    __m128 exz = _mm_add_ps(ex, ez);
+    __m128 eyz = _mm_add_ps(ey, ez);
+    __m128 a = _mm_sub_ps(cx, cy);      // x - y
+    __m128 b = _mm_add_ps(cx, cy);      // x + y
+    __m128 c = _mm_sub_ps(cx, cz);      // x - z
+    __m128 d = _mm_add_ps(cx, cz);      // x + z
+    __m128 e = _mm_sub_ps(cy, cz);      // y - z
+    __m128 f = _mm_add_ps(cy, cz);      // y + z
+    __m128 pos_a = _mm_cmpge_ps(_mm_add_ps(a, exy), zero), neg_a = _mm_cmple_ps(_mm_sub_ps(a, exy), zero);
+    __m128 pos_b = _mm_cmpge_ps(_mm_add_ps(b, exy), zero), neg_b = _mm_cmple_ps(_mm_sub_ps(b, exy), zero);
+    __m128 pos_c = _mm_cmpge_ps(_mm_add_ps(c, exz), zero), neg_c = _mm_cmple_ps(_mm_sub_ps(c, exz), zero);
+    __m128 pos_d = _mm_cmpge_ps(_mm_add_ps(d, exz), zero), neg_d = _mm_cmple_ps(_mm_sub_ps(d, exz), zero);
+    __m128 pos_e = _mm_cmpge_ps(_mm_add_ps(e, eyz), zero), neg_e = _mm_cmple_ps(_mm_sub_ps(e, eyz), zero);
+    __m128 pos_f = _mm_cmpge_ps(_mm_add_ps(f, eyz), zero), neg_f = _mm_cmple_ps(_mm_sub_ps(f, eyz), zero);
+
+    // near/far planes along the axes: the box spans [lo, hi] on each axis
+    __m128 near_z = _mm_set1_ps(cull->near_z);
+    __m128 lo_x = _mm_sub_ps(cx, ex), hi_x = _mm_add_ps(cx, ex);
+    __m128 lo_y = _mm_sub_ps(cy, ey), hi_y = _mm_add_ps(cy, ey);
+    __m128 lo_z = _mm_sub_ps(cz, ez), hi_z = _mm_add_ps(cz, ez);
+    __m128 depth [CUBE_CULL_FACE_COUNT] = {
+        _mm_and_ps(_mm_cmpge_ps(hi_x, near_z), _mm_cmple_ps(lo_x, _mm_set1_ps(cull->far_z[0]))),
+        _mm_and_ps(_mm_cmple_ps(lo_x, _mm_sub_ps(zero, near_z)), _mm_cmpge_ps(hi_x, _mm_set1_ps(-cull->far_z[1]))),
+        _mm_and_ps(_mm_cmpge_ps(hi_y, near_z), _mm_cmple_ps(lo_y, _mm_set1_ps(cull->far_z[2]))),
+        _mm_and_ps(_mm_cmple_ps(lo_y, _mm_sub_ps(zero, near_z)), _mm_cmpge_ps(hi_y, _mm_set1_ps(-cull->far_z[3]))),
+        _mm_and_ps(_mm_cmpge_ps(hi_z, near_z), _mm_cmple_ps(lo_z, _mm_set1_ps(cull->far_z[4]))),
+        _mm_and_ps(_mm_cmple_ps(lo_z, _mm_sub_ps(zero, near_z)), _mm_cmpge_ps(hi_z, _mm_set1_ps(-cull->far_z[5]))),
+    };
+    __m128 sides [CUBE_CULL_FACE_COUNT] = {
+        _mm_and_ps(_mm_and_ps(pos_a, pos_b), _mm_and_ps(pos_c, pos_d)),     // +X: x >= |y|, x >= |z|
+        _mm_and_ps(_mm_and_ps(neg_a, neg_b), _mm_and_ps(neg_c, neg_d)),     // -X
+        _mm_and_ps(_mm_and_ps(neg_a, pos_b), _mm_and_ps(pos_e, pos_f)),     // +Y: y >= |x|, y >= |z|
+        _mm_and_ps(_mm_and_ps(pos_a, neg_b), _mm_and_ps(neg_e, neg_f)),     // -Y
+        _mm_and_ps(_mm_and_ps(neg_c, pos_d), _mm_and_ps(neg_e, pos_f)),     // +Z: z >= |x|, z >= |y|
+        _mm_and_ps(_mm_and_ps(pos_c, neg_d), _mm_and_ps(pos_e, neg_f)),     // -Z
+    };
+
+    // gather the per face lanes into one 6-bit mask per box
+    __m128i mask = _mm_setzero_si128();
+    for (int face = 0; face < CUBE_CULL_FACE_COUNT; ++face) {
+        __m128i in_face = _mm_castps_si128(_mm_and_ps(sides[face], depth[face]));
+        mask = _mm_or_si128(mask, _mm_and_si128(in_face, _mm_set1_epi32(1 << face)));
+    }
+    return mask;
+}
+// Computes the face mask of every item and the list of items each face draws.
+// Items not initialized are seen by no face.
+static void
+CubeFaceCulling_Cull (CubeFaceCulling * cull, RenderItem const * ritems, UINT count) {
+    _ASSERT_EXPR(count <= CUBE_CULL_MAX_ITEMS, _T("too many render items to cull"));
+    XMVECTOR probe = XMLoadFloat3(&cull->center);
+    for (UINT i = 0; i < count; ++i) {
+        BoundingBox world_box;
+        ritems[i].bounds.Transform(world_box, XMLoadFloat4x4(&ritems[i].world));
+        XMFLOAT3 rel;
+        XMStoreFloat3(&rel, XMLoadFloat3(&world_box.Center) - probe);
+        cull->center_x[i] = rel.x;
+        cull->center_y[i] = rel.y;
+        cull->center_z[i] = rel.z;
+        cull->extent_x[i] = world_box.Extents.x;
+        cull->extent_y[i] = world_box.Extents.y;
+        cull->extent_z[i] = world_box.Extents.z;
+    }
+    cull->item_count = count;
+
+    alignas(16) int masks [4];
+    for (UINT i = 0; i < count; i += 4) {
+        _mm_store_si128((__m128i *)masks, CubeFaceCulling_TestBoxes(cull, i));
+        UINT lanes = count - i < 4 ? count - i : 4;
+        for (UINT k = 0; k < lanes; ++k)
+            cull->face_mask[i + k] = ritems[i + k].initialized ? (uint8_t)masks[k] : 0;
+    }
+
+    for (int face = 0; face < CUBE_CULL_FACE_COUNT; ++face)
+        cull->face_count[face] = 0;
+    for (UINT i = 0; i < count; ++i)
+        for (int face = 0; face < CUBE_CULL_FACE_COUNT; ++face)
+            if (cull->face_mask[i] & (1 << face))
+                cull->face_items[face][cull->face_count[face]++] = i;
+}
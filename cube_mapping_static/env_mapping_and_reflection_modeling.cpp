@@ -24,6 +24,7 @@
 #include "headers/utils.h"
 #include "headers/game_timer.h"
 #include "headers/dds_loader.h"
+#include "headers/mesh_loader.h"
 
 #include <imgui/imgui.h>
 #include <imgui/imgui_impl_win32.h>
@@ -342,59 +343,11 @@ create_materials (Material out_materials []) {
     out_materials[MAT_SKY].n_frames_dirty = NUM_QUEUING_FRAMES;
 }
 static void
-create_skull_geometry (D3DRenderContext * render_ctx) {
-#pragma region Read_Data_File
-    FILE * f = nullptr;
-    errno_t err = fopen_s(&f, "./models/skull.txt", "r");
-    if (0 == f || err != 0) {
-        printf("could not open file\n");
-        return;
-    }
-    char linebuf[100];
-    int cnt = 0;
-    unsigned vcount = 0;
-    unsigned tcount = 0;
-    // -- read 1st line
-    if (fgets(linebuf, sizeof(linebuf), f))
-        cnt = sscanf_s(linebuf, "%*s %d", &vcount);
-    if (cnt != 1) {
-        printf("read error\n");
-        printf("read line: %s\n", linebuf);
-        return;
-    }
-    // -- read 2nd line
-    if (fgets(linebuf, sizeof(linebuf), f))
-        cnt = sscanf_s(linebuf, "%*s %d", &tcount);
-    if (cnt != 1) {
-        printf("read error\n");
-        printf("read line: %s\n", linebuf);
-        return;
-    }
-    // -- skip two lines
-    fgets(linebuf, sizeof(linebuf), f);
-    fgets(linebuf, sizeof(linebuf), f);
-
-    // -- vmin and vmax for AABB construction
-    XMFLOAT3 vminf3(+FLT_MAX, +FLT_MAX, +FLT_MAX);
-    XMFLOAT3 vmaxf3(-FLT_MAX, -FLT_MAX, -FLT_MAX);
-
-    XMVECTOR vmin = XMLoadFloat3(&vminf3);
-    XMVECTOR vmax = XMLoadFloat3(&vmaxf3);
-
-    // -- read vertices
-    Vertex * vertices = (Vertex *)calloc(vcount, sizeof(Vertex));
-    for (unsigned i = 0; i < vcount; i++) {
-        fgets(linebuf, sizeof(linebuf), f);
-        cnt = sscanf_s(
-            linebuf, "%f %f %f %f %f %f",
-            &vertices[i].position.x, &vertices[i].position.y, &vertices[i].position.z,
-            &vertices[i].normal.x, &vertices[i].normal.y, &vertices[i].normal.z
-        );
-        if (cnt != 6) {
-            printf("read error\n");
-            printf("read line: %s\n", linebuf);
-            return;
-        }
+build_skull_vertices (TextMesh const * src, void * out_vertices) {
+    Vertex * vertices = (Vertex *)out_vertices;
+    for (UINT i = 0; i < src->vertex_count; i++) {
+        vertices[i].position = src->positions[i];
+        vertices[i].normal = src->normals[i];
 
 #pragma region skull texture coordinates calculations
         XMVECTOR P = XMLoadFloat3(&vertices[i].position);
@@ -416,74 +369,37 @@ create_skull_geometry (D3DRenderContext * render_ctx) {
 
         vertices[i].texc = {u, v};
 #pragma endregion
-
-        // -- calculate vmin, vmax
-        vmin = XMVectorMin(vmin, P);
-        vmax = XMVectorMax(vmax, P);
     }
+}
+static void
+create_skull_geometry (D3DRenderContext * render_ctx) {
 
-    // -- construct bounding box (AABB)
-    BoundingBox bounds;
-    XMStoreFloat3(&bounds.Center, 0.5f * (vmin + vmax));
-    XMStoreFloat3(&bounds.Extents, 0.5f * (vmax - vmin));
-
-    // -- skip three lines
-    fgets(linebuf, sizeof(linebuf), f);
-    fgets(linebuf, sizeof(linebuf), f);
-    fgets(linebuf, sizeof(linebuf), f);
-    // -- read indices
-    uint32_t * indices = (uint32_t *)calloc(static_cast<size_t>(tcount) * 3, sizeof(uint32_t));
-    for (unsigned i = 0; i < tcount; i++) {
-        fgets(linebuf, sizeof(linebuf), f);
-        cnt = sscanf_s(
-            linebuf, "%d %d %d",
-            &indices[i * 3 + 0], &indices[i * 3 + 1], &indices[i * 3 + 2]
-        );
-        if (cnt != 3) {
-            printf("read error\n");
-            printf("read line: %s\n", linebuf);
-            return;
-        }
+    // -- map the binary mesh (created from the text file on first load)
+    MeshCacheView mesh = {};
+    if (!load_mesh_cached("./models/skull.mesh", "./models/skull.txt", sizeof(Vertex), build_skull_vertices, &mesh)) {
+        printf("could not load skull mesh\n");
+        return;
     }
 
-    // -- remember to free heap-allocated memory
-    /*
-    free(vertices);
-    free(indices);
-    */
-    fclose(f);
-#pragma endregion   Read_Data_File
-
-    UINT vb_byte_size = vcount * sizeof(Vertex);
-    UINT ib_byte_size = (tcount * 3) * sizeof(uint32_t);
+    UINT vb_byte_size = mesh.vertex_count * sizeof(Vertex);
 
     // -- Fill out render_ctx geom[GEOM_SKULL] (skull)
     D3DCreateBlob(vb_byte_size, &render_ctx->geom[GEOM_SKULL].vb_cpu);
-    CopyMemory(render_ctx->geom[GEOM_SKULL].vb_cpu->GetBufferPointer(), vertices, vb_byte_size);
+    CopyMemory(render_ctx->geom[GEOM_SKULL].vb_cpu->GetBufferPointer(), mesh.vertices, vb_byte_size);
 
-    D3DCreateBlob(ib_byte_size, &render_ctx->geom[GEOM_SKULL].ib_cpu);
-    CopyMemory(render_ctx->geom[GEOM_SKULL].ib_cpu->GetBufferPointer(), indices, ib_byte_size);
+    // narrowest index format that still draws the skull as a single submesh
+    Mesh_CreateIndexBuffer(&render_ctx->geom[GEOM_SKULL], mesh.indices, mesh.index_count, mesh.vertices, sizeof(Vertex), 1, "skull");
 
-    create_default_buffer(render_ctx->device, render_ctx->direct_cmd_list, vertices, vb_byte_size, &render_ctx->geom[GEOM_SKULL].vb_uploader, &render_ctx->geom[GEOM_SKULL].vb_gpu);
-    create_default_buffer(render_ctx->device, render_ctx->direct_cmd_list, indices, ib_byte_size, &render_ctx->geom[GEOM_SKULL].ib_uploader, &render_ctx->geom[GEOM_SKULL].ib_gpu);
+    create_default_buffer(render_ctx->device, render_ctx->direct_cmd_list, (void *)mesh.vertices, vb_byte_size, &render_ctx->geom[GEOM_SKULL].vb_uploader, &render_ctx->geom[GEOM_SKULL].vb_gpu);
+    create_default_buffer(render_ctx->device, render_ctx->direct_cmd_list, render_ctx->geom[GEOM_SKULL].ib_cpu->GetBufferPointer(), render_ctx->geom[GEOM_SKULL].ib_byte_size, &render_ctx->geom[GEOM_SKULL].ib_uploader, &render_ctx->geom[GEOM_SKULL].ib_gpu);
 
     render_ctx->geom[GEOM_SKULL].vb_byte_stide = sizeof(Vertex);
     render_ctx->geom[GEOM_SKULL].vb_byte_size = vb_byte_size;
-    render_ctx->geom[GEOM_SKULL].ib_byte_size = ib_byte_size;
-    render_ctx->geom[GEOM_SKULL].index_format = DXGI_FORMAT_R32_UINT;
-
-    SubmeshGeometry submesh = {};
-    submesh.index_count = tcount * 3;
-    submesh.start_index_location = 0;
-    submesh.base_vertex_location = 0;
-    submesh.bounds = bounds;
 
     render_ctx->geom[GEOM_SKULL].submesh_names[0] = "skull";
-    render_ctx->geom[GEOM_SKULL].submesh_geoms[0] = submesh;
 
     // -- cleanup
-    free(vertices);
-    free(indices);
+    MeshCache_Release(&mesh);
 }
 #define _BOX_VTX_CNT   24
 #define _BOX_IDX_CNT   36
@@ -629,9 +545,6 @@ create_shapes_geometry (D3DRenderContext * render_ctx) {
     if (indices)
         CopyMemory(render_ctx->geom[GEOM_SHAPES].ib_cpu->GetBufferPointer(), indices, ib_byte_size);
 
-    create_default_buffer(render_ctx->device, render_ctx->direct_cmd_list, vertices, vb_byte_size, &render_ctx->geom[GEOM_SHAPES].vb_uploader, &render_ctx->geom[GEOM_SHAPES].vb_gpu);
-    create_default_buffer(render_ctx->device, render_ctx->direct_cmd_list, indices, ib_byte_size, &render_ctx->geom[GEOM_SHAPES].ib_uploader, &render_ctx->geom[GEOM_SHAPES].ib_gpu);
-
     render_ctx->geom[GEOM_SHAPES].vb_byte_stide = sizeof(Vertex);
     render_ctx->geom[GEOM_SHAPES].vb_byte_size = vb_byte_size;
     render_ctx->geom[GEOM_SHAPES].ib_byte_size = ib_byte_size;
@@ -646,6 +559,12 @@ create_shapes_geometry (D3DRenderContext * render_ctx) {
     render_ctx->geom[GEOM_SHAPES].submesh_names[_CYLINDER_ID] = "cylinder";
     render_ctx->geom[GEOM_SHAPES].submesh_geoms[_CYLINDER_ID] = cylinder_submesh;
 
+    // -- reorder every shape for overdraw and vertex fetch, then upload the optimized blobs
+    Mesh_OptimizeCpuBuffers(&render_ctx->geom[GEOM_SHAPES], _CYLINDER_ID + 1, "shapes");
+
+    create_default_buffer(render_ctx->device, render_ctx->direct_cmd_list, render_ctx->geom[GEOM_SHAPES].vb_cpu->GetBufferPointer(), vb_byte_size, &render_ctx->geom[GEOM_SHAPES].vb_uploader, &render_ctx->geom[GEOM_SHAPES].vb_gpu);
+    create_default_buffer(render_ctx->device, render_ctx->direct_cmd_list, render_ctx->geom[GEOM_SHAPES].ib_cpu->GetBufferPointer(), ib_byte_size, &render_ctx->geom[GEOM_SHAPES].ib_uploader, &render_ctx->geom[GEOM_SHAPES].ib_gpu);
+
     // -- cleanup
     free(scratch);
     free(indices);
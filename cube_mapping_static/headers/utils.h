@@ -10,6 +10,7 @@
 
 #include "common.h"
 #include "mesh_geometry.h"
+#include "mesh_optimizer.h"
 
 #define ARRAY_COUNT(arr)                sizeof(arr)/sizeof(arr[0])
 #define CLAMP_VALUE(val, lb, ub)        ((val) < (lb)) ? (lb) : ((val) > (ub) ? (ub) : (val))
@@ -743,6 +744,9 @@ create_sphere (float radius, GeomVertex out_vtx [], uint16_t out_idx []) {
         out_idx[_idx_cnt++] = base_index + i;
         out_idx[_idx_cnt++] = base_index + i + 1;
     }
+
+    // bottom pole is stored at [n_vtx + 1]
+    optimize_vertex_cache_and_report("sphere", out_idx, _idx_cnt, n_vtx + 2);
 }
 static void
 create_cylinder (float bottom_radius, float top_radius, float height, GeomVertex out_vtx [], uint16_t out_idx []) {
@@ -877,6 +881,7 @@ create_cylinder (float bottom_radius, float top_radius, float height, GeomVertex
     }
 #pragma endregion build cylinder bottom
 
+    optimize_vertex_cache_and_report("cylinder", out_idx, _idx_cnt, _vtx_cnt);
 }
 static void
 create_grid16 (float width, float depth, UINT32 m, UINT32 n, GeomVertex out_vtx [], uint16_t out_idx []) {
@@ -925,6 +930,8 @@ create_grid16 (float width, float depth, UINT32 m, UINT32 n, GeomVertex out_vtx
             k += 6; // next quad
         }
     }
+
+    optimize_vertex_cache_and_report("grid16", out_idx, k, m * n);
 }
 static void
 create_grid32 (float width, float depth, UINT32 m, UINT32 n, GeomVertex out_vtx [], uint32_t out_idx []) {
@@ -973,4 +980,6 @@ create_grid32 (float width, float depth, UINT32 m, UINT32 n, GeomVertex out_vtx
             k += 6; // next quad
         }
     }
+
+    optimize_vertex_cache_and_report("grid32", out_idx, k, m * n);
 }
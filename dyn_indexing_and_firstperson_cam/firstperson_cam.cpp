@@ -9,6 +9,7 @@
 #include "headers/utils.h"
 #include "headers/game_timer.h"
 #include "headers/dds_loader.h"
+#include "headers/mesh_conditioning.h"
 
 #include "offscreen_render_target.h"
 #include "gpu_waves.h"
@@ -499,32 +500,23 @@ create_water_geometry (UINT nrow, UINT ncol, UINT ntri, D3DRenderContext * rende
     }
 
     UINT vb_byte_size = _WAVE_VTX_CNT * sizeof(Vertex);
-    UINT ib_byte_size = _idx_cnt * sizeof(uint32_t);
 
     // -- Fill out render_ctx geom (output)
 
     CHECK_AND_FAIL(D3DCreateBlob(vb_byte_size, &render_ctx->geom[GEOM_WATER].vb_cpu));
     if (vertices)
         CopyMemory(render_ctx->geom[GEOM_WATER].vb_cpu->GetBufferPointer(), vertices, vb_byte_size);
-    CHECK_AND_FAIL(D3DCreateBlob(ib_byte_size, &render_ctx->geom[GEOM_WATER].ib_cpu));
-    if (indices)
-        CopyMemory(render_ctx->geom[GEOM_WATER].ib_cpu->GetBufferPointer(), indices, ib_byte_size);
+
+    // a 256x256 grid is exactly addressable with R16 indices
+    Mesh_CreateIndexBuffer(&render_ctx->geom[GEOM_WATER], indices, _idx_cnt, vertices, sizeof(Vertex), 1, "water");
 
     create_default_buffer(render_ctx->device, render_ctx->direct_cmd_list, vertices, vb_byte_size, &render_ctx->geom[GEOM_WATER].vb_gpu, &render_ctx->geom[GEOM_WATER].vb_uploader);
-    create_default_buffer(render_ctx->device, render_ctx->direct_cmd_list, indices, ib_byte_size, &render_ctx->geom[GEOM_WATER].ib_gpu, &render_ctx->geom[GEOM_WATER].ib_uploader);
+    create_default_buffer(render_ctx->device, render_ctx->direct_cmd_list, render_ctx->geom[GEOM_WATER].ib_cpu->GetBufferPointer(), render_ctx->geom[GEOM_WATER].ib_byte_size, &render_ctx->geom[GEOM_WATER].ib_gpu, &render_ctx->geom[GEOM_WATER].ib_uploader);
 
     render_ctx->geom[GEOM_WATER].vb_byte_stide = sizeof(Vertex);
     render_ctx->geom[GEOM_WATER].vb_byte_size = vb_byte_size;
-    render_ctx->geom[GEOM_WATER].ib_byte_size = ib_byte_size;
-    render_ctx->geom[GEOM_WATER].index_format = DXGI_FORMAT_R32_UINT;
-
-    SubmeshGeometry submesh;
-    submesh.index_count = _idx_cnt;
-    submesh.start_index_location = 0;
-    submesh.base_vertex_location = 0;
 
     render_ctx->geom[GEOM_WATER].submesh_names[0] = "water";
-    render_ctx->geom[GEOM_WATER].submesh_geoms[0] = submesh;
 
     ::free(grid);
     ::free(indices);
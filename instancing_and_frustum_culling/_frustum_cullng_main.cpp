@@ -22,6 +22,14 @@
 #include "headers/utils.h"
 #include "headers/game_timer.h"
 #include "headers/dds_loader.h"
+#include "headers/mesh_loader.h"
+#include "headers/mesh_lod.h"
+#include "headers/screen_coverage.h"
+#include "headers/instance_culling.h"
+#include "headers/instance_bvh.h"
+#include "headers/cull_workers.h"
+#include "headers/instance_upload.h"
+#include "headers/instance_compression.h"
 
 #include "offscreen_render_target.h"
 #include "blur_filter.h"
@@ -49,6 +57,11 @@
 
 #define ENABLE_DEARIMGUI
 #define ENABLE_FRUSTUM_CULLING
+#define ENABLE_LOD_SELECTION
+#define ENABLE_COVERAGE_CULLING
+#define ENABLE_AVX2_CULLING
+#define ENABLE_BVH_CULLING
+#define ENABLE_PARALLEL_CULLING
 
 #define NUM_BACKBUFFERS         2
 #define NUM_QUEUING_FRAMES      3
@@ -64,8 +77,14 @@ enum RENDER_LAYER : int {
 
     _COUNT_RENDERCOMPUTE_LAYER
 };
+#define INSTANCE_GRID_DIM   10          // instances per grid axis (47 gives ~100k, 100 gives 1M)
 static int max_instance_count = 0;
-InstanceData * global_instance_data = nullptr;    // array of instance data
+InstanceStore global_instances;                   // instance transforms, materials and world bounds (SoA)
+InstanceBvh global_instance_bvh;                  // dynamic AABB tree over global_instances
+CullWorkerPool global_cull_workers;               // threads sharing the per-frame culling and instance writes
+uint8_t * global_instance_lods = nullptr;         // LOD of each instance this frame (INSTANCE_CULLED if not drawn)
+#define INSTANCE_CULLED     0xff
+InstanceUploadRecord global_upload_records[NUM_QUEUING_FRAMES];  // what each frame resource's instance buffer holds
 enum ALL_RENDERITEMS {
     RITEM_SKULL = 0,
 
@@ -130,7 +149,6 @@ struct SceneContext {
 };
 
 Camera * global_camera;
-BoundingFrustum global_cam_frustum;
 GameTimer global_timer;
 bool global_paused;
 bool global_resizing;
@@ -153,6 +171,46 @@ bool global_frustumculling_enabled = true;
 bool global_frustumculling_enabled = false;
 #endif // defined(ENABLE_FRUSTUM_CULLING)
 
+#if defined(ENABLE_AVX2_CULLING)
+bool global_avx2_culling_enabled = true;
+#else
+bool global_avx2_culling_enabled = false;
+#endif // defined(ENABLE_AVX2_CULLING)
+
+#if defined(ENABLE_BVH_CULLING)
+bool global_bvh_culling_enabled = true;
+#else
+bool global_bvh_culling_enabled = false;
+#endif // defined(ENABLE_BVH_CULLING)
+
+#if defined(ENABLE_PARALLEL_CULLING)
+bool global_parallel_culling_enabled = true;
+#else
+bool global_parallel_culling_enabled = false;
+#endif // defined(ENABLE_PARALLEL_CULLING)
+
+struct VisibilityStats {
+    UINT    slots_written;      // instance buffer slots rewritten
+    UINT64  bytes_written;
+    UINT    too_small;          // instances dropped by screen coverage
+};
+VisibilityStats global_visibility_stats;
+double global_cull_ms = 0.0;                      // culling, LOD selection and instance buffer writes
+
+#if defined(ENABLE_LOD_SELECTION)
+bool global_lod_enabled = true;
+#else
+bool global_lod_enabled = false;
+#endif // defined(ENABLE_LOD_SELECTION)
+float global_lod_pixel_error = LOD_MAX_PIXEL_ERROR;
+
+#if defined(ENABLE_COVERAGE_CULLING)
+bool global_coverage_culling_enabled = true;
+#else
+bool global_coverage_culling_enabled = false;
+#endif // defined(ENABLE_COVERAGE_CULLING)
+float global_coverage_min_pixels = COVERAGE_MIN_PIXELS;
+
 struct RenderItemArray {
     RenderItem  ritems[_COUNT_RENDERITEM];
     uint32_t    size;
@@ -322,60 +380,11 @@ create_materials (Material out_materials []) {
     out_materials[MAT_WIRED_CRATE].n_frames_dirty = NUM_QUEUING_FRAMES;
 }
 static void
-create_skull_geometry (D3DRenderContext * render_ctx) {
-
-#pragma region Read_Data_File
-    FILE * f = nullptr;
-    errno_t err = fopen_s(&f, "./models/skull.txt", "r");
-    if (0 == f || err != 0) {
-        printf("could not open file\n");
-        return;
-    }
-    char linebuf[100];
-    int cnt = 0;
-    unsigned vcount = 0;
-    unsigned tcount = 0;
-    // -- read 1st line
-    if (fgets(linebuf, sizeof(linebuf), f))
-        cnt = sscanf_s(linebuf, "%*s %d", &vcount);
-    if (cnt != 1) {
-        printf("read error\n");
-        printf("read line: %s\n", linebuf);
-        return;
-    }
-    // -- read 2nd line
-    if (fgets(linebuf, sizeof(linebuf), f))
-        cnt = sscanf_s(linebuf, "%*s %d", &tcount);
-    if (cnt != 1) {
-        printf("read error\n");
-        printf("read line: %s\n", linebuf);
-        return;
-    }
-    // -- skip two lines
-    fgets(linebuf, sizeof(linebuf), f);
-    fgets(linebuf, sizeof(linebuf), f);
-
-    // -- vmin and vmax for AABB construction
-    XMFLOAT3 vminf3(+FLT_MAX, +FLT_MAX, +FLT_MAX);
-    XMFLOAT3 vmaxf3(-FLT_MAX, -FLT_MAX, -FLT_MAX);
-
-    XMVECTOR vmin = XMLoadFloat3(&vminf3);
-    XMVECTOR vmax = XMLoadFloat3(&vmaxf3);
-
-    // -- read vertices
-    Vertex * vertices = (Vertex *)calloc(vcount, sizeof(Vertex));
-    for (unsigned i = 0; i < vcount; i++) {
-        fgets(linebuf, sizeof(linebuf), f);
-        cnt = sscanf_s(
-            linebuf, "%f %f %f %f %f %f",
-            &vertices[i].position.x, &vertices[i].position.y, &vertices[i].position.z,
-            &vertices[i].normal.x, &vertices[i].normal.y, &vertices[i].normal.z
-        );
-        if (cnt != 6) {
-            printf("read error\n");
-            printf("read line: %s\n", linebuf);
-            return;
-        }
+build_skull_vertices (TextMesh const * src, void * out_vertices) {
+    Vertex * vertices = (Vertex *)out_vertices;
+    for (UINT i = 0; i < src->vertex_count; i++) {
+        vertices[i].position = src->positions[i];
+        vertices[i].normal = src->normals[i];
 
 #pragma region skull texture coordinates calculations
         XMVECTOR P = XMLoadFloat3(&vertices[i].position);
@@ -397,74 +406,40 @@ create_skull_geometry (D3DRenderContext * render_ctx) {
 
         vertices[i].texc = {u, v};
 #pragma endregion
-
-        // -- calculate vmin, vmax
-        vmin = XMVectorMin(vmin, P);
-        vmax = XMVectorMax(vmax, P);
     }
+}
+static void
+create_skull_geometry (D3DRenderContext * render_ctx) {
 
-    // -- construct bounding box (AABB)
-    BoundingBox bounds;
-    XMStoreFloat3(&bounds.Center, 0.5f * (vmin + vmax));
-    XMStoreFloat3(&bounds.Extents, 0.5f * (vmax - vmin));
-
-    // -- skip three lines
-    fgets(linebuf, sizeof(linebuf), f);
-    fgets(linebuf, sizeof(linebuf), f);
-    fgets(linebuf, sizeof(linebuf), f);
-    // -- read indices
-    uint32_t * indices = (uint32_t *)calloc(static_cast<size_t>(tcount) * 3, sizeof(uint32_t));
-    for (unsigned i = 0; i < tcount; i++) {
-        fgets(linebuf, sizeof(linebuf), f);
-        cnt = sscanf_s(
-            linebuf, "%d %d %d",
-            &indices[i * 3 + 0], &indices[i * 3 + 1], &indices[i * 3 + 2]
-        );
-        if (cnt != 3) {
-            printf("read error\n");
-            printf("read line: %s\n", linebuf);
-            return;
-        }
+    // -- map the binary mesh (created from the text file on first load)
+    MeshCacheView mesh = {};
+    if (!load_mesh_cached("./models/skull.mesh", "./models/skull.txt", sizeof(Vertex), build_skull_vertices, &mesh)) {
+        printf("could not load skull mesh\n");
+        return;
     }
 
-    // -- remember to free heap-allocated memory
-    /*
-    free(vertices);
-    free(indices);
-    */
-    fclose(f);
-#pragma endregion   Read_Data_File
-
-    UINT vb_byte_size = vcount * sizeof(Vertex);
-    UINT ib_byte_size = (tcount * 3) * sizeof(uint32_t);
+    UINT vb_byte_size = mesh.vertex_count * sizeof(Vertex);
 
     // -- Fill out render_ctx geom[GEOM_SKULL] (skull)
     D3DCreateBlob(vb_byte_size, &render_ctx->geom[GEOM_SKULL].vb_cpu);
-    CopyMemory(render_ctx->geom[GEOM_SKULL].vb_cpu->GetBufferPointer(), vertices, vb_byte_size);
+    CopyMemory(render_ctx->geom[GEOM_SKULL].vb_cpu->GetBufferPointer(), mesh.vertices, vb_byte_size);
 
-    D3DCreateBlob(ib_byte_size, &render_ctx->geom[GEOM_SKULL].ib_cpu);
-    CopyMemory(render_ctx->geom[GEOM_SKULL].ib_cpu->GetBufferPointer(), indices, ib_byte_size);
-
-    create_default_buffer(render_ctx->device, render_ctx->direct_cmd_list, vertices, vb_byte_size, &render_ctx->geom[GEOM_SKULL].vb_uploader, &render_ctx->geom[GEOM_SKULL].vb_gpu);
-    create_default_buffer(render_ctx->device, render_ctx->direct_cmd_list, indices, ib_byte_size, &render_ctx->geom[GEOM_SKULL].ib_uploader, &render_ctx->geom[GEOM_SKULL].ib_gpu);
+    // narrowest index format that still draws the skull as a single submesh
+    Mesh_CreateIndexBuffer(&render_ctx->geom[GEOM_SKULL], mesh.indices, mesh.index_count, mesh.vertices, sizeof(Vertex), 1, "skull");
 
     render_ctx->geom[GEOM_SKULL].vb_byte_stide = sizeof(Vertex);
     render_ctx->geom[GEOM_SKULL].vb_byte_size = vb_byte_size;
-    render_ctx->geom[GEOM_SKULL].ib_byte_size = ib_byte_size;
-    render_ctx->geom[GEOM_SKULL].index_format = DXGI_FORMAT_R32_UINT;
-
-    SubmeshGeometry submesh = {};
-    submesh.index_count = tcount * 3;
-    submesh.start_index_location = 0;
-    submesh.base_vertex_location = 0;
-    submesh.bounds = bounds;
 
     render_ctx->geom[GEOM_SKULL].submesh_names[0] = "skull";
-    render_ctx->geom[GEOM_SKULL].submesh_geoms[0] = submesh;
+
+    // -- simplified levels are appended to ib_cpu, so upload the index buffer afterwards
+    Mesh_BuildLods(&render_ctx->geom[GEOM_SKULL], 0, mesh.vertices, sizeof(Vertex), offsetof(Vertex, normal), mesh.vertex_count, "skull");
+
+    create_default_buffer(render_ctx->device, render_ctx->direct_cmd_list, (void *)mesh.vertices, vb_byte_size, &render_ctx->geom[GEOM_SKULL].vb_uploader, &render_ctx->geom[GEOM_SKULL].vb_gpu);
+    create_default_buffer(render_ctx->device, render_ctx->direct_cmd_list, render_ctx->geom[GEOM_SKULL].ib_cpu->GetBufferPointer(), render_ctx->geom[GEOM_SKULL].ib_byte_size, &render_ctx->geom[GEOM_SKULL].ib_uploader, &render_ctx->geom[GEOM_SKULL].ib_gpu);
 
     // -- cleanup
-    free(vertices);
-    free(indices);
+    MeshCache_Release(&mesh);
 }
 static void
 create_render_items (D3DRenderContext * render_ctx) {
@@ -480,15 +455,21 @@ create_render_items (D3DRenderContext * render_ctx) {
     render_ctx->all_ritems.ritems[RITEM_SKULL].start_index_loc = render_ctx->geom[GEOM_SKULL].submesh_geoms[0].start_index_location;
     render_ctx->all_ritems.ritems[RITEM_SKULL].base_vertex_loc = render_ctx->geom[GEOM_SKULL].submesh_geoms[0].base_vertex_location;
     render_ctx->all_ritems.ritems[RITEM_SKULL].bounds = render_ctx->geom[GEOM_SKULL].submesh_geoms[0].bounds;
+    render_ctx->all_ritems.ritems[RITEM_SKULL].lod_count = render_ctx->geom[GEOM_SKULL].submesh_geoms[0].lod_count;
+    memcpy(render_ctx->all_ritems.ritems[RITEM_SKULL].lods, render_ctx->geom[GEOM_SKULL].submesh_geoms[0].lods, sizeof(MeshLod) * MAX_LOD_COUNT);
     render_ctx->all_ritems.ritems[RITEM_SKULL].n_frames_dirty = NUM_QUEUING_FRAMES;
     render_ctx->all_ritems.ritems[RITEM_SKULL].mat->n_frames_dirty = NUM_QUEUING_FRAMES;
     render_ctx->all_ritems.ritems[RITEM_SKULL].initialized = true;
     //render_ctx->all_ritems.ritems[RITEM_SKULL].bounds = ...
 
     // -- generate instance data
-    int const n = 10;
+    int const n = INSTANCE_GRID_DIM;
     max_instance_count = n * n * n;
-    global_instance_data = (InstanceData *)::calloc(max_instance_count, sizeof(InstanceData));
+    InstanceStore_Init(&global_instances, max_instance_count);
+    global_instance_lods = (uint8_t *)::malloc(global_instances.capacity);
+    memset(global_instance_lods, INSTANCE_CULLED, global_instances.capacity);
+    for (int i = 0; i < NUM_QUEUING_FRAMES; ++i)
+        InstanceUploadRecord_Init(&global_upload_records[i], global_instances.capacity);
 
     float width = 200.0f;
     float height = 200.0f;
@@ -505,17 +486,21 @@ create_render_items (D3DRenderContext * render_ctx) {
             for (int j = 0; j < n; ++j) {
                 int index = k * n * n + i * n + j;
                 // Position instanced along a 3D grid.
-                global_instance_data[index].world = XMFLOAT4X4(
+                InstanceStore_SetWorld(&global_instances, index, XMFLOAT4X4(
                     1.0f, 0.0f, 0.0f, 0.0f,
                     0.0f, 1.0f, 0.0f, 0.0f,
                     0.0f, 0.0f, 1.0f, 0.0f,
-                    x + j * dx, y + i * dy, z + k * dz, 1.0f);
+                    x + j * dx, y + i * dy, z + k * dz, 1.0f));
 
-                XMStoreFloat4x4(&global_instance_data[index].tex_transform, XMMatrixScaling(2.0f, 2.0f, 1.0f));
-                global_instance_data[index].mat_index = index % _COUNT_MATERIAL;
+                XMStoreFloat4x4(&global_instances.tex_transform[index], XMMatrixScaling(2.0f, 2.0f, 1.0f));
+                global_instances.mat_index[index] = index % _COUNT_MATERIAL;
             }
         }
     }
+    InstanceStore_UpdateBounds(&global_instances, render_ctx->all_ritems.ritems[RITEM_SKULL].bounds);
+    InstanceBvh_Init(&global_instance_bvh, global_instances.capacity);
+    for (int i = 0; i < max_instance_count; ++i)
+        InstanceBvh_Insert(&global_instance_bvh, &global_instances, i);
 
     render_ctx->all_ritems.size++;
     /*render_ctx->opaque_ritems.ritems[0] = render_ctx->all_ritems.ritems[RITEM_SKULL];
@@ -542,12 +527,31 @@ draw_render_items (
             // For structured buffers, we can bypass the heap and set as a root descriptor.
             //ID3D12Resource * instance_buffer = instance_buffer; // TODO(omid): correct instance book keeping 
 
-            cmd_list->SetGraphicsRootShaderResourceView(0, instance_buffer->GetGPUVirtualAddress());
+            if (ritem_array->ritems[i].lod_count < 2) {
+                cmd_list->SetGraphicsRootShaderResourceView(0, instance_buffer->GetGPUVirtualAddress());
 
-            cmd_list->DrawIndexedInstanced(
-                ritem_array->ritems[i].index_count,
-                ritem_array->ritems[i].instance_count,
-                ritem_array->ritems[i].start_index_loc, ritem_array->ritems[i].base_vertex_loc, 0);
+                cmd_list->DrawIndexedInstanced(
+                    ritem_array->ritems[i].index_count,
+                    ritem_array->ritems[i].instance_count,
+                    ritem_array->ritems[i].start_index_loc, ritem_array->ritems[i].base_vertex_loc, 0);
+                continue;
+            }
+
+            // Instances are grouped by LOD in the instance buffer, one draw per level.
+            // SV_InstanceID does not include StartInstanceLocation, so offset the root SRV instead.
+            UINT first_instance = 0;
+            for (UINT lod = 0; lod < ritem_array->ritems[i].lod_count; ++lod) {
+                UINT lod_instance_count = ritem_array->ritems[i].lod_instance_count[lod];
+                if (lod_instance_count > 0) {
+                    cmd_list->SetGraphicsRootShaderResourceView(0, instance_buffer->GetGPUVirtualAddress() + first_instance * sizeof(InstanceData));
+
+                    cmd_list->DrawIndexedInstanced(
+                        ritem_array->ritems[i].lods[lod].index_count,
+                        lod_instance_count,
+                        ritem_array->ritems[i].lods[lod].start_index_location, ritem_array->ritems[i].base_vertex_loc, 0);
+                }
+                first_instance += lod_instance_count;
+            }
         }
     }
 }
@@ -1212,55 +1216,190 @@ handle_mouse_move (SceneContext * scene_ctx, WPARAM wParam, int x, int y) {
     scene_ctx->mouse.x = x;
     scene_ctx->mouse.y = y;
 }
+// Per worker slice of a frame's instance culling.
+// Each worker culls (or takes) a contiguous slice and stages its survivors in store->visible;
+// a prefix sum over the per-LOD counts then gives every worker its own output slots.
+struct InstanceCullWorker {
+    UINT    visible_offset;     // staged survivors in global_instances.visible
+    UINT    visible_count;
+    UINT    too_small_count;
+    UINT    slots_written;
+    UINT    lod_counts [MAX_LOD_COUNT];
+    UINT    lod_offsets [MAX_LOD_COUNT];    // first instance buffer slot of each LOD group
+};
+struct InstanceCullFrame {
+    RenderItem const *  ritem;
+    CullPlanes          planes;
+    bool                cull_in_jobs;       // linear culling in the workers, else store->visible is already filled
+    bool                allow_avx2;         // enabled and supported (resolved before the workers start)
+    XMFLOAT3            eye_pos;
+    ScreenCoverageParams    coverage;       // small object culling and LOD selection
+    uint8_t *           instance_begin_ptr;
+    InstanceUploadRecord *  upload_record;  // slots already holding their instance in the mapped buffer
+    InstanceCullWorker  workers [CULL_MAX_WORKERS];
+};
+// LOD of an instance from its screen coverage (INSTANCE_CULLED if too small on screen)
+static UINT
+cull_coverage_lod (InstanceCullFrame const * frame, UINT j) {
+    RenderItem const * ritem = frame->ritem;
+    ScreenCoverage coverage = screen_coverage(ritem->bounds, global_instances.world[j], frame->coverage);
+    if (!coverage.visible)
+        return INSTANCE_CULLED;
+    return global_lod_enabled ? select_lod_at_scale(ritem->lods, ritem->lod_count, coverage.pixels_per_unit, global_lod_pixel_error) : 0;
+}
+// Screen coverage and LOD of a worker's staged survivors, dropping the ones too small on screen
+static void
+cull_select_lods (InstanceCullFrame * frame, InstanceCullWorker * w) {
+    memset(w->lod_counts, 0, sizeof(w->lod_counts));
+    w->too_small_count = 0;
+
+    UINT * staged = global_instances.visible + w->visible_offset;
+    UINT kept = 0;
+    for (UINT v = 0; v < w->visible_count; ++v) {
+        UINT j = staged[v];
+        UINT lod = cull_coverage_lod(frame, j);
+        global_instance_lods[j] = (uint8_t)lod;
+        if (INSTANCE_CULLED == lod) {
+            ++w->too_small_count;
+            continue;
+        }
+        ++w->lod_counts[lod];
+        staged[kept++] = j;
+    }
+    w->visible_count = kept;
+}
+// Phase 1: frustum culling of a slice of the instances, then screen coverage and LOD of the survivors
+static void
+cull_job_frustum (void * param, UINT worker, UINT worker_count) {
+    InstanceCullFrame * frame = (InstanceCullFrame *)param;
+    InstanceCullWorker * w = &frame->workers[worker];
+
+    if (frame->cull_in_jobs) {
+        // slices start on a SIMD group boundary
+        UINT per_worker = (global_instances.count + worker_count - 1) / worker_count;
+        per_worker = (per_worker + INSTANCE_CULL_LANES - 1) / INSTANCE_CULL_LANES * INSTANCE_CULL_LANES;
+        UINT first = per_worker * worker < global_instances.count ? per_worker * worker : global_instances.count;
+        UINT last = first + per_worker < global_instances.count ? first + per_worker : global_instances.count;
+        w->visible_offset = first;
+        w->visible_count = cull_instance_range(
+            &global_instances, &frame->planes, first, last, global_instances.visible + first, frame->allow_avx2);
+    } else {
+        UINT total = global_instances.visible_count;
+        w->visible_offset = (UINT)((uint64_t)total * worker / worker_count);
+        w->visible_count = (UINT)((uint64_t)total * (worker + 1) / worker_count) - w->visible_offset;
+    }
+    cull_select_lods(frame, w);
+}
+// Puts instance [j] in [slot] of the mapped instance buffer, skipping the copy when that buffer
+// still holds the same version of it from its last use. Returns true if it was written.
+static bool
+write_instance_slot (InstanceCullFrame * frame, UINT slot, UINT j) {
+    if (!InstanceUploadRecord_Update(frame->upload_record, slot, j, global_instances.version[j]))
+        return false;
+    InstanceData * instance_ptr = (InstanceData *)frame->instance_begin_ptr + slot;
+    pack_instance_data(global_instances.world[j], global_instances.tex_transform[j], global_instances.mat_index[j], instance_ptr);
+    return true;
+}
+// Phase 2: write a worker's survivors to its slots of the mapped instance buffer
+static void
+cull_job_write (void * param, UINT worker, UINT worker_count) {
+    UNREFERENCED_PARAMETER(worker_count);
+    InstanceCullFrame * frame = (InstanceCullFrame *)param;
+    InstanceCullWorker * w = &frame->workers[worker];
+    w->slots_written = 0;
+    for (UINT v = w->visible_offset; v < w->visible_offset + w->visible_count; ++v) {
+        UINT j = global_instances.visible[v];
+        UINT slot = w->lod_offsets[global_instance_lods[j]]++;
+        w->slots_written += write_instance_slot(frame, slot, j);
+    }
+    _mm_sfence();
+}
 static int
 update_instance_buffer (D3DRenderContext * render_ctx) {
     int visible_instance_count = 0;
-    _ASSERT_EXPR(global_instance_data, _T("global instance data array not initialized"));
-
-    XMMATRIX view = Camera_GetView(global_camera);
-    XMVECTOR det_view = XMMatrixDeterminant(view);
-    XMMATRIX inv_view = XMMatrixInverse(&det_view, view);
+    _ASSERT_EXPR(global_instances.world, _T("global instance store not initialized"));
+
+    int64_t update_begin, update_end;
+    QueryPerformanceCounter((LARGE_INTEGER *)&update_begin);
+
+    XMMATRIX view_proj = XMMatrixMultiply(Camera_GetView(global_camera), Camera_GetProj(global_camera));
+
+    static InstanceCullFrame frame;
+    // LOD selection parameters
+    frame.eye_pos = Camera_GetPosition3f(global_camera);
+    frame.coverage.eye_pos = frame.eye_pos;
+    frame.coverage.proj_scale = coverage_projection_scale(Camera_GetProj4x4f(global_camera), (float)global_scene_ctx.height);
+    frame.coverage.min_pixels = global_coverage_culling_enabled ? global_coverage_min_pixels : 0.0f;
+    frame.coverage.shadow_min_pixels = COVERAGE_SHADOW_MIN_PIXELS;     // no shadow pass in this demo
+    frame.allow_avx2 = global_avx2_culling_enabled && cull_cpu_has_avx2();
+    frame.instance_begin_ptr = render_ctx->frame_resources[render_ctx->frame_index].instance_ptr;
+    frame.upload_record = &global_upload_records[render_ctx->frame_index];
+    UINT worker_count = global_parallel_culling_enabled ? global_cull_workers.worker_count : 1;
+    global_visibility_stats = {};
 
-    UINT frame_index = render_ctx->frame_index;
-    size_t instance_data_size = sizeof(InstanceData);
-    uint8_t * instance_begin_ptr = render_ctx->frame_resources[frame_index].instance_ptr;
     for (unsigned i = 0; i < render_ctx->all_ritems.size; i++) {
         if (render_ctx->all_ritems.ritems[i].initialized) {
-            for (int j = 0; j < max_instance_count; ++j) {
-                XMMATRIX world = XMLoadFloat4x4(&global_instance_data[j].world);
-                XMMATRIX tex_transform = XMLoadFloat4x4(&global_instance_data[j].tex_transform);
-
-                XMVECTOR det_world = XMMatrixDeterminant(world);
-                XMMATRIX inv_world = XMMatrixInverse(&det_world, world);
-
-                //
-                // Frustum Culling
-                //
-
-                // view space to obj's local space
-                XMMATRIX view_to_local = XMMatrixMultiply(inv_view, inv_world);
-
-                // transform camera frustum from view space to obj's local space
-                BoundingFrustum local_camfrustum;
-                global_cam_frustum.Transform(local_camfrustum, view_to_local);
-
-                // perform box/frustum intersection test in local space
-                if (
-                    local_camfrustum.Contains(render_ctx->all_ritems.ritems[i].bounds) != DirectX::DISJOINT ||
-                    false == global_frustumculling_enabled
-                ) {
-                    InstanceData data = {};
-                    XMStoreFloat4x4(&data.world, XMMatrixTranspose(world));
-                    XMStoreFloat4x4(&data.tex_transform, XMMatrixTranspose(tex_transform));
-                    data.mat_index = global_instance_data[j].mat_index;
-
-                    uint8_t * instance_ptr = instance_begin_ptr + (instance_data_size * visible_instance_count++);
-                    memcpy(instance_ptr, &data, instance_data_size);
+            RenderItem * ritem = &render_ctx->all_ritems.ritems[i];
+            frame.ritem = ritem;
+
+            //
+            // Frustum Culling
+            //
+            // world space AABBs of the instances against the camera planes, visible indices compacted.
+            // The BVH path rejects/accepts whole subtrees up front, the linear path tests every
+            // instance with SIMD inside the workers.
+            InstanceStore_UpdateBounds(&global_instances, ritem->bounds);
+            InstanceBvh_Refit(&global_instance_bvh, &global_instances);
+            frame.cull_in_jobs = false;
+            if (global_frustumculling_enabled && global_bvh_culling_enabled)
+                InstanceBvh_Cull(&global_instance_bvh, &global_instances, view_proj);
+            else if (global_frustumculling_enabled)
+                frame.cull_in_jobs = true;
+            else
+                InstanceStore_NoCull(&global_instances);
+            cull_extract_planes(view_proj, &frame.planes);
+
+            // -- pass 1: frustum culling, screen coverage and LODs, staged per worker
+            CullWorkerPool_Run(&global_cull_workers, cull_job_frustum, &frame, global_parallel_culling_enabled);
+            for (UINT w = 0; w < worker_count; ++w)
+                global_visibility_stats.too_small += frame.workers[w].too_small_count;
+
+            // -- prefix sum: visible instances grouped by LOD (see draw_render_items), in worker order within a group
+            memset(ritem->lod_instance_count, 0, sizeof(ritem->lod_instance_count));
+            UINT slot = visible_instance_count;
+            for (UINT lod = 0; lod < MAX_LOD_COUNT; ++lod) {
+                for (UINT w = 0; w < worker_count; ++w) {
+                    frame.workers[w].lod_offsets[lod] = slot;
+                    slot += frame.workers[w].lod_counts[lod];
+                    ritem->lod_instance_count[lod] += frame.workers[w].lod_counts[lod];
                 }
             }
+            // -- close the gaps between the staged slices (they only move down)
+            UINT compacted = 0;
+            for (UINT w = 0; w < worker_count; ++w) {
+                InstanceCullWorker * cw = &frame.workers[w];
+                if (compacted != cw->visible_offset)
+                    memmove(global_instances.visible + compacted, global_instances.visible + cw->visible_offset, sizeof(UINT) * cw->visible_count);
+                cw->visible_offset = compacted;
+                compacted += cw->visible_count;
+            }
+            global_instances.visible_count = compacted;
+
+            // -- pass 2: every worker copies its survivors to the mapped instance buffer
+            CullWorkerPool_Run(&global_cull_workers, cull_job_write, &frame, global_parallel_culling_enabled);
+            for (UINT w = 0; w < worker_count; ++w)
+                global_visibility_stats.slots_written += frame.workers[w].slots_written;
+
+            visible_instance_count = slot;
             render_ctx->all_ritems.ritems[i].instance_count = visible_instance_count;
         }
     }
+
+    QueryPerformanceCounter((LARGE_INTEGER *)&update_end);
+    int64_t count_per_sec;
+    QueryPerformanceFrequency((LARGE_INTEGER *)&count_per_sec);
+    global_cull_ms = (double)(update_end - update_begin) * 1000.0 / (double)count_per_sec;
+    global_visibility_stats.bytes_written = (UINT64)global_visibility_stats.slots_written * sizeof(InstanceData);
     return visible_instance_count;
 }
 static void
@@ -1924,7 +2063,6 @@ d3d_resize (D3DRenderContext * render_ctx, BlurFilter * blur, SobelFilter * sobe
     }
 
     Camera_SetLens(global_camera, 0.25f * XM_PI, global_scene_ctx.aspect_ratio, 1.0f, 1000.0f);
-    BoundingFrustum::CreateFromMatrix(global_cam_frustum, Camera_GetProj(global_camera));
 }
 static void
 check_active_item () {
@@ -2044,8 +2182,6 @@ WinMain(_In_ HINSTANCE hInstance, _In_opt_ HINSTANCE, _In_ LPSTR, _In_ INT) {
     Camera_Init(global_camera);
     Camera_SetPosition(global_camera, 10.0f, 5.0f, -45.0f);
 
-    BoundingFrustum::CreateFromMatrix(global_cam_frustum, Camera_GetProj(global_camera));
-
     // ========================================================================================================
 #pragma region Windows_Setup
     WNDCLASS wc = {};
@@ -2331,6 +2467,7 @@ WinMain(_In_ HINSTANCE hInstance, _In_opt_ HINSTANCE, _In_ LPSTR, _In_ INT) {
     create_skull_geometry(render_ctx);
     create_materials(render_ctx->materials);
     create_render_items(render_ctx);
+    CullWorkerPool_Init(&global_cull_workers, 0);
 
 #pragma endregion 
 
@@ -2535,6 +2672,31 @@ WinMain(_In_ HINSTANCE hInstance, _In_opt_ HINSTANCE, _In_ LPSTR, _In_ INT) {
                 ImGui::Separator();
                 ImGui::Separator();
                 ImGui::Checkbox("Frustum Culling", &global_frustumculling_enabled);
+                ImGui::Checkbox("BVH Culling", &global_bvh_culling_enabled);
+                if (global_bvh_culling_enabled) {
+                    InstanceBvhStats const * bvh_stats = &global_instance_bvh.stats;
+                    ImGui::Text("BVH: %u nodes, %u visited", global_instance_bvh.node_count, bvh_stats->nodes_visited);
+                    ImGui::Text("BVH: %u subtrees inside (%u instances untested)", bvh_stats->subtrees_accepted, bvh_stats->instances_accepted);
+                } else {
+                    ImGui::Checkbox("AVX2 Culling (SSE otherwise)", &global_avx2_culling_enabled);
+                }
+                ImGui::Checkbox("Multithreaded Culling", &global_parallel_culling_enabled);
+                ImGui::SameLine(); ImGui::Text("(%u workers)", global_cull_workers.worker_count);
+                ImGui::Text("Instance writes: %u slots, %.1f KB", global_visibility_stats.slots_written, (double)global_visibility_stats.bytes_written / 1024.0);
+                ImGui::Text("Culling + writes: %u / %u visible, %.3f ms", global_instances.visible_count, global_instances.count, global_cull_ms);
+                ImGui::Separator();
+                ImGui::Checkbox("Screen Coverage Culling", &global_coverage_culling_enabled);
+                ImGui::SliderFloat("Min Pixels", &global_coverage_min_pixels, 0.25f, 16.0f, "%.2f");
+                sliderf = sliderf || ImGui::IsItemActive();
+                if (global_coverage_culling_enabled)
+                    ImGui::Text("Too small: %u instances", global_visibility_stats.too_small);
+                ImGui::Checkbox("LOD Selection", &global_lod_enabled);
+                ImGui::SliderFloat("LOD Pixel Error", &global_lod_pixel_error, 0.25f, 16.0f, "%.2f");
+                sliderf = sliderf || ImGui::IsItemActive();
+                RenderItem const * skull_ritem = &render_ctx->all_ritems.ritems[RITEM_SKULL];
+                for (UINT lod = 0; lod < skull_ritem->lod_count; ++lod) {
+                    ImGui::Text("LOD%u (%u tris): %u instances", lod, skull_ritem->lods[lod].index_count / 3, skull_ritem->lod_instance_count[lod]);
+                }
                 ImGui::Separator();
 
                 /*ImGui::Text("\nUse \'W\' \'S\' for Walk, \'A\' \'D\' for Strafing");*/
@@ -2645,7 +2807,12 @@ WinMain(_In_ HINSTANCE hInstance, _In_opt_ HINSTANCE, _In_ LPSTR, _In_ INT) {
     BlurFilter_Deinit(global_blur_filter);
     ::free(blur_memory);
 
-    ::free(global_instance_data);
+    CullWorkerPool_Release(&global_cull_workers);
+    InstanceBvh_Release(&global_instance_bvh);
+    InstanceStore_Release(&global_instances);
+    ::free(global_instance_lods);
+    for (int i = 0; i < NUM_QUEUING_FRAMES; ++i)
+        InstanceUploadRecord_Release(&global_upload_records[i]);
 
     // release swapchain backbuffers resources
     for (unsigned i = 0; i < NUM_BACKBUFFERS; ++i)
@@ -0,0 +1,131 @@
+/* ===========================================================
+   #File: cull_workers.h #
+   #Date: 17 Oct 2026 #
+   #Revision: 1.0 #
+   #Creator: Omid Miresmaeili #
+   #Description: persistent worker threads for per-frame culling jobs #
+   #Notice: (C) Copyright 2021 by Omid. All Rights Reserved. #
+   =========================================================== */
+#pragma once
+
+#include "common.h"
+
+//
+// Cull worker pool
+//
+// Threads created once and parked on a condition variable between frames.
+// CullWorkerPool_Run hands the same job to every worker (the calling thread is
+// worker 0) and returns when all of them finished it, so consecutive Runs act as
+// barriers between the phases of a frame.
+//
+#define CULL_MAX_WORKERS        16
+
+typedef void (*CullJobFunc)(void * param, UINT worker, UINT worker_count);
+
+struct CullWorkerParam {
+    struct CullWorkerPool * pool;
+    UINT                    worker;
+};
+struct CullWorkerPool {
+    HANDLE              threads [CULL_MAX_WORKERS];
+    CullWorkerParam     thread_params [CULL_MAX_WORKERS];
+    UINT                worker_count;       // including the calling thread
+
+    SRWLOCK             lock;
+    CONDITION_VARIABLE  start_cv;
+    CONDITION_VARIABLE  done_cv;
+    UINT                generation;         // bumped by every Run
+    UINT                pending;            // threads still working on the current job
+    bool                quit;
+
+    CullJobFunc         func;
+    void *              param;
+};
+static DWORD WINAPI
+cull_worker_main (LPVOID param) {
+    CullWorkerParam * p = (CullWorkerParam *)param;
+    CullWorkerPool * pool = p->pool;
+    UINT seen_generation = 0;
+    AcquireSRWLockExclusive(&pool->lock);
+    for (;;) {
+        while (!pool->quit && pool->generation == seen_generation)
+            SleepConditionVariableSRW(&pool->start_cv, &pool->lock, INFINITE, 0);
+        if (pool->quit)
+            break;
+        seen_generation = pool->generation;
+        CullJobFunc func = pool->func;
+        void * job_param = pool->param;
+        ReleaseSRWLockExclusive(&pool->lock);
+
+        func(job_param, p->worker, pool->worker_count);
+
+        AcquireSRWLockExclusive(&pool->lock);
+        if (0 == --pool->pending)
+            WakeAllConditionVariable(&pool->done_cv);
+    }
+    ReleaseSRWLockExclusive(&pool->lock);
+    return 0;
+}
+// [worker_count] counts the calling thread; 0 uses one worker per logical processor
+static void
+CullWorkerPool_Init (CullWorkerPool * pool, UINT worker_count) {
+    memset(pool, 0, sizeof(CullWorkerPool));
+    InitializeSRWLock(&pool->lock);
+    InitializeConditionVariable(&pool->start_cv);
+    InitializeConditionVariable(&pool->done_cv);
+    if (0 == worker_count) {
+        SYSTEM_INFO sys_info;
+        GetSystemInfo(&sys_info);
+        worker_count = sys_info.dwNumberOfProcessors;
+    }
+    if (worker_count > CULL_MAX_WORKERS)
+        worker_count = CULL_MAX_WORKERS;
+    if (worker_count < 1)
+        worker_count = 1;
+
+    pool->worker_count = 1;
+    for (UINT i = 1; i < worker_count; ++i) {
+        pool->thread_params[i] = {.pool = pool, .worker = i};
+        HANDLE t = CreateThread(nullptr, 0, cull_worker_main, &pool->thread_params[i], 0, nullptr);
+        if (nullptr == t)
+            break;
+        pool->threads[i] = t;
+        pool->worker_count = i + 1;
+    }
+}
+// Runs [func] once on every worker and waits for all of them.
+// [use_workers] false runs it on the calling thread only (worker_count 1).
+static void
+CullWorkerPool_Run (CullWorkerPool * pool, CullJobFunc func, void * param, bool use_workers) {
+    if (!use_workers || 1 == pool->worker_count) {
+        func(param, 0, 1);
+        return;
+    }
+    AcquireSRWLockExclusive(&pool->lock);
+    pool->func = func;
+    pool->param = param;
+    pool->pending = pool->worker_count - 1;
+    ++pool->generation;
+    WakeAllConditionVariable(&pool->start_cv);
+    ReleaseSRWLockExclusive(&pool->lock);
+
+    func(param, 0, pool->worker_count);
+
+    AcquireSRWLockExclusive(&pool->lock);
+    while (pool->pending > 0)
+        SleepConditionVariableSRW(&pool->done_cv, &pool->lock, INFINITE, 0);
+    ReleaseSRWLockExclusive(&pool->lock);
+}
+static void
+CullWorkerPool_Release (CullWorkerPool * pool) {
+    AcquireSRWLockExclusive(&pool->lock);
+    pool->quit = true;
+    WakeAllConditionVariable(&pool->start_cv);
+    ReleaseSRWLockExclusive(&pool->lock);
+    if (pool->worker_count > 1) {
+        WaitForMultipleObjects(pool->worker_count - 1, &pool->threads[1], TRUE, INFINITE);
+        for (UINT i = 1; i < pool->worker_count; ++i)
+            CloseHandle(pool->threads[i]);
+    }
+    pool->worker_count = 0;
+}
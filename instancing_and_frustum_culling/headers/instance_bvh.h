@@ -0,0 +1,385 @@
+/* ===========================================================
+   #File: instance_bvh.h #
+   #Date: 17 Oct 2026 #
+   #Revision: 1.0 #
+   #Creator: Omid Miresmaeili #
+   #Description: dynamic AABB tree over instance bounds for hierarchical frustum culling #
+   #Notice: (C) Copyright 2021 by Omid. All Rights Reserved. #
+   =========================================================== */
+#pragma once
+
+#include "common.h"
+#include "instance_culling.h"
+
+//
+// Instance BVH
+//
+// Dynamic AABB tree (one leaf per instance) kept balanced with AVL style rotations.
+// Leaves store the instance AABB grown by a margin, so small moves only touch the
+// InstanceStore: InstanceBvh_Refit reinserts a leaf only once its instance leaves the
+// fat box. Culling walks the tree with a mask of the planes still straddled; a subtree
+// fully inside every plane is accepted without testing any of its instances.
+//
+#define INSTANCE_BVH_NULL           UINT_MAX
+#define INSTANCE_BVH_FAT_MARGIN     2.0f        // world units added around leaf boxes
+#define INSTANCE_BVH_STACK_SIZE     128
+#define INSTANCE_BVH_ALL_PLANES     0x3f
+
+struct InstanceBvhNode {
+    XMFLOAT3    aabb_min;
+    XMFLOAT3    aabb_max;
+    UINT        parent;         // next free node while on the free list
+    UINT        child1;
+    UINT        child2;         // INSTANCE_BVH_NULL for leaves
+    INT         height;         // 0 for leaves, -1 while free
+    UINT        instance;
+};
+struct InstanceBvhStats {
+    UINT    nodes_visited;      // nodes whose box was tested against the planes
+    UINT    subtrees_accepted;  // fully inside: instances taken without tests
+    UINT    instances_accepted; // instances taken from accepted subtrees
+};
+struct InstanceBvh {
+    InstanceBvhNode *   nodes;
+    UINT                node_capacity;
+    UINT                node_count;
+    UINT                free_list;
+    UINT                root;
+
+    UINT *              leaf_of_instance;
+    UINT                instance_capacity;
+
+    InstanceBvhStats    stats;          // of the last InstanceBvh_Cull
+};
+
+inline bool
+bvh_is_leaf (InstanceBvhNode const * node) {
+    return INSTANCE_BVH_NULL == node->child1;
+}
+inline void
+bvh_union (InstanceBvhNode * out, InstanceBvhNode const * a, InstanceBvhNode const * b) {
+    out->aabb_min = XMFLOAT3(fminf(a->aabb_min.x, b->aabb_min.x), fminf(a->aabb_min.y, b->aabb_min.y), fminf(a->aabb_min.z, b->aabb_min.z));
+    out->aabb_max = XMFLOAT3(fmaxf(a->aabb_max.x, b->aabb_max.x), fmaxf(a->aabb_max.y, b->aabb_max.y), fmaxf(a->aabb_max.z, b->aabb_max.z));
+}
+// Half the surface area of a box (the SAH cost of a node)
+inline float
+bvh_area (XMFLOAT3 const & mn, XMFLOAT3 const & mx) {
+    float dx = mx.x - mn.x, dy = mx.y - mn.y, dz = mx.z - mn.z;
+    return dx * dy + dy * dz + dz * dx;
+}
+inline float
+bvh_union_area (InstanceBvhNode const * a, InstanceBvhNode const * b) {
+    InstanceBvhNode u;
+    bvh_union(&u, a, b);
+    return bvh_area(u.aabb_min, u.aabb_max);
+}
+static void
+InstanceBvh_Init (InstanceBvh * bvh, UINT instance_capacity) {
+    *bvh = {};
+    bvh->root = INSTANCE_BVH_NULL;
+    bvh->free_list = INSTANCE_BVH_NULL;
+    bvh->instance_capacity = instance_capacity;
+    bvh->leaf_of_instance = (UINT *)::malloc(sizeof(UINT) * instance_capacity);
+    memset(bvh->leaf_of_instance, 0xff, sizeof(UINT) * instance_capacity);
+}
+inline void
+InstanceBvh_Release (InstanceBvh * bvh) {
+    ::free(bvh->nodes);
+    ::free(bvh->leaf_of_instance);
+    *bvh = {};
+}
+static UINT
+bvh_alloc_node (InstanceBvh * bvh) {
+    if (INSTANCE_BVH_NULL == bvh->free_list) {
+        // -- grow the pool and thread the new nodes onto the free list
+        UINT old_capacity = bvh->node_capacity;
+        bvh->node_capacity = old_capacity ? old_capacity * 2 : 64;
+        bvh->nodes = (InstanceBvhNode *)::realloc(bvh->nodes, sizeof(InstanceBvhNode) * bvh->node_capacity);
+        for (UINT i = old_capacity; i < bvh->node_capacity; ++i) {
+            bvh->nodes[i].parent = i + 1 < bvh->node_capacity ? i + 1 : INSTANCE_BVH_NULL;
+            bvh->nodes[i].height = -1;
+        }
+        bvh->free_list = old_capacity;
+    }
+    UINT id = bvh->free_list;
+    InstanceBvhNode * node = &bvh->nodes[id];
+    bvh->free_list = node->parent;
+    node->parent = node->child1 = node->child2 = INSTANCE_BVH_NULL;
+    node->height = 0;
+    node->instance = UINT_MAX;
+    ++bvh->node_count;
+    return id;
+}
+inline void
+bvh_free_node (InstanceBvh * bvh, UINT id) {
+    bvh->nodes[id].parent = bvh->free_list;
+    bvh->nodes[id].height = -1;
+    bvh->free_list = id;
+    --bvh->node_count;
+}
+inline void
+bvh_replace_child (InstanceBvh * bvh, UINT parent, UINT old_child, UINT new_child) {
+    if (INSTANCE_BVH_NULL == parent)
+        bvh->root = new_child;
+    else if (bvh->nodes[parent].child1 == old_child)
+        bvh->nodes[parent].child1 = new_child;
+    else
+        bvh->nodes[parent].child2 = new_child;
+}
+inline void
+bvh_refit_node (InstanceBvh * bvh, UINT id) {
+    InstanceBvhNode * node = &bvh->nodes[id];
+    InstanceBvhNode * c1 = &bvh->nodes[node->child1];
+    InstanceBvhNode * c2 = &bvh->nodes[node->child2];
+    bvh_union(node, c1, c2);
+    node->height = 1 + (c1->height > c2->height ? c1->height : c2->height);
+}
+// Rotates the taller grandchild up if [a]'s subtrees differ in height by more than one.
+// Returns the root of the subtree.
+static UINT
+bvh_balance (InstanceBvh * bvh, UINT a) {
+    InstanceBvhNode * node_a = &bvh->nodes[a];
+    if (bvh_is_leaf(node_a) || node_a->height < 2)
+        return a;
+
+    UINT b = node_a->child1;
+    UINT c = node_a->child2;
+    int balance = bvh->nodes[c].height - bvh->nodes[b].height;
+    if (balance > 1 || balance < -1) {
+        // the taller child moves up; its shorter child becomes a child of [a]
+        UINT up = balance > 1 ? c : b;
+        UINT stay = balance > 1 ? b : c;
+        InstanceBvhNode * node_up = &bvh->nodes[up];
+        UINT f = node_up->child1;
+        UINT g = node_up->child2;
+        UINT tall = bvh->nodes[f].height > bvh->nodes[g].height ? f : g;
+        UINT shorter = tall == f ? g : f;
+
+        node_up->parent = node_a->parent;
+        bvh_replace_child(bvh, node_a->parent, a, up);
+        node_up->child1 = a;
+        node_up->child2 = tall;
+        node_a->parent = up;
+
+        node_a->child1 = stay;
+        node_a->child2 = shorter;
+        bvh->nodes[shorter].parent = a;
+
+        bvh_refit_node(bvh, a);
+        bvh_refit_node(bvh, up);
+        return up;
+    }
+    return a;
+}
+// Walks from [id] to the root refitting boxes and rebalancing
+static void
+bvh_fix_upwards (InstanceBvh * bvh, UINT id) {
+    while (INSTANCE_BVH_NULL != id) {
+        id = bvh_balance(bvh, id);
+        bvh_refit_node(bvh, id);
+        id = bvh->nodes[id].parent;
+    }
+}
+static void
+bvh_insert_leaf (InstanceBvh * bvh, UINT leaf) {
+    if (INSTANCE_BVH_NULL == bvh->root) {
+        bvh->root = leaf;
+        bvh->nodes[leaf].parent = INSTANCE_BVH_NULL;
+        return;
+    }
+
+    // -- find the cheapest sibling (surface area heuristic, greedy descent)
+    InstanceBvhNode const * leaf_node = &bvh->nodes[leaf];
+    UINT index = bvh->root;
+    while (!bvh_is_leaf(&bvh->nodes[index])) {
+        InstanceBvhNode const * node = &bvh->nodes[index];
+        float area = bvh_area(node->aabb_min, node->aabb_max);
+        float combined_area = bvh_union_area(node, leaf_node);
+
+        // cost of a new parent for this node and the leaf, and the increase pushed down to the children
+        float cost = 2.0f * combined_area;
+        float inheritance = 2.0f * (combined_area - area);
+
+        float child_cost [2];
+        UINT children [2] = {node->child1, node->child2};
+        for (int k = 0; k < 2; ++k) {
+            InstanceBvhNode const * child = &bvh->nodes[children[k]];
+            child_cost[k] = bvh_union_area(child, leaf_node) + inheritance;
+            if (!bvh_is_leaf(child))
+                child_cost[k] -= bvh_area(child->aabb_min, child->aabb_max);
+        }
+        if (cost < child_cost[0] && cost < child_cost[1])
+            break;
+        index = child_cost[0] < child_cost[1] ? children[0] : children[1];
+    }
+
+    // -- new parent for the sibling and the leaf
+    UINT sibling = index;
+    UINT old_parent = bvh->nodes[sibling].parent;
+    UINT new_parent = bvh_alloc_node(bvh);      // may move bvh->nodes
+    InstanceBvhNode * parent_node = &bvh->nodes[new_parent];
+    parent_node->parent = old_parent;
+    parent_node->child1 = sibling;
+    parent_node->child2 = leaf;
+    bvh_replace_child(bvh, old_parent, sibling, new_parent);
+    bvh->nodes[sibling].parent = new_parent;
+    bvh->nodes[leaf].parent = new_parent;
+
+    bvh_fix_upwards(bvh, new_parent);
+}
+static void
+bvh_remove_leaf (InstanceBvh * bvh, UINT leaf) {
+    if (leaf == bvh->root) {
+        bvh->root = INSTANCE_BVH_NULL;
+        return;
+    }
+    UINT parent = bvh->nodes[leaf].parent;
+    UINT grand_parent = bvh->nodes[parent].parent;
+    UINT sibling = bvh->nodes[parent].child1 == leaf ? bvh->nodes[parent].child2 : bvh->nodes[parent].child1;
+
+    bvh_replace_child(bvh, grand_parent, parent, sibling);
+    bvh->nodes[sibling].parent = grand_parent;
+    bvh_free_node(bvh, parent);
+    bvh_fix_upwards(bvh, grand_parent);
+}
+inline void
+bvh_set_fat_box (InstanceBvhNode * node, InstanceStore const * store, UINT i) {
+    float const m = INSTANCE_BVH_FAT_MARGIN;
+    node->aabb_min = XMFLOAT3(
+        store->center_x[i] - store->extent_x[i] - m, store->center_y[i] - store->extent_y[i] - m, store->center_z[i] - store->extent_z[i] - m);
+    node->aabb_max = XMFLOAT3(
+        store->center_x[i] + store->extent_x[i] + m, store->center_y[i] + store->extent_y[i] + m, store->center_z[i] + store->extent_z[i] + m);
+}
+// Adds instance [i] of [store] (its bounds must be up to date)
+static void
+InstanceBvh_Insert (InstanceBvh * bvh, InstanceStore const * store, UINT i) {
+    _ASSERT_EXPR(i < bvh->instance_capacity && INSTANCE_BVH_NULL == bvh->leaf_of_instance[i], _T("Instance already in the BVH"));
+    UINT leaf = bvh_alloc_node(bvh);
+    bvh->nodes[leaf].instance = i;
+    bvh_set_fat_box(&bvh->nodes[leaf], store, i);
+    bvh->leaf_of_instance[i] = leaf;
+    bvh_insert_leaf(bvh, leaf);
+}
+static void
+InstanceBvh_Remove (InstanceBvh * bvh, UINT i) {
+    UINT leaf = bvh->leaf_of_instance[i];
+    _ASSERT_EXPR(INSTANCE_BVH_NULL != leaf, _T("Instance not in the BVH"));
+    bvh_remove_leaf(bvh, leaf);
+    bvh_free_node(bvh, leaf);
+    bvh->leaf_of_instance[i] = INSTANCE_BVH_NULL;
+}
+// Updates the tree for the instances InstanceStore_UpdateBounds just moved.
+// Returns how many left their fat box and were reinserted.
+static UINT
+InstanceBvh_Refit (InstanceBvh * bvh, InstanceStore const * store) {
+    UINT reinserted = 0;
+    for (UINT k = 0; k < store->moved_count; ++k) {
+        UINT i = store->moved[k];
+        UINT leaf = bvh->leaf_of_instance[i];
+        if (INSTANCE_BVH_NULL == leaf)
+            continue;
+        InstanceBvhNode const * node = &bvh->nodes[leaf];
+        bool contained =
+            store->center_x[i] - store->extent_x[i] >= node->aabb_min.x && store->center_x[i] + store->extent_x[i] <= node->aabb_max.x &&
+            store->center_y[i] - store->extent_y[i] >= node->aabb_min.y && store->center_y[i] + store->extent_y[i] <= node->aabb_max.y &&
+            store->center_z[i] - store->extent_z[i] >= node->aabb_min.z && store->center_z[i] + store->extent_z[i] <= node->aabb_max.z;
+        if (contained)
+            continue;
+        bvh_remove_leaf(bvh, leaf);
+        bvh_set_fat_box(&bvh->nodes[leaf], store, i);
+        bvh_insert_leaf(bvh, leaf);
+        ++reinserted;
+    }
+    return reinserted;
+}
+// Classifies a box against the planes in [mask]: false if outside one of them, otherwise
+// [out_mask] keeps only the planes the box straddles
+inline bool
+bvh_test_planes (
+    CullPlanes const * planes, float cx, float cy, float cz, float ex, float ey, float ez, UINT mask, UINT * out_mask
+) {
+    for (int p = 0; p < 6; ++p) {
+        if (0 == (mask & (1u << p)))
+            continue;
+        float dist = planes->nx[p] * cx + planes->ny[p] * cy + planes->nz[p] * cz + planes->d[p];
+        float radius = fabsf(planes->nx[p]) * ex + fabsf(planes->ny[p]) * ey + fabsf(planes->nz[p]) * ez;
+        if (dist + radius < 0.0f)
+            return false;
+        if (dist - radius >= 0.0f)
+            mask &= ~(1u << p);
+    }
+    *out_mask = mask;
+    return true;
+}
+// Appends every instance under [id] without testing them
+static UINT
+bvh_accept_subtree (InstanceBvh const * bvh, UINT id, UINT * visible, UINT visible_count) {
+    UINT stack [INSTANCE_BVH_STACK_SIZE];
+    UINT top = 0;
+    stack[top++] = id;
+    while (top > 0) {
+        InstanceBvhNode const * node = &bvh->nodes[stack[--top]];
+        if (bvh_is_leaf(node)) {
+            visible[visible_count++] = node->instance;
+        } else {
+            _ASSERT_EXPR(top + 2 <= INSTANCE_BVH_STACK_SIZE, _T("BVH traversal stack overflow"));
+            stack[top++] = node->child1;
+            stack[top++] = node->child2;
+        }
+    }
+    return visible_count;
+}
+// Culls the instances in the tree against [view_proj] into store->visible / visible_count (in tree order)
+static UINT
+InstanceBvh_Cull (InstanceBvh * bvh, InstanceStore * store, XMMATRIX const & view_proj) {
+    CullPlanes planes;
+    cull_extract_planes(view_proj, &planes);
+
+    InstanceBvhStats stats = {};
+    UINT visible_count = 0;
+    UINT stack_node [INSTANCE_BVH_STACK_SIZE];
+    UINT stack_mask [INSTANCE_BVH_STACK_SIZE];
+    UINT top = 0;
+    if (INSTANCE_BVH_NULL != bvh->root) {
+        stack_node[top] = bvh->root;
+        stack_mask[top++] = INSTANCE_BVH_ALL_PLANES;
+    }
+    while (top > 0) {
+        --top;
+        UINT id = stack_node[top];
+        UINT mask = stack_mask[top];
+        InstanceBvhNode const * node = &bvh->nodes[id];
+        ++stats.nodes_visited;
+
+        if (bvh_is_leaf(node)) {
+            // test the tight instance box, not the fat leaf box
+            UINT i = node->instance;
+            if (bvh_test_planes(&planes,
+                    store->center_x[i], store->center_y[i], store->center_z[i],
+                    store->extent_x[i], store->extent_y[i], store->extent_z[i], mask, &mask))
+                store->visible[visible_count++] = i;
+            continue;
+        }
+
+        float cx = 0.5f * (node->aabb_min.x + node->aabb_max.x);
+        float cy = 0.5f * (node->aabb_min.y + node->aabb_max.y);
+        float cz = 0.5f * (node->aabb_min.z + node->aabb_max.z);
+        if (!bvh_test_planes(&planes, cx, cy, cz, node->aabb_max.x - cx, node->aabb_max.y - cy, node->aabb_max.z - cz, mask, &mask))
+            continue;
+        if (0 == mask) {
+            UINT before = visible_count;
+            visible_count = bvh_accept_subtree(bvh, id, store->visible, visible_count);
+            ++stats.subtrees_accepted;
+            stats.instances_accepted += visible_count - before;
+            continue;
+        }
+        _ASSERT_EXPR(top + 2 <= INSTANCE_BVH_STACK_SIZE, _T("BVH traversal stack overflow"));
+        stack_node[top] = node->child1;
+        stack_mask[top++] = mask;
+        stack_node[top] = node->child2;
+        stack_mask[top++] = mask;
+    }
+    store->visible_count = visible_count;
+    bvh->stats = stats;
+    return visible_count;
+}
@@ -0,0 +1,64 @@
+/* ===========================================================
+   #File: instance_compression.h #
+   #Date: 17 Oct 2026 #
+   #Revision: 1.0 #
+   #Creator: Omid Miresmaeili #
+   #Description: packed per instance shader data (decoded in shaders/default.hlsl) #
+   #Notice: (C) Copyright 2021 by Omid. All Rights Reserved. #
+   =========================================================== */
+#pragma once
+
+#include "common.h"
+#include "utils.h"
+#include <DirectXPackedVector.h>
+#include <immintrin.h>
+
+using namespace DirectX;
+
+//
+// 64 bytes per instance instead of two 4x4 matrices (144 bytes):
+// the world matrix is affine so its last column (0, 0, 0, 1) is implied, and the texture
+// transform is reduced to a 2D scale and offset at half precision (see InstanceData in utils.h)
+//
+static_assert(64 == sizeof(InstanceData), "InstanceData must match the StructuredBuffer in default.hlsl");
+
+#define INSTANCE_MAX_MATERIALS          0x10000
+#define INSTANCE_FLAG_TEX_TRANSFORM     (1u << 16)  // tex_scale / tex_offset apply (identity otherwise)
+
+inline UINT
+pack_half2 (float x, float y) {
+    return (UINT)PackedVector::XMConvertFloatToHalf(x) | ((UINT)PackedVector::XMConvertFloatToHalf(y) << 16);
+}
+// Packs one instance into [out] (16-byte aligned) with non-temporal stores: the instance buffer is
+// write-combined upload memory that is never read back. Call _mm_sfence after the last one.
+inline void
+pack_instance_data (XMFLOAT4X4 const & world, XMFLOAT4X4 const & tex_transform, UINT mat_index, InstanceData * out) {
+    _ASSERT_EXPR(0 == ((uintptr_t)out & 15), _T("InstanceData must be 16-byte aligned"));
+    _ASSERT_EXPR(mat_index < INSTANCE_MAX_MATERIALS, _T("material index does not fit in 16 bits"));
+    _ASSERT_EXPR(0.0f == tex_transform.m[0][1] && 0.0f == tex_transform.m[1][0], _T("texture transform must be a 2D scale and offset"));
+
+    // -- rows of the transposed world matrix (its first three columns)
+    __m128 r0 = _mm_loadu_ps(world.m[0]);
+    __m128 r1 = _mm_loadu_ps(world.m[1]);
+    __m128 r2 = _mm_loadu_ps(world.m[2]);
+    __m128 r3 = _mm_loadu_ps(world.m[3]);
+    _MM_TRANSPOSE4_PS(r0, r1, r2, r3);
+    _mm_stream_ps(&out->world_rows[0].x, r0);
+    _mm_stream_ps(&out->world_rows[1].x, r1);
+    _mm_stream_ps(&out->world_rows[2].x, r2);
+
+    // -- texture transform, material index and flags
+    UINT tex_scale = 0;
+    UINT tex_offset = 0;
+    UINT mat_index_flags = mat_index;
+    float su = tex_transform.m[0][0];
+    float sv = tex_transform.m[1][1];
+    float ou = tex_transform.m[3][0];
+    float ov = tex_transform.m[3][1];
+    if (1.0f != su || 1.0f != sv || 0.0f != ou || 0.0f != ov) {
+        tex_scale = pack_half2(su, sv);
+        tex_offset = pack_half2(ou, ov);
+        mat_index_flags |= INSTANCE_FLAG_TEX_TRANSFORM;
+    }
+    _mm_stream_si128((__m128i *)&out->tex_scale, _mm_set_epi32(0, (int)mat_index_flags, (int)tex_offset, (int)tex_scale));
+}
@@ -0,0 +1,294 @@
+/* ===========================================================
+   #File: instance_culling.h #
+   #Date: 17 Oct 2026 #
+   #Revision: 1.0 #
+   #Creator: Omid Miresmaeili #
+   #Description: SoA instance store and SIMD world space frustum culling #
+   #Notice: (C) Copyright 2021 by Omid. All Rights Reserved. #
+   =========================================================== */
+#pragma once
+
+#include "common.h"
+
+#include <immintrin.h>
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+using namespace DirectX;
+
+//
+// Instance store
+//
+// Instances of one mesh kept as structure of arrays. The world space AABB of every
+// instance (the mesh bounds moved by its world matrix) is cached next to the transforms
+// and only recomputed for instances whose transform changed, so culling never inverts a
+// matrix: it tests the cached boxes against the six camera planes, 8 (AVX2) or 4 (SSE)
+// instances at a time, and writes the indices of the survivors to a compacted list.
+//
+#define INSTANCE_CULL_LANES     8       // arrays are padded to a multiple of the widest kernel
+
+// GCC/Clang need the target spelled out to compile the AVX2 kernel without -mavx2 (MSVC doesn't)
+#if defined(__GNUC__) || defined(__clang__)
+#define INSTANCE_CULL_AVX2_FUNCTION __attribute__((target("avx2,fma")))
+#else
+#define INSTANCE_CULL_AVX2_FUNCTION
+#endif
+
+struct InstanceStore {
+    UINT            count;
+    UINT            capacity;       // multiple of INSTANCE_CULL_LANES
+
+    // Per instance shader data (see InstanceData)
+    XMFLOAT4X4 *    world;
+    XMFLOAT4X4 *    tex_transform;
+    UINT *          mat_index;
+    UINT *          version;        // bumped whenever the instance's shader data changes
+
+    // World space AABBs
+    float *         center_x;
+    float *         center_y;
+    float *         center_z;
+    float *         extent_x;
+    float *         extent_y;
+    float *         extent_z;
+
+    // Instances whose world matrix changed since the last InstanceStore_UpdateBounds
+    bool *          bounds_dirty;
+    bool            any_bounds_dirty;
+
+    // Instances whose AABB the last InstanceStore_UpdateBounds recomputed (for acceleration structures)
+    UINT *          moved;
+    UINT            moved_count;
+
+    // Output of InstanceStore_Cull
+    UINT *          visible;
+    UINT            visible_count;
+};
+// Camera planes as SoA: a point p is inside when nx*p.x + ny*p.y + nz*p.z + d >= 0 for all six
+struct CullPlanes {
+    float nx [6];
+    float ny [6];
+    float nz [6];
+    float d [6];
+};
+
+inline void
+InstanceStore_Init (InstanceStore * store, UINT count) {
+    *store = {};
+    store->count = count;
+    store->capacity = (count + INSTANCE_CULL_LANES - 1) / INSTANCE_CULL_LANES * INSTANCE_CULL_LANES;
+    store->world = (XMFLOAT4X4 *)::calloc(store->capacity, sizeof(XMFLOAT4X4));
+    store->tex_transform = (XMFLOAT4X4 *)::calloc(store->capacity, sizeof(XMFLOAT4X4));
+    store->mat_index = (UINT *)::calloc(store->capacity, sizeof(UINT));
+    store->version = (UINT *)::calloc(store->capacity, sizeof(UINT));
+    store->center_x = (float *)::calloc(store->capacity, sizeof(float));
+    store->center_y = (float *)::calloc(store->capacity, sizeof(float));
+    store->center_z = (float *)::calloc(store->capacity, sizeof(float));
+    store->extent_x = (float *)::calloc(store->capacity, sizeof(float));
+    store->extent_y = (float *)::calloc(store->capacity, sizeof(float));
+    store->extent_z = (float *)::calloc(store->capacity, sizeof(float));
+    store->bounds_dirty = (bool *)::calloc(store->capacity, sizeof(bool));
+    store->moved = (UINT *)::calloc(store->capacity, sizeof(UINT));
+    store->visible = (UINT *)::calloc(store->capacity, sizeof(UINT));
+}
+inline void
+InstanceStore_Release (InstanceStore * store) {
+    ::free(store->world);
+    ::free(store->tex_transform);
+    ::free(store->mat_index);
+    ::free(store->version);
+    ::free(store->center_x);
+    ::free(store->center_y);
+    ::free(store->center_z);
+    ::free(store->extent_x);
+    ::free(store->extent_y);
+    ::free(store->extent_z);
+    ::free(store->bounds_dirty);
+    ::free(store->moved);
+    ::free(store->visible);
+    *store = {};
+}
+inline void
+InstanceStore_SetWorld (InstanceStore * store, UINT i, XMFLOAT4X4 const & world) {
+    store->world[i] = world;
+    ++store->version[i];
+    store->bounds_dirty[i] = true;
+    store->any_bounds_dirty = true;
+}
+// Recomputes the world AABBs of the instances moved since the last call and lists them in store->moved.
+// [local_bounds] is the bounding box of the instanced mesh in object space.
+static void
+InstanceStore_UpdateBounds (InstanceStore * store, BoundingBox const & local_bounds) {
+    store->moved_count = 0;
+    if (!store->any_bounds_dirty)
+        return;
+    XMVECTOR local_center = XMLoadFloat3(&local_bounds.Center);
+    XMVECTOR local_extents = XMLoadFloat3(&local_bounds.Extents);
+    for (UINT i = 0; i < store->count; ++i) {
+        if (!store->bounds_dirty[i])
+            continue;
+        XMMATRIX world = XMLoadFloat4x4(&store->world[i]);
+        XMVECTOR center = XMVector3Transform(local_center, world);
+        // extents of the transformed box: |M| applied to the local extents
+        XMVECTOR extents =
+            XMVectorAbs(world.r[0]) * XMVectorSplatX(local_extents) +
+            XMVectorAbs(world.r[1]) * XMVectorSplatY(local_extents) +
+            XMVectorAbs(world.r[2]) * XMVectorSplatZ(local_extents);
+        store->center_x[i] = XMVectorGetX(center);
+        store->center_y[i] = XMVectorGetY(center);
+        store->center_z[i] = XMVectorGetZ(center);
+        store->extent_x[i] = XMVectorGetX(extents);
+        store->extent_y[i] = XMVectorGetY(extents);
+        store->extent_z[i] = XMVectorGetZ(extents);
+        store->bounds_dirty[i] = false;
+        store->moved[store->moved_count++] = i;
+    }
+    store->any_bounds_dirty = false;
+}
+// Extracts the normalized frustum planes of a (row vector) view-projection matrix with a [0, 1] depth range
+inline void
+cull_extract_planes (XMMATRIX const & view_proj, CullPlanes * out_planes) {
+    XMMATRIX m = XMMatrixTranspose(view_proj);     // rows are now the columns of view_proj
+    XMVECTOR planes [6] = {
+        m.r[3] + m.r[0],    // left
+        m.r[3] - m.r[0],    // right
+        m.r[3] + m.r[1],    // bottom
+        m.r[3] - m.r[1],    // top
+        m.r[2],             // near
+        m.r[3] - m.r[2],    // far
+    };
+    for (int p = 0; p < 6; ++p) {
+        XMFLOAT4 plane;
+        XMStoreFloat4(&plane, XMPlaneNormalize(planes[p]));
+        out_planes->nx[p] = plane.x;
+        out_planes->ny[p] = plane.y;
+        out_planes->nz[p] = plane.z;
+        out_planes->d[p] = plane.w;
+    }
+}
+// Lanes [0, n) of a group starting at [base] are instances, the rest is padding
+inline int
+cull_lane_mask (UINT base, UINT count, int lanes) {
+    UINT n = count - base;
+    return n >= (UINT)lanes ? (1 << lanes) - 1 : (1 << n) - 1;
+}
+inline UINT
+cull_append_visible (UINT * visible, UINT visible_count, UINT base, int mask) {
+    while (mask) {
+#if defined(_MSC_VER)
+        unsigned long lane;
+        _BitScanForward(&lane, (unsigned long)mask);
+#else
+        int lane = __builtin_ctz((unsigned)mask);
+#endif
+        visible[visible_count++] = base + lane;
+        mask &= mask - 1;
+    }
+    return visible_count;
+}
+static UINT
+cull_instances_sse (InstanceStore const * store, CullPlanes const * planes, UINT first, UINT last, UINT * visible) {
+    __m128 const sign_mask = _mm_set1_ps(-0.0f);
+    UINT visible_count = 0;
+    for (UINT base = first; base < last; base += 4) {
+        __m128 cx = _mm_loadu_ps(store->center_x + base);
+        __m128 cy = _mm_loadu_ps(store->center_y + base);
+        __m128 cz = _mm_loadu_ps(store->center_z + base);
+        __m128 ex = _mm_loadu_ps(store->extent_x + base);
+        __m128 ey = _mm_loadu_ps(store->extent_y + base);
+        __m128 ez = _mm_loadu_ps(store->extent_z + base);
+        __m128 inside = _mm_castsi128_ps(_mm_set1_epi32(-1));
+        for (int p = 0; p < 6; ++p) {
+            __m128 nx = _mm_set1_ps(planes->nx[p]);
+            __m128 ny = _mm_set1_ps(planes->ny[p]);
+            __m128 nz = _mm_set1_ps(planes->nz[p]);
+            // signed distance of the box corner furthest along the plane normal
+            __m128 dist = _mm_add_ps(
+                _mm_add_ps(_mm_mul_ps(nx, cx), _mm_mul_ps(ny, cy)),
+                _mm_add_ps(_mm_mul_ps(nz, cz), _mm_set1_ps(planes->d[p])));
+            __m128 radius = _mm_add_ps(
+                _mm_add_ps(_mm_mul_ps(_mm_andnot_ps(sign_mask, nx), ex), _mm_mul_ps(_mm_andnot_ps(sign_mask, ny), ey)),
+                _mm_mul_ps(_mm_andnot_ps(sign_mask, nz), ez));
+            inside = _mm_and_ps(inside, _mm_cmpge_ps(_mm_add_ps(dist, radius), _mm_setzero_ps()));
+        }
+        int mask = _mm_movemask_ps(inside) & cull_lane_mask(base, last, 4);
+        visible_count = cull_append_visible(visible, visible_count, base, mask);
+    }
+    return visible_count;
+}
+INSTANCE_CULL_AVX2_FUNCTION static UINT
+cull_instances_avx2 (InstanceStore const * store, CullPlanes const * planes, UINT first, UINT last, UINT * visible) {
+    __m256 const sign_mask = _mm256_set1_ps(-0.0f);
+    UINT visible_count = 0;
+    for (UINT base = first; base < last; base += 8) {
+        __m256 cx = _mm256_loadu_ps(store->center_x + base);
+        __m256 cy = _mm256_loadu_ps(store->center_y + base);
+        __m256 cz = _mm256_loadu_ps(store->center_z + base);
+        __m256 ex = _mm256_loadu_ps(store->extent_x + base);
+        __m256 ey = _mm256_loadu_ps(store->extent_y + base);
+        __m256 ez = _mm256_loadu_ps(store->extent_z + base);
+        __m256 inside = _mm256_castsi256_ps(_mm256_set1_epi32(-1));
+        for (int p = 0; p < 6; ++p) {
+            __m256 nx = _mm256_set1_ps(planes->nx[p]);
+            __m256 ny = _mm256_set1_ps(planes->ny[p]);
+            __m256 nz = _mm256_set1_ps(planes->nz[p]);
+            __m256 dist = _mm256_fmadd_ps(nx, cx, _mm256_fmadd_ps(ny, cy, _mm256_fmadd_ps(nz, cz, _mm256_set1_ps(planes->d[p]))));
+            dist = _mm256_fmadd_ps(_mm256_andnot_ps(sign_mask, nx), ex, dist);
+            dist = _mm256_fmadd_ps(_mm256_andnot_ps(sign_mask, ny), ey, dist);
+            dist = _mm256_fmadd_ps(_mm256_andnot_ps(sign_mask, nz), ez, dist);
+            inside = _mm256_and_ps(inside, _mm256_cmp_ps(dist, _mm256_setzero_ps(), _CMP_GE_OQ));
+        }
+        int mask = _mm256_movemask_ps(inside) & cull_lane_mask(base, last, 8);
+        visible_count = cull_append_visible(visible, visible_count, base, mask);
+    }
+    return visible_count;
+}
+// AVX2 and FMA supported by the CPU and enabled by the OS (checked once). The first call
+// caches the answer unsynchronized, so make it from one thread before starting cull workers.
+inline bool
+cull_cpu_has_avx2 () {
+    static int has_avx2 = -1;
+    if (has_avx2 < 0) {
+#if defined(_MSC_VER)
+        int info[4];
+        __cpuid(info, 1);
+        bool fma = (info[2] & (1 << 12)) != 0;
+        bool osxsave = (info[2] & (1 << 27)) != 0;
+        bool ymm_enabled = osxsave && (_xgetbv(0) & 0x6) == 0x6;
+        __cpuidex(info, 7, 0);
+        bool avx2 = (info[1] & (1 << 5)) != 0;
+        has_avx2 = (fma && ymm_enabled && avx2) ? 1 : 0;
+#else
+        has_avx2 = (__builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma")) ? 1 : 0;
+#endif
+    }
+    return 1 == has_avx2;
+}
+// Culls instances [first, last) (first a multiple of INSTANCE_CULL_LANES) and writes the
+// indices of the visible ones to [visible] in increasing order. Returns how many were written.
+// [use_avx2] must already be checked against cull_cpu_has_avx2 (workers call this concurrently).
+static UINT
+cull_instance_range (
+    InstanceStore const * store, CullPlanes const * planes, UINT first, UINT last, UINT * visible, bool use_avx2
+) {
+    if (use_avx2)
+        return cull_instances_avx2(store, planes, first, last, visible);
+    return cull_instances_sse(store, planes, first, last, visible);
+}
+// Culls every instance against [view_proj] into store->visible / visible_count
+static UINT
+InstanceStore_Cull (InstanceStore * store, XMMATRIX const & view_proj, bool allow_avx2) {
+    CullPlanes planes;
+    cull_extract_planes(view_proj, &planes);
+    store->visible_count = cull_instance_range(store, &planes, 0, store->count, store->visible, allow_avx2 && cull_cpu_has_avx2());
+    return store->visible_count;
+}
+// Marks every instance visible (culling disabled)
+inline UINT
+InstanceStore_NoCull (InstanceStore * store) {
+    for (UINT i = 0; i < store->count; ++i)
+        store->visible[i] = i;
+    store->visible_count = store->count;
+    return store->visible_count;
+}
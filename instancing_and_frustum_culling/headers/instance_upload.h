@@ -0,0 +1,46 @@
+/* ===========================================================
+   #File: instance_upload.h #
+   #Date: 17 Oct 2026 #
+   #Revision: 1.0 #
+   #Creator: Omid Miresmaeili #
+   #Description: per-buffer records of uploaded instances #
+   #Notice: (C) Copyright 2021 by Omid. All Rights Reserved. #
+   =========================================================== */
+#pragma once
+
+#include "common.h"
+
+//
+// Instance upload records
+//
+// What each slot of one upload buffer holds (instance and version), so a frame only
+// rewrites the slots whose content differs from what that buffer got the last time it
+// was used. One record per queued frame buffer.
+//
+struct InstanceUploadRecord {
+    UINT *  slot_instance;
+    UINT *  slot_version;
+    UINT    capacity;
+};
+inline void
+InstanceUploadRecord_Init (InstanceUploadRecord * record, UINT capacity) {
+    record->capacity = capacity;
+    record->slot_instance = (UINT *)::malloc(sizeof(UINT) * capacity);
+    record->slot_version = (UINT *)::malloc(sizeof(UINT) * capacity);
+    memset(record->slot_instance, 0xff, sizeof(UINT) * capacity);     // nothing uploaded yet
+}
+inline void
+InstanceUploadRecord_Release (InstanceUploadRecord * record) {
+    ::free(record->slot_instance);
+    ::free(record->slot_version);
+    *record = {};
+}
+// True if [slot] must be rewritten to hold version [version] of [instance]; records it as written
+inline bool
+InstanceUploadRecord_Update (InstanceUploadRecord * record, UINT slot, UINT instance, UINT version) {
+    if (record->slot_instance[slot] == instance && record->slot_version[slot] == version)
+        return false;
+    record->slot_instance[slot] = instance;
+    record->slot_version[slot] = version;
+    return true;
+}
@@ -0,0 +1,255 @@
+/* ===========================================================
+   #File: mesh_conditioning.h #
+   #Date: 17 Oct 2026 #
+   #Revision: 1.0 #
+   #Creator: Omid Miresmaeili #
+   #Description: vertex welding and index format narrowing at load time #
+   #Notice: (C) Copyright 2021 by Omid. All Rights Reserved. #
+   =========================================================== */
+#pragma once
+
+#include "common.h"
+#include "mesh_geometry.h"
+
+using namespace DirectX;
+
+//
+// Vertex welding
+//
+// Merges vertices whose components are all equal within an epsilon (bit-identical when
+// both epsilons are 0). Candidates are found with an open addressing hash of the position
+// snapped to a grid of [position_epsilon] cells; the 27 cells around a vertex are probed
+// so neighbours straddling a cell border are found too. Vertices are assumed to be made of
+// floats with the position first, which holds for every Vertex layout of the demos.
+//
+#define MESH_WELD_POSITION_EPSILON      1e-5f
+#define MESH_WELD_ATTRIBUTE_EPSILON     1e-4f   // normals, tangents and texture coordinates
+
+// Vertices addressable by one R16 submesh (list topologies don't use a strip cut value)
+#define MESH_INDEX16_VERTEX_LIMIT       65536
+
+struct WeldCell {
+    int x, y, z;
+};
+inline UINT
+weld_hash (int x, int y, int z) {
+    UINT h = (UINT)x * 73856093u ^ (UINT)y * 19349663u ^ (UINT)z * 83492791u;
+    h ^= h >> 16; h *= 0x85ebca6b;
+    h ^= h >> 13;
+    return h;
+}
+inline WeldCell
+weld_cell (XMFLOAT3 const * p, float inv_cell_size) {
+    WeldCell ret;
+    if (inv_cell_size > 0.0f) {
+        ret.x = (int)floorf(p->x * inv_cell_size);
+        ret.y = (int)floorf(p->y * inv_cell_size);
+        ret.z = (int)floorf(p->z * inv_cell_size);
+    } else {
+        // exact welding: the bits are the cell
+        memcpy(&ret, p, sizeof(ret));
+    }
+    return ret;
+}
+inline bool
+weld_vertices_equal (
+    float const * a, float const * b, UINT float_count, float position_epsilon, float attribute_epsilon
+) {
+    for (UINT k = 0; k < float_count; ++k) {
+        float eps = k < 3 ? position_epsilon : attribute_epsilon;
+        if (0.0f == eps ? (a[k] != b[k]) : (fabsf(a[k] - b[k]) > eps))
+            return false;
+    }
+    return true;
+}
+// Welds [vertices] in place (survivors keep their first-occurrence order) and returns the new vertex count.
+// [out_remap] receives the new index of every old vertex.
+static UINT
+weld_vertices (
+    void * vertices, UINT vertex_count, UINT vertex_stride,
+    float position_epsilon, float attribute_epsilon, UINT * out_remap
+) {
+    _ASSERT_EXPR(0 == vertex_stride % sizeof(float), _T("weld_vertices expects float vertex components"));
+    UINT float_count = vertex_stride / sizeof(float);
+    float inv_cell_size = position_epsilon > 0.0f ? 1.0f / position_epsilon : 0.0f;
+    int search = position_epsilon > 0.0f ? 1 : 0;
+
+    UINT table_size = 1;
+    while (table_size < vertex_count * 2)
+        table_size <<= 1;
+    UINT * table = (UINT *)::malloc(sizeof(UINT) * table_size);     // new vertex indices
+    memset(table, 0xff, sizeof(UINT) * table_size);
+    WeldCell * cells = (WeldCell *)::malloc(sizeof(WeldCell) * vertex_count);
+
+    BYTE * base = (BYTE *)vertices;
+    UINT unique_count = 0;
+    for (UINT v = 0; v < vertex_count; ++v) {
+        float const * src = (float const *)(base + (size_t)v * vertex_stride);
+        WeldCell cell = weld_cell((XMFLOAT3 const *)src, inv_cell_size);
+
+        // -- look for an equal vertex in the neighbouring cells
+        UINT match = UINT_MAX;
+        for (int dz = -search; dz <= search && UINT_MAX == match; ++dz)
+        for (int dy = -search; dy <= search && UINT_MAX == match; ++dy)
+        for (int dx = -search; dx <= search && UINT_MAX == match; ++dx) {
+            int cx = cell.x + dx, cy = cell.y + dy, cz = cell.z + dz;
+            for (UINT slot = weld_hash(cx, cy, cz) & (table_size - 1); UINT_MAX != table[slot]; slot = (slot + 1) & (table_size - 1)) {
+                UINT u = table[slot];
+                if (cells[u].x != cx || cells[u].y != cy || cells[u].z != cz)
+                    continue;
+                float const * other = (float const *)(base + (size_t)u * vertex_stride);
+                if (weld_vertices_equal(src, other, float_count, position_epsilon, attribute_epsilon)) {
+                    match = u;
+                    break;
+                }
+            }
+        }
+        if (UINT_MAX != match) {
+            out_remap[v] = match;
+            continue;
+        }
+
+        // -- keep it (u <= v, so the move never overwrites an unvisited vertex)
+        UINT u = unique_count++;
+        if (u != v)
+            memmove(base + (size_t)u * vertex_stride, src, vertex_stride);
+        cells[u] = cell;
+        UINT slot = weld_hash(cell.x, cell.y, cell.z) & (table_size - 1);
+        while (UINT_MAX != table[slot])
+            slot = (slot + 1) & (table_size - 1);
+        table[slot] = u;
+        out_remap[v] = u;
+    }
+    ::free(cells);
+    ::free(table);
+    return unique_count;
+}
+// Welds a triangle list in place and returns the new vertex count
+static UINT
+weld_mesh (
+    char const * mesh_name, void * vertices, UINT vertex_count, UINT vertex_stride,
+    uint32_t * indices, UINT index_count
+) {
+    UINT * remap = (UINT *)::malloc(sizeof(UINT) * vertex_count);
+    UINT unique_count = weld_vertices(
+        vertices, vertex_count, vertex_stride, MESH_WELD_POSITION_EPSILON, MESH_WELD_ATTRIBUTE_EPSILON, remap);
+    for (UINT i = 0; i < index_count; ++i)
+        indices[i] = remap[indices[i]];
+    ::free(remap);
+
+    char buf[256];
+    sprintf_s(buf, sizeof(buf), "[weld] %s: %u -> %u vertices\n", mesh_name, vertex_count, unique_count);
+    ::OutputDebugStringA(buf);
+    return unique_count;
+}
+
+//
+// Index narrowing
+//
+// Picks the narrowest index format for a triangle list. Meshes addressing more than
+// MESH_INDEX16_VERTEX_LIMIT vertices are split into consecutive triangle ranges that
+// each span less than that many vertices, drawn as separate submeshes with their own
+// base_vertex_location. Vertex fetch optimized meshes (vertices in first-use order)
+// split into a handful of ranges.
+//
+
+// Splits [indices] into ranges spanning at most MESH_INDEX16_VERTEX_LIMIT vertices.
+// Returns the number of ranges, or UINT_MAX if more than [max_ranges] would be needed.
+static UINT
+split_index16_ranges (
+    uint32_t const * indices, UINT index_count, UINT max_ranges,
+    UINT out_starts [], UINT out_counts [], UINT out_base_vertices []
+) {
+    UINT n_ranges = 0;
+    UINT lo = UINT_MAX, hi = 0;
+    UINT start = 0;
+    for (UINT i = 0; i < index_count; i += 3) {
+        UINT a = indices[i], b = indices[i + 1], c = indices[i + 2];
+        UINT tri_lo = a < b ? (a < c ? a : c) : (b < c ? b : c);
+        UINT tri_hi = a > b ? (a > c ? a : c) : (b > c ? b : c);
+        if (tri_hi - tri_lo >= MESH_INDEX16_VERTEX_LIMIT)
+            return UINT_MAX;        // a single triangle out of reach
+        UINT new_lo = tri_lo < lo ? tri_lo : lo;
+        UINT new_hi = tri_hi > hi ? tri_hi : hi;
+        if (new_hi - new_lo >= MESH_INDEX16_VERTEX_LIMIT) {
+            if (n_ranges + 1 >= max_ranges)
+                return UINT_MAX;
+            out_starts[n_ranges] = start;
+            out_counts[n_ranges] = i - start;
+            out_base_vertices[n_ranges] = lo;
+            ++n_ranges;
+            start = i;
+            new_lo = tri_lo;
+            new_hi = tri_hi;
+        }
+        lo = new_lo;
+        hi = new_hi;
+    }
+    if (index_count > start) {
+        out_starts[n_ranges] = start;
+        out_counts[n_ranges] = index_count - start;
+        out_base_vertices[n_ranges] = lo;
+        ++n_ranges;
+    }
+    return n_ranges;
+}
+// Creates geom->ib_cpu from a 32-bit triangle list in the narrowest index format and fills
+// submesh_geoms[0 .. n) (index ranges, base vertices and bounds), returning n.
+// Pass max_submeshes = 1 when the mesh is drawn as a single submesh: it then stays 32-bit if it
+// can't be addressed with 16-bit indices. The caller uploads ib_cpu and names the submeshes.
+static UINT
+Mesh_CreateIndexBuffer (
+    MeshGeometry * geom, uint32_t const * indices, UINT index_count,
+    void const * vertices, UINT vertex_stride, UINT max_submeshes, char const * name
+) {
+    UINT starts [MAX_SUBMESH_COUNT];
+    UINT counts [MAX_SUBMESH_COUNT];
+    UINT base_vertices [MAX_SUBMESH_COUNT];
+    UINT n = split_index16_ranges(
+        indices, index_count, max_submeshes < MAX_SUBMESH_COUNT ? max_submeshes : MAX_SUBMESH_COUNT,
+        starts, counts, base_vertices);
+
+    UINT index_size = sizeof(uint16_t);
+    if (UINT_MAX == n) {
+        // -- keep 32-bit indices
+        n = 1;
+        starts[0] = 0;
+        counts[0] = index_count;
+        base_vertices[0] = 0;
+        index_size = sizeof(uint32_t);
+    }
+
+    D3DCreateBlob(index_count * index_size, &geom->ib_cpu);
+    geom->ib_byte_size = index_count * index_size;
+    geom->index_format = sizeof(uint16_t) == index_size ? DXGI_FORMAT_R16_UINT : DXGI_FORMAT_R32_UINT;
+    uint16_t * ib16 = (uint16_t *)geom->ib_cpu->GetBufferPointer();
+    uint32_t * ib32 = (uint32_t *)geom->ib_cpu->GetBufferPointer();
+    for (UINT s = 0; s < n; ++s) {
+        XMVECTOR vmin = XMVectorReplicate(+FLT_MAX);
+        XMVECTOR vmax = XMVectorReplicate(-FLT_MAX);
+        for (UINT i = starts[s]; i < starts[s] + counts[s]; ++i) {
+            UINT v = indices[i];
+            if (sizeof(uint16_t) == index_size)
+                ib16[i] = (uint16_t)(v - base_vertices[s]);
+            else
+                ib32[i] = v;
+            XMVECTOR p = XMLoadFloat3((XMFLOAT3 const *)((BYTE const *)vertices + (size_t)v * vertex_stride));
+            vmin = XMVectorMin(vmin, p);
+            vmax = XMVectorMax(vmax, p);
+        }
+        SubmeshGeometry * submesh = &geom->submesh_geoms[s];
+        *submesh = {};
+        submesh->index_count = counts[s];
+        submesh->start_index_location = starts[s];
+        submesh->base_vertex_location = (INT)base_vertices[s];
+        XMStoreFloat3(&submesh->bounds.Center, 0.5f * (vmin + vmax));
+        XMStoreFloat3(&submesh->bounds.Extents, 0.5f * (vmax - vmin));
+    }
+
+    char buf[256];
+    sprintf_s(buf, sizeof(buf), "[index] %s: %u indices as %s in %u submesh(es), %u -> %u bytes\n",
+        name, index_count, sizeof(uint16_t) == index_size ? "R16" : "R32", n,
+        index_count * (UINT)sizeof(uint32_t), geom->ib_byte_size);
+    ::OutputDebugStringA(buf);
+    return n;
+}
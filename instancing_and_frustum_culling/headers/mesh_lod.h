@@ -0,0 +1,469 @@
+/* ===========================================================
+   #File: mesh_lod.h #
+   #Date: 17 Oct 2026 #
+   #Revision: 1.0 #
+   #Creator: Omid Miresmaeili #
+   #Description: quadric error mesh simplification, LOD chains and LOD selection #
+   #Notice: (C) Copyright 2021 by Omid. All Rights Reserved. #
+   =========================================================== */
+#pragma once
+
+#include "common.h"
+#include "mesh_geometry.h"
+#include "mesh_optimizer.h"
+#include "screen_coverage.h"
+
+using namespace DirectX;
+
+//
+// Mesh simplification
+//
+// Repeated half-edge collapses ordered by quadric error: every vertex accumulates the
+// (area weighted) planes of its triangles, and collapsing a vertex onto a neighbour costs
+// the mean squared distance of the neighbour to the planes of both. Vertices keep their
+// attributes, so a LOD is just another index range into the original vertex buffer.
+// Normals are taken into account by penalizing collapses between vertices whose normals
+// disagree. Border and attribute seam vertices (same position, different attributes)
+// are never moved.
+// Reference: Garland and Heckbert, "Surface Simplification Using Quadric Error Metrics" (1997)
+//
+#define LOD_NORMAL_WEIGHT       0.25f   // normal penalty: 1 - cos(angle) scaled by (weight * mesh radius)^2
+#define LOD_FLIP_MIN_COS        0.25f   // reject collapses rotating a triangle by more than ~75 degrees
+#define LOD_PASS_ERROR_SLACK    1.5f    // a pass may collapse edges costing up to 1.5x its goal collapse
+#define LOD_MIN_REDUCTION       0.9f    // stop the chain when a level keeps more than 90% of the previous one
+#define LOD_MAX_PIXEL_ERROR     1.0f    // default screen-space error threshold of select_lod
+
+// Fraction of the full resolution triangles kept by each level of a LOD chain
+static float const lod_chain_ratios [MAX_LOD_COUNT] = {1.0f, 0.5f, 0.25f, 0.1f};
+
+// Q(p) = p'Ap + 2b'p + c, A symmetric
+struct Quadric {
+    float a00, a11, a22, a01, a02, a12;
+    float b0, b1, b2;
+    float c;
+    float weight;       // total area of the planes
+};
+struct LodCollapse {
+    UINT from;
+    UINT to;
+    float cost;
+};
+
+inline void
+quadric_add (Quadric * q, Quadric const & r) {
+    q->a00 += r.a00; q->a11 += r.a11; q->a22 += r.a22;
+    q->a01 += r.a01; q->a02 += r.a02; q->a12 += r.a12;
+    q->b0 += r.b0; q->b1 += r.b1; q->b2 += r.b2;
+    q->c += r.c;
+    q->weight += r.weight;
+}
+inline Quadric
+quadric_from_triangle (XMFLOAT3 const & p0, XMFLOAT3 const & p1, XMFLOAT3 const & p2) {
+    Quadric q = {};
+    float ux = p1.x - p0.x, uy = p1.y - p0.y, uz = p1.z - p0.z;
+    float vx = p2.x - p0.x, vy = p2.y - p0.y, vz = p2.z - p0.z;
+    float nx = uy * vz - uz * vy;
+    float ny = uz * vx - ux * vz;
+    float nz = ux * vy - uy * vx;
+    float len = sqrtf(nx * nx + ny * ny + nz * nz);
+    if (len <= 0.0f)
+        return q;
+    nx /= len; ny /= len; nz /= len;
+    float d = -(nx * p0.x + ny * p0.y + nz * p0.z);
+    float w = 0.5f * len;
+    q.a00 = w * nx * nx; q.a11 = w * ny * ny; q.a22 = w * nz * nz;
+    q.a01 = w * nx * ny; q.a02 = w * nx * nz; q.a12 = w * ny * nz;
+    q.b0 = w * nx * d; q.b1 = w * ny * d; q.b2 = w * nz * d;
+    q.c = w * d * d;
+    q.weight = w;
+    return q;
+}
+// Mean squared distance of p to the planes of q
+inline float
+quadric_error (Quadric const & q, XMFLOAT3 const & p) {
+    float rx = q.a00 * p.x + q.a01 * p.y + q.a02 * p.z + 2.0f * q.b0;
+    float ry = q.a01 * p.x + q.a11 * p.y + q.a12 * p.z + 2.0f * q.b1;
+    float rz = q.a02 * p.x + q.a12 * p.y + q.a22 * p.z + 2.0f * q.b2;
+    float e = p.x * rx + p.y * ry + p.z * rz + q.c;
+    return q.weight > 0.0f ? fabsf(e) / q.weight : 0.0f;
+}
+inline XMFLOAT3 const *
+vertex_normal (void const * vertices, UINT vertex_stride, UINT normal_offset, UINT i) {
+    return (XMFLOAT3 const *)((uint8_t const *)vertices + (INT64)i * vertex_stride + normal_offset);
+}
+static int
+compare_lod_collapses (void const * a, void const * b) {
+    float ca = ((LodCollapse const *)a)->cost;
+    float cb = ((LodCollapse const *)b)->cost;
+    return (ca > cb) - (ca < cb);
+}
+inline UINT
+lod_hash (UINT h) {
+    // murmur3 finalizer
+    h ^= h >> 16; h *= 0x85ebca6b;
+    h ^= h >> 13; h *= 0xc2b2ae35;
+    h ^= h >> 16;
+    return h;
+}
+inline UINT
+lod_pow2_at_least (UINT n) {
+    UINT ret = 1;
+    while (ret < n)
+        ret <<= 1;
+    return ret;
+}
+// Locks vertices sharing their position with another vertex (attribute seams)
+static void
+lod_lock_seams (void const * vertices, UINT vertex_stride, UINT vertex_count, uint8_t * locked) {
+    UINT table_size = lod_pow2_at_least(vertex_count * 2);
+    UINT * table = (UINT *)::malloc(sizeof(UINT) * table_size);
+    memset(table, 0xff, sizeof(UINT) * table_size);
+    for (UINT v = 0; v < vertex_count; ++v) {
+        XMFLOAT3 const * p = vertex_position(vertices, vertex_stride, v);
+        UINT bits[3];
+        memcpy(bits, p, sizeof(bits));
+        UINT slot = lod_hash(bits[0] ^ lod_hash(bits[1] ^ lod_hash(bits[2]))) & (table_size - 1);
+        for (;;) {
+            if (UINT_MAX == table[slot]) {
+                table[slot] = v;
+                break;
+            }
+            XMFLOAT3 const * q = vertex_position(vertices, vertex_stride, table[slot]);
+            if (0 == memcmp(p, q, sizeof(XMFLOAT3))) {
+                locked[v] = 1;
+                locked[table[slot]] = 1;
+                break;
+            }
+            slot = (slot + 1) & (table_size - 1);
+        }
+    }
+    ::free(table);
+}
+// Locks the vertices of edges used by a single triangle (mesh borders)
+template <typename T> static void
+lod_lock_borders (T const * indices, UINT index_count, uint8_t * locked) {
+    UINT table_size = lod_pow2_at_least(index_count * 2);
+    uint64_t * table = (uint64_t *)::malloc(sizeof(uint64_t) * table_size);
+    memset(table, 0xff, sizeof(uint64_t) * table_size);
+    for (int pass = 0; pass < 2; ++pass) {
+        for (UINT i = 0; i < index_count; ++i) {
+            UINT a = indices[i];
+            UINT b = indices[i % 3 == 2 ? i - 2 : i + 1];
+            // insert directed edges, then look up their opposites
+            uint64_t key = 0 == pass ? ((uint64_t)a << 32 | b) : ((uint64_t)b << 32 | a);
+            UINT slot = lod_hash((UINT)key ^ lod_hash((UINT)(key >> 32))) & (table_size - 1);
+            while (table[slot] != key && table[slot] != UINT64_MAX)
+                slot = (slot + 1) & (table_size - 1);
+            if (0 == pass)
+                table[slot] = key;
+            else if (UINT64_MAX == table[slot])
+                locked[a] = locked[b] = 1;
+        }
+    }
+    ::free(table);
+}
+// Collapsing [from] onto [to] must not turn any remaining triangle around [from] over
+static bool
+lod_collapse_flips (
+    UINT from, UINT to, UINT const * adjacency_offsets, UINT const * adjacency,
+    UINT const * tri_indices, void const * vertices, UINT vertex_stride
+) {
+    XMFLOAT3 const * pf = vertex_position(vertices, vertex_stride, from);
+    XMFLOAT3 const * pt = vertex_position(vertices, vertex_stride, to);
+    for (UINT k = adjacency_offsets[from]; k < adjacency_offsets[from + 1]; ++k) {
+        UINT const * tri = tri_indices + 3 * adjacency[k];
+        UINT corner = tri[0] == from ? 0 : (tri[1] == from ? 1 : 2);
+        UINT b = tri[(corner + 1) % 3];
+        UINT c = tri[(corner + 2) % 3];
+        if (b == to || c == to)
+            continue;   // removed by the collapse
+        XMFLOAT3 const * pb = vertex_position(vertices, vertex_stride, b);
+        XMFLOAT3 const * pc = vertex_position(vertices, vertex_stride, c);
+        float bx = pb->x - pc->x, by = pb->y - pc->y, bz = pb->z - pc->z;
+        float fx = pf->x - pc->x, fy = pf->y - pc->y, fz = pf->z - pc->z;
+        float tx = pt->x - pc->x, ty = pt->y - pc->y, tz = pt->z - pc->z;
+        // normals before/after (cross(b - c, p - c))
+        float n0x = by * fz - bz * fy, n0y = bz * fx - bx * fz, n0z = bx * fy - by * fx;
+        float n1x = by * tz - bz * ty, n1y = bz * tx - bx * tz, n1z = bx * ty - by * tx;
+        float d = n0x * n1x + n0y * n1y + n0z * n1z;
+        float l = sqrtf((n0x * n0x + n0y * n0y + n0z * n0z) * (n1x * n1x + n1y * n1y + n1z * n1z));
+        if (d <= LOD_FLIP_MIN_COS * l)
+            return true;
+    }
+    return false;
+}
+// Simplifies [indices] in place towards [target_index_count] and returns the resulting index count.
+// [out_error] receives the largest collapse error (an object space distance).
+template <typename T> static UINT
+simplify_mesh (
+    T * indices, UINT index_count,
+    void const * vertices, UINT vertex_stride, UINT normal_offset, UINT vertex_count,
+    UINT target_index_count, float * out_error
+) {
+    uint8_t * locked = (uint8_t *)::calloc(vertex_count, 1);
+    uint8_t * pass_locked = (uint8_t *)::malloc(vertex_count);
+    UINT * remap = (UINT *)::malloc(sizeof(UINT) * vertex_count);
+    Quadric * quadrics = (Quadric *)::calloc(vertex_count, sizeof(Quadric));
+    UINT * adjacency_offsets = (UINT *)::malloc(sizeof(UINT) * (vertex_count + 1));
+    UINT * adjacency = (UINT *)::malloc(sizeof(UINT) * index_count);
+    UINT * tri_indices = (UINT *)::malloc(sizeof(UINT) * index_count);
+    LodCollapse * collapses = (LodCollapse *)::malloc(sizeof(LodCollapse) * index_count);
+
+    lod_lock_seams(vertices, vertex_stride, vertex_count, locked);
+    lod_lock_borders(indices, index_count, locked);
+
+    // -- plane quadrics and mesh extent (scales the normal penalty)
+    XMFLOAT3 bb_min = XMFLOAT3(FLT_MAX, FLT_MAX, FLT_MAX);
+    XMFLOAT3 bb_max = XMFLOAT3(-FLT_MAX, -FLT_MAX, -FLT_MAX);
+    for (UINT i = 0; i < index_count; i += 3) {
+        Quadric q = quadric_from_triangle(
+            *vertex_position(vertices, vertex_stride, indices[i + 0]),
+            *vertex_position(vertices, vertex_stride, indices[i + 1]),
+            *vertex_position(vertices, vertex_stride, indices[i + 2]));
+        for (UINT k = 0; k < 3; ++k) {
+            quadric_add(&quadrics[indices[i + k]], q);
+            XMFLOAT3 const * p = vertex_position(vertices, vertex_stride, indices[i + k]);
+            bb_min = XMFLOAT3(fminf(bb_min.x, p->x), fminf(bb_min.y, p->y), fminf(bb_min.z, p->z));
+            bb_max = XMFLOAT3(fmaxf(bb_max.x, p->x), fmaxf(bb_max.y, p->y), fmaxf(bb_max.z, p->z));
+        }
+    }
+    float dx = bb_max.x - bb_min.x, dy = bb_max.y - bb_min.y, dz = bb_max.z - bb_min.z;
+    float normal_scale = LOD_NORMAL_WEIGHT * 0.5f * sqrtf(dx * dx + dy * dy + dz * dz);
+    normal_scale *= normal_scale;
+
+    float max_error = 0.0f;
+    while (index_count > target_index_count) {
+        UINT tri_count = index_count / 3;
+        for (UINT i = 0; i < index_count; ++i)
+            tri_indices[i] = indices[i];
+
+        // -- vertex -> triangle adjacency
+        memset(adjacency_offsets, 0, sizeof(UINT) * (vertex_count + 1));
+        for (UINT i = 0; i < index_count; ++i)
+            ++adjacency_offsets[tri_indices[i] + 1];
+        for (UINT v = 0; v < vertex_count; ++v)
+            adjacency_offsets[v + 1] += adjacency_offsets[v];
+        for (UINT i = 0; i < index_count; ++i)
+            adjacency[adjacency_offsets[tri_indices[i]]++] = i / 3;
+        for (UINT v = vertex_count; v > 0; --v)
+            adjacency_offsets[v] = adjacency_offsets[v - 1];
+        adjacency_offsets[0] = 0;
+
+        // -- cheapest direction of every edge (interior edges are seen from both triangles, keep one)
+        UINT n_collapses = 0;
+        for (UINT i = 0; i < index_count; ++i) {
+            UINT a = tri_indices[i];
+            UINT b = tri_indices[i % 3 == 2 ? i - 2 : i + 1];
+            if (a >= b || (locked[a] && locked[b]))
+                continue;
+            Quadric q = quadrics[a];
+            quadric_add(&q, quadrics[b]);
+            XMFLOAT3 const * na = vertex_normal(vertices, vertex_stride, normal_offset, a);
+            XMFLOAT3 const * nb = vertex_normal(vertices, vertex_stride, normal_offset, b);
+            float normal_cost = normal_scale * (1.0f - (na->x * nb->x + na->y * nb->y + na->z * nb->z));
+            float cost_ab = locked[a] ? FLT_MAX : quadric_error(q, *vertex_position(vertices, vertex_stride, b));
+            float cost_ba = locked[b] ? FLT_MAX : quadric_error(q, *vertex_position(vertices, vertex_stride, a));
+            LodCollapse c;
+            c.from = cost_ab <= cost_ba ? a : b;
+            c.to = cost_ab <= cost_ba ? b : a;
+            c.cost = (cost_ab <= cost_ba ? cost_ab : cost_ba) + normal_cost;
+            collapses[n_collapses++] = c;
+        }
+        if (0 == n_collapses)
+            break;
+        ::qsort(collapses, n_collapses, sizeof(LodCollapse), compare_lod_collapses);
+
+        // an interior collapse removes two triangles
+        UINT collapse_goal = (index_count - target_index_count) / 6 + 1;
+        float pass_error_limit = collapses[(collapse_goal < n_collapses ? collapse_goal : n_collapses) - 1].cost * LOD_PASS_ERROR_SLACK;
+
+        // -- collapse independent edges: the 1-ring of a moved vertex is frozen for the rest of the pass
+        for (UINT v = 0; v < vertex_count; ++v)
+            remap[v] = v;
+        memset(pass_locked, 0, vertex_count);
+        UINT n_applied = 0;
+        for (UINT i = 0; i < n_collapses && n_applied < collapse_goal; ++i) {
+            LodCollapse const & c = collapses[i];
+            if (c.cost > pass_error_limit)
+                break;
+            if (pass_locked[c.from] || pass_locked[c.to])
+                continue;
+            if (lod_collapse_flips(c.from, c.to, adjacency_offsets, adjacency, tri_indices, vertices, vertex_stride))
+                continue;
+            for (UINT k = adjacency_offsets[c.from]; k < adjacency_offsets[c.from + 1]; ++k) {
+                UINT const * tri = tri_indices + 3 * adjacency[k];
+                pass_locked[tri[0]] = pass_locked[tri[1]] = pass_locked[tri[2]] = 1;
+            }
+            remap[c.from] = c.to;
+            quadric_add(&quadrics[c.to], quadrics[c.from]);
+            max_error = c.cost > max_error ? c.cost : max_error;
+            ++n_applied;
+        }
+        if (0 == n_applied)
+            break;
+
+        // -- apply the collapses, dropping the triangles that became degenerate
+        UINT n_indices = 0;
+        for (UINT t = 0; t < tri_count; ++t) {
+            UINT a = remap[tri_indices[3 * t + 0]];
+            UINT b = remap[tri_indices[3 * t + 1]];
+            UINT c = remap[tri_indices[3 * t + 2]];
+            if (a == b || b == c || c == a)
+                continue;
+            indices[n_indices++] = (T)a;
+            indices[n_indices++] = (T)b;
+            indices[n_indices++] = (T)c;
+        }
+        index_count = n_indices;
+    }
+
+    ::free(collapses);
+    ::free(tri_indices);
+    ::free(adjacency);
+    ::free(adjacency_offsets);
+    ::free(quadrics);
+    ::free(remap);
+    ::free(pass_locked);
+    ::free(locked);
+
+    *out_error = sqrtf(max_error);
+    return index_count;
+}
+
+//
+// LOD chains
+//
+// Simplifies a submesh into the levels of lod_chain_ratios, each one from the previous
+// level. The levels are appended to the index buffer of [geom] (ib_cpu is replaced by a
+// larger blob) so this must run before the index buffer is uploaded.
+// [vertices] are the vertices of the whole MeshGeometry; [normal_offset] locates the
+// float3 normal inside a vertex.
+//
+template <typename T> static UINT
+build_lod_chain (
+    T const * lod0_indices, UINT lod0_index_count,
+    void const * vertices, UINT vertex_stride, UINT normal_offset, UINT vertex_count,
+    T * out_indices, MeshLod out_lods []
+) {
+    out_lods[0].index_count = lod0_index_count;
+    out_lods[0].start_index_location = 0;
+    out_lods[0].error = 0.0f;
+
+    UINT lod_count = 1;
+    UINT out_index_count = 0;
+    T const * prev = lod0_indices;
+    for (UINT l = 1; l < MAX_LOD_COUNT; ++l) {
+        UINT prev_count = out_lods[l - 1].index_count;
+        UINT target = (UINT)(lod0_index_count / 3 * lod_chain_ratios[l]) * 3;
+        T * dst = out_indices + out_index_count;
+        memcpy(dst, prev, sizeof(T) * prev_count);
+
+        float error = 0.0f;
+        UINT n = simplify_mesh(dst, prev_count, vertices, vertex_stride, normal_offset, vertex_count, target, &error);
+        if (n > prev_count * LOD_MIN_REDUCTION)
+            break;
+        optimize_vertex_cache(dst, n, vertex_count);
+
+        out_lods[l].index_count = n;
+        out_lods[l].start_index_location = out_index_count;  // relative to the first simplified level
+        // deviation from LOD0 is bounded by the sum of the deviations of the steps
+        out_lods[l].error = out_lods[l - 1].error + error;
+        out_index_count += n;
+        prev = dst;
+        ++lod_count;
+    }
+    return lod_count;
+}
+inline UINT
+lod_chain_index_bound (UINT lod0_index_count) {
+    // every simplified level is smaller than LOD0
+    return (MAX_LOD_COUNT - 1) * lod0_index_count;
+}
+static void
+Mesh_BuildLods (
+    MeshGeometry * geom, UINT submesh_index,
+    void const * vertices, UINT vertex_stride, UINT normal_offset, UINT vertex_count, char const * name
+) {
+    SubmeshGeometry * submesh = &geom->submesh_geoms[submesh_index];
+    UINT index_size = DXGI_FORMAT_R16_UINT == geom->index_format ? sizeof(uint16_t) : sizeof(uint32_t);
+    UINT lod_index_start = geom->ib_byte_size / index_size;
+
+    void const * submesh_vertices = (uint8_t const *)vertices + (INT64)submesh->base_vertex_location * vertex_stride;
+    UINT submesh_vertex_count = vertex_count - submesh->base_vertex_location;
+    uint8_t const * lod0 = (uint8_t const *)geom->ib_cpu->GetBufferPointer() + (size_t)submesh->start_index_location * index_size;
+    void * lod_indices = ::malloc((size_t)lod_chain_index_bound(submesh->index_count) * index_size);
+    if (DXGI_FORMAT_R16_UINT == geom->index_format)
+        submesh->lod_count = build_lod_chain(
+            (uint16_t const *)lod0, submesh->index_count,
+            submesh_vertices, vertex_stride, normal_offset, submesh_vertex_count, (uint16_t *)lod_indices, submesh->lods);
+    else
+        submesh->lod_count = build_lod_chain(
+            (uint32_t const *)lod0, submesh->index_count,
+            submesh_vertices, vertex_stride, normal_offset, submesh_vertex_count, (uint32_t *)lod_indices, submesh->lods);
+    submesh->lods[0].start_index_location = submesh->start_index_location;
+
+    UINT lod_index_count = 0;
+    for (UINT l = 1; l < submesh->lod_count; ++l) {
+        submesh->lods[l].start_index_location += lod_index_start;
+        lod_index_count += submesh->lods[l].index_count;
+    }
+
+    // -- append the simplified levels to the index buffer
+    if (lod_index_count > 0) {
+        ID3DBlob * ib_cpu = nullptr;
+        D3DCreateBlob(geom->ib_byte_size + lod_index_count * index_size, &ib_cpu);
+        CopyMemory(ib_cpu->GetBufferPointer(), geom->ib_cpu->GetBufferPointer(), geom->ib_byte_size);
+        CopyMemory((uint8_t *)ib_cpu->GetBufferPointer() + geom->ib_byte_size, lod_indices, (size_t)lod_index_count * index_size);
+        geom->ib_cpu->Release();
+        geom->ib_cpu = ib_cpu;
+        geom->ib_byte_size += lod_index_count * index_size;
+    }
+    ::free(lod_indices);
+
+    char buf[256];
+    for (UINT l = 0; l < submesh->lod_count; ++l) {
+        sprintf_s(buf, sizeof(buf), "[lod] %s: LOD%u %u triangles, error %.4f\n",
+            name, l, submesh->lods[l].index_count / 3, submesh->lods[l].error);
+        ::OutputDebugStringA(buf);
+    }
+}
+
+//
+// LOD selection
+//
+// The object space error of a level, projected at the distance of the nearest point of
+// the bounding sphere (screen_coverage, the same projection as small object culling), is
+// compared against a pixel threshold; the coarsest level within the threshold wins.
+//
+
+// Pixels per unit of length at distance 1 (viewport_height / (2 * tan(fov_y / 2)))
+inline float
+lod_projection_scale (XMFLOAT4X4 const & proj, float viewport_height) {
+    return coverage_projection_scale(proj, viewport_height);
+}
+// Coarsest level whose error stays within [max_pixel_error] at [pixels_per_unit] (object space units to pixels)
+inline UINT
+select_lod_at_scale (MeshLod const lods [], UINT lod_count, float pixels_per_unit, float max_pixel_error) {
+    UINT ret = 0;
+    for (UINT l = 1; l < lod_count; ++l)
+        if (lods[l].error * pixels_per_unit <= max_pixel_error)
+            ret = l;
+    return ret;
+}
+inline UINT
+select_lod (
+    MeshLod const lods [], UINT lod_count, BoundingBox const & bounds, XMFLOAT4X4 const & world,
+    XMFLOAT3 const & eye_pos_w, float proj_scale, float max_pixel_error
+) {
+    if (lod_count < 2)
+        return 0;
+
+    ScreenCoverageParams params = {};
+    params.eye_pos = eye_pos_w;
+    params.proj_scale = proj_scale;
+    ScreenCoverage coverage = screen_coverage(bounds, world, params);
+    if (FLT_MAX == coverage.pixels_per_unit)
+        return 0;   // eye inside the bounding sphere
+
+    return select_lod_at_scale(lods, lod_count, coverage.pixels_per_unit, max_pixel_error);
+}
@@ -10,6 +10,7 @@
 
 #include "common.h"
 #include "mesh_geometry.h"
+#include "mesh_optimizer.h"
 
 #define ARRAY_COUNT(arr)                sizeof(arr)/sizeof(arr[0])
 #define CLAMP_VALUE(val, lb, ub)        ((val) < (lb)) ? (lb) : ((val) > (ub) ? (ub) : (val))
@@ -27,14 +28,14 @@ struct Light {
 
 #define MAX_LIGHTS  16
 
+// packed by pack_instance_data (see instance_compression.h)
 struct InstanceData {
-    XMFLOAT4X4 world;
-    XMFLOAT4X4 tex_transform;
+    XMFLOAT4 world_rows[3];     // transposed affine world matrix (3x4)
 
-    UINT mat_index;
+    UINT tex_scale;             // half2, texture transform scale
+    UINT tex_offset;            // half2, texture transform offset
+    UINT mat_index_flags;       // material index (low 16 bits), INSTANCE_FLAG_* (high 16 bits)
     UINT instance_pad0;
-    UINT instance_pad1;
-    UINT instance_pad2;
 };
 // -- per pass constants
 struct PassConstants {
@@ -177,6 +178,12 @@ struct RenderItem {
 
     BoundingBox bounds;
 
+    // LOD chain of the drawn submesh (see SubmeshGeometry::lods) and the number of
+    // instances drawn with each level, grouped by level in the instance buffer
+    UINT lod_count;
+    MeshLod lods [MAX_LOD_COUNT];
+    UINT lod_instance_count [MAX_LOD_COUNT];
+
     Material * mat;
     MeshGeometry * geometry;
 };
@@ -739,6 +746,9 @@ create_sphere (float radius, GeomVertex out_vtx [], uint16_t out_idx []) {
         out_idx[_idx_cnt++] = base_index + i;
         out_idx[_idx_cnt++] = base_index + i + 1;
     }
+
+    // bottom pole is stored at [n_vtx + 1]
+    optimize_vertex_cache_and_report("sphere", out_idx, _idx_cnt, n_vtx + 2);
 }
 static void
 create_cylinder (float bottom_radius, float top_radius, float height, GeomVertex out_vtx [], uint16_t out_idx []) {
@@ -873,6 +883,7 @@ create_cylinder (float bottom_radius, float top_radius, float height, GeomVertex
     }
 #pragma endregion build cylinder bottom
 
+    optimize_vertex_cache_and_report("cylinder", out_idx, _idx_cnt, _vtx_cnt);
 }
 static void
 create_grid16 (float width, float depth, UINT32 m, UINT32 n, GeomVertex out_vtx [], uint16_t out_idx []) {
@@ -921,6 +932,8 @@ create_grid16 (float width, float depth, UINT32 m, UINT32 n, GeomVertex out_vtx
             k += 6; // next quad
         }
     }
+
+    optimize_vertex_cache_and_report("grid16", out_idx, k, m * n);
 }
 static void
 create_grid32 (float width, float depth, UINT32 m, UINT32 n, GeomVertex out_vtx [], uint32_t out_idx []) {
@@ -969,4 +982,6 @@ create_grid32 (float width, float depth, UINT32 m, UINT32 n, GeomVertex out_vtx
             k += 6; // next quad
         }
     }
+
+    optimize_vertex_cache_and_report("grid32", out_idx, k, m * n);
 }
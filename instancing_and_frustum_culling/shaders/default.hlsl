@@ -10,15 +10,21 @@
 
 #include "light_utils.hlsl"
 
+// packed on the CPU by pack_instance_data (headers/instance_compression.h)
 struct InstanceData {
-    float4x4 world;
-    float4x4 tex_transform;
+    float4 world_rows[3];   // transposed affine world matrix (3x4)
 
-    uint mat_index;
+    uint tex_scale;         // half2
+    uint tex_offset;        // half2
+    uint mat_index_flags;   // material index (low 16 bits), flags (high 16 bits)
     uint instance_pad0;
-    uint instance_pad1;
-    uint instance_pad2;
 };
+#define INSTANCE_FLAG_TEX_TRANSFORM     (1u << 16)
+
+float2
+unpack_half2 (uint v) {
+    return f16tof32(uint2(v & 0xffff, v >> 16));
+}
 
 struct MaterialData {
     float4 diffuse_albedo;
@@ -101,9 +107,8 @@ VertexShader_Main (VertexShaderInput vin, uint instance_id : SV_InstanceID) {
 
     // fetch instance data
     InstanceData inst_data = global_instance_data[instance_id];
-    float4x4 world = inst_data.world;
-    float4x4 tex_transform = inst_data.tex_transform;
-    uint mat_index = inst_data.mat_index;
+    float3x4 world_t = float3x4(inst_data.world_rows[0], inst_data.world_rows[1], inst_data.world_rows[2]);
+    uint mat_index = inst_data.mat_index_flags & 0xffff;
     
     result.mat_index = mat_index;
  
@@ -111,18 +116,20 @@ VertexShader_Main (VertexShaderInput vin, uint instance_id : SV_InstanceID) {
     MaterialData mat_data = global_mat_data[mat_index];
     
     // transform to world space
-    float4 pos_world = mul(float4(vin.pos_local, 1.0f), world);
+    float4 pos_world = float4(mul(world_t, float4(vin.pos_local, 1.0f)), 1.0f);
     result.pos_world = pos_world.xyz;
     
     // assuming nonuniform scale (otherwise have to use inverse-transpose of world-matrix)
-    result.normal_world = mul(vin.normal_local, (float3x3)world);
+    result.normal_world = mul((float3x3)world_t, vin.normal_local);
 
     // transform to homogenous clip space
     result.pos_homogenous_clip_space = mul(pos_world, global_view_proj);
 
     // output vertex attributes for interpolation across triangle
-    float4 texc = mul(float4(vin.texc, 0.0f, 1.0f), tex_transform);
-    result.texc = mul(texc, mat_data.mat_transform).xy;
+    float2 texc = vin.texc;
+    if (inst_data.mat_index_flags & INSTANCE_FLAG_TEX_TRANSFORM)
+        texc = texc * unpack_half2(inst_data.tex_scale) + unpack_half2(inst_data.tex_offset);
+    result.texc = mul(float4(texc, 0.0f, 1.0f), mat_data.mat_transform).xy;
 
     return result;
 }
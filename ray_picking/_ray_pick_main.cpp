@@ -22,6 +22,11 @@
 #include "headers/utils.h"
 #include "headers/game_timer.h"
 #include "headers/dds_loader.h"
+#include "headers/mesh_loader.h"
+#include "headers/mesh_lod.h"
+#include "headers/triangle_bvh.h"
+#include "headers/pick_scene.h"
+#include "headers/pick_select.h"
 
 #include <time.h>
 
@@ -40,6 +45,7 @@
 #endif
 
 #define ENABLE_FRUSTUM_CULLING
+#define ENABLE_LOD_SELECTION
 
 #define NUM_BACKBUFFERS         2
 #define NUM_QUEUING_FRAMES      3
@@ -98,6 +104,11 @@ struct SceneContext {
     // mouse position
     POINT mouse;
 
+    // marquee selection: corner where the right button went down with shift (triangles) or ctrl (items)
+    POINT marquee_anchor;
+    bool marquee_active;
+    bool marquee_triangles;
+
     // display-related data
     UINT width;
     UINT height;
@@ -118,6 +129,13 @@ bool global_frustumculling_enabled = true;
 bool global_frustumculling_enabled = false;
 #endif // defined(ENABLE_FRUSTUM_CULLING)
 
+#if defined(ENABLE_LOD_SELECTION)
+bool global_lod_enabled = true;
+#else
+bool global_lod_enabled = false;
+#endif // defined(ENABLE_LOD_SELECTION)
+float global_lod_pixel_error = LOD_MAX_PIXEL_ERROR;
+
 struct RenderItemArray {
     RenderItem  ritems[_COUNT_RENDERITEM];
     uint32_t    size;
@@ -164,6 +182,19 @@ struct D3DRenderContext {
     RenderItemArray                 highlight_ritems;
 
     MeshGeometry                    geom[_COUNT_GEOM];
+    // Pickable render items over the triangle BVHs of their meshes
+    PickScene                       pick_scene;
+
+    // Marquee selection; the selected triangles are highlighted through a copy of their indices
+    // (one slice of selection_ib per queuing frame, drawn over the vertices of the selected item)
+    PickSelection                   selection;
+    ID3D12Resource *                selection_ib;
+    BYTE *                          selection_ib_ptr;
+    UINT                            selection_ib_slice_size;
+    int                             selection_n_frames_dirty;
+    MeshGeometry                    selection_geom;
+    D3D12_VERTEX_BUFFER_VIEW        selection_vbv;
+    D3D12_INDEX_BUFFER_VIEW         selection_ibv;
 
     // Synchronization stuff
     UINT                            frame_index;
@@ -266,60 +297,11 @@ create_materials (Material out_materials []) {
     out_materials[MAT_HIGHLIGHT].n_frames_dirty = NUM_QUEUING_FRAMES;
 }
 static void
-create_car_geometry (D3DRenderContext * render_ctx) {
-
-#pragma region Read_Data_File
-    FILE * f = nullptr;
-    errno_t err = fopen_s(&f, "./models/car.txt", "r");
-    if (0 == f || err != 0) {
-        printf("could not open file\n");
-        return;
-    }
-    char linebuf[100];
-    int cnt = 0;
-    unsigned vcount = 0;
-    unsigned tcount = 0;
-    // -- read 1st line
-    if (fgets(linebuf, sizeof(linebuf), f))
-        cnt = sscanf_s(linebuf, "%*s %d", &vcount);
-    if (cnt != 1) {
-        printf("read error\n");
-        printf("read line: %s\n", linebuf);
-        return;
-    }
-    // -- read 2nd line
-    if (fgets(linebuf, sizeof(linebuf), f))
-        cnt = sscanf_s(linebuf, "%*s %d", &tcount);
-    if (cnt != 1) {
-        printf("read error\n");
-        printf("read line: %s\n", linebuf);
-        return;
-    }
-    // -- skip two lines
-    fgets(linebuf, sizeof(linebuf), f);
-    fgets(linebuf, sizeof(linebuf), f);
-
-    // -- vmin and vmax for AABB construction
-    XMFLOAT3 vminf3(+FLT_MAX, +FLT_MAX, +FLT_MAX);
-    XMFLOAT3 vmaxf3(-FLT_MAX, -FLT_MAX, -FLT_MAX);
-
-    XMVECTOR vmin = XMLoadFloat3(&vminf3);
-    XMVECTOR vmax = XMLoadFloat3(&vmaxf3);
-
-    // -- read vertices
-    Vertex * vertices = (Vertex *)calloc(vcount, sizeof(Vertex));
-    for (unsigned i = 0; i < vcount; i++) {
-        fgets(linebuf, sizeof(linebuf), f);
-        cnt = sscanf_s(
-            linebuf, "%f %f %f %f %f %f",
-            &vertices[i].position.x, &vertices[i].position.y, &vertices[i].position.z,
-            &vertices[i].normal.x, &vertices[i].normal.y, &vertices[i].normal.z
-        );
-        if (cnt != 6) {
-            printf("read error\n");
-            printf("read line: %s\n", linebuf);
-            return;
-        }
+build_car_vertices (TextMesh const * src, void * out_vertices) {
+    Vertex * vertices = (Vertex *)out_vertices;
+    for (UINT i = 0; i < src->vertex_count; i++) {
+        vertices[i].position = src->positions[i];
+        vertices[i].normal = src->normals[i];
 
 #pragma region skull texture coordinates calculations
         XMVECTOR P = XMLoadFloat3(&vertices[i].position);
@@ -341,74 +323,44 @@ create_car_geometry (D3DRenderContext * render_ctx) {
 
         vertices[i].texc = {u, v};
 #pragma endregion
-
-        // -- calculate vmin, vmax
-        vmin = XMVectorMin(vmin, P);
-        vmax = XMVectorMax(vmax, P);
     }
+}
+static void
+create_car_geometry (D3DRenderContext * render_ctx) {
 
-    // -- construct bounding box (AABB)
-    BoundingBox bounds;
-    XMStoreFloat3(&bounds.Center, 0.5f * (vmin + vmax));
-    XMStoreFloat3(&bounds.Extents, 0.5f * (vmax - vmin));
-
-    // -- skip three lines
-    fgets(linebuf, sizeof(linebuf), f);
-    fgets(linebuf, sizeof(linebuf), f);
-    fgets(linebuf, sizeof(linebuf), f);
-    // -- read indices
-    uint32_t * indices = (uint32_t *)calloc(static_cast<size_t>(tcount) * 3, sizeof(uint32_t));
-    for (unsigned i = 0; i < tcount; i++) {
-        fgets(linebuf, sizeof(linebuf), f);
-        cnt = sscanf_s(
-            linebuf, "%d %d %d",
-            &indices[i * 3 + 0], &indices[i * 3 + 1], &indices[i * 3 + 2]
-        );
-        if (cnt != 3) {
-            printf("read error\n");
-            printf("read line: %s\n", linebuf);
-            return;
-        }
+    // -- map the binary mesh (created from the text file on first load)
+    MeshCacheView mesh = {};
+    if (!load_mesh_cached("./models/car.mesh", "./models/car.txt", sizeof(Vertex), build_car_vertices, &mesh)) {
+        printf("could not load car mesh\n");
+        return;
     }
 
-    // -- remember to free heap-allocated memory
-    /*
-    free(vertices);
-    free(indices);
-    */
-    fclose(f);
-#pragma endregion   Read_Data_File
+    UINT vb_byte_size = mesh.vertex_count * sizeof(Vertex);
 
-    UINT vb_byte_size = vcount * sizeof(Vertex);
-    UINT ib_byte_size = (tcount * 3) * sizeof(uint32_t);
-
-    // -- Fill out render_ctx geom[GEOM_CAR] (skull)
+    // -- Fill out render_ctx geom[GEOM_CAR] (car)
     D3DCreateBlob(vb_byte_size, &render_ctx->geom[GEOM_CAR].vb_cpu);
-    CopyMemory(render_ctx->geom[GEOM_CAR].vb_cpu->GetBufferPointer(), vertices, vb_byte_size);
-
-    D3DCreateBlob(ib_byte_size, &render_ctx->geom[GEOM_CAR].ib_cpu);
-    CopyMemory(render_ctx->geom[GEOM_CAR].ib_cpu->GetBufferPointer(), indices, ib_byte_size);
+    CopyMemory(render_ctx->geom[GEOM_CAR].vb_cpu->GetBufferPointer(), mesh.vertices, vb_byte_size);
 
-    create_default_buffer(render_ctx->device, render_ctx->direct_cmd_list, vertices, vb_byte_size, &render_ctx->geom[GEOM_CAR].vb_uploader, &render_ctx->geom[GEOM_CAR].vb_gpu);
-    create_default_buffer(render_ctx->device, render_ctx->direct_cmd_list, indices, ib_byte_size, &render_ctx->geom[GEOM_CAR].ib_uploader, &render_ctx->geom[GEOM_CAR].ib_gpu);
+    // narrowest index format that still draws the car as a single submesh
+    Mesh_CreateIndexBuffer(&render_ctx->geom[GEOM_CAR], mesh.indices, mesh.index_count, mesh.vertices, sizeof(Vertex), 1, "car");
 
     render_ctx->geom[GEOM_CAR].vb_byte_stide = sizeof(Vertex);
     render_ctx->geom[GEOM_CAR].vb_byte_size = vb_byte_size;
-    render_ctx->geom[GEOM_CAR].ib_byte_size = ib_byte_size;
-    render_ctx->geom[GEOM_CAR].index_format = DXGI_FORMAT_R32_UINT;
-
-    SubmeshGeometry submesh = {};
-    submesh.index_count = tcount * 3;
-    submesh.start_index_location = 0;
-    submesh.base_vertex_location = 0;
-    submesh.bounds = bounds;
 
     render_ctx->geom[GEOM_CAR].submesh_names[0] = "car";
-    render_ctx->geom[GEOM_CAR].submesh_geoms[0] = submesh;
+
+    // -- simplified levels are appended to ib_cpu (after the full resolution triangles used for picking),
+    // so upload the index buffer afterwards
+    Mesh_BuildLods(&render_ctx->geom[GEOM_CAR], 0, mesh.vertices, sizeof(Vertex), offsetof(Vertex, normal), mesh.vertex_count, "car");
+
+    // -- picking BVH over the full resolution triangles
+    Mesh_BuildTriangleBvh(&render_ctx->geom[GEOM_CAR], 1, "car");
+
+    create_default_buffer(render_ctx->device, render_ctx->direct_cmd_list, (void *)mesh.vertices, vb_byte_size, &render_ctx->geom[GEOM_CAR].vb_uploader, &render_ctx->geom[GEOM_CAR].vb_gpu);
+    create_default_buffer(render_ctx->device, render_ctx->direct_cmd_list, render_ctx->geom[GEOM_CAR].ib_cpu->GetBufferPointer(), render_ctx->geom[GEOM_CAR].ib_byte_size, &render_ctx->geom[GEOM_CAR].ib_uploader, &render_ctx->geom[GEOM_CAR].ib_gpu);
 
     // -- cleanup
-    free(vertices);
-    free(indices);
+    MeshCache_Release(&mesh);
 }
 static void
 create_render_items (D3DRenderContext * render_ctx) {
@@ -423,6 +375,8 @@ create_render_items (D3DRenderContext * render_ctx) {
     render_ctx->all_ritems.ritems[RITEM_CAR].start_index_loc = render_ctx->geom[GEOM_CAR].submesh_geoms[0].start_index_location;
     render_ctx->all_ritems.ritems[RITEM_CAR].base_vertex_loc = render_ctx->geom[GEOM_CAR].submesh_geoms[0].base_vertex_location;
     render_ctx->all_ritems.ritems[RITEM_CAR].bounds = render_ctx->geom[GEOM_CAR].submesh_geoms[0].bounds;
+    render_ctx->all_ritems.ritems[RITEM_CAR].lod_count = render_ctx->geom[GEOM_CAR].submesh_geoms[0].lod_count;
+    memcpy(render_ctx->all_ritems.ritems[RITEM_CAR].lods, render_ctx->geom[GEOM_CAR].submesh_geoms[0].lods, sizeof(MeshLod) * MAX_LOD_COUNT);
     render_ctx->all_ritems.ritems[RITEM_CAR].n_frames_dirty = NUM_QUEUING_FRAMES;
     render_ctx->all_ritems.ritems[RITEM_CAR].mat->n_frames_dirty = NUM_QUEUING_FRAMES;
     render_ctx->all_ritems.ritems[RITEM_CAR].initialized = true;
@@ -455,6 +409,32 @@ create_render_items (D3DRenderContext * render_ctx) {
     render_ctx->highlight_ritems.ritems[0] = render_ctx->all_ritems.ritems[RITEM_PICKED];
     render_ctx->highlight_ritems.size++;
 }
+// Every render item but the highlight is pickable (by its index in all_ritems)
+static void
+create_pick_scene (D3DRenderContext * render_ctx) {
+    PickScene_Init(&render_ctx->pick_scene, _COUNT_RENDERITEM);
+    for (UINT i = 0; i < render_ctx->all_ritems.size; ++i) {
+        RenderItem const * ritem = &render_ctx->all_ritems.ritems[i];
+        if (RITEM_PICKED == i)
+            continue;
+        PickScene_AddInstance(
+            &render_ctx->pick_scene, i, ritem->world, ritem->bounds,
+            ritem->geometry->triangle_bvh, ritem->start_index_loc, ritem->index_count);
+    }
+    PickScene_BuildTopLevel(&render_ctx->pick_scene);
+}
+// The selection can hold every triangle of the largest mesh, per queuing frame
+static void
+create_selection_buffer (D3DRenderContext * render_ctx) {
+    PickSelection_Init(&render_ctx->selection, _COUNT_RENDERITEM);
+    UINT slice_size = 0;
+    for (unsigned i = 0; i < _COUNT_GEOM; i++)
+        slice_size = render_ctx->geom[i].ib_byte_size > slice_size ? render_ctx->geom[i].ib_byte_size : slice_size;
+    render_ctx->selection_ib_slice_size = slice_size;
+    create_upload_buffer(render_ctx->device, (UINT64)slice_size * NUM_QUEUING_FRAMES, &render_ctx->selection_ib_ptr, &render_ctx->selection_ib);
+    render_ctx->selection_geom.pool_vbv = &render_ctx->selection_vbv;
+    render_ctx->selection_geom.pool_ibv = &render_ctx->selection_ibv;
+}
 static void
 draw_render_items (
     ID3D12GraphicsCommandList * cmd_list,
@@ -476,10 +456,16 @@ draw_render_items (
 
             cmd_list->SetGraphicsRootConstantBufferView(0, obj_cb_address);
 
+            UINT index_count = ritem_array->ritems[i].index_count;
+            UINT start_index_loc = ritem_array->ritems[i].start_index_loc;
+            if (ritem_array->ritems[i].lod > 0) {
+                index_count = ritem_array->ritems[i].lods[ritem_array->ritems[i].lod].index_count;
+                start_index_loc = ritem_array->ritems[i].lods[ritem_array->ritems[i].lod].start_index_location;
+            }
             cmd_list->DrawIndexedInstanced(
-                ritem_array->ritems[i].index_count,
+                index_count,
                 1,
-                ritem_array->ritems[i].start_index_loc, ritem_array->ritems[i].base_vertex_loc, 0);
+                start_index_loc, ritem_array->ritems[i].base_vertex_loc, 0);
         }
     }
 }
@@ -889,7 +875,7 @@ handle_mouse_move (SceneContext * scene_ctx, WPARAM wParam, int x, int y) {
     scene_ctx->mouse.y = y;
 }
 static void
-ray_pick (int sx, int sy, int ritems_count, RenderItem ritems []) {
+ray_pick (int sx, int sy, PickScene const * pick_scene, RenderItem ritems []) {
     XMFLOAT4X4 proj = Camera_GetProj4x4f(global_camera);
 
     // -- compute (vx, vy, 1) on picking ray in view space
@@ -897,90 +883,106 @@ ray_pick (int sx, int sy, int ritems_count, RenderItem ritems []) {
     float vy = (-2.0f * sy / global_scene_ctx.height + 1.0f) / proj(1, 1);
 
     // -- define ray on viw space
-    XMVECTOR ray_origin = XMVectorSet(0.0f, 0.0f, 0.0f, 1.0f);
-    XMVECTOR ray_dir = XMVectorSet(vx, vy, 1.0f, 0.0f);
+    XMVECTOR view_ray_origin = XMVectorSet(0.0f, 0.0f, 0.0f, 1.0f);
+    XMVECTOR view_ray_dir = XMVectorSet(vx, vy, 1.0f, 0.0f);
 
     XMMATRIX view = Camera_GetView(global_camera);
     XMVECTOR det_view = XMMatrixDeterminant(view);
     XMMATRIX inv_view = XMMatrixInverse(&det_view, view);
 
+    // -- transform ray to world space (the pick scene moves it into each item's local space)
+    XMVECTOR ray_origin = XMVector3TransformCoord(view_ray_origin, inv_view);
+    XMVECTOR ray_dir = XMVector3Normalize(XMVector3TransformNormal(view_ray_dir, inv_view));
+
     // -- assume no obj is picked to start
     global_picked_ritem->visible = false;
 
-    // -- check if we picked an opague render item
-    // NOTE(omid): A real app might keep a separate "picking list" of objects that can be selected 
-    for (int i = 0; i < ritems_count; ++i) {
-        MeshGeometry * geo = ritems[i].geometry;
-
-        // -- skip invisible targets
-        if (false == ritems[i].visible)
-            continue;
-
-        XMMATRIX world = XMLoadFloat4x4(&ritems[i].world);
-        XMVECTOR det_world = XMMatrixDeterminant(world);
-        XMMATRIX inv_world = XMMatrixInverse(&det_world, world);
-
-        // -- compute matrix for transforming to local space of mesh (concat inv_view + inv_world)
-        XMMATRIX to_local = XMMatrixMultiply(inv_view, inv_world);
-
-        // -- transform ray to local space
-        ray_origin = XMVector3TransformCoord(ray_origin, to_local);
-        ray_dir = XMVector3TransformNormal(ray_dir, to_local);
-
-        // -- normalize ray dir (for intersection tests)
-        ray_dir = XMVector3Normalize(ray_dir);
-
-        /*
-            If we hit the bounding box of the mesh, then we might have picked a mesh triangle,
-            so do the ray/triangle tests.
-            
-            If we did not hit the bounding box, then it is impossible that we hit 
-            the mesh, so do not waste effort doing ray/triangle tests.
-        */
-        float tmin = 0.0f;
-        if (ritems[i].bounds.Intersects(ray_origin, ray_dir, tmin)) {
-            // NOTE(omid): for this demo we no what to cast to 
-            // but for real apps might need some metadata for book-keeping formats
-            Vertex * vertices = (Vertex *)geo->vb_cpu->GetBufferPointer();
-            uint32_t * indices = (uint32_t *)geo->ib_cpu->GetBufferPointer();
-            UINT tri_count = ritems[i].index_count / 3;
-
-            // -- find nearest ray/triangle intersection
-            tmin = FLT_MAX;
-            for (UINT j = 0; j < tri_count; ++j) {
-                // indices for this triangle
-                UINT i0 = indices[j * 3 + 0];
-                UINT i1 = indices[j * 3 + 1];
-                UINT i2 = indices[j * 3 + 2];
-
-                // vertices for this triangle
-                XMVECTOR v0 = XMLoadFloat3(&vertices[i0].position);
-                XMVECTOR v1 = XMLoadFloat3(&vertices[i1].position);
-                XMVECTOR v2 = XMLoadFloat3(&vertices[i2].position);
-
-                // -- iterate over all triagnles to find intersection
-                float t = 0.0f;
-                if (DirectX::TriangleTests::Intersects(ray_origin, ray_dir, v0, v1, v2, t)) {
-                    if (t < tmin) {
-                        tmin = t;
-                        UINT picked_triangle = j;
-
-                        global_picked_ritem->visible = true;
-                        global_picked_ritem->index_count = 3;
-                        global_picked_ritem->base_vertex_loc = 0;
-
-                        global_picked_ritem->world = ritems[i].world;
-                        global_picked_ritem->n_frames_dirty = NUM_QUEUING_FRAMES;
-
-                        // -- offset to the picked triangle in mesh index buffer
-                        global_picked_ritem->start_index_loc = 3 * picked_triangle;
-                    }
-                }
-            }
-        }
+    // -- nearest ray/triangle intersection over the pickable items (see headers/pick_scene.h)
+    PickHit hit = {};
+    hit.triangle.t = FLT_MAX;
+    if (PickScene_Intersect(pick_scene, ray_origin, ray_dir, &hit)) {
+        RenderItem const * picked = &ritems[hit.item];
+        global_picked_ritem->visible = true;
+        global_picked_ritem->geometry = picked->geometry;
+        global_picked_ritem->index_count = 3;
+        global_picked_ritem->base_vertex_loc = picked->base_vertex_loc;
+
+        global_picked_ritem->world = picked->world;
+        global_picked_ritem->n_frames_dirty = NUM_QUEUING_FRAMES;
+
+        // -- offset to the picked triangle in mesh index buffer
+        global_picked_ritem->start_index_loc = hit.triangle.index_location;
     }
+}
+// Selects the items (or with [triangles], their triangles) inside the screen rectangle (x0, y0)-(x1, y1)
+static void
+marquee_pick (int x0, int y0, int x1, int y1, bool triangles, D3DRenderContext * render_ctx) {
+    if (x0 > x1) { int x = x0; x0 = x1; x1 = x; }
+    if (y0 > y1) { int y = y0; y0 = y1; y1 = y; }
+    x1 = x1 > x0 ? x1 : x0 + 1;     // at least one pixel
+    y1 = y1 > y0 ? y1 : y0 + 1;
+    XMFLOAT4X4 proj = Camera_GetProj4x4f(global_camera);
 
-
+    // -- the rectangle's sides on the z = 1 plane in view space (as the picking ray in ray_pick)
+    float vx_left = (+2.0f * x0 / global_scene_ctx.width - 1.0f) / proj(0, 0);
+    float vx_right = (+2.0f * x1 / global_scene_ctx.width - 1.0f) / proj(0, 0);
+    float vy_top = (-2.0f * y0 / global_scene_ctx.height + 1.0f) / proj(1, 1);
+    float vy_bottom = (-2.0f * y1 / global_scene_ctx.height + 1.0f) / proj(1, 1);
+
+    // -- sub-frustum planes through the eye and the rectangle's sides, plus the camera's near and far planes
+    float near_z = Camera_GetNearZ(global_camera);
+    float far_z = Camera_GetFarZ(global_camera);
+    XMVECTOR view_planes [PICK_FRUSTUM_PLANES] = {
+        XMVectorSet(1.0f, 0.0f, -vx_left, 0.0f),
+        XMVectorSet(-1.0f, 0.0f, vx_right, 0.0f),
+        XMVectorSet(0.0f, 1.0f, -vy_bottom, 0.0f),
+        XMVectorSet(0.0f, -1.0f, vy_top, 0.0f),
+        XMVectorSet(0.0f, 0.0f, 1.0f, -near_z),
+        XMVectorSet(0.0f, 0.0f, -1.0f, far_z),
+    };
+    // -- to world space (planes go through the inverse transpose of inv_view, that is transpose(view))
+    XMMATRIX view_transpose = XMMatrixTranspose(Camera_GetView(global_camera));
+    XMFLOAT4 planes [PICK_FRUSTUM_PLANES];
+    for (UINT i = 0; i < PICK_FRUSTUM_PLANES; ++i)
+        XMStoreFloat4(&planes[i], XMPlaneTransform(view_planes[i], view_transpose));
+    PickFrustum frustum;
+    PickFrustum_Init(&frustum, planes);
+
+    int64_t begin, end, freq;
+    QueryPerformanceCounter((LARGE_INTEGER *)&begin);
+    PickScene_SelectFrustum(&render_ctx->pick_scene, &frustum, triangles, &render_ctx->selection);
+    QueryPerformanceCounter((LARGE_INTEGER *)&end);
+    QueryPerformanceFrequency((LARGE_INTEGER *)&freq);
+
+    char buf [256];
+    ::sprintf_s(buf, sizeof(buf), "[select] %u items, %u tris, %.3f ms\n",
+        render_ctx->selection.item_count, render_ctx->selection.triangle_count, (double)(end - begin) * 1000.0 / (double)freq);
+    ::OutputDebugStringA(buf);
+
+    // -- highlight the first selected item (this demo has a single pickable item): the whole
+    // item, or its selected triangles through selection_ib (see update_selection_ibuffer)
+    global_picked_ritem->visible = false;
+    if (0 == render_ctx->selection.item_count)
+        return;
+    PickSelectionItem const * selected = &render_ctx->selection.items[0];
+    RenderItem const * ritem = &render_ctx->all_ritems.ritems[selected->item];
+    global_picked_ritem->visible = true;
+    global_picked_ritem->base_vertex_loc = ritem->base_vertex_loc;
+    global_picked_ritem->world = ritem->world;
+    global_picked_ritem->n_frames_dirty = NUM_QUEUING_FRAMES;
+    if (triangles) {
+        render_ctx->selection_vbv = Mesh_GetVertexBufferView(ritem->geometry);
+        render_ctx->selection_ibv.Format = ritem->geometry->index_format;
+        render_ctx->selection_ibv.SizeInBytes = render_ctx->selection_ib_slice_size;
+        render_ctx->selection_n_frames_dirty = NUM_QUEUING_FRAMES;
+        global_picked_ritem->geometry = &render_ctx->selection_geom;
+        global_picked_ritem->index_count = 3 * selected->count;
+        global_picked_ritem->start_index_loc = 0;
+    } else {
+        global_picked_ritem->geometry = ritem->geometry;
+        global_picked_ritem->index_count = ritem->index_count;
+        global_picked_ritem->start_index_loc = ritem->start_index_loc;
+    }
 }
 static void
 handle_mouse_down (
@@ -988,15 +990,30 @@ handle_mouse_down (
     WPARAM wparam,
     int x, int y,
     HWND hwnd,
-    int ritems_count,
+    PickScene const * pick_scene,
     RenderItem ritems[]
 ) {
     if ((wparam & MK_LBUTTON) != 0) {
         scene_ctx->mouse.x = x;
         scene_ctx->mouse.y = y;
         SetCapture(hwnd);
+    } else if ((wparam & MK_RBUTTON) != 0 && (wparam & (MK_SHIFT | MK_CONTROL)) != 0) {
+        // -- marquee selection, done when the button goes up
+        scene_ctx->marquee_anchor.x = x;
+        scene_ctx->marquee_anchor.y = y;
+        scene_ctx->marquee_active = true;
+        scene_ctx->marquee_triangles = (wparam & MK_SHIFT) != 0;
+        SetCapture(hwnd);
     } else if ((wparam & MK_RBUTTON) != 0)
-        ray_pick(x, y, ritems_count, ritems);
+        ray_pick(x, y, pick_scene, ritems);
+}
+static void
+handle_mouse_up (SceneContext * scene_ctx, int x, int y, D3DRenderContext * render_ctx) {
+    if (scene_ctx->marquee_active) {
+        scene_ctx->marquee_active = false;
+        marquee_pick(scene_ctx->marquee_anchor.x, scene_ctx->marquee_anchor.y, x, y, scene_ctx->marquee_triangles, render_ctx);
+    }
+    ReleaseCapture();
 }
 
 static void
@@ -1019,9 +1036,56 @@ update_object_cbuffer (D3DRenderContext * render_ctx) {
 
             uint8_t * obj_ptr = obj_begin_ptr + (obj_cbuffer_size * render_ctx->all_ritems.ritems[i].obj_cbuffer_index);
             memcpy(obj_ptr, &data, obj_cbuffer_size);
+
+            // Next FrameResource need to be updated too.
+            render_ctx->all_ritems.ritems[i].n_frames_dirty--;
         }
     }
 }
+// Refreshes the cached picking data of the items whose transform changed (before update_object_cbuffer clears their dirty count)
+static void
+update_pick_scene (D3DRenderContext * render_ctx) {
+    PickScene * scene = &render_ctx->pick_scene;
+    for (UINT i = 0; i < scene->instance_count; ++i) {
+        PickInstance * instance = &scene->instances[i];
+        RenderItem const * ritem = &render_ctx->all_ritems.ritems[instance->item];
+        instance->pickable = ritem->visible;
+        if (ritem->n_frames_dirty > 0)
+            PickScene_UpdateTransform(scene, i, ritem->world, ritem->bounds);
+    }
+    PickScene_BuildTopLevel(scene);
+}
+// Copies the indices of the selected triangles to this frame's slice of selection_ib
+static void
+update_selection_ibuffer (D3DRenderContext * render_ctx) {
+    UINT frame_index = render_ctx->frame_index;
+    UINT slice_offset = frame_index * render_ctx->selection_ib_slice_size;
+    render_ctx->selection_ibv.BufferLocation = render_ctx->selection_ib->GetGPUVirtualAddress() + slice_offset;
+    if (render_ctx->selection_n_frames_dirty <= 0 || 0 == render_ctx->selection.item_count)
+        return;
+    PickSelectionItem const * selected = &render_ctx->selection.items[0];
+    MeshGeometry const * geom = render_ctx->all_ritems.ritems[selected->item].geometry;
+    UINT index_size = DXGI_FORMAT_R16_UINT == geom->index_format ? 2 : 4;
+    BYTE const * src = (BYTE const *)geom->ib_cpu->GetBufferPointer();
+    BYTE * dst = render_ctx->selection_ib_ptr + slice_offset;
+    for (UINT i = 0; i < selected->count; ++i) {
+        UINT index_location = render_ctx->selection.triangles[selected->first + i];
+        memcpy(dst + 3 * index_size * i, src + index_size * index_location, 3 * index_size);
+    }
+    // Next FrameResource need to be updated too.
+    render_ctx->selection_n_frames_dirty--;
+}
+// Picks the LOD of the drawn copies (opaque_ritems), all_ritems keep the full resolution mesh for picking
+static void
+update_lods (D3DRenderContext * render_ctx) {
+    XMFLOAT3 eye_pos = Camera_GetPosition3f(global_camera);
+    float lod_proj_scale = lod_projection_scale(Camera_GetProj4x4f(global_camera), (float)global_scene_ctx.height);
+    for (unsigned i = 0; i < render_ctx->opaque_ritems.size; ++i) {
+        RenderItem * ritem = &render_ctx->opaque_ritems.ritems[i];
+        ritem->lod = global_lod_enabled ?
+            select_lod(ritem->lods, ritem->lod_count, ritem->bounds, ritem->world, eye_pos, lod_proj_scale, global_lod_pixel_error) : 0;
+    }
+}
 static void
 update_mat_buffer (D3DRenderContext * render_ctx) {
     UINT frame_index = render_ctx->frame_index;
@@ -1491,14 +1555,15 @@ main_win_cb (HWND hwnd, UINT uMsg, WPARAM wParam, LPARAM lParam) {
             wParam,
             GET_X_LPARAM(lParam), GET_Y_LPARAM(lParam),
             hwnd,
-            _render_ctx->opaque_ritems.size,
-            _render_ctx->opaque_ritems.ritems
+            &_render_ctx->pick_scene,
+            _render_ctx->all_ritems.ritems
         );
     } break;
     case WM_LBUTTONUP:
     case WM_MBUTTONUP:
     case WM_RBUTTONUP: {
-        ReleaseCapture();
+        _ASSERT_EXPR(_render_ctx, _T("Uninitialized render context!"));
+        handle_mouse_up(&global_scene_ctx, GET_X_LPARAM(lParam), GET_Y_LPARAM(lParam), _render_ctx);
     } break;
     case WM_MOUSEMOVE: {
         handle_mouse_move(&global_scene_ctx, wParam, GET_X_LPARAM(lParam), GET_Y_LPARAM(lParam));
@@ -1813,6 +1878,8 @@ WinMain(_In_ HINSTANCE hInstance, _In_opt_ HINSTANCE, _In_ LPSTR, _In_ INT) {
     create_car_geometry(render_ctx);
     create_materials(render_ctx->materials);
     create_render_items(render_ctx);
+    create_pick_scene(render_ctx);
+    create_selection_buffer(render_ctx);
 
 #pragma endregion 
 
@@ -1916,7 +1983,10 @@ WinMain(_In_ HINSTANCE hInstance, _In_opt_ HINSTANCE, _In_ LPSTR, _In_ INT) {
                 handle_keyboard_input(&global_scene_ctx, &global_timer);
                 update_mat_buffer(render_ctx);
                 update_pass_cbuffers(render_ctx, &global_timer);
+                update_pick_scene(render_ctx);
                 update_object_cbuffer(render_ctx);
+                update_selection_ibuffer(render_ctx);
+                update_lods(render_ctx);
 
                 draw_main(render_ctx);
 
@@ -1946,7 +2016,12 @@ WinMain(_In_ HINSTANCE hInstance, _In_opt_ HINSTANCE, _In_ LPSTR, _In_ INT) {
     CloseHandle(render_ctx->fence_event);
     render_ctx->fence->Release();
 
+    PickScene_Release(&render_ctx->pick_scene);
+    PickSelection_Release(&render_ctx->selection);
+    render_ctx->selection_ib->Unmap(0, nullptr);
+    render_ctx->selection_ib->Release();
     for (unsigned i = 0; i < _COUNT_GEOM; i++) {
+        Mesh_ReleaseTriangleBvh(&render_ctx->geom[i]);
         render_ctx->geom[i].ib_uploader->Release();
         render_ctx->geom[i].vb_uploader->Release();
         render_ctx->geom[i].vb_gpu->Release();
@@ -0,0 +1,368 @@
+/* ===========================================================
+   #File: pick_query.h #
+   #Date: 17 Oct 2026 #
+   #Revision: 1.0 #
+   #Creator: Omid Miresmaeili #
+   #Description: batched ray queries against the pick scene (sorted rays, packet traversal) #
+   #Notice: (C) Copyright 2021 by Omid. All Rights Reserved. #
+   =========================================================== */
+#pragma once
+
+#include "common.h"
+#include "pick_scene.h"
+
+using namespace DirectX;
+
+//
+// Batched pick queries
+//
+// Many rays per frame against a PickScene (hover previews, line of sight, traces). The rays
+// are sorted by a key of their direction octant and the Morton code of their origin, so
+// neighbours in the sorted order start close together and go the same way. Runs of up to
+// PICK_PACKET_SIZE sorted rays in one octant, whose directions stay within PICK_PACKET_MIN_COS
+// of the run's first ray, are traced as a packet: each node is fetched once for the whole
+// packet and its box tested against all the lanes still inside it at once (8 lanes with AVX2,
+// two times 4 with SSE), and children are visited in the order the packet's octant crosses
+// them. Rays that do not fit in a packet are traced one by one with PickScene_Intersect.
+// Hits come back in the caller's order.
+//
+#define PICK_PACKET_SIZE        RAY_TRI_LANES
+#define PICK_PACKET_MIN_COS     0.95f       // about 18 degrees between a packet's rays
+#define PICK_MORTON_BITS        9           // per axis of the origin in the sort key (below the 3 octant bits)
+#define PICK_NO_HIT             UINT_MAX    // instance and item of a ray that hit nothing
+
+struct PickQuery {
+    UINT    capacity;
+    UINT *  keys;
+    UINT *  order;              // ray indices in sorted order
+    UINT *  sort_keys;          // radix sort scratch
+    UINT *  sort_order;
+
+    // Last run
+    UINT    packet_count;       // packets of two rays or more
+    UINT    packet_ray_count;   // rays traced in them
+    UINT    single_ray_count;   // rays traced one by one
+};
+// Up to PICK_PACKET_SIZE rays in one space (world, or the local space of an instance)
+struct PickPacket {
+    UINT            count;
+    UINT            ray [PICK_PACKET_SIZE];         // index in the batch
+    XMFLOAT3        origin [PICK_PACKET_SIZE];
+    XMFLOAT3        dir [PICK_PACKET_SIZE];
+    RayTriangleHit  hit [PICK_PACKET_SIZE];         // t is the nearest hit so far (or the ray's t_max)
+
+    // The same rays swizzled for the box tests (t mirrors hit[].t)
+    float           origin_x [PICK_PACKET_SIZE];
+    float           origin_y [PICK_PACKET_SIZE];
+    float           origin_z [PICK_PACKET_SIZE];
+    float           inv_dir_x [PICK_PACKET_SIZE];
+    float           inv_dir_y [PICK_PACKET_SIZE];
+    float           inv_dir_z [PICK_PACKET_SIZE];
+    float           t [PICK_PACKET_SIZE];
+};
+struct PickPacketTask {
+    UINT    node;
+    UINT    mask;               // lanes that entered the parent
+};
+
+static void
+PickQuery_Init (PickQuery * query, UINT capacity) {
+    *query = {};
+    query->capacity = capacity;
+    query->keys = (UINT *)::malloc(sizeof(UINT) * capacity);
+    query->order = (UINT *)::malloc(sizeof(UINT) * capacity);
+    query->sort_keys = (UINT *)::malloc(sizeof(UINT) * capacity);
+    query->sort_order = (UINT *)::malloc(sizeof(UINT) * capacity);
+}
+inline void
+PickQuery_Release (PickQuery * query) {
+    ::free(query->keys);
+    ::free(query->order);
+    ::free(query->sort_keys);
+    ::free(query->sort_order);
+    *query = {};
+}
+
+inline UINT
+pick_lowest_lane (UINT mask) {
+#if defined(_MSC_VER)
+    unsigned long lane;
+    _BitScanForward(&lane, (unsigned long)mask);
+    return (UINT)lane;
+#else
+    return (UINT)__builtin_ctz(mask);
+#endif
+}
+// Spreads the low 10 bits of [v] to every third bit
+inline UINT
+pick_morton_spread (UINT v) {
+    v = (v | (v << 16)) & 0x030000ff;
+    v = (v | (v << 8)) & 0x0300f00f;
+    v = (v | (v << 4)) & 0x030c30c3;
+    v = (v | (v << 2)) & 0x09249249;
+    return v;
+}
+inline UINT
+pick_octant (XMFLOAT3 const & dir) {
+    return (dir.x < 0.0f ? 1u : 0u) | (dir.y < 0.0f ? 2u : 0u) | (dir.z < 0.0f ? 4u : 0u);
+}
+// Sorts [order] by [keys] (both reordered), least significant byte first
+static void
+pick_radix_sort (UINT * keys, UINT * order, UINT * scratch_keys, UINT * scratch_order, UINT count) {
+    for (UINT shift = 0; shift < 32; shift += 8) {
+        UINT offsets [256] = {};
+        for (UINT i = 0; i < count; ++i)
+            ++offsets[(keys[i] >> shift) & 0xff];
+        UINT sum = 0;
+        for (UINT b = 0; b < 256; ++b) {
+            UINT n = offsets[b];
+            offsets[b] = sum;
+            sum += n;
+        }
+        for (UINT i = 0; i < count; ++i) {
+            UINT dst = offsets[(keys[i] >> shift) & 0xff]++;
+            scratch_keys[dst] = keys[i];
+            scratch_order[dst] = order[i];
+        }
+        UINT * tmp = keys; keys = scratch_keys; scratch_keys = tmp;
+        tmp = order; order = scratch_order; scratch_order = tmp;
+    }
+    // four passes: the result is back in the caller's arrays
+}
+inline void
+pick_packet_set_lane (PickPacket * packet, UINT lane, XMFLOAT3 const & origin, XMFLOAT3 const & dir, float t) {
+    packet->origin[lane] = origin;
+    packet->dir[lane] = dir;
+    packet->hit[lane].t = t;
+    packet->origin_x[lane] = origin.x;
+    packet->origin_y[lane] = origin.y;
+    packet->origin_z[lane] = origin.z;
+    packet->inv_dir_x[lane] = 1.0f / dir.x;     // +-inf on axis aligned rays
+    packet->inv_dir_y[lane] = 1.0f / dir.y;
+    packet->inv_dir_z[lane] = 1.0f / dir.z;
+    packet->t[lane] = t;
+}
+// Lanes of [mask] entering the box before their nearest hit
+static UINT
+pick_packet_box_mask_sse (PickPacket const * packet, UINT mask, XMFLOAT3 const & mn, XMFLOAT3 const & mx) {
+    UINT inside = 0;
+    for (UINT base = 0; base < PICK_PACKET_SIZE; base += 4) {
+        if (0 == ((mask >> base) & 0xf))
+            continue;
+        __m128 ox = _mm_loadu_ps(packet->origin_x + base), ix = _mm_loadu_ps(packet->inv_dir_x + base);
+        __m128 oy = _mm_loadu_ps(packet->origin_y + base), iy = _mm_loadu_ps(packet->inv_dir_y + base);
+        __m128 oz = _mm_loadu_ps(packet->origin_z + base), iz = _mm_loadu_ps(packet->inv_dir_z + base);
+        __m128 t = _mm_loadu_ps(packet->t + base);
+        __m128 tx1 = _mm_mul_ps(_mm_sub_ps(_mm_set1_ps(mn.x), ox), ix), tx2 = _mm_mul_ps(_mm_sub_ps(_mm_set1_ps(mx.x), ox), ix);
+        __m128 ty1 = _mm_mul_ps(_mm_sub_ps(_mm_set1_ps(mn.y), oy), iy), ty2 = _mm_mul_ps(_mm_sub_ps(_mm_set1_ps(mx.y), oy), iy);
+        __m128 tz1 = _mm_mul_ps(_mm_sub_ps(_mm_set1_ps(mn.z), oz), iz), tz2 = _mm_mul_ps(_mm_sub_ps(_mm_set1_ps(mx.z), oz), iz);
+        __m128 t_enter = _mm_max_ps(_mm_max_ps(_mm_min_ps(tx1, tx2), _mm_min_ps(ty1, ty2)), _mm_max_ps(_mm_min_ps(tz1, tz2), _mm_setzero_ps()));
+        __m128 t_exit = _mm_min_ps(_mm_min_ps(_mm_max_ps(tx1, tx2), _mm_max_ps(ty1, ty2)), _mm_min_ps(_mm_max_ps(tz1, tz2), t));
+        __m128 enters = _mm_and_ps(_mm_cmple_ps(t_enter, t_exit), _mm_cmplt_ps(t_enter, t));
+        inside |= (UINT)_mm_movemask_ps(enters) << base;
+    }
+    return inside & mask;
+}
+RAY_TRI_AVX2_FUNCTION static UINT
+pick_packet_box_mask_avx2 (PickPacket const * packet, UINT mask, XMFLOAT3 const & mn, XMFLOAT3 const & mx) {
+    __m256 ox = _mm256_loadu_ps(packet->origin_x), ix = _mm256_loadu_ps(packet->inv_dir_x);
+    __m256 oy = _mm256_loadu_ps(packet->origin_y), iy = _mm256_loadu_ps(packet->inv_dir_y);
+    __m256 oz = _mm256_loadu_ps(packet->origin_z), iz = _mm256_loadu_ps(packet->inv_dir_z);
+    __m256 t = _mm256_loadu_ps(packet->t);
+    __m256 tx1 = _mm256_mul_ps(_mm256_sub_ps(_mm256_set1_ps(mn.x), ox), ix), tx2 = _mm256_mul_ps(_mm256_sub_ps(_mm256_set1_ps(mx.x), ox), ix);
+    __m256 ty1 = _mm256_mul_ps(_mm256_sub_ps(_mm256_set1_ps(mn.y), oy), iy), ty2 = _mm256_mul_ps(_mm256_sub_ps(_mm256_set1_ps(mx.y), oy), iy);
+    __m256 tz1 = _mm256_mul_ps(_mm256_sub_ps(_mm256_set1_ps(mn.z), oz), iz), tz2 = _mm256_mul_ps(_mm256_sub_ps(_mm256_set1_ps(mx.z), oz), iz);
+    __m256 t_enter = _mm256_max_ps(_mm256_max_ps(_mm256_min_ps(tx1, tx2), _mm256_min_ps(ty1, ty2)), _mm256_max_ps(_mm256_min_ps(tz1, tz2), _mm256_setzero_ps()));
+    __m256 t_exit = _mm256_min_ps(_mm256_min_ps(_mm256_max_ps(tx1, tx2), _mm256_max_ps(ty1, ty2)), _mm256_min_ps(_mm256_max_ps(tz1, tz2), t));
+    __m256 enters = _mm256_and_ps(_mm256_cmp_ps(t_enter, t_exit, _CMP_LE_OQ), _mm256_cmp_ps(t_enter, t, _CMP_LT_OQ));
+    return (UINT)_mm256_movemask_ps(enters) & mask;
+}
+inline UINT
+pick_packet_box_mask (PickPacket const * packet, UINT mask, XMFLOAT3 const & mn, XMFLOAT3 const & mx) {
+    if (ray_tri_cpu_has_avx2())
+        return pick_packet_box_mask_avx2(packet, mask, mn, mx);
+    return pick_packet_box_mask_sse(packet, mask, mn, mx);
+}
+// Child of an internal node a packet going along [dir] meets first: the lower one along the axis
+// their centers are furthest apart on if the rays go up that axis, else the upper one
+inline UINT
+pick_packet_near_child (TriangleBvhNode const * nodes, UINT child, XMFLOAT3 const & dir) {
+    TriangleBvhNode const * a = &nodes[child];
+    TriangleBvhNode const * b = &nodes[child + 1];
+    float dx = (b->aabb_min.x + b->aabb_max.x) - (a->aabb_min.x + a->aabb_max.x);
+    float dy = (b->aabb_min.y + b->aabb_max.y) - (a->aabb_min.y + a->aabb_max.y);
+    float dz = (b->aabb_min.z + b->aabb_max.z) - (a->aabb_min.z + a->aabb_max.z);
+    float along = fabsf(dx) >= fabsf(dy) && fabsf(dx) >= fabsf(dz) ? dx * dir.x : (fabsf(dy) >= fabsf(dz) ? dy * dir.y : dz * dir.z);
+    return along >= 0.0f ? child : child + 1;
+}
+// Traces the lanes of [mask] through the triangle BVH (triangles in [first_index, first_index +
+// index_count) only). Returns the lanes whose hit was updated.
+static UINT
+pick_packet_triangles (TriangleBvh const * bvh, PickPacket * packet, UINT mask, UINT first_index, UINT index_count) {
+    if (0 == bvh->node_count)
+        return 0;
+    UINT hit_mask = 0;
+    PickPacketTask stack [TRI_BVH_STACK_SIZE];
+    UINT top = 0;
+    stack[top++] = {0, mask};
+    while (top > 0) {
+        PickPacketTask task = stack[--top];
+        TriangleBvhNode const * node = &bvh->nodes[task.node];
+        UINT node_mask = pick_packet_box_mask(packet, task.mask, node->aabb_min, node->aabb_max);
+        if (0 == node_mask)
+            continue;
+        if (node->tri_count > 0) {
+            RayTriangleBlock const * block = &bvh->blocks[node->first];
+            int lane_mask = 0;
+            for (UINT lane = 0; lane < node->tri_count; ++lane)
+                if (block->index_location[lane] - first_index < index_count)
+                    lane_mask |= 1 << lane;
+            if (0 == lane_mask)
+                continue;
+            for (UINT m = node_mask; m; m &= m - 1) {
+                UINT lane = pick_lowest_lane(m);
+                if (RayTriangleBlock_Intersect(block, packet->origin[lane], packet->dir[lane], lane_mask, &packet->hit[lane])) {
+                    packet->t[lane] = packet->hit[lane].t;
+                    hit_mask |= 1u << lane;
+                }
+            }
+            continue;
+        }
+        UINT near_child = pick_packet_near_child(bvh->nodes, node->first, packet->dir[pick_lowest_lane(node_mask)]);
+        _ASSERT_EXPR(top + 2 <= TRI_BVH_STACK_SIZE, _T("triangle BVH traversal stack overflow"));
+        stack[top++] = {near_child == node->first ? node->first + 1 : node->first, node_mask};
+        stack[top++] = {near_child, node_mask};
+    }
+    return hit_mask;
+}
+// Traces a world space packet through the pick scene into [hits] (indexed by PickPacket::ray)
+static void
+pick_packet_scene (PickScene const * scene, PickPacket * packet, PickHit * hits) {
+    UINT all = (1u << packet->count) - 1;
+    PickPacketTask stack [TRI_BVH_STACK_SIZE];
+    UINT top = 0;
+    if (scene->node_count > 0)
+        stack[top++] = {0, all};
+    while (top > 0) {
+        PickPacketTask task = stack[--top];
+        TriangleBvhNode const * node = &scene->nodes[task.node];
+        UINT node_mask = pick_packet_box_mask(packet, task.mask, node->aabb_min, node->aabb_max);
+        if (0 == node_mask)
+            continue;
+        if (node->tri_count > 0) {
+            for (UINT i = node->first; i < node->first + node->tri_count; ++i) {
+                UINT instance = scene->order[i];
+                PickInstance const * inst = &scene->instances[instance];
+                if (!inst->pickable)
+                    continue;
+                UINT inst_mask = pick_packet_box_mask(packet, node_mask, inst->aabb_min, inst->aabb_max);
+                if (0 == inst_mask)
+                    continue;
+                // -- the lanes in the instance's local space, distances scaled to it
+                PickPacket local = {};
+                local.count = packet->count;
+                float scale [PICK_PACKET_SIZE];
+                for (UINT m = inst_mask; m; m &= m - 1) {
+                    UINT lane = pick_lowest_lane(m);
+                    XMVECTOR local_origin, local_dir;
+                    scale[lane] = pick_local_ray(inst, XMLoadFloat3(&packet->origin[lane]), XMLoadFloat3(&packet->dir[lane]), &local_origin, &local_dir);
+                    if (scale[lane] <= 0.0f) {
+                        inst_mask &= ~(1u << lane);
+                        continue;
+                    }
+                    XMFLOAT3 o, d;
+                    XMStoreFloat3(&o, local_origin);
+                    XMStoreFloat3(&d, local_dir);
+                    pick_packet_set_lane(&local, lane, o, d, FLT_MAX == packet->hit[lane].t ? FLT_MAX : packet->hit[lane].t * scale[lane]);
+                }
+                UINT hit_mask = pick_packet_triangles(inst->blas, &local, inst_mask, inst->first_index, inst->index_count);
+                for (UINT m = hit_mask; m; m &= m - 1) {
+                    UINT lane = pick_lowest_lane(m);
+                    packet->hit[lane] = local.hit[lane];
+                    packet->hit[lane].t = local.hit[lane].t / scale[lane];
+                    packet->t[lane] = packet->hit[lane].t;
+                    hits[packet->ray[lane]].instance = instance;
+                    hits[packet->ray[lane]].item = inst->item;
+                }
+            }
+            continue;
+        }
+        UINT near_child = pick_packet_near_child(scene->nodes, node->first, packet->dir[pick_lowest_lane(node_mask)]);
+        _ASSERT_EXPR(top + 2 <= TRI_BVH_STACK_SIZE, _T("pick scene traversal stack overflow"));
+        stack[top++] = {near_child == node->first ? node->first + 1 : node->first, node_mask};
+        stack[top++] = {near_child, node_mask};
+    }
+    for (UINT lane = 0; lane < packet->count; ++lane)
+        hits[packet->ray[lane]].triangle = packet->hit[lane];
+}
+// Nearest hits of [count] world space rays (normalized directions) within their [t_max] with
+// the pickable instances of [scene]. hits[i] is the hit of ray i; a ray that hits nothing gets
+// instance and item PICK_NO_HIT and t = t_max[i].
+static void
+PickQuery_Run (
+    PickQuery * query, PickScene const * scene, UINT count,
+    XMFLOAT3 const * origins, XMFLOAT3 const * dirs, float const * t_max, PickHit * hits
+) {
+    _ASSERT_EXPR(count <= query->capacity, _T("too many rays for the pick query"));
+    query->packet_count = 0;
+    query->packet_ray_count = 0;
+    query->single_ray_count = 0;
+    if (0 == count)
+        return;
+
+    // -- sort keys: direction octant, then the Morton code of the origin within the origins' bounds
+    XMFLOAT3 mn = origins[0], mx = origins[0];
+    for (UINT i = 1; i < count; ++i)
+        tri_bvh_grow(&mn, &mx, origins[i], origins[i]);
+    float const cells = (float)((1u << PICK_MORTON_BITS) - 1);
+    XMFLOAT3 cell_scale = XMFLOAT3(
+        mx.x > mn.x ? cells / (mx.x - mn.x) : 0.0f,
+        mx.y > mn.y ? cells / (mx.y - mn.y) : 0.0f,
+        mx.z > mn.z ? cells / (mx.z - mn.z) : 0.0f);
+    for (UINT i = 0; i < count; ++i) {
+        UINT x = (UINT)((origins[i].x - mn.x) * cell_scale.x);
+        UINT y = (UINT)((origins[i].y - mn.y) * cell_scale.y);
+        UINT z = (UINT)((origins[i].z - mn.z) * cell_scale.z);
+        UINT morton = pick_morton_spread(x) | (pick_morton_spread(y) << 1) | (pick_morton_spread(z) << 2);
+        query->keys[i] = (pick_octant(dirs[i]) << (3 * PICK_MORTON_BITS)) | morton;
+        query->order[i] = i;
+
+        hits[i] = {};
+        hits[i].triangle.t = t_max[i];
+        hits[i].triangle.index_location = PICK_NO_HIT;
+        hits[i].instance = PICK_NO_HIT;
+        hits[i].item = PICK_NO_HIT;
+    }
+    pick_radix_sort(query->keys, query->order, query->sort_keys, query->sort_order, count);
+
+    // -- runs of coherent rays as packets, the rest one by one
+    UINT first = 0;
+    while (first < count) {
+        UINT lead = query->order[first];
+        UINT octant = query->keys[first] >> (3 * PICK_MORTON_BITS);
+        XMVECTOR lead_dir = XMLoadFloat3(&dirs[lead]);
+        UINT end = first + 1;
+        while (end < count && end - first < PICK_PACKET_SIZE &&
+            query->keys[end] >> (3 * PICK_MORTON_BITS) == octant &&
+            XMVectorGetX(XMVector3Dot(lead_dir, XMLoadFloat3(&dirs[query->order[end]]))) >= PICK_PACKET_MIN_COS)
+            ++end;
+
+        if (1 == end - first) {
+            PickScene_Intersect(scene, XMLoadFloat3(&origins[lead]), lead_dir, &hits[lead]);
+            ++query->single_ray_count;
+        } else {
+            PickPacket packet = {};
+            packet.count = end - first;
+            for (UINT lane = 0; lane < packet.count; ++lane) {
+                UINT ray = query->order[first + lane];
+                packet.ray[lane] = ray;
+                packet.hit[lane] = hits[ray].triangle;
+                pick_packet_set_lane(&packet, lane, origins[ray], dirs[ray], t_max[ray]);
+            }
+            pick_packet_scene(scene, &packet, hits);
+            ++query->packet_count;
+            query->packet_ray_count += packet.count;
+        }
+        first = end;
+    }
+}
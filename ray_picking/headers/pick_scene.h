@@ -0,0 +1,200 @@
+/* ===========================================================
+   #File: pick_scene.h #
+   #Date: 17 Oct 2026 #
+   #Revision: 1.0 #
+   #Creator: Omid Miresmaeili #
+   #Description: two level ray picking structure over render items (top level BVH over triangle BVHs) #
+   #Notice: (C) Copyright 2021 by Omid. All Rights Reserved. #
+   =========================================================== */
+#pragma once
+
+#include "common.h"
+#include "triangle_bvh.h"
+
+using namespace DirectX;
+
+//
+// Pick scene
+//
+// One instance per pickable render item: its world space bounds, its inverse world matrix
+// and the triangle BVH of its mesh (the bottom level, shared by every item drawing that
+// mesh). The inverse and the bounds are cached and only recomputed when the item's world
+// matrix changes; the top level BVH over the world bounds is rebuilt when any of them moved.
+// A world space ray walks the top level, is moved into the local space of the instances
+// whose bounds it enters with the cached inverses, and walks their triangle BVHs; distances
+// are kept in world units so the nearest hit over all the instances wins.
+//
+struct PickInstance {
+    XMFLOAT4X4          world;          // the transform the cached data was computed from
+    XMFLOAT4X4          inv_world;
+    XMFLOAT3            aabb_min;       // world space bounds
+    XMFLOAT3            aabb_max;
+    TriangleBvh const * blas;           // triangle BVH of the item's mesh
+    UINT                first_index;    // the item's triangles in the mesh index buffer
+    UINT                index_count;
+    UINT                item;           // caller's id of the item
+    bool                pickable;
+};
+struct PickScene {
+    PickInstance *      instances;
+    UINT                instance_count;
+    UINT                capacity;
+    TriangleBvhNode *   nodes;          // top level, leaves cover order[first, first + tri_count)
+    UINT                node_count;
+    UINT *              order;          // instance indices in leaf order
+    bool                dirty;          // bounds changed since the top level was built
+};
+struct PickHit {
+    RayTriangleHit      triangle;       // t in world units
+    UINT                instance;
+    UINT                item;           // PickInstance::item of the instance
+};
+
+static void
+PickScene_Init (PickScene * scene, UINT capacity) {
+    *scene = {};
+    scene->capacity = capacity;
+    scene->instances = (PickInstance *)::calloc(capacity, sizeof(PickInstance));
+    scene->nodes = (TriangleBvhNode *)::calloc(2 * capacity - 1, sizeof(TriangleBvhNode));
+    scene->order = (UINT *)::calloc(capacity, sizeof(UINT));
+}
+inline void
+PickScene_Release (PickScene * scene) {
+    ::free(scene->instances);
+    ::free(scene->nodes);
+    ::free(scene->order);
+    *scene = {};
+}
+// Recomputes the cached inverse and world bounds of [instance] if [world] differs from the
+// matrix they were computed from. Returns true if they were.
+static bool
+PickScene_UpdateTransform (PickScene * scene, UINT instance, XMFLOAT4X4 const & world, BoundingBox const & local_bounds) {
+    PickInstance * inst = &scene->instances[instance];
+    if (0 == ::memcmp(&inst->world, &world, sizeof(XMFLOAT4X4)))
+        return false;
+    inst->world = world;
+    XMMATRIX w = XMLoadFloat4x4(&world);
+    XMVECTOR det = XMMatrixDeterminant(w);
+    XMStoreFloat4x4(&inst->inv_world, XMMatrixInverse(&det, w));
+
+    BoundingBox world_bounds;
+    local_bounds.Transform(world_bounds, w);
+    XMVECTOR center = XMLoadFloat3(&world_bounds.Center);
+    XMVECTOR extents = XMLoadFloat3(&world_bounds.Extents);
+    XMStoreFloat3(&inst->aabb_min, center - extents);
+    XMStoreFloat3(&inst->aabb_max, center + extents);
+    scene->dirty = true;
+    return true;
+}
+// Adds a pickable item drawing [index_count] indices from [first_index] of the mesh of [blas]; returns its instance
+static UINT
+PickScene_AddInstance (
+    PickScene * scene, UINT item, XMFLOAT4X4 const & world, BoundingBox const & local_bounds,
+    TriangleBvh const * blas, UINT first_index, UINT index_count
+) {
+    _ASSERT_EXPR(scene->instance_count < scene->capacity, _T("pick scene is full"));
+    _ASSERT_EXPR(blas, _T("pickable geometry needs a triangle BVH"));
+    UINT instance = scene->instance_count++;
+    PickInstance * inst = &scene->instances[instance];
+    *inst = {};
+    inst->blas = blas;
+    inst->first_index = first_index;
+    inst->index_count = index_count;
+    inst->item = item;
+    inst->pickable = true;
+    inst->world.m[0][0] = NAN;      // never equal, so the transform below is cached
+    PickScene_UpdateTransform(scene, instance, world, local_bounds);
+    return instance;
+}
+// Rebuilds the top level BVH if any instance moved since the last build
+static void
+PickScene_BuildTopLevel (PickScene * scene) {
+    if (!scene->dirty)
+        return;
+    scene->dirty = false;
+    scene->node_count = 0;
+    if (0 == scene->instance_count)
+        return;
+    TriBvhBuildRef * refs = (TriBvhBuildRef *)::malloc(sizeof(TriBvhBuildRef) * scene->instance_count);
+    for (UINT i = 0; i < scene->instance_count; ++i) {
+        PickInstance const * inst = &scene->instances[i];
+        refs[i].aabb_min = inst->aabb_min;
+        refs[i].aabb_max = inst->aabb_max;
+        refs[i].centroid = XMFLOAT3(
+            0.5f * (inst->aabb_min.x + inst->aabb_max.x),
+            0.5f * (inst->aabb_min.y + inst->aabb_max.y),
+            0.5f * (inst->aabb_min.z + inst->aabb_max.z));
+        refs[i].triangle = i;
+    }
+    scene->node_count = tri_bvh_build_nodes(refs, scene->instance_count, scene->nodes);
+    for (UINT i = 0; i < scene->instance_count; ++i)
+        scene->order[i] = refs[i].triangle;
+    ::free(refs);
+}
+// Moves the world space ray into the local space of [inst] (local_dir normalized). Returns the
+// local length of one world unit along the ray (0 for a degenerate transform).
+inline float
+pick_local_ray (PickInstance const * inst, FXMVECTOR origin, FXMVECTOR dir, XMVECTOR * local_origin, XMVECTOR * local_dir) {
+    XMMATRIX inv_world = XMLoadFloat4x4(&inst->inv_world);
+    *local_origin = XMVector3TransformCoord(origin, inv_world);
+    XMVECTOR d = XMVector3TransformNormal(dir, inv_world);
+    float scale = XMVectorGetX(XMVector3Length(d));
+    if (scale > 0.0f)
+        *local_dir = d * (1.0f / scale);
+    return scale;
+}
+// Nearest hit of the world space ray (origin, normalized dir) with the pickable instances,
+// closer than io_hit->triangle.t. On a hit, overwrites [io_hit] and returns true.
+static bool
+PickScene_Intersect (PickScene const * scene, FXMVECTOR origin, FXMVECTOR dir, PickHit * io_hit) {
+    if (0 == scene->node_count)
+        return false;
+    XMFLOAT3 o, d;
+    XMStoreFloat3(&o, origin);
+    XMStoreFloat3(&d, dir);
+    XMFLOAT3 inv_dir = XMFLOAT3(1.0f / d.x, 1.0f / d.y, 1.0f / d.z);
+
+    bool hit = false;
+    UINT stack [TRI_BVH_STACK_SIZE];
+    UINT top = 0;
+    if (tri_bvh_ray_node(&scene->nodes[0], o, inv_dir, io_hit->triangle.t) < io_hit->triangle.t)
+        stack[top++] = 0;
+    while (top > 0) {
+        TriangleBvhNode const * node = &scene->nodes[stack[--top]];
+        if (node->tri_count > 0) {
+            for (UINT i = node->first; i < node->first + node->tri_count; ++i) {
+                UINT instance = scene->order[i];
+                PickInstance const * inst = &scene->instances[instance];
+                if (!inst->pickable || tri_bvh_ray_box(inst->aabb_min, inst->aabb_max, o, inv_dir, io_hit->triangle.t) >= io_hit->triangle.t)
+                    continue;
+                // -- local space ray; [scale] turns world distances into local ones
+                XMVECTOR local_origin, local_dir;
+                float scale = pick_local_ray(inst, origin, dir, &local_origin, &local_dir);
+                if (scale <= 0.0f)
+                    continue;
+                RayTriangleHit local_hit = {};
+                local_hit.t = FLT_MAX == io_hit->triangle.t ? FLT_MAX : io_hit->triangle.t * scale;
+                if (TriangleBvh_Intersect(inst->blas, local_origin, local_dir, inst->first_index, inst->index_count, &local_hit)) {
+                    io_hit->triangle = local_hit;
+                    io_hit->triangle.t = local_hit.t / scale;
+                    io_hit->instance = instance;
+                    io_hit->item = inst->item;
+                    hit = true;
+                }
+            }
+            continue;
+        }
+        // -- near child first, children entered beyond the nearest hit dropped
+        UINT child = node->first;
+        float t0 = tri_bvh_ray_node(&scene->nodes[child], o, inv_dir, io_hit->triangle.t);
+        float t1 = tri_bvh_ray_node(&scene->nodes[child + 1], o, inv_dir, io_hit->triangle.t);
+        UINT near_child = t0 <= t1 ? child : child + 1;
+        float t_far = t0 <= t1 ? t1 : t0;
+        _ASSERT_EXPR(top + 2 <= TRI_BVH_STACK_SIZE, _T("pick scene traversal stack overflow"));
+        if (t_far < io_hit->triangle.t)
+            stack[top++] = near_child == child ? child + 1 : child;
+        if (fminf(t0, t1) < io_hit->triangle.t)
+            stack[top++] = near_child;
+    }
+    return hit;
+}
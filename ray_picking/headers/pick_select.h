@@ -0,0 +1,273 @@
+/* ===========================================================
+   #File: pick_select.h #
+   #Date: 17 Oct 2026 #
+   #Revision: 1.0 #
+   #Creator: Omid Miresmaeili #
+   #Description: marquee selection of pick scene items and triangles with a frustum #
+   #Notice: (C) Copyright 2021 by Omid. All Rights Reserved. #
+   =========================================================== */
+#pragma once
+
+#include "common.h"
+#include "pick_scene.h"
+
+using namespace DirectX;
+
+//
+// Marquee selection
+//
+// A screen rectangle becomes a sub-frustum of the camera (six planes, see marquee_pick in the
+// demo). The frustum walks the top level of the pick scene against the world bounds; each
+// instance it touches gets the planes moved into its local space and walks its triangle BVH.
+// Nodes and instances entirely inside the frustum take all their triangles without tests, the
+// leaves it only crosses test their 8 triangles at once. Like the box tests, a triangle is only
+// rejected when one plane has all three corners outside, so triangles just past a corner of
+// the frustum can be accepted; no depth test is done, hidden triangles are selected too.
+//
+#define PICK_FRUSTUM_PLANES     6
+
+enum PICK_CLASSIFY : int {
+    PICK_OUTSIDE = 0,
+    PICK_INTERSECTS = 1,
+    PICK_INSIDE = 2,
+};
+// Planes (n, w) keeping the points with dot(n, p) + w >= 0, swizzled for the triangle tests
+struct PickFrustum {
+    float   plane_x [PICK_FRUSTUM_PLANES];
+    float   plane_y [PICK_FRUSTUM_PLANES];
+    float   plane_z [PICK_FRUSTUM_PLANES];
+    float   plane_w [PICK_FRUSTUM_PLANES];
+};
+struct PickSelectionItem {
+    UINT    instance;
+    UINT    item;               // PickInstance::item
+    UINT    first;              // its triangles are PickSelection::triangles[first, first + count)
+    UINT    count;
+};
+struct PickSelection {
+    PickSelectionItem * items;
+    UINT                item_count;
+    UINT                item_capacity;
+    UINT *              triangles;          // index location (first index) of the selected triangles
+    UINT                triangle_count;
+    UINT                triangle_capacity;
+};
+
+static void
+PickSelection_Init (PickSelection * sel, UINT item_capacity) {
+    *sel = {};
+    sel->item_capacity = item_capacity;
+    sel->items = (PickSelectionItem *)::calloc(item_capacity, sizeof(PickSelectionItem));
+}
+inline void
+PickSelection_Release (PickSelection * sel) {
+    ::free(sel->items);
+    ::free(sel->triangles);
+    *sel = {};
+}
+inline void
+pick_selection_reserve (PickSelection * sel, UINT extra) {
+    if (sel->triangle_count + extra <= sel->triangle_capacity)
+        return;
+    UINT capacity = sel->triangle_capacity ? sel->triangle_capacity : 1024;
+    while (capacity < sel->triangle_count + extra)
+        capacity *= 2;
+    sel->triangles = (UINT *)::realloc(sel->triangles, sizeof(UINT) * capacity);
+    sel->triangle_capacity = capacity;
+}
+inline void
+PickFrustum_Init (PickFrustum * frustum, XMFLOAT4 const planes [PICK_FRUSTUM_PLANES]) {
+    for (UINT i = 0; i < PICK_FRUSTUM_PLANES; ++i) {
+        frustum->plane_x[i] = planes[i].x;
+        frustum->plane_y[i] = planes[i].y;
+        frustum->plane_z[i] = planes[i].z;
+        frustum->plane_w[i] = planes[i].w;
+    }
+}
+// The planes of [frustum] in the local space of an object placed by [world]
+inline void
+PickFrustum_Transform (PickFrustum * out, PickFrustum const * frustum, XMFLOAT4X4 const & world) {
+    // planes go through the inverse transpose of the world to local transform, that is transpose(world)
+    XMMATRIX m = XMMatrixTranspose(XMLoadFloat4x4(&world));
+    for (UINT i = 0; i < PICK_FRUSTUM_PLANES; ++i) {
+        XMVECTOR p = XMVectorSet(frustum->plane_x[i], frustum->plane_y[i], frustum->plane_z[i], frustum->plane_w[i]);
+        XMFLOAT4 local;
+        XMStoreFloat4(&local, XMVector4Transform(p, m));
+        out->plane_x[i] = local.x;
+        out->plane_y[i] = local.y;
+        out->plane_z[i] = local.z;
+        out->plane_w[i] = local.w;
+    }
+}
+// Box against the planes: outside of one of them, inside all of them, or crossing
+inline int
+pick_frustum_box (PickFrustum const * frustum, XMFLOAT3 const & mn, XMFLOAT3 const & mx) {
+    int result = PICK_INSIDE;
+    for (UINT i = 0; i < PICK_FRUSTUM_PLANES; ++i) {
+        float nx = frustum->plane_x[i], ny = frustum->plane_y[i], nz = frustum->plane_z[i];
+        // -- corners farthest along and against the normal
+        float d_far =
+            nx * (nx >= 0.0f ? mx.x : mn.x) + ny * (ny >= 0.0f ? mx.y : mn.y) + nz * (nz >= 0.0f ? mx.z : mn.z) + frustum->plane_w[i];
+        if (d_far < 0.0f)
+            return PICK_OUTSIDE;
+        float d_near =
+            nx * (nx >= 0.0f ? mn.x : mx.x) + ny * (ny >= 0.0f ? mn.y : mx.y) + nz * (nz >= 0.0f ? mn.z : mx.z) + frustum->plane_w[i];
+        if (d_near < 0.0f)
+            result = PICK_INTERSECTS;
+    }
+    return result;
+}
+// Lanes of [lane_mask] whose triangle is not entirely outside one of the planes
+static int
+pick_frustum_block_sse (PickFrustum const * frustum, RayTriangleBlock const * block, int lane_mask) {
+    int inside = 0;
+    for (UINT base = 0; base < RAY_TRI_LANES; base += 4) {
+        if (0 == ((lane_mask >> base) & 0xf))
+            continue;
+        __m128 v0x = _mm_loadu_ps(block->v0_x + base), v0y = _mm_loadu_ps(block->v0_y + base), v0z = _mm_loadu_ps(block->v0_z + base);
+        __m128 e1x = _mm_loadu_ps(block->e1_x + base), e1y = _mm_loadu_ps(block->e1_y + base), e1z = _mm_loadu_ps(block->e1_z + base);
+        __m128 e2x = _mm_loadu_ps(block->e2_x + base), e2y = _mm_loadu_ps(block->e2_y + base), e2z = _mm_loadu_ps(block->e2_z + base);
+        __m128 outside = _mm_setzero_ps();
+        for (UINT i = 0; i < PICK_FRUSTUM_PLANES; ++i) {
+            __m128 nx = _mm_set1_ps(frustum->plane_x[i]), ny = _mm_set1_ps(frustum->plane_y[i]), nz = _mm_set1_ps(frustum->plane_z[i]);
+            // -- distances of v0, v1 = v0 + e1 and v2 = v0 + e2
+            __m128 d0 = _mm_add_ps(_mm_add_ps(_mm_mul_ps(nx, v0x), _mm_mul_ps(ny, v0y)), _mm_add_ps(_mm_mul_ps(nz, v0z), _mm_set1_ps(frustum->plane_w[i])));
+            __m128 d1 = _mm_add_ps(d0, _mm_add_ps(_mm_add_ps(_mm_mul_ps(nx, e1x), _mm_mul_ps(ny, e1y)), _mm_mul_ps(nz, e1z)));
+            __m128 d2 = _mm_add_ps(d0, _mm_add_ps(_mm_add_ps(_mm_mul_ps(nx, e2x), _mm_mul_ps(ny, e2y)), _mm_mul_ps(nz, e2z)));
+            outside = _mm_or_ps(outside, _mm_cmplt_ps(_mm_max_ps(d0, _mm_max_ps(d1, d2)), _mm_setzero_ps()));
+        }
+        inside |= (~_mm_movemask_ps(outside) & 0xf) << base;
+    }
+    return inside & lane_mask;
+}
+RAY_TRI_AVX2_FUNCTION static int
+pick_frustum_block_avx2 (PickFrustum const * frustum, RayTriangleBlock const * block, int lane_mask) {
+    __m256 v0x = _mm256_loadu_ps(block->v0_x), v0y = _mm256_loadu_ps(block->v0_y), v0z = _mm256_loadu_ps(block->v0_z);
+    __m256 e1x = _mm256_loadu_ps(block->e1_x), e1y = _mm256_loadu_ps(block->e1_y), e1z = _mm256_loadu_ps(block->e1_z);
+    __m256 e2x = _mm256_loadu_ps(block->e2_x), e2y = _mm256_loadu_ps(block->e2_y), e2z = _mm256_loadu_ps(block->e2_z);
+    __m256 outside = _mm256_setzero_ps();
+    for (UINT i = 0; i < PICK_FRUSTUM_PLANES; ++i) {
+        __m256 nx = _mm256_set1_ps(frustum->plane_x[i]), ny = _mm256_set1_ps(frustum->plane_y[i]), nz = _mm256_set1_ps(frustum->plane_z[i]);
+        __m256 d0 = _mm256_fmadd_ps(nx, v0x, _mm256_fmadd_ps(ny, v0y, _mm256_fmadd_ps(nz, v0z, _mm256_set1_ps(frustum->plane_w[i]))));
+        __m256 d1 = _mm256_fmadd_ps(nx, e1x, _mm256_fmadd_ps(ny, e1y, _mm256_fmadd_ps(nz, e1z, d0)));
+        __m256 d2 = _mm256_fmadd_ps(nx, e2x, _mm256_fmadd_ps(ny, e2y, _mm256_fmadd_ps(nz, e2z, d0)));
+        outside = _mm256_or_ps(outside, _mm256_cmp_ps(_mm256_max_ps(d0, _mm256_max_ps(d1, d2)), _mm256_setzero_ps(), _CMP_LT_OQ));
+    }
+    return ~_mm256_movemask_ps(outside) & lane_mask;
+}
+inline int
+pick_frustum_block (PickFrustum const * frustum, RayTriangleBlock const * block, int lane_mask) {
+    if (ray_tri_cpu_has_avx2())
+        return pick_frustum_block_avx2(frustum, block, lane_mask);
+    return pick_frustum_block_sse(frustum, block, lane_mask);
+}
+// Appends the triangles of [bvh] in [first_index, first_index + index_count) touching the local
+// space [frustum] to sel->triangles; with [any] it stops at the first one. Returns how many.
+static UINT
+TriangleBvh_SelectFrustum (
+    TriangleBvh const * bvh, PickFrustum const * frustum, UINT first_index, UINT index_count,
+    bool any, PickSelection * sel
+) {
+    if (0 == bvh->node_count)
+        return 0;
+    UINT count = 0;
+    UINT stack [TRI_BVH_STACK_SIZE];
+    bool stack_inside [TRI_BVH_STACK_SIZE];     // node known to be inside, no more tests below it
+    UINT top = 0;
+    stack[top] = 0;
+    stack_inside[top++] = false;
+    while (top > 0) {
+        --top;
+        TriangleBvhNode const * node = &bvh->nodes[stack[top]];
+        bool inside = stack_inside[top];
+        if (!inside) {
+            int classify = pick_frustum_box(frustum, node->aabb_min, node->aabb_max);
+            if (PICK_OUTSIDE == classify)
+                continue;
+            inside = PICK_INSIDE == classify;
+        }
+        if (node->tri_count > 0) {
+            RayTriangleBlock const * block = &bvh->blocks[node->first];
+            int lane_mask = 0;
+            for (UINT lane = 0; lane < node->tri_count; ++lane)
+                if (block->index_location[lane] - first_index < index_count)
+                    lane_mask |= 1 << lane;
+            if (lane_mask && !inside)
+                lane_mask = pick_frustum_block(frustum, block, lane_mask);
+            if (0 == lane_mask)
+                continue;
+            if (any)
+                return 1;
+            pick_selection_reserve(sel, RAY_TRI_LANES);
+            for (UINT lane = 0; lane < node->tri_count; ++lane) {
+                if (lane_mask & (1 << lane)) {
+                    sel->triangles[sel->triangle_count++] = block->index_location[lane];
+                    ++count;
+                }
+            }
+            continue;
+        }
+        _ASSERT_EXPR(top + 2 <= TRI_BVH_STACK_SIZE, _T("triangle BVH traversal stack overflow"));
+        stack[top] = node->first;
+        stack_inside[top++] = inside;
+        stack[top] = node->first + 1;
+        stack_inside[top++] = inside;
+    }
+    return count;
+}
+// Selects the pickable instances touching the world space [frustum] into [sel] (replacing its
+// content), with their triangles when [triangles] is set; otherwise an item only needs one.
+static void
+PickScene_SelectFrustum (PickScene const * scene, PickFrustum const * frustum, bool triangles, PickSelection * sel) {
+    sel->item_count = 0;
+    sel->triangle_count = 0;
+    if (0 == scene->node_count)
+        return;
+    UINT stack [TRI_BVH_STACK_SIZE];
+    UINT top = 0;
+    stack[top++] = 0;
+    while (top > 0) {
+        TriangleBvhNode const * node = &scene->nodes[stack[--top]];
+        if (PICK_OUTSIDE == pick_frustum_box(frustum, node->aabb_min, node->aabb_max))
+            continue;
+        if (0 == node->tri_count) {
+            _ASSERT_EXPR(top + 2 <= TRI_BVH_STACK_SIZE, _T("pick scene traversal stack overflow"));
+            stack[top++] = node->first + 1;
+            stack[top++] = node->first;
+            continue;
+        }
+        for (UINT i = node->first; i < node->first + node->tri_count; ++i) {
+            UINT instance = scene->order[i];
+            PickInstance const * inst = &scene->instances[instance];
+            if (!inst->pickable || 0 == inst->index_count)
+                continue;
+            int classify = pick_frustum_box(frustum, inst->aabb_min, inst->aabb_max);
+            if (PICK_OUTSIDE == classify)
+                continue;
+
+            UINT first = sel->triangle_count;
+            UINT count = 0;
+            if (PICK_INSIDE == classify) {
+                // -- the whole item, no triangle tests
+                count = inst->index_count / 3;
+                if (triangles) {
+                    pick_selection_reserve(sel, count);
+                    for (UINT t = 0; t < count; ++t)
+                        sel->triangles[sel->triangle_count++] = inst->first_index + 3 * t;
+                }
+            } else {
+                PickFrustum local;
+                PickFrustum_Transform(&local, frustum, inst->world);
+                count = TriangleBvh_SelectFrustum(inst->blas, &local, inst->first_index, inst->index_count, !triangles, sel);
+            }
+            if (0 == count)
+                continue;
+            _ASSERT_EXPR(sel->item_count < sel->item_capacity, _T("selection is full"));
+            PickSelectionItem * item = &sel->items[sel->item_count++];
+            item->instance = instance;
+            item->item = inst->item;
+            item->first = first;
+            item->count = triangles ? count : 0;
+        }
+    }
+}
@@ -0,0 +1,219 @@
+/* ===========================================================
+   #File: ray_triangle.h #
+   #Date: 17 Oct 2026 #
+   #Revision: 1.0 #
+   #Creator: Omid Miresmaeili #
+   #Description: one ray against 8 triangles at a time (SoA blocks, SSE and AVX2 kernels) #
+   #Notice: (C) Copyright 2021 by Omid. All Rights Reserved. #
+   =========================================================== */
+#pragma once
+
+#include "common.h"
+
+#include <immintrin.h>
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+using namespace DirectX;
+
+//
+// Ray / triangle blocks
+//
+// Triangles are stored swizzled in blocks of RAY_TRI_LANES: every coordinate of the first
+// vertex and of the two edges from it has its own array, so one load fills a register with
+// that coordinate for all the triangles of the block. A ray is tested against a whole block
+// with Moller-Trumbore (8 lanes with AVX2, two times 4 with SSE) and the nearest hit in it is
+// returned with its barycentrics. Unused lanes hold degenerate triangles, which never hit.
+//
+#define RAY_TRI_LANES       8
+#define RAY_TRI_EPSILON     1e-20f      // smallest |determinant| of a hit, as in DirectXCollision
+
+// GCC/Clang need the target spelled out to compile the AVX2 kernel without -mavx2 (MSVC doesn't)
+#if defined(__GNUC__) || defined(__clang__)
+#define RAY_TRI_AVX2_FUNCTION __attribute__((target("avx2,fma")))
+#else
+#define RAY_TRI_AVX2_FUNCTION
+#endif
+
+struct RayTriangleBlock {
+    float   v0_x [RAY_TRI_LANES];
+    float   v0_y [RAY_TRI_LANES];
+    float   v0_z [RAY_TRI_LANES];
+    float   e1_x [RAY_TRI_LANES];       // v1 - v0
+    float   e1_y [RAY_TRI_LANES];
+    float   e1_z [RAY_TRI_LANES];
+    float   e2_x [RAY_TRI_LANES];       // v2 - v0
+    float   e2_y [RAY_TRI_LANES];
+    float   e2_z [RAY_TRI_LANES];
+    UINT    index_location [RAY_TRI_LANES];     // of the triangle's first index in the index buffer
+};
+struct RayTriangleHit {
+    float   t;                  // distance along the ray; on input, only closer hits are accepted
+    float   u;                  // barycentrics of v1 and v2 (the hit point is v0 + u * e1 + v * e2)
+    float   v;
+    UINT    index_location;
+};
+
+// Every lane a degenerate triangle
+inline void
+RayTriangleBlock_Clear (RayTriangleBlock * block) {
+    ::memset(block, 0, sizeof(RayTriangleBlock));
+}
+inline void
+RayTriangleBlock_Set (
+    RayTriangleBlock * block, UINT lane,
+    XMFLOAT3 const & v0, XMFLOAT3 const & v1, XMFLOAT3 const & v2, UINT index_location
+) {
+    block->v0_x[lane] = v0.x;
+    block->v0_y[lane] = v0.y;
+    block->v0_z[lane] = v0.z;
+    block->e1_x[lane] = v1.x - v0.x;
+    block->e1_y[lane] = v1.y - v0.y;
+    block->e1_z[lane] = v1.z - v0.z;
+    block->e2_x[lane] = v2.x - v0.x;
+    block->e2_y[lane] = v2.y - v0.y;
+    block->e2_z[lane] = v2.z - v0.z;
+    block->index_location[lane] = index_location;
+}
+// Picks the nearest of the lanes in [mask] and writes it to [hit]
+inline bool
+ray_tri_nearest_lane (RayTriangleBlock const * block, int mask, float const * t, float const * u, float const * v, RayTriangleHit * hit) {
+    if (0 == mask)
+        return false;
+    int nearest = -1;
+    float t_nearest = hit->t;
+    while (mask) {
+#if defined(_MSC_VER)
+        unsigned long lane;
+        _BitScanForward(&lane, (unsigned long)mask);
+#else
+        int lane = __builtin_ctz((unsigned)mask);
+#endif
+        if (t[lane] < t_nearest) {
+            t_nearest = t[lane];
+            nearest = (int)lane;
+        }
+        mask &= mask - 1;
+    }
+    hit->t = t[nearest];
+    hit->u = u[nearest];
+    hit->v = v[nearest];
+    hit->index_location = block->index_location[nearest];
+    return true;
+}
+static bool
+ray_tri_block_sse (RayTriangleBlock const * block, XMFLOAT3 const & origin, XMFLOAT3 const & dir, int lane_mask, RayTriangleHit * hit) {
+    __m128 const ox = _mm_set1_ps(origin.x), oy = _mm_set1_ps(origin.y), oz = _mm_set1_ps(origin.z);
+    __m128 const dx = _mm_set1_ps(dir.x), dy = _mm_set1_ps(dir.y), dz = _mm_set1_ps(dir.z);
+    __m128 const zero = _mm_setzero_ps(), one = _mm_set1_ps(1.0f);
+    __m128 const t_max = _mm_set1_ps(hit->t);
+    __m128 const sign_mask = _mm_set1_ps(-0.0f);
+    alignas(16) float t [RAY_TRI_LANES], u [RAY_TRI_LANES], v [RAY_TRI_LANES];
+    int mask = 0;
+    for (UINT base = 0; base < RAY_TRI_LANES; base += 4) {
+        __m128 e1x = _mm_loadu_ps(block->e1_x + base), e1y = _mm_loadu_ps(block->e1_y + base), e1z = _mm_loadu_ps(block->e1_z + base);
+        __m128 e2x = _mm_loadu_ps(block->e2_x + base), e2y = _mm_loadu_ps(block->e2_y + base), e2z = _mm_loadu_ps(block->e2_z + base);
+        // p = dir x e2, det = e1 . p
+        __m128 px = _mm_sub_ps(_mm_mul_ps(dy, e2z), _mm_mul_ps(dz, e2y));
+        __m128 py = _mm_sub_ps(_mm_mul_ps(dz, e2x), _mm_mul_ps(dx, e2z));
+        __m128 pz = _mm_sub_ps(_mm_mul_ps(dx, e2y), _mm_mul_ps(dy, e2x));
+        __m128 det = _mm_add_ps(_mm_mul_ps(e1x, px), _mm_add_ps(_mm_mul_ps(e1y, py), _mm_mul_ps(e1z, pz)));
+        __m128 inv_det = _mm_div_ps(one, det);
+        // s = origin - v0, u = (s . p) / det
+        __m128 sx = _mm_sub_ps(ox, _mm_loadu_ps(block->v0_x + base));
+        __m128 sy = _mm_sub_ps(oy, _mm_loadu_ps(block->v0_y + base));
+        __m128 sz = _mm_sub_ps(oz, _mm_loadu_ps(block->v0_z + base));
+        __m128 uu = _mm_mul_ps(_mm_add_ps(_mm_mul_ps(sx, px), _mm_add_ps(_mm_mul_ps(sy, py), _mm_mul_ps(sz, pz))), inv_det);
+        // q = s x e1, v = (dir . q) / det, t = (e2 . q) / det
+        __m128 qx = _mm_sub_ps(_mm_mul_ps(sy, e1z), _mm_mul_ps(sz, e1y));
+        __m128 qy = _mm_sub_ps(_mm_mul_ps(sz, e1x), _mm_mul_ps(sx, e1z));
+        __m128 qz = _mm_sub_ps(_mm_mul_ps(sx, e1y), _mm_mul_ps(sy, e1x));
+        __m128 vv = _mm_mul_ps(_mm_add_ps(_mm_mul_ps(dx, qx), _mm_add_ps(_mm_mul_ps(dy, qy), _mm_mul_ps(dz, qz))), inv_det);
+        __m128 tt = _mm_mul_ps(_mm_add_ps(_mm_mul_ps(e2x, qx), _mm_add_ps(_mm_mul_ps(e2y, qy), _mm_mul_ps(e2z, qz))), inv_det);
+
+        __m128 accept = _mm_cmpgt_ps(_mm_andnot_ps(sign_mask, det), _mm_set1_ps(RAY_TRI_EPSILON));
+        accept = _mm_and_ps(accept, _mm_cmpge_ps(uu, zero));
+        accept = _mm_and_ps(accept, _mm_cmpge_ps(vv, zero));
+        accept = _mm_and_ps(accept, _mm_cmple_ps(_mm_add_ps(uu, vv), one));
+        accept = _mm_and_ps(accept, _mm_cmpge_ps(tt, zero));
+        accept = _mm_and_ps(accept, _mm_cmplt_ps(tt, t_max));
+        mask |= _mm_movemask_ps(accept) << base;
+        _mm_store_ps(t + base, tt);
+        _mm_store_ps(u + base, uu);
+        _mm_store_ps(v + base, vv);
+    }
+    return ray_tri_nearest_lane(block, mask & lane_mask, t, u, v, hit);
+}
+RAY_TRI_AVX2_FUNCTION static bool
+ray_tri_block_avx2 (RayTriangleBlock const * block, XMFLOAT3 const & origin, XMFLOAT3 const & dir, int lane_mask, RayTriangleHit * hit) {
+    __m256 const dx = _mm256_set1_ps(dir.x), dy = _mm256_set1_ps(dir.y), dz = _mm256_set1_ps(dir.z);
+    __m256 const zero = _mm256_setzero_ps(), one = _mm256_set1_ps(1.0f);
+    __m256 e1x = _mm256_loadu_ps(block->e1_x), e1y = _mm256_loadu_ps(block->e1_y), e1z = _mm256_loadu_ps(block->e1_z);
+    __m256 e2x = _mm256_loadu_ps(block->e2_x), e2y = _mm256_loadu_ps(block->e2_y), e2z = _mm256_loadu_ps(block->e2_z);
+    // p = dir x e2, det = e1 . p
+    __m256 px = _mm256_fmsub_ps(dy, e2z, _mm256_mul_ps(dz, e2y));
+    __m256 py = _mm256_fmsub_ps(dz, e2x, _mm256_mul_ps(dx, e2z));
+    __m256 pz = _mm256_fmsub_ps(dx, e2y, _mm256_mul_ps(dy, e2x));
+    __m256 det = _mm256_fmadd_ps(e1x, px, _mm256_fmadd_ps(e1y, py, _mm256_mul_ps(e1z, pz)));
+    __m256 inv_det = _mm256_div_ps(one, det);
+    // s = origin - v0, u = (s . p) / det
+    __m256 sx = _mm256_sub_ps(_mm256_set1_ps(origin.x), _mm256_loadu_ps(block->v0_x));
+    __m256 sy = _mm256_sub_ps(_mm256_set1_ps(origin.y), _mm256_loadu_ps(block->v0_y));
+    __m256 sz = _mm256_sub_ps(_mm256_set1_ps(origin.z), _mm256_loadu_ps(block->v0_z));
+    __m256 u = _mm256_mul_ps(_mm256_fmadd_ps(sx, px, _mm256_fmadd_ps(sy, py, _mm256_mul_ps(sz, pz))), inv_det);
+    // q = s x e1, v = (dir . q) / det, t = (e2 . q) / det
+    __m256 qx = _mm256_fmsub_ps(sy, e1z, _mm256_mul_ps(sz, e1y));
+    __m256 qy = _mm256_fmsub_ps(sz, e1x, _mm256_mul_ps(sx, e1z));
+    __m256 qz = _mm256_fmsub_ps(sx, e1y, _mm256_mul_ps(sy, e1x));
+    __m256 v = _mm256_mul_ps(_mm256_fmadd_ps(dx, qx, _mm256_fmadd_ps(dy, qy, _mm256_mul_ps(dz, qz))), inv_det);
+    __m256 t = _mm256_mul_ps(_mm256_fmadd_ps(e2x, qx, _mm256_fmadd_ps(e2y, qy, _mm256_mul_ps(e2z, qz))), inv_det);
+
+    __m256 accept = _mm256_cmp_ps(_mm256_andnot_ps(_mm256_set1_ps(-0.0f), det), _mm256_set1_ps(RAY_TRI_EPSILON), _CMP_GT_OQ);
+    accept = _mm256_and_ps(accept, _mm256_cmp_ps(u, zero, _CMP_GE_OQ));
+    accept = _mm256_and_ps(accept, _mm256_cmp_ps(v, zero, _CMP_GE_OQ));
+    accept = _mm256_and_ps(accept, _mm256_cmp_ps(_mm256_add_ps(u, v), one, _CMP_LE_OQ));
+    accept = _mm256_and_ps(accept, _mm256_cmp_ps(t, zero, _CMP_GE_OQ));
+    accept = _mm256_and_ps(accept, _mm256_cmp_ps(t, _mm256_set1_ps(hit->t), _CMP_LT_OQ));
+    int mask = _mm256_movemask_ps(accept) & lane_mask;
+    if (0 == mask)
+        return false;
+    alignas(32) float t_lanes [RAY_TRI_LANES], u_lanes [RAY_TRI_LANES], v_lanes [RAY_TRI_LANES];
+    _mm256_store_ps(t_lanes, t);
+    _mm256_store_ps(u_lanes, u);
+    _mm256_store_ps(v_lanes, v);
+    return ray_tri_nearest_lane(block, mask, t_lanes, u_lanes, v_lanes, hit);
+}
+// AVX2 and FMA supported by the CPU and enabled by the OS
+inline bool
+ray_tri_detect_avx2 () {
+#if defined(_MSC_VER)
+    int info[4];
+    __cpuid(info, 1);
+    bool fma = (info[2] & (1 << 12)) != 0;
+    bool osxsave = (info[2] & (1 << 27)) != 0;
+    bool ymm_enabled = osxsave && (_xgetbv(0) & 0x6) == 0x6;
+    __cpuidex(info, 7, 0);
+    bool avx2 = (info[1] & (1 << 5)) != 0;
+    return fma && ymm_enabled && avx2;
+#else
+    return __builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma");
+#endif
+}
+// ray_tri_detect_avx2, checked once. Safe to call from any thread: the answer is kept in a
+// function-local static, whose initialization is thread-safe since C++11.
+inline bool
+ray_tri_cpu_has_avx2 () {
+    static bool const has_avx2 = ray_tri_detect_avx2();
+    return has_avx2;
+}
+// Nearest hit of the ray (origin, dir) with the lanes of [block] set in [lane_mask], closer
+// than hit->t. On a hit, overwrites [hit] and returns true.
+inline bool
+RayTriangleBlock_Intersect (
+    RayTriangleBlock const * block, XMFLOAT3 const & origin, XMFLOAT3 const & dir, int lane_mask, RayTriangleHit * hit
+) {
+    if (ray_tri_cpu_has_avx2())
+        return ray_tri_block_avx2(block, origin, dir, lane_mask, hit);
+    return ray_tri_block_sse(block, origin, dir, lane_mask, hit);
+}
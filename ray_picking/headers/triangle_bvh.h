@@ -0,0 +1,364 @@
+/* ===========================================================
+   #File: triangle_bvh.h #
+   #Date: 17 Oct 2026 #
+   #Revision: 1.0 #
+   #Creator: Omid Miresmaeili #
+   #Description: binned SAH bounding volume hierarchy over mesh triangles for ray picking #
+   #Notice: (C) Copyright 2021 by Omid. All Rights Reserved. #
+   =========================================================== */
+#pragma once
+
+#include "common.h"
+#include "mesh_geometry.h"
+#include "ray_triangle.h"
+
+using namespace DirectX;
+
+//
+// Triangle BVH
+//
+// Built once at load from the system memory copies of a MeshGeometry (vb_cpu / ib_cpu),
+// over the full resolution triangles of its submeshes. Nodes are split where the surface
+// area heuristic is lowest among TRI_BVH_BIN_COUNT bins of the triangle centroids per
+// axis, and become leaves when splitting costs more than testing their triangles.
+// Every leaf holds at most RAY_TRI_LANES triangles, copied into one RayTriangleBlock
+// (positions and their location in the index buffer), so traversal never touches the vertex
+// or index buffers and a leaf is tested with a single SIMD call. Ray queries return the
+// nearest hit: nodes are visited near child first and skipped once their entry distance is
+// beyond the nearest hit so far.
+//
+#define TRI_BVH_BIN_COUNT           16
+#define TRI_BVH_MAX_LEAF_SIZE       RAY_TRI_LANES   // larger nodes are always split
+#define TRI_BVH_TRAVERSAL_COST      1.0f    // of one node, relative to one ray/triangle test
+#define TRI_BVH_MAX_DEPTH           48      // deeper nodes are split in half (bounds the traversal stack)
+#define TRI_BVH_STACK_SIZE          (TRI_BVH_MAX_DEPTH + 32)
+
+struct TriangleBvhNode {
+    XMFLOAT3    aabb_min;
+    UINT        first;          // first child (the second is first + 1), or block of a leaf
+    XMFLOAT3    aabb_max;
+    UINT        tri_count;      // 0 for internal nodes
+};
+struct TriangleBvh {
+    TriangleBvhNode *       nodes;
+    UINT                    node_count;
+    RayTriangleBlock *      blocks;         // one per leaf
+    UINT                    block_count;
+    UINT                    tri_count;
+};
+
+// Build time data of one triangle (or of any box, see tri_bvh_build_nodes)
+struct TriBvhTriangle {
+    XMFLOAT3    v0;
+    XMFLOAT3    v1;
+    XMFLOAT3    v2;
+    UINT        index_location; // of its first index in the index buffer
+};
+struct TriBvhBuildRef {
+    XMFLOAT3    aabb_min;
+    XMFLOAT3    aabb_max;
+    XMFLOAT3    centroid;
+    UINT        triangle;       // index in the unordered triangle array (or of the box)
+};
+struct TriBvhBin {
+    XMFLOAT3    aabb_min;
+    XMFLOAT3    aabb_max;
+    UINT        count;
+};
+
+inline void
+tri_bvh_grow (XMFLOAT3 * mn, XMFLOAT3 * mx, XMFLOAT3 const & p_min, XMFLOAT3 const & p_max) {
+    mn->x = fminf(mn->x, p_min.x); mn->y = fminf(mn->y, p_min.y); mn->z = fminf(mn->z, p_min.z);
+    mx->x = fmaxf(mx->x, p_max.x); mx->y = fmaxf(mx->y, p_max.y); mx->z = fmaxf(mx->z, p_max.z);
+}
+inline float
+tri_bvh_area (XMFLOAT3 const & mn, XMFLOAT3 const & mx) {
+    float dx = mx.x - mn.x, dy = mx.y - mn.y, dz = mx.z - mn.z;
+    return dx < 0.0f ? 0.0f : dx * dy + dy * dz + dz * dx;      // half the surface, empty boxes are 0
+}
+inline float
+tri_bvh_axis (XMFLOAT3 const & v, UINT axis) {
+    return 0 == axis ? v.x : (1 == axis ? v.y : v.z);
+}
+// Bin of a centroid along [axis] of the centroid bounds [c_min, c_min + extent]
+inline UINT
+tri_bvh_bin (float c, float c_min, float scale) {
+    UINT bin = (UINT)((c - c_min) * scale);
+    return bin < TRI_BVH_BIN_COUNT ? bin : TRI_BVH_BIN_COUNT - 1;
+}
+// Splits refs[first, first + count) of [node]; returns how many go to the first child
+// (0 to make the node a leaf)
+static UINT
+tri_bvh_split (TriBvhBuildRef * refs, UINT first, UINT count, TriangleBvhNode const * node, UINT depth) {
+    XMFLOAT3 c_min = XMFLOAT3(FLT_MAX, FLT_MAX, FLT_MAX);
+    XMFLOAT3 c_max = XMFLOAT3(-FLT_MAX, -FLT_MAX, -FLT_MAX);
+    for (UINT i = first; i < first + count; ++i)
+        tri_bvh_grow(&c_min, &c_max, refs[i].centroid, refs[i].centroid);
+
+    // -- cheapest bin boundary over the three axes
+    float best_cost = FLT_MAX;
+    UINT best_axis = 0, best_split = 0;
+    for (UINT axis = 0; axis < 3; ++axis) {
+        float lo = tri_bvh_axis(c_min, axis);
+        float extent = tri_bvh_axis(c_max, axis) - lo;
+        if (extent <= 0.0f)
+            continue;
+        float scale = TRI_BVH_BIN_COUNT / extent;
+        TriBvhBin bins [TRI_BVH_BIN_COUNT];
+        for (UINT b = 0; b < TRI_BVH_BIN_COUNT; ++b) {
+            bins[b].aabb_min = XMFLOAT3(FLT_MAX, FLT_MAX, FLT_MAX);
+            bins[b].aabb_max = XMFLOAT3(-FLT_MAX, -FLT_MAX, -FLT_MAX);
+            bins[b].count = 0;
+        }
+        for (UINT i = first; i < first + count; ++i) {
+            TriBvhBin * bin = &bins[tri_bvh_bin(tri_bvh_axis(refs[i].centroid, axis), lo, scale)];
+            tri_bvh_grow(&bin->aabb_min, &bin->aabb_max, refs[i].aabb_min, refs[i].aabb_max);
+            ++bin->count;
+        }
+        // areas and counts left of every boundary, then sweep back from the right
+        float left_area [TRI_BVH_BIN_COUNT - 1];
+        UINT left_count [TRI_BVH_BIN_COUNT - 1];
+        XMFLOAT3 mn = XMFLOAT3(FLT_MAX, FLT_MAX, FLT_MAX), mx = XMFLOAT3(-FLT_MAX, -FLT_MAX, -FLT_MAX);
+        UINT n = 0;
+        for (UINT b = 0; b < TRI_BVH_BIN_COUNT - 1; ++b) {
+            tri_bvh_grow(&mn, &mx, bins[b].aabb_min, bins[b].aabb_max);
+            n += bins[b].count;
+            left_area[b] = tri_bvh_area(mn, mx);
+            left_count[b] = n;
+        }
+        mn = XMFLOAT3(FLT_MAX, FLT_MAX, FLT_MAX);
+        mx = XMFLOAT3(-FLT_MAX, -FLT_MAX, -FLT_MAX);
+        n = 0;
+        for (UINT b = TRI_BVH_BIN_COUNT - 1; b > 0; --b) {
+            tri_bvh_grow(&mn, &mx, bins[b].aabb_min, bins[b].aabb_max);
+            n += bins[b].count;
+            if (0 == n || n == count)
+                continue;
+            float cost = left_area[b - 1] * left_count[b - 1] + tri_bvh_area(mn, mx) * n;
+            if (cost < best_cost) {
+                best_cost = cost;
+                best_axis = axis;
+                best_split = b;
+            }
+        }
+    }
+
+    // -- leaf if splitting is no cheaper than testing every triangle
+    float node_area = tri_bvh_area(node->aabb_min, node->aabb_max);
+    bool can_split = FLT_MAX != best_cost;
+    if (can_split && node_area > 0.0f)
+        best_cost = TRI_BVH_TRAVERSAL_COST + best_cost / node_area;
+    if (count <= TRI_BVH_MAX_LEAF_SIZE && (!can_split || best_cost >= (float)count))
+        return 0;
+
+    // -- partition around the chosen boundary (in half when too deep or the centroids coincide)
+    UINT mid = first + count / 2;
+    if (can_split && depth < TRI_BVH_MAX_DEPTH) {
+        float lo = tri_bvh_axis(c_min, best_axis);
+        float scale = TRI_BVH_BIN_COUNT / (tri_bvh_axis(c_max, best_axis) - lo);
+        UINT i = first, j = first + count;
+        while (i < j) {
+            if (tri_bvh_bin(tri_bvh_axis(refs[i].centroid, best_axis), lo, scale) < best_split) {
+                ++i;
+            } else {
+                --j;
+                TriBvhBuildRef tmp = refs[i];
+                refs[i] = refs[j];
+                refs[j] = tmp;
+            }
+        }
+        if (i > first && i < first + count)
+            mid = i;
+    }
+    return mid - first;
+}
+// Splits refs[0, count) top-down into [nodes] (room for 2 * count - 1) and reorders the refs
+// so every leaf covers refs[first, first + tri_count). Returns the node count.
+static UINT
+tri_bvh_build_nodes (TriBvhBuildRef * refs, UINT count, TriangleBvhNode * nodes) {
+    UINT node_count = 1;
+    struct BuildTask {
+        UINT node, first, count, depth;
+    };
+    BuildTask stack [TRI_BVH_STACK_SIZE];
+    UINT top = 0;
+    stack[top++] = {0, 0, count, 0};
+    while (top > 0) {
+        BuildTask task = stack[--top];
+        TriangleBvhNode * node = &nodes[task.node];
+        node->aabb_min = XMFLOAT3(FLT_MAX, FLT_MAX, FLT_MAX);
+        node->aabb_max = XMFLOAT3(-FLT_MAX, -FLT_MAX, -FLT_MAX);
+        for (UINT i = task.first; i < task.first + task.count; ++i)
+            tri_bvh_grow(&node->aabb_min, &node->aabb_max, refs[i].aabb_min, refs[i].aabb_max);
+
+        UINT left_count = tri_bvh_split(refs, task.first, task.count, node, task.depth);
+        if (0 == left_count) {
+            node->first = task.first;
+            node->tri_count = task.count;
+            continue;
+        }
+        node->first = node_count;
+        node->tri_count = 0;
+        node_count += 2;
+        _ASSERT_EXPR(top + 2 <= TRI_BVH_STACK_SIZE, _T("triangle BVH build stack overflow"));
+        stack[top++] = {node->first, task.first, left_count, task.depth + 1};
+        stack[top++] = {node->first + 1, task.first + left_count, task.count - left_count, task.depth + 1};
+    }
+    return node_count;
+}
+// Builds the BVH of the triangles of [submeshes] in the given vertex and index buffers.
+// The position is the first member of each vertex (float3).
+static void
+TriangleBvh_Build (
+    TriangleBvh * bvh, void const * vertices, UINT vertex_stride, void const * indices, DXGI_FORMAT index_format,
+    SubmeshGeometry const * submeshes, UINT submesh_count
+) {
+    *bvh = {};
+    for (UINT s = 0; s < submesh_count; ++s)
+        bvh->tri_count += submeshes[s].index_count / 3;
+    if (0 == bvh->tri_count)
+        return;
+
+    // -- gather the triangles and their bounds
+    TriBvhTriangle * unordered = (TriBvhTriangle *)::malloc(sizeof(TriBvhTriangle) * bvh->tri_count);
+    TriBvhBuildRef * refs = (TriBvhBuildRef *)::malloc(sizeof(TriBvhBuildRef) * bvh->tri_count);
+    UINT t = 0;
+    for (UINT s = 0; s < submesh_count; ++s) {
+        SubmeshGeometry const * submesh = &submeshes[s];
+        for (UINT k = 0; k + 2 < submesh->index_count; k += 3, ++t) {
+            UINT location = submesh->start_index_location + k;
+            XMFLOAT3 * v [3] = {&unordered[t].v0, &unordered[t].v1, &unordered[t].v2};
+            for (UINT c = 0; c < 3; ++c) {
+                UINT index = DXGI_FORMAT_R16_UINT == index_format ?
+                    ((uint16_t const *)indices)[location + c] : ((uint32_t const *)indices)[location + c];
+                size_t vertex = (size_t)((INT)index + submesh->base_vertex_location);
+                *v[c] = *(XMFLOAT3 const *)((BYTE const *)vertices + vertex * vertex_stride);
+            }
+            unordered[t].index_location = location;
+
+            TriBvhBuildRef * ref = &refs[t];
+            ref->aabb_min = unordered[t].v0;
+            ref->aabb_max = unordered[t].v0;
+            tri_bvh_grow(&ref->aabb_min, &ref->aabb_max, unordered[t].v1, unordered[t].v1);
+            tri_bvh_grow(&ref->aabb_min, &ref->aabb_max, unordered[t].v2, unordered[t].v2);
+            ref->centroid = XMFLOAT3(
+                0.5f * (ref->aabb_min.x + ref->aabb_max.x),
+                0.5f * (ref->aabb_min.y + ref->aabb_max.y),
+                0.5f * (ref->aabb_min.z + ref->aabb_max.z));
+            ref->triangle = t;
+        }
+    }
+
+    // -- split top-down
+    bvh->nodes = (TriangleBvhNode *)::malloc(sizeof(TriangleBvhNode) * (2 * bvh->tri_count - 1));
+    bvh->node_count = tri_bvh_build_nodes(refs, bvh->tri_count, bvh->nodes);
+
+    // -- triangles of every leaf swizzled into its block (a binary tree has one more leaf than internal nodes)
+    bvh->blocks = (RayTriangleBlock *)::malloc(sizeof(RayTriangleBlock) * ((bvh->node_count + 1) / 2));
+    for (UINT n = 0; n < bvh->node_count; ++n) {
+        TriangleBvhNode * node = &bvh->nodes[n];
+        if (0 == node->tri_count)
+            continue;
+        RayTriangleBlock * block = &bvh->blocks[bvh->block_count];
+        RayTriangleBlock_Clear(block);
+        for (UINT lane = 0; lane < node->tri_count; ++lane) {
+            TriBvhTriangle const * tri = &unordered[refs[node->first + lane].triangle];
+            RayTriangleBlock_Set(block, lane, tri->v0, tri->v1, tri->v2, tri->index_location);
+        }
+        node->first = bvh->block_count++;
+    }
+    ::free(refs);
+    ::free(unordered);
+}
+inline void
+TriangleBvh_Release (TriangleBvh * bvh) {
+    ::free(bvh->nodes);
+    ::free(bvh->blocks);
+    *bvh = {};
+}
+// Entry distance of the ray into the box (FLT_MAX if it misses it or enters beyond [t_max])
+inline float
+tri_bvh_ray_box (XMFLOAT3 const & mn, XMFLOAT3 const & mx, XMFLOAT3 const & origin, XMFLOAT3 const & inv_dir, float t_max) {
+    float tx1 = (mn.x - origin.x) * inv_dir.x, tx2 = (mx.x - origin.x) * inv_dir.x;
+    float ty1 = (mn.y - origin.y) * inv_dir.y, ty2 = (mx.y - origin.y) * inv_dir.y;
+    float tz1 = (mn.z - origin.z) * inv_dir.z, tz2 = (mx.z - origin.z) * inv_dir.z;
+    float t_enter = fmaxf(fmaxf(fminf(tx1, tx2), fminf(ty1, ty2)), fmaxf(fminf(tz1, tz2), 0.0f));
+    float t_exit = fminf(fminf(fmaxf(tx1, tx2), fmaxf(ty1, ty2)), fminf(fmaxf(tz1, tz2), t_max));
+    return t_enter <= t_exit ? t_enter : FLT_MAX;
+}
+inline float
+tri_bvh_ray_node (TriangleBvhNode const * node, XMFLOAT3 const & origin, XMFLOAT3 const & inv_dir, float t_max) {
+    return tri_bvh_ray_box(node->aabb_min, node->aabb_max, origin, inv_dir, t_max);
+}
+// Nearest hit of the ray (origin, normalized dir) with the triangles whose first index lies in
+// [first_index, first_index + index_count), closer than io_hit->t. On a hit, overwrites [io_hit]
+// (distance, barycentrics and the first index of the triangle).
+static bool
+TriangleBvh_Intersect (
+    TriangleBvh const * bvh, FXMVECTOR origin, FXMVECTOR dir, UINT first_index, UINT index_count,
+    RayTriangleHit * io_hit
+) {
+    if (0 == bvh->node_count)
+        return false;
+    XMFLOAT3 o, d;
+    XMStoreFloat3(&o, origin);
+    XMStoreFloat3(&d, dir);
+    XMFLOAT3 inv_dir = XMFLOAT3(1.0f / d.x, 1.0f / d.y, 1.0f / d.z);     // +-inf on axis aligned rays
+
+    bool hit = false;
+    UINT stack [TRI_BVH_STACK_SIZE];
+    UINT top = 0;
+    if (tri_bvh_ray_node(&bvh->nodes[0], o, inv_dir, io_hit->t) < io_hit->t)
+        stack[top++] = 0;
+    while (top > 0) {
+        TriangleBvhNode const * node = &bvh->nodes[stack[--top]];
+        if (node->tri_count > 0) {
+            RayTriangleBlock const * block = &bvh->blocks[node->first];
+            int lane_mask = 0;
+            for (UINT lane = 0; lane < node->tri_count; ++lane)
+                if (block->index_location[lane] - first_index < index_count)
+                    lane_mask |= 1 << lane;
+            if (RayTriangleBlock_Intersect(block, o, d, lane_mask, io_hit))
+                hit = true;
+            continue;
+        }
+        // -- near child last on the stack (visited first), children entered beyond the nearest hit dropped
+        UINT child = node->first;
+        float t0 = tri_bvh_ray_node(&bvh->nodes[child], o, inv_dir, io_hit->t);
+        float t1 = tri_bvh_ray_node(&bvh->nodes[child + 1], o, inv_dir, io_hit->t);
+        UINT near_child = t0 <= t1 ? child : child + 1;
+        float t_far = t0 <= t1 ? t1 : t0;
+        _ASSERT_EXPR(top + 2 <= TRI_BVH_STACK_SIZE, _T("triangle BVH traversal stack overflow"));
+        if (t_far < io_hit->t)
+            stack[top++] = near_child == child ? child + 1 : child;
+        if (fminf(t0, t1) < io_hit->t)
+            stack[top++] = near_child;
+    }
+    return hit;
+}
+// Builds [geom]->triangle_bvh from its system memory copies (float3 positions) for its first [submesh_count] submeshes
+static void
+Mesh_BuildTriangleBvh (MeshGeometry * geom, UINT submesh_count, char const * name) {
+    _ASSERT_EXPR(VERTEX_ENCODING_FLOAT32 == geom->vertex_encoding, _T("triangle BVH needs float positions"));
+    int64_t begin, end, freq;
+    QueryPerformanceCounter((LARGE_INTEGER *)&begin);
+    geom->triangle_bvh = (TriangleBvh *)::malloc(sizeof(TriangleBvh));
+    TriangleBvh_Build(
+        geom->triangle_bvh, geom->vb_cpu->GetBufferPointer(), geom->vb_byte_stide,
+        geom->ib_cpu->GetBufferPointer(), geom->index_format, geom->submesh_geoms, submesh_count);
+    QueryPerformanceCounter((LARGE_INTEGER *)&end);
+    QueryPerformanceFrequency((LARGE_INTEGER *)&freq);
+
+    char buf [256];
+    ::sprintf_s(buf, sizeof(buf), "[bvh] %s: %u tris, %u nodes, %.2f ms\n",
+        name, geom->triangle_bvh->tri_count, geom->triangle_bvh->node_count, (double)(end - begin) * 1000.0 / (double)freq);
+    ::OutputDebugStringA(buf);
+}
+inline void
+Mesh_ReleaseTriangleBvh (MeshGeometry * geom) {
+    if (geom->triangle_bvh) {
+        TriangleBvh_Release(geom->triangle_bvh);
+        ::free(geom->triangle_bvh);
+        geom->triangle_bvh = nullptr;
+    }
+}
@@ -22,6 +22,10 @@
 #include "headers/utils.h"
 #include "headers/game_timer.h"
 #include "headers/dds_loader.h"
+#include "headers/mesh_loader.h"
+#include "headers/geometry_pool.h"
+#include "headers/render_item_culling.h"
+#include "headers/screen_coverage.h"
 
 #include <imgui/imgui.h>
 #include <imgui/imgui_impl_win32.h>
@@ -116,6 +120,15 @@ enum GEOM_INDEX {
 
     _COUNT_GEOM
 };
+// Every mesh uses the Vertex layout, so the pools only differ by index format
+enum GEOM_POOL_INDEX {
+    GEOM_POOL_INDEX16 = 0,
+    GEOM_POOL_INDEX32 = 1,
+
+    _COUNT_GEOM_POOL
+};
+#define GEOM_POOL_VERTEX_CAPACITY   (128 * 1024)
+#define GEOM_POOL_INDEX_CAPACITY    (512 * 1024)
 enum SUBMESH_INDEX {
     _BOX_ID,
     _GRID_ID,
@@ -198,6 +211,21 @@ bool g_resizing;
 bool g_mouse_active;
 SceneContext g_scene_ctx;
 
+// per frame culling of opaque_ritems for the camera and as shadow casters (see headers/render_item_culling.h)
+struct RenderItemCulling {
+    RenderItemBounds    bounds;
+    bool                camera_visible [_COUNT_RENDERITEM];     // indexed like opaque_ritems
+    bool                caster_visible [_COUNT_RENDERITEM];
+    UINT                camera_visible_count;
+    UINT                caster_visible_count;
+};
+bool g_ritem_culling_enabled = true;
+bool g_coverage_culling_enabled = true;        // drop items too small on screen, and casters too small to cast a visible shadow
+float g_coverage_min_pixels = COVERAGE_MIN_PIXELS;
+float g_shadow_min_pixels = COVERAGE_SHADOW_MIN_PIXELS;
+bool g_repack_geometry_pool;                    // remove, re-add and defragment the skull on the next frame
+RenderItemCulling g_ritem_culling;
+
 struct RenderItemArray {
     RenderItem  ritems[_COUNT_RENDERITEM];
     uint32_t    size;
@@ -255,6 +283,9 @@ struct D3DRenderContext {
     RenderItemArray                 debug_ritems;
 
     MeshGeometry                    geom[_COUNT_GEOM];
+    // Shared vertex/index buffers the geometries are suballocated from
+    GeometryPool                    geom_pools[_COUNT_GEOM_POOL];
+    UINT                            geom_pool_handles[_COUNT_GEOM];
 
     // Synchronization stuff
     UINT                            frame_index;
@@ -388,56 +419,14 @@ create_materials (Material out_materials []) {
     out_materials[MAT_SKY].n_frames_dirty = NUM_QUEUING_FRAMES;
 }
 static void
-create_skull_geometry (D3DRenderContext * render_ctx) {
-#pragma region Read_Data_File
-    FILE * f = nullptr;
-    errno_t err = fopen_s(&f, "./models/skull.txt", "r");
-    if (0 == f || err != 0) {
-        MessageBox(0, _T("Could not open file"), 0, 0);
-        return;
-    }
-    char linebuf[100];
-    int cnt = 0;
-    unsigned vcount = 0;
-    unsigned tcount = 0;
-    // -- read 1st line
-    if (fgets(linebuf, sizeof(linebuf), f))
-        cnt = sscanf_s(linebuf, "%*s %d", &vcount);
-    if (cnt != 1) {
-        MessageBox(0, _T("Read error"), 0, 0);
-        return;
-    }
-    // -- read 2nd line
-    if (fgets(linebuf, sizeof(linebuf), f))
-        cnt = sscanf_s(linebuf, "%*s %d", &tcount);
-    if (cnt != 1) {
-        MessageBox(0, _T("Read error"), 0, 0);
-        return;
-    }
-    // -- skip two lines
-    fgets(linebuf, sizeof(linebuf), f);
-    fgets(linebuf, sizeof(linebuf), f);
-
-    // -- vmin and vmax for AABB construction
-    XMFLOAT3 vminf3(+FLT_MAX, +FLT_MAX, +FLT_MAX);
-    XMFLOAT3 vmaxf3(-FLT_MAX, -FLT_MAX, -FLT_MAX);
-
-    XMVECTOR vmin = XMLoadFloat3(&vminf3);
-    XMVECTOR vmax = XMLoadFloat3(&vmaxf3);
-
-    // -- read vertices
-    Vertex * vertices = (Vertex *)calloc(vcount, sizeof(Vertex));
-    for (unsigned i = 0; i < vcount; i++) {
-        fgets(linebuf, sizeof(linebuf), f);
-        cnt = sscanf_s(
-            linebuf, "%f %f %f %f %f %f",
-            &vertices[i].position.x, &vertices[i].position.y, &vertices[i].position.z,
-            &vertices[i].normal.x, &vertices[i].normal.y, &vertices[i].normal.z
-        );
+build_skull_vertices (TextMesh const * src, void * out_vertices) {
+    Vertex * vertices = (Vertex *)out_vertices;
+    for (UINT i = 0; i < src->vertex_count; i++) {
+        vertices[i].position = src->positions[i];
+        vertices[i].normal = src->normals[i];
 
         // generating tangent vector
         vertices[i].texc = {0.0f, 0.0f};
-        XMVECTOR P = XMLoadFloat3(&vertices[i].position);
         XMVECTOR N = XMLoadFloat3(&vertices[i].normal);
         // NOTE(omid): We aren't applying a texture map to the skull,
         // so we just need any tangent vector
@@ -452,11 +441,6 @@ create_skull_geometry (D3DRenderContext * render_ctx) {
             XMStoreFloat3(&vertices[i].tangent_u, T);
         }
 
-        if (cnt != 6) {
-            MessageBox(0, _T("Read error"), 0, 0);
-            return;
-        }
-
 #pragma region skull texture coordinates calculations (Legacy Code)
         // Project point onto unit sphere and generate spherical texture coordinates.
         /*XMVECTOR P = XMLoadFloat3(&vertices[i].position);
@@ -476,73 +460,54 @@ create_skull_geometry (D3DRenderContext * render_ctx) {
 
         vertices[i].texc = {u, v};*/
 #pragma endregion
-
-        // -- calculate vmin, vmax
-        vmin = XMVectorMin(vmin, P);
-        vmax = XMVectorMax(vmax, P);
     }
+}
+static GeometryPool *
+geometry_pool_of (D3DRenderContext * render_ctx, MeshGeometry * geom) {
+    bool index16 = DXGI_FORMAT_R16_UINT == geom->index_format;
+    return &render_ctx->geom_pools[index16 ? GEOM_POOL_INDEX16 : GEOM_POOL_INDEX32];
+}
+// Places a geometry (with its CPU blobs filled) in the pool of its index format
+static void
+add_to_geometry_pool (D3DRenderContext * render_ctx, UINT geom_id, UINT submesh_count, char const * name) {
+    MeshGeometry * geom = &render_ctx->geom[geom_id];
+    GeometryPool * pool = geometry_pool_of(render_ctx, geom);
+    if (nullptr == pool->vertex_arena.gpu)
+        GeometryPool_Init(pool, render_ctx->device, sizeof(Vertex), geom->index_format, GEOM_POOL_VERTEX_CAPACITY, GEOM_POOL_INDEX_CAPACITY);
+
+    UINT handle = GeometryPool_AddMesh(pool, geom, submesh_count, name);
+    _ASSERT_EXPR(UINT_MAX != handle, _T("Geometry pool is full"));
+    render_ctx->geom_pool_handles[geom_id] = handle;
+}
+static void
+create_skull_geometry (D3DRenderContext * render_ctx) {
 
-    // -- construct bounding box (AABB)
-    BoundingBox bounds;
-    XMStoreFloat3(&bounds.Center, 0.5f * (vmin + vmax));
-    XMStoreFloat3(&bounds.Extents, 0.5f * (vmax - vmin));
-
-    // -- skip three lines
-    fgets(linebuf, sizeof(linebuf), f);
-    fgets(linebuf, sizeof(linebuf), f);
-    fgets(linebuf, sizeof(linebuf), f);
-    // -- read indices
-    uint32_t * indices = (uint32_t *)calloc(static_cast<size_t>(tcount) * 3, sizeof(uint32_t));
-    for (unsigned i = 0; i < tcount; i++) {
-        fgets(linebuf, sizeof(linebuf), f);
-        cnt = sscanf_s(
-            linebuf, "%d %d %d",
-            &indices[i * 3 + 0], &indices[i * 3 + 1], &indices[i * 3 + 2]
-        );
-        if (cnt != 3) {
-            MessageBox(0, _T("Read error"), 0, 0);
-            return;
-        }
+    // -- map the binary mesh (created from the text file on first load)
+    MeshCacheView mesh = {};
+    if (!load_mesh_cached("./models/skull.mesh", "./models/skull.txt", sizeof(Vertex), build_skull_vertices, &mesh)) {
+        MessageBox(0, _T("Could not load skull mesh"), 0, 0);
+        return;
     }
 
-    // -- remember to free heap-allocated memory
-    /*
-    free(vertices);
-    free(indices);
-    */
-    fclose(f);
-#pragma endregion   Read_Data_File
-
-    UINT vb_byte_size = vcount * sizeof(Vertex);
-    UINT ib_byte_size = (tcount * 3) * sizeof(uint32_t);
+    UINT vb_byte_size = mesh.vertex_count * sizeof(Vertex);
 
     // -- Fill out render_ctx geom[GEOM_SKULL] (skull)
     D3DCreateBlob(vb_byte_size, &render_ctx->geom[GEOM_SKULL].vb_cpu);
-    CopyMemory(render_ctx->geom[GEOM_SKULL].vb_cpu->GetBufferPointer(), vertices, vb_byte_size);
-
-    D3DCreateBlob(ib_byte_size, &render_ctx->geom[GEOM_SKULL].ib_cpu);
-    CopyMemory(render_ctx->geom[GEOM_SKULL].ib_cpu->GetBufferPointer(), indices, ib_byte_size);
+    CopyMemory(render_ctx->geom[GEOM_SKULL].vb_cpu->GetBufferPointer(), mesh.vertices, vb_byte_size);
 
-    create_default_buffer(render_ctx->device, render_ctx->direct_cmd_list, vertices, vb_byte_size, &render_ctx->geom[GEOM_SKULL].vb_uploader, &render_ctx->geom[GEOM_SKULL].vb_gpu);
-    create_default_buffer(render_ctx->device, render_ctx->direct_cmd_list, indices, ib_byte_size, &render_ctx->geom[GEOM_SKULL].ib_uploader, &render_ctx->geom[GEOM_SKULL].ib_gpu);
+    // narrowest index format that still draws the skull as a single submesh
+    Mesh_CreateIndexBuffer(&render_ctx->geom[GEOM_SKULL], mesh.indices, mesh.index_count, mesh.vertices, sizeof(Vertex), 1, "skull");
 
     render_ctx->geom[GEOM_SKULL].vb_byte_stide = sizeof(Vertex);
     render_ctx->geom[GEOM_SKULL].vb_byte_size = vb_byte_size;
-    render_ctx->geom[GEOM_SKULL].ib_byte_size = ib_byte_size;
-    render_ctx->geom[GEOM_SKULL].index_format = DXGI_FORMAT_R32_UINT;
-
-    SubmeshGeometry submesh = {};
-    submesh.index_count = tcount * 3;
-    submesh.start_index_location = 0;
-    submesh.base_vertex_location = 0;
-    submesh.bounds = bounds;
 
     render_ctx->geom[GEOM_SKULL].submesh_names[0] = "skull";
-    render_ctx->geom[GEOM_SKULL].submesh_geoms[0] = submesh;
+    render_ctx->geom[GEOM_SKULL].submesh_geoms[0].bounds = mesh.bounds;
+
+    add_to_geometry_pool(render_ctx, GEOM_SKULL, 1, "skull");
 
     // -- cleanup
-    free(vertices);
-    free(indices);
+    MeshCache_Release(&mesh);
 }
 #define _BOX_VTX_CNT   24
 #define _BOX_IDX_CNT   36
@@ -644,6 +609,13 @@ create_shapes_geometry (D3DRenderContext * render_ctx) {
     quad_submesh.start_index_location = quad_index_offset;
     quad_submesh.base_vertex_location = quad_vertex_offset;
 
+    // local bounds of the shapes (for culling their render items)
+    BoundingBox::CreateFromPoints(box_submesh.bounds, _BOX_VTX_CNT, &box_vertices[0].Position, sizeof(GeomVertex));
+    BoundingBox::CreateFromPoints(grid_submesh.bounds, _GRID_VTX_CNT, &grid_vertices[0].Position, sizeof(GeomVertex));
+    BoundingBox::CreateFromPoints(sphere_submesh.bounds, _SPHERE_VTX_CNT, &sphere_vertices[0].Position, sizeof(GeomVertex));
+    BoundingBox::CreateFromPoints(cylinder_submesh.bounds, _CYLINDER_VTX_CNT, &cylinder_vertices[0].Position, sizeof(GeomVertex));
+    BoundingBox::CreateFromPoints(quad_submesh.bounds, _QUAD_VTX_CNT, &quad_verts[0].Position, sizeof(GeomVertex));
+
     // Extract the vertex elements we are interested in and pack the
     // vertices of all the meshes into one vertex buffer.
 
@@ -705,9 +677,6 @@ create_shapes_geometry (D3DRenderContext * render_ctx) {
     if (indices)
         CopyMemory(render_ctx->geom[GEOM_SHAPES].ib_cpu->GetBufferPointer(), indices, ib_byte_size);
 
-    create_default_buffer(render_ctx->device, render_ctx->direct_cmd_list, vertices, vb_byte_size, &render_ctx->geom[GEOM_SHAPES].vb_uploader, &render_ctx->geom[GEOM_SHAPES].vb_gpu);
-    create_default_buffer(render_ctx->device, render_ctx->direct_cmd_list, indices, ib_byte_size, &render_ctx->geom[GEOM_SHAPES].ib_uploader, &render_ctx->geom[GEOM_SHAPES].ib_gpu);
-
     render_ctx->geom[GEOM_SHAPES].vb_byte_stide = sizeof(Vertex);
     render_ctx->geom[GEOM_SHAPES].vb_byte_size = vb_byte_size;
     render_ctx->geom[GEOM_SHAPES].ib_byte_size = ib_byte_size;
@@ -724,6 +693,11 @@ create_shapes_geometry (D3DRenderContext * render_ctx) {
     render_ctx->geom[GEOM_SHAPES].submesh_names[_QUAD_ID] = "quad";
     render_ctx->geom[GEOM_SHAPES].submesh_geoms[_QUAD_ID] = quad_submesh;
 
+    // -- reorder every shape for overdraw and vertex fetch, then place the optimized blobs in the pool
+    Mesh_OptimizeCpuBuffers(&render_ctx->geom[GEOM_SHAPES], _QUAD_ID + 1, "shapes");
+
+    add_to_geometry_pool(render_ctx, GEOM_SHAPES, _QUAD_ID + 1, "shapes");
+
     // -- cleanup
     free(scratch);
     free(indices);
@@ -738,6 +712,7 @@ create_render_items (D3DRenderContext * render_ctx) {
     render_ctx->all_ritems.ritems[RITEM_SKY].mat = &render_ctx->materials[MAT_SKY];
     render_ctx->all_ritems.ritems[RITEM_SKY].geometry = &render_ctx->geom[GEOM_SHAPES];
     render_ctx->all_ritems.ritems[RITEM_SKY].primitive_type = D3D11_PRIMITIVE_TOPOLOGY_TRIANGLELIST;
+    render_ctx->all_ritems.ritems[RITEM_SKY].submesh_index = _SPHERE_ID;
     render_ctx->all_ritems.ritems[RITEM_SKY].index_count = render_ctx->geom[GEOM_SHAPES].submesh_geoms[_SPHERE_ID].index_count;
     render_ctx->all_ritems.ritems[RITEM_SKY].start_index_loc = render_ctx->geom[GEOM_SHAPES].submesh_geoms[_SPHERE_ID].start_index_location;
     render_ctx->all_ritems.ritems[RITEM_SKY].base_vertex_loc = render_ctx->geom[GEOM_SHAPES].submesh_geoms[_SPHERE_ID].base_vertex_location;
@@ -756,6 +731,7 @@ create_render_items (D3DRenderContext * render_ctx) {
     render_ctx->all_ritems.ritems[RITEM_QUAD].geometry = &render_ctx->geom[GEOM_SHAPES];
     render_ctx->all_ritems.ritems[RITEM_QUAD].mat = &render_ctx->materials[MAT_BRICK];
     render_ctx->all_ritems.ritems[RITEM_QUAD].primitive_type = D3D_PRIMITIVE_TOPOLOGY_TRIANGLELIST;
+    render_ctx->all_ritems.ritems[RITEM_QUAD].submesh_index = _QUAD_ID;
     render_ctx->all_ritems.ritems[RITEM_QUAD].index_count = render_ctx->geom[GEOM_SHAPES].submesh_geoms[_QUAD_ID].index_count;
     render_ctx->all_ritems.ritems[RITEM_QUAD].start_index_loc = render_ctx->geom[GEOM_SHAPES].submesh_geoms[_QUAD_ID].start_index_location;
     render_ctx->all_ritems.ritems[RITEM_QUAD].base_vertex_loc = render_ctx->geom[GEOM_SHAPES].submesh_geoms[_QUAD_ID].base_vertex_location;
@@ -772,6 +748,7 @@ create_render_items (D3DRenderContext * render_ctx) {
     render_ctx->all_ritems.ritems[RITEM_BOX].geometry = &render_ctx->geom[GEOM_SHAPES];
     render_ctx->all_ritems.ritems[RITEM_BOX].mat = &render_ctx->materials[MAT_BRICK];
     render_ctx->all_ritems.ritems[RITEM_BOX].primitive_type = D3D_PRIMITIVE_TOPOLOGY_TRIANGLELIST;
+    render_ctx->all_ritems.ritems[RITEM_BOX].submesh_index = _BOX_ID;
     render_ctx->all_ritems.ritems[RITEM_BOX].index_count = render_ctx->geom[GEOM_SHAPES].submesh_geoms[_BOX_ID].index_count;
     render_ctx->all_ritems.ritems[RITEM_BOX].start_index_loc = render_ctx->geom[GEOM_SHAPES].submesh_geoms[_BOX_ID].start_index_location;
     render_ctx->all_ritems.ritems[RITEM_BOX].base_vertex_loc = render_ctx->geom[GEOM_SHAPES].submesh_geoms[_BOX_ID].base_vertex_location;
@@ -788,6 +765,7 @@ create_render_items (D3DRenderContext * render_ctx) {
     render_ctx->all_ritems.ritems[RITEM_GLOBE].geometry = &render_ctx->geom[GEOM_SHAPES];
     render_ctx->all_ritems.ritems[RITEM_GLOBE].mat = &render_ctx->materials[MAT_MIRROR];
     render_ctx->all_ritems.ritems[RITEM_GLOBE].primitive_type = D3D_PRIMITIVE_TOPOLOGY_TRIANGLELIST;
+    render_ctx->all_ritems.ritems[RITEM_GLOBE].submesh_index = _SPHERE_ID;
     render_ctx->all_ritems.ritems[RITEM_GLOBE].index_count = render_ctx->geom[GEOM_SHAPES].submesh_geoms[_SPHERE_ID].index_count;
     render_ctx->all_ritems.ritems[RITEM_GLOBE].start_index_loc = render_ctx->geom[GEOM_SHAPES].submesh_geoms[_SPHERE_ID].start_index_location;
     render_ctx->all_ritems.ritems[RITEM_GLOBE].base_vertex_loc = render_ctx->geom[GEOM_SHAPES].submesh_geoms[_SPHERE_ID].base_vertex_location;
@@ -804,6 +782,7 @@ create_render_items (D3DRenderContext * render_ctx) {
     render_ctx->all_ritems.ritems[RITEM_SKULL].geometry = &render_ctx->geom[GEOM_SKULL];
     render_ctx->all_ritems.ritems[RITEM_SKULL].mat = &render_ctx->materials[MAT_SKULL];
     render_ctx->all_ritems.ritems[RITEM_SKULL].primitive_type = D3D_PRIMITIVE_TOPOLOGY_TRIANGLELIST;
+    render_ctx->all_ritems.ritems[RITEM_SKULL].submesh_index = 0;
     render_ctx->all_ritems.ritems[RITEM_SKULL].index_count = render_ctx->geom[GEOM_SKULL].submesh_geoms[0].index_count;
     render_ctx->all_ritems.ritems[RITEM_SKULL].start_index_loc = render_ctx->geom[GEOM_SKULL].submesh_geoms[0].start_index_location;
     render_ctx->all_ritems.ritems[RITEM_SKULL].base_vertex_loc = render_ctx->geom[GEOM_SKULL].submesh_geoms[0].base_vertex_location;
@@ -820,6 +799,7 @@ create_render_items (D3DRenderContext * render_ctx) {
     render_ctx->all_ritems.ritems[RITEM_GRID].geometry = &render_ctx->geom[GEOM_SHAPES];
     render_ctx->all_ritems.ritems[RITEM_GRID].mat = &render_ctx->materials[MAT_TILE];
     render_ctx->all_ritems.ritems[RITEM_GRID].primitive_type = D3D_PRIMITIVE_TOPOLOGY_TRIANGLELIST;
+    render_ctx->all_ritems.ritems[RITEM_GRID].submesh_index = _GRID_ID;
     render_ctx->all_ritems.ritems[RITEM_GRID].index_count = render_ctx->geom[GEOM_SHAPES].submesh_geoms[_GRID_ID].index_count;
     render_ctx->all_ritems.ritems[RITEM_GRID].start_index_loc = render_ctx->geom[GEOM_SHAPES].submesh_geoms[_GRID_ID].start_index_location;
     render_ctx->all_ritems.ritems[RITEM_GRID].base_vertex_loc = render_ctx->geom[GEOM_SHAPES].submesh_geoms[_GRID_ID].base_vertex_location;
@@ -846,6 +826,7 @@ create_render_items (D3DRenderContext * render_ctx) {
         render_ctx->all_ritems.ritems[_curr].geometry = &render_ctx->geom[GEOM_SHAPES];
         render_ctx->all_ritems.ritems[_curr].mat = &render_ctx->materials[MAT_BRICK];
         render_ctx->all_ritems.ritems[_curr].primitive_type = D3D_PRIMITIVE_TOPOLOGY_TRIANGLELIST;
+        render_ctx->all_ritems.ritems[_curr].submesh_index = _CYLINDER_ID;
         render_ctx->all_ritems.ritems[_curr].index_count = render_ctx->geom[GEOM_SHAPES].submesh_geoms[_CYLINDER_ID].index_count;
         render_ctx->all_ritems.ritems[_curr].start_index_loc = render_ctx->geom[GEOM_SHAPES].submesh_geoms[_CYLINDER_ID].start_index_location;
         render_ctx->all_ritems.ritems[_curr].base_vertex_loc = render_ctx->geom[GEOM_SHAPES].submesh_geoms[_CYLINDER_ID].base_vertex_location;
@@ -862,6 +843,7 @@ create_render_items (D3DRenderContext * render_ctx) {
         render_ctx->all_ritems.ritems[_curr].geometry = &render_ctx->geom[GEOM_SHAPES];
         render_ctx->all_ritems.ritems[_curr].mat = &render_ctx->materials[MAT_BRICK];
         render_ctx->all_ritems.ritems[_curr].primitive_type = D3D_PRIMITIVE_TOPOLOGY_TRIANGLELIST;
+        render_ctx->all_ritems.ritems[_curr].submesh_index = _CYLINDER_ID;
         render_ctx->all_ritems.ritems[_curr].index_count = render_ctx->geom[GEOM_SHAPES].submesh_geoms[_CYLINDER_ID].index_count;
         render_ctx->all_ritems.ritems[_curr].start_index_loc = render_ctx->geom[GEOM_SHAPES].submesh_geoms[_CYLINDER_ID].start_index_location;
         render_ctx->all_ritems.ritems[_curr].base_vertex_loc = render_ctx->geom[GEOM_SHAPES].submesh_geoms[_CYLINDER_ID].base_vertex_location;
@@ -878,6 +860,7 @@ create_render_items (D3DRenderContext * render_ctx) {
         render_ctx->all_ritems.ritems[_curr].geometry = &render_ctx->geom[GEOM_SHAPES];
         render_ctx->all_ritems.ritems[_curr].mat = &render_ctx->materials[MAT_MIRROR];
         render_ctx->all_ritems.ritems[_curr].primitive_type = D3D_PRIMITIVE_TOPOLOGY_TRIANGLELIST;
+        render_ctx->all_ritems.ritems[_curr].submesh_index = _SPHERE_ID;
         render_ctx->all_ritems.ritems[_curr].index_count = render_ctx->geom[GEOM_SHAPES].submesh_geoms[_SPHERE_ID].index_count;
         render_ctx->all_ritems.ritems[_curr].start_index_loc = render_ctx->geom[GEOM_SHAPES].submesh_geoms[_SPHERE_ID].start_index_location;
         render_ctx->all_ritems.ritems[_curr].base_vertex_loc = render_ctx->geom[GEOM_SHAPES].submesh_geoms[_SPHERE_ID].base_vertex_location;
@@ -894,6 +877,7 @@ create_render_items (D3DRenderContext * render_ctx) {
         render_ctx->all_ritems.ritems[_curr].geometry = &render_ctx->geom[GEOM_SHAPES];
         render_ctx->all_ritems.ritems[_curr].mat = &render_ctx->materials[MAT_MIRROR];
         render_ctx->all_ritems.ritems[_curr].primitive_type = D3D_PRIMITIVE_TOPOLOGY_TRIANGLELIST;
+        render_ctx->all_ritems.ritems[_curr].submesh_index = _SPHERE_ID;
         render_ctx->all_ritems.ritems[_curr].index_count = render_ctx->geom[GEOM_SHAPES].submesh_geoms[_SPHERE_ID].index_count;
         render_ctx->all_ritems.ritems[_curr].start_index_loc = render_ctx->geom[GEOM_SHAPES].submesh_geoms[_SPHERE_ID].start_index_location;
         render_ctx->all_ritems.ritems[_curr].base_vertex_loc = render_ctx->geom[GEOM_SHAPES].submesh_geoms[_SPHERE_ID].base_vertex_location;
@@ -905,20 +889,34 @@ create_render_items (D3DRenderContext * render_ctx) {
         _curr++;
     }
     _ASSERT_EXPR(_curr == _COUNT_RENDERITEM, _T("Invalid render items creation"));
+
+    render_item_bounds_from_submeshes(render_ctx->all_ritems.ritems, render_ctx->all_ritems.size);
+    render_item_bounds_from_submeshes(render_ctx->opaque_ritems.ritems, render_ctx->opaque_ritems.size);
 }
+// [visible] (optional) skips the items whose flag is false (indexed like ritem_array->ritems)
 static void
 draw_render_items (
     ID3D12GraphicsCommandList * cmd_list,
     ID3D12Resource * obj_cb,
-    RenderItemArray * ritem_array
+    RenderItemArray * ritem_array,
+    bool const * visible = nullptr
 ) {
     size_t obj_cbuffer_size = sizeof(ObjectConstants);
+    // pooled geometries share their buffers, so only bind when they change
+    D3D12_GPU_VIRTUAL_ADDRESS bound_vb = 0;
+    D3D12_GPU_VIRTUAL_ADDRESS bound_ib = 0;
     for (size_t i = 0; i < ritem_array->size; ++i) {
-        if (ritem_array->ritems[i].initialized) {
+        if (ritem_array->ritems[i].initialized && (nullptr == visible || visible[i])) {
             D3D12_VERTEX_BUFFER_VIEW vbv = Mesh_GetVertexBufferView(ritem_array->ritems[i].geometry);
             D3D12_INDEX_BUFFER_VIEW ibv = Mesh_GetIndexBufferView(ritem_array->ritems[i].geometry);
-            cmd_list->IASetVertexBuffers(0, 1, &vbv);
-            cmd_list->IASetIndexBuffer(&ibv);
+            if (vbv.BufferLocation != bound_vb) {
+                cmd_list->IASetVertexBuffers(0, 1, &vbv);
+                bound_vb = vbv.BufferLocation;
+            }
+            if (ibv.BufferLocation != bound_ib) {
+                cmd_list->IASetIndexBuffer(&ibv);
+                bound_ib = ibv.BufferLocation;
+            }
             cmd_list->IASetPrimitiveTopology(ritem_array->ritems[i].primitive_type);
 
             D3D12_GPU_VIRTUAL_ADDRESS obj_cb_address =
@@ -1701,6 +1699,40 @@ update_shadow_transform (GameTimer * timer) {
     XMStoreFloat4x4(&g_scene_ctx.light_proj_mat, light_proj);
     XMStoreFloat4x4(&g_scene_ctx.shadow_transform, S);
 }
+// Culls opaque_ritems against the camera frustum, and as shadow casters against the light volume
+// intersected with the camera frustum extruded toward the light
+static void
+update_render_item_culling (D3DRenderContext * render_ctx) {
+    RenderItemArray const * opaque = &render_ctx->opaque_ritems;
+    RenderItemBounds_Update(&g_ritem_culling.bounds, opaque->ritems, opaque->size);
+
+    XMMATRIX view_proj = XMMatrixMultiply(Camera_GetView(g_camera), Camera_GetProj(g_camera));
+    CullPlaneSet camera_planes = {};
+    CullPlaneSet_AddFrustum(&camera_planes, view_proj);
+    g_ritem_culling.camera_visible_count = RenderItemBounds_Cull(&g_ritem_culling.bounds, &camera_planes, g_ritem_culling.camera_visible);
+
+    XMMATRIX light_view_proj = XMMatrixMultiply(XMLoadFloat4x4(&g_scene_ctx.light_view_mat), XMLoadFloat4x4(&g_scene_ctx.light_proj_mat));
+    CullPlaneSet caster_planes = {};
+    CullPlaneSet_AddFrustum(&caster_planes, light_view_proj);
+    CullPlaneSet_AddShadowCasters(&caster_planes, view_proj, XMLoadFloat3(&g_scene_ctx.rotated_light_dirs[0]));
+    g_ritem_culling.caster_visible_count = RenderItemBounds_Cull(&g_ritem_culling.bounds, &caster_planes, g_ritem_culling.caster_visible);
+
+    if (g_coverage_culling_enabled) {
+        ScreenCoverageParams coverage = {};
+        coverage.eye_pos = Camera_GetPosition3f(g_camera);
+        coverage.proj_scale = coverage_projection_scale(Camera_GetProj4x4f(g_camera), (float)g_scene_ctx.height);
+        coverage.min_pixels = g_coverage_min_pixels;
+        coverage.shadow_min_pixels = g_shadow_min_pixels;
+        cull_render_items_by_coverage(opaque->ritems, opaque->size, coverage, g_ritem_culling.camera_visible, g_ritem_culling.caster_visible);
+
+        g_ritem_culling.camera_visible_count = 0;
+        g_ritem_culling.caster_visible_count = 0;
+        for (UINT i = 0; i < opaque->size; ++i) {
+            g_ritem_culling.camera_visible_count += g_ritem_culling.camera_visible[i];
+            g_ritem_culling.caster_visible_count += g_ritem_culling.caster_visible[i];
+        }
+    }
+}
 static void
 update_shadow_pass_cb(ShadowMap * smap, D3DRenderContext * render_ctx, GameTimer * timer) {
     XMMATRIX view = XMLoadFloat4x4(&g_scene_ctx.light_view_mat);
@@ -1780,6 +1812,45 @@ flush_command_queue (D3DRenderContext * render_ctx) {
         }
     }
 }
+// Render items keep copies of their submesh locations, re-read them after the pool moved things
+static void
+refresh_render_item_locations (RenderItemArray * ritems) {
+    for (UINT i = 0; i < ritems->size; ++i) {
+        RenderItem * ritem = &ritems->ritems[i];
+        SubmeshGeometry const * submesh = &ritem->geometry->submesh_geoms[ritem->submesh_index];
+        ritem->index_count = submesh->index_count;
+        ritem->start_index_loc = submesh->start_index_location;
+        ritem->base_vertex_loc = submesh->base_vertex_location;
+    }
+}
+// Takes the skull out of its pool, puts it back and defragments the pools,
+// then uploads the moved ranges before anything is drawn from them again.
+static void
+repack_geometry_pool (D3DRenderContext * render_ctx) {
+    flush_command_queue(render_ctx);
+
+    MeshGeometry * skull = &render_ctx->geom[GEOM_SKULL];
+    GeometryPool_RemoveMesh(geometry_pool_of(render_ctx, skull), render_ctx->geom_pool_handles[GEOM_SKULL]);
+    add_to_geometry_pool(render_ctx, GEOM_SKULL, 1, "skull");
+    for (unsigned i = 0; i < _COUNT_GEOM_POOL; ++i)
+        if (render_ctx->geom_pools[i].vertex_arena.gpu)
+            GeometryPool_Defragment(&render_ctx->geom_pools[i]);
+
+    refresh_render_item_locations(&render_ctx->all_ritems);
+    refresh_render_item_locations(&render_ctx->opaque_ritems);
+    refresh_render_item_locations(&render_ctx->environment_ritems);
+    refresh_render_item_locations(&render_ctx->debug_ritems);
+
+    render_ctx->direct_cmd_list->Reset(render_ctx->direct_cmd_list_alloc, nullptr);
+    for (unsigned i = 0; i < _COUNT_GEOM_POOL; ++i)
+        if (render_ctx->geom_pools[i].vertex_arena.gpu)
+            GeometryPool_Upload(&render_ctx->geom_pools[i], render_ctx->device, render_ctx->direct_cmd_list);
+    render_ctx->direct_cmd_list->Close();
+    ID3D12CommandList * cmd_lists [] = {render_ctx->direct_cmd_list};
+    render_ctx->cmd_queue->ExecuteCommandLists(ARRAY_COUNT(cmd_lists), cmd_lists);
+
+    flush_command_queue(render_ctx);
+}
 static void
 draw_scene_to_shadow_map (ShadowMap * smap, D3DRenderContext * render_ctx) {
     UINT frame_index = render_ctx->frame_index;
@@ -1814,7 +1885,8 @@ draw_scene_to_shadow_map (ShadowMap * smap, D3DRenderContext * render_ctx) {
 
     cmdlist->SetPipelineState(render_ctx->psos[LAYER_SHADOW_OPAQUE]);
 
-    draw_render_items(cmdlist, render_ctx->frame_resources[frame_index].obj_cb, &render_ctx->opaque_ritems);
+    draw_render_items(cmdlist, render_ctx->frame_resources[frame_index].obj_cb, &render_ctx->opaque_ritems,
+                      g_ritem_culling_enabled ? g_ritem_culling.caster_visible : nullptr);
 
     // change back to generic read so texture can be read in shader
     resource_usage_transition(
@@ -1905,7 +1977,8 @@ draw_main (D3DRenderContext * render_ctx, ShadowMap * smap) {
     draw_render_items(
         cmdlist,
         render_ctx->frame_resources[frame_index].obj_cb,
-        &render_ctx->opaque_ritems
+        &render_ctx->opaque_ritems,
+        g_ritem_culling_enabled ? g_ritem_culling.camera_visible : nullptr
     );
 
     // 2. draw debug quad
@@ -2631,6 +2704,9 @@ WinMain(_In_ HINSTANCE hInstance, _In_opt_ HINSTANCE, _In_ LPSTR, _In_ INT) {
 #pragma region Shapes_And_Renderitem_Creation
     create_skull_geometry(render_ctx);
     create_shapes_geometry(render_ctx);
+    for (unsigned i = 0; i < _COUNT_GEOM_POOL; ++i)
+        if (render_ctx->geom_pools[i].vertex_arena.gpu)
+            GeometryPool_Upload(&render_ctx->geom_pools[i], render_ctx->device, render_ctx->direct_cmd_list);
     create_materials(render_ctx->materials);
     create_render_items(render_ctx);
 
@@ -2798,6 +2874,19 @@ WinMain(_In_ HINSTANCE hInstance, _In_opt_ HINSTANCE, _In_ LPSTR, _In_ INT) {
                     "Skybox Texture", &selected_mat,
                     "   Grass Cube\0   Desert Cube\0   Snow Cube\0   Sunset Cube\0\0");
 
+                ImGui::Separator();
+                ImGui::Checkbox("Render Item Culling", &g_ritem_culling_enabled);
+                if (g_ritem_culling_enabled)
+                    ImGui::Text("Opaque items: %u / %u in view, %u shadow casters",
+                        g_ritem_culling.camera_visible_count, g_ritem_culling.bounds.count, g_ritem_culling.caster_visible_count);
+                ImGui::Checkbox("Screen Coverage Culling", &g_coverage_culling_enabled);
+                if (g_coverage_culling_enabled) {
+                    ImGui::SliderFloat("Min Pixels", &g_coverage_min_pixels, 0.25f, 64.0f, "%.2f");
+                    ImGui::SliderFloat("Shadow Min Pixels", &g_shadow_min_pixels, 0.25f, 64.0f, "%.2f");
+                }
+                if (ImGui::Button("Repack Geometry Pool"))
+                    g_repack_geometry_pool = true;
+
                 ImGui::Text("\n");
                 ImGui::Separator();
                 ImGui::Text("Application average %.3f ms/frame (%.1f FPS)", 1000.0f / ImGui::GetIO().Framerate, ImGui::GetIO().Framerate);
@@ -2822,6 +2911,10 @@ WinMain(_In_ HINSTANCE hInstance, _In_opt_ HINSTANCE, _In_ LPSTR, _In_ INT) {
             Timer_Tick(&g_timer);
 
             if (!g_paused) {
+                if (g_repack_geometry_pool) {
+                    g_repack_geometry_pool = false;
+                    repack_geometry_pool(render_ctx);
+                }
                 move_to_next_frame(render_ctx, &render_ctx->frame_index);
 
                 //
@@ -2841,6 +2934,8 @@ WinMain(_In_ HINSTANCE hInstance, _In_opt_ HINSTANCE, _In_ LPSTR, _In_ INT) {
 
                 update_shadow_transform(&g_timer);
                 update_shadow_pass_cb(g_smap, render_ctx, &g_timer);
+                if (g_ritem_culling_enabled)
+                    update_render_item_culling(render_ctx);
 
                 update_object_cbuffer(render_ctx);
 
@@ -2879,12 +2974,10 @@ WinMain(_In_ HINSTANCE hInstance, _In_opt_ HINSTANCE, _In_ LPSTR, _In_ INT) {
     CloseHandle(render_ctx->fence_event);
     render_ctx->fence->Release();
 
-    for (unsigned i = 0; i < _COUNT_GEOM; i++) {
-        render_ctx->geom[i].ib_uploader->Release();
-        render_ctx->geom[i].vb_uploader->Release();
-        render_ctx->geom[i].vb_gpu->Release();
-        render_ctx->geom[i].ib_gpu->Release();
-    }
+    for (unsigned i = 0; i < _COUNT_GEOM; i++)
+        Mesh_Dispose(&render_ctx->geom[i]);
+    for (unsigned i = 0; i < _COUNT_GEOM_POOL; i++)
+        GeometryPool_Release(&render_ctx->geom_pools[i]);
 
     for (int i = 0; i < _COUNT_RENDERCOMPUTE_LAYER; ++i)
         render_ctx->psos[i]->Release();
@@ -0,0 +1,404 @@
+/* ===========================================================
+   #File: geometry_pool.h #
+   #Date: 17 Oct 2026 #
+   #Revision: 1.0 #
+   #Creator: Omid Miresmaeili #
+   #Description: shared vertex/index buffers with suballocated mesh ranges #
+   #Notice: (C) Copyright 2021 by Omid. All Rights Reserved. #
+   =========================================================== */
+#pragma once
+
+#include "common.h"
+#include "mesh_geometry.h"
+
+//
+// Geometry pool
+//
+// One default heap vertex buffer and one index buffer shared by every mesh of a vertex
+// layout and index format. Meshes get a vertex range and an index range from a first-fit
+// free list, and their submesh locations are rebased so they draw straight from the pool
+// buffers: all the meshes of a pool bind the same views and can be merged into one draw.
+// A system memory copy of both buffers is kept so ranges can be compacted (defragmented)
+// and re-uploaded without reading back from the GPU.
+//
+#define GEOMETRY_POOL_MAX_MESHES        32
+#define GEOMETRY_POOL_MAX_FREE_RANGES   (GEOMETRY_POOL_MAX_MESHES + 1)
+
+// Range of vertices or indices (in elements, not bytes)
+struct GeometryRange {
+    UINT offset;
+    UINT count;
+};
+
+// One shared buffer with its free list and the range not uploaded yet
+struct GeometryArena {
+    ID3D12Resource *        gpu;
+    D3D12_RESOURCE_STATES   state;
+    BYTE *                  cpu;
+    UINT                    element_size;
+    UINT                    capacity;
+
+    // Sorted by offset, never adjacent (freeing coalesces neighbours)
+    GeometryRange           free_ranges [GEOMETRY_POOL_MAX_FREE_RANGES];
+    UINT                    free_count;
+
+    UINT                    dirty_begin;    // dirty_begin >= dirty_end when clean
+    UINT                    dirty_end;
+};
+
+// A mesh placed in the pool, returned as a handle by GeometryPool_AddMesh
+struct GeometryAllocation {
+    bool                    in_use;
+    MeshGeometry *          mesh;
+    UINT                    submesh_count;
+    GeometryRange           vertices;
+    GeometryRange           indices;
+};
+
+struct GeometryPool {
+    GeometryArena               vertex_arena;
+    GeometryArena               index_arena;
+    DXGI_FORMAT                 index_format;
+
+    D3D12_VERTEX_BUFFER_VIEW    vbv;
+    D3D12_INDEX_BUFFER_VIEW     ibv;
+
+    // Staging buffer of the last upload, kept alive until the next one
+    ID3D12Resource *            uploader;
+
+    GeometryAllocation          allocations [GEOMETRY_POOL_MAX_MESHES];
+};
+
+static void
+geometry_arena_init (ID3D12Device * device, GeometryArena * arena, UINT element_size, UINT capacity) {
+    arena->element_size = element_size;
+    arena->capacity = capacity;
+    arena->cpu = (BYTE *)::malloc((size_t)element_size * capacity);
+    arena->free_ranges[0] = {.offset = 0, .count = capacity};
+    arena->free_count = 1;
+    arena->dirty_begin = capacity;
+    arena->dirty_end = 0;
+
+    D3D12_HEAP_PROPERTIES def_heap = {};
+    def_heap.Type = D3D12_HEAP_TYPE_DEFAULT;
+    def_heap.CPUPageProperty = D3D12_CPU_PAGE_PROPERTY_UNKNOWN;
+    def_heap.MemoryPoolPreference = D3D12_MEMORY_POOL_UNKNOWN;
+    def_heap.CreationNodeMask = 1;
+    def_heap.VisibleNodeMask = 1;
+
+    D3D12_RESOURCE_DESC buf_desc = {};
+    buf_desc.Dimension = D3D12_RESOURCE_DIMENSION_BUFFER;
+    buf_desc.Alignment = 0;
+    buf_desc.Width = (UINT64)element_size * capacity;
+    buf_desc.Height = 1;
+    buf_desc.DepthOrArraySize = 1;
+    buf_desc.MipLevels = 1;
+    buf_desc.Format = DXGI_FORMAT_UNKNOWN;
+    buf_desc.SampleDesc = {.Count = 1, .Quality = 0};
+    buf_desc.Layout = D3D12_TEXTURE_LAYOUT_ROW_MAJOR;
+    buf_desc.Flags = D3D12_RESOURCE_FLAG_NONE;
+
+    device->CreateCommittedResource(
+        &def_heap, D3D12_HEAP_FLAG_NONE, &buf_desc, D3D12_RESOURCE_STATE_COMMON, nullptr, IID_PPV_ARGS(&arena->gpu));
+    arena->state = D3D12_RESOURCE_STATE_COMMON;
+}
+// First fit, returns UINT_MAX when no free range is large enough
+static UINT
+geometry_arena_alloc (GeometryArena * arena, UINT count) {
+    for (UINT i = 0; i < arena->free_count; ++i) {
+        GeometryRange * range = &arena->free_ranges[i];
+        if (range->count < count)
+            continue;
+        UINT offset = range->offset;
+        range->offset += count;
+        range->count -= count;
+        if (0 == range->count) {
+            memmove(range, range + 1, sizeof(GeometryRange) * (arena->free_count - i - 1));
+            --arena->free_count;
+        }
+        return offset;
+    }
+    return UINT_MAX;
+}
+static void
+geometry_arena_free (GeometryArena * arena, GeometryRange freed) {
+    if (0 == freed.count)
+        return;
+    UINT i = 0;
+    while (i < arena->free_count && arena->free_ranges[i].offset < freed.offset)
+        ++i;
+
+    bool merge_prev = i > 0 &&
+        arena->free_ranges[i - 1].offset + arena->free_ranges[i - 1].count == freed.offset;
+    bool merge_next = i < arena->free_count &&
+        freed.offset + freed.count == arena->free_ranges[i].offset;
+    if (merge_prev && merge_next) {
+        arena->free_ranges[i - 1].count += freed.count + arena->free_ranges[i].count;
+        memmove(&arena->free_ranges[i], &arena->free_ranges[i + 1], sizeof(GeometryRange) * (arena->free_count - i - 1));
+        --arena->free_count;
+    } else if (merge_prev) {
+        arena->free_ranges[i - 1].count += freed.count;
+    } else if (merge_next) {
+        arena->free_ranges[i].offset = freed.offset;
+        arena->free_ranges[i].count += freed.count;
+    } else {
+        // one free range more than live ranges at most, so this always fits
+        _ASSERT_EXPR(arena->free_count < GEOMETRY_POOL_MAX_FREE_RANGES, _T("Geometry pool free list overflow"));
+        memmove(&arena->free_ranges[i + 1], &arena->free_ranges[i], sizeof(GeometryRange) * (arena->free_count - i));
+        arena->free_ranges[i] = freed;
+        ++arena->free_count;
+    }
+}
+static void
+geometry_arena_mark_dirty (GeometryArena * arena, GeometryRange range) {
+    if (range.offset < arena->dirty_begin)
+        arena->dirty_begin = range.offset;
+    if (range.offset + range.count > arena->dirty_end)
+        arena->dirty_end = range.offset + range.count;
+}
+static UINT
+geometry_arena_free_count (GeometryArena const * arena) {
+    UINT ret = 0;
+    for (UINT i = 0; i < arena->free_count; ++i)
+        ret += arena->free_ranges[i].count;
+    return ret;
+}
+// Shifts the submesh locations of an allocation after it has been placed or moved
+static void
+geometry_allocation_rebase (GeometryAllocation * alloc, INT vertex_delta, INT index_delta) {
+    for (UINT s = 0; s < alloc->submesh_count; ++s) {
+        SubmeshGeometry * submesh = &alloc->mesh->submesh_geoms[s];
+        submesh->base_vertex_location += vertex_delta;
+        submesh->start_index_location += index_delta;
+        for (UINT l = 0; l < submesh->lod_count; ++l)
+            submesh->lods[l].start_index_location += index_delta;
+    }
+}
+
+static void
+GeometryPool_Init (
+    GeometryPool * pool, ID3D12Device * device,
+    UINT vertex_stride, DXGI_FORMAT index_format, UINT vertex_capacity, UINT index_capacity
+) {
+    *pool = {};
+    pool->index_format = index_format;
+    geometry_arena_init(device, &pool->vertex_arena, vertex_stride, vertex_capacity);
+    geometry_arena_init(device, &pool->index_arena,
+        DXGI_FORMAT_R16_UINT == index_format ? sizeof(uint16_t) : sizeof(uint32_t), index_capacity);
+
+    pool->vbv.BufferLocation = pool->vertex_arena.gpu->GetGPUVirtualAddress();
+    pool->vbv.StrideInBytes = vertex_stride;
+    pool->vbv.SizeInBytes = vertex_stride * vertex_capacity;
+    pool->ibv.BufferLocation = pool->index_arena.gpu->GetGPUVirtualAddress();
+    pool->ibv.Format = index_format;
+    pool->ibv.SizeInBytes = pool->index_arena.element_size * index_capacity;
+}
+// Copies the CPU blobs of [mesh] into the pool, rebases its first [submesh_count] submeshes
+// (and their LODs) to absolute pool locations and points its views at the pool buffers.
+// The mesh keeps its blobs and must not own vb_gpu/ib_gpu. Returns the allocation handle,
+// or UINT_MAX if the formats don't match or the pool is full.
+static UINT
+GeometryPool_AddMesh (GeometryPool * pool, MeshGeometry * mesh, UINT submesh_count, char const * name) {
+    UINT handle = UINT_MAX;
+    for (UINT i = 0; i < GEOMETRY_POOL_MAX_MESHES && UINT_MAX == handle; ++i)
+        if (!pool->allocations[i].in_use)
+            handle = i;
+    if (UINT_MAX == handle ||
+        mesh->vb_byte_stide != pool->vertex_arena.element_size || mesh->index_format != pool->index_format)
+        return UINT_MAX;
+
+    UINT vertex_count = mesh->vb_byte_size / pool->vertex_arena.element_size;
+    UINT index_count = mesh->ib_byte_size / pool->index_arena.element_size;
+    UINT vertex_offset = geometry_arena_alloc(&pool->vertex_arena, vertex_count);
+    if (UINT_MAX == vertex_offset)
+        return UINT_MAX;
+    UINT index_offset = geometry_arena_alloc(&pool->index_arena, index_count);
+    if (UINT_MAX == index_offset) {
+        geometry_arena_free(&pool->vertex_arena, {.offset = vertex_offset, .count = vertex_count});
+        return UINT_MAX;
+    }
+
+    GeometryAllocation * alloc = &pool->allocations[handle];
+    alloc->in_use = true;
+    alloc->mesh = mesh;
+    alloc->submesh_count = submesh_count;
+    alloc->vertices = {.offset = vertex_offset, .count = vertex_count};
+    alloc->indices = {.offset = index_offset, .count = index_count};
+
+    memcpy(pool->vertex_arena.cpu + (size_t)vertex_offset * pool->vertex_arena.element_size,
+        mesh->vb_cpu->GetBufferPointer(), mesh->vb_byte_size);
+    memcpy(pool->index_arena.cpu + (size_t)index_offset * pool->index_arena.element_size,
+        mesh->ib_cpu->GetBufferPointer(), mesh->ib_byte_size);
+    geometry_arena_mark_dirty(&pool->vertex_arena, alloc->vertices);
+    geometry_arena_mark_dirty(&pool->index_arena, alloc->indices);
+
+    geometry_allocation_rebase(alloc, (INT)vertex_offset, (INT)index_offset);
+    mesh->pool_vbv = &pool->vbv;
+    mesh->pool_ibv = &pool->ibv;
+
+    char buf[256];
+    sprintf_s(buf, sizeof(buf), "[pool] %s: vertices [%u, %u), indices [%u, %u)\n",
+        name, vertex_offset, vertex_offset + vertex_count, index_offset, index_offset + index_count);
+    ::OutputDebugStringA(buf);
+    return handle;
+}
+// Returns the ranges of a mesh to the free lists and restores its relative submesh locations
+static void
+GeometryPool_RemoveMesh (GeometryPool * pool, UINT handle) {
+    GeometryAllocation * alloc = &pool->allocations[handle];
+    if (!alloc->in_use)
+        return;
+    geometry_allocation_rebase(alloc, -(INT)alloc->vertices.offset, -(INT)alloc->indices.offset);
+    alloc->mesh->pool_vbv = nullptr;
+    alloc->mesh->pool_ibv = nullptr;
+    geometry_arena_free(&pool->vertex_arena, alloc->vertices);
+    geometry_arena_free(&pool->index_arena, alloc->indices);
+    *alloc = {};
+}
+// Slides every allocation of an arena down to close the holes, rebasing the submeshes that moved.
+// [vertex_arena] selects which of the two ranges of an allocation is compacted.
+static void
+geometry_pool_compact (GeometryPool * pool, bool vertex_arena) {
+    GeometryArena * arena = vertex_arena ? &pool->vertex_arena : &pool->index_arena;
+    UINT cursor = 0;
+    for (;;) {
+        // -- next allocation in address order
+        GeometryAllocation * next = nullptr;
+        for (UINT i = 0; i < GEOMETRY_POOL_MAX_MESHES; ++i) {
+            GeometryAllocation * alloc = &pool->allocations[i];
+            GeometryRange * range = vertex_arena ? &alloc->vertices : &alloc->indices;
+            if (!alloc->in_use || range->offset < cursor || 0 == range->count)
+                continue;
+            GeometryRange * best = next ? (vertex_arena ? &next->vertices : &next->indices) : nullptr;
+            if (nullptr == best || range->offset < best->offset)
+                next = alloc;
+        }
+        if (nullptr == next)
+            break;
+
+        GeometryRange * range = vertex_arena ? &next->vertices : &next->indices;
+        if (range->offset != cursor) {
+            memmove(arena->cpu + (size_t)cursor * arena->element_size,
+                arena->cpu + (size_t)range->offset * arena->element_size,
+                (size_t)range->count * arena->element_size);
+            INT delta = (INT)cursor - (INT)range->offset;
+            geometry_allocation_rebase(next, vertex_arena ? delta : 0, vertex_arena ? 0 : delta);
+            range->offset = cursor;
+            geometry_arena_mark_dirty(arena, *range);
+        }
+        cursor += range->count;
+    }
+    arena->free_ranges[0] = {.offset = cursor, .count = arena->capacity - cursor};
+    arena->free_count = cursor < arena->capacity ? 1 : 0;
+}
+// Packs all meshes at the start of the pool so the free space is one range again.
+// Submesh locations are updated, so anything that copied them (e.g. render items) has to
+// re-read them, and GeometryPool_Upload has to run before the next draw from the pool.
+static void
+GeometryPool_Defragment (GeometryPool * pool) {
+    UINT vertex_holes = pool->vertex_arena.free_count;
+    UINT index_holes = pool->index_arena.free_count;
+    geometry_pool_compact(pool, true);
+    geometry_pool_compact(pool, false);
+
+    char buf[256];
+    sprintf_s(buf, sizeof(buf), "[pool] defragment: %u -> %u vertex, %u -> %u index free ranges\n",
+        vertex_holes, pool->vertex_arena.free_count, index_holes, pool->index_arena.free_count);
+    ::OutputDebugStringA(buf);
+}
+// Records the copy of the ranges added or moved since the last upload into the pool buffers.
+// The previous staging buffer is released, so the GPU must be done with the last upload.
+static void
+GeometryPool_Upload (GeometryPool * pool, ID3D12Device * device, ID3D12GraphicsCommandList * cmd_list) {
+    GeometryArena * arenas [] = {&pool->vertex_arena, &pool->index_arena};
+    UINT64 dirty_bytes [2] = {};
+    UINT64 total_bytes = 0;
+    for (UINT a = 0; a < 2; ++a) {
+        GeometryArena * arena = arenas[a];
+        if (arena->dirty_begin < arena->dirty_end)
+            dirty_bytes[a] = (UINT64)(arena->dirty_end - arena->dirty_begin) * arena->element_size;
+        total_bytes += dirty_bytes[a];
+    }
+    if (0 == total_bytes)
+        return;
+
+    if (pool->uploader) {
+        pool->uploader->Release();
+        pool->uploader = nullptr;
+    }
+    D3D12_HEAP_PROPERTIES upload_heap = {};
+    upload_heap.Type = D3D12_HEAP_TYPE_UPLOAD;
+    upload_heap.CPUPageProperty = D3D12_CPU_PAGE_PROPERTY_UNKNOWN;
+    upload_heap.MemoryPoolPreference = D3D12_MEMORY_POOL_UNKNOWN;
+    upload_heap.CreationNodeMask = 1;
+    upload_heap.VisibleNodeMask = 1;
+
+    D3D12_RESOURCE_DESC buf_desc = {};
+    buf_desc.Dimension = D3D12_RESOURCE_DIMENSION_BUFFER;
+    buf_desc.Alignment = 0;
+    buf_desc.Width = total_bytes;
+    buf_desc.Height = 1;
+    buf_desc.DepthOrArraySize = 1;
+    buf_desc.MipLevels = 1;
+    buf_desc.Format = DXGI_FORMAT_UNKNOWN;
+    buf_desc.SampleDesc = {.Count = 1, .Quality = 0};
+    buf_desc.Layout = D3D12_TEXTURE_LAYOUT_ROW_MAJOR;
+    buf_desc.Flags = D3D12_RESOURCE_FLAG_NONE;
+
+    device->CreateCommittedResource(
+        &upload_heap, D3D12_HEAP_FLAG_NONE, &buf_desc, D3D12_RESOURCE_STATE_GENERIC_READ, nullptr, IID_PPV_ARGS(&pool->uploader));
+
+    BYTE * mapped = nullptr;
+    pool->uploader->Map(0, nullptr, reinterpret_cast<void **>(&mapped));
+    UINT64 upload_offset = 0;
+    for (UINT a = 0; a < 2; ++a) {
+        GeometryArena * arena = arenas[a];
+        if (0 == dirty_bytes[a])
+            continue;
+        UINT64 dst_offset = (UINT64)arena->dirty_begin * arena->element_size;
+        memcpy(mapped + upload_offset, arena->cpu + dst_offset, dirty_bytes[a]);
+
+        D3D12_RESOURCE_BARRIER barrier = {};
+        barrier.Type = D3D12_RESOURCE_BARRIER_TYPE_TRANSITION;
+        barrier.Flags = D3D12_RESOURCE_BARRIER_FLAG_NONE;
+        barrier.Transition.pResource = arena->gpu;
+        barrier.Transition.Subresource = D3D12_RESOURCE_BARRIER_ALL_SUBRESOURCES;
+        barrier.Transition.StateBefore = arena->state;
+        barrier.Transition.StateAfter = D3D12_RESOURCE_STATE_COPY_DEST;
+        cmd_list->ResourceBarrier(1, &barrier);
+        cmd_list->CopyBufferRegion(arena->gpu, dst_offset, pool->uploader, upload_offset, dirty_bytes[a]);
+        barrier.Transition.StateBefore = D3D12_RESOURCE_STATE_COPY_DEST;
+        barrier.Transition.StateAfter = D3D12_RESOURCE_STATE_GENERIC_READ;
+        cmd_list->ResourceBarrier(1, &barrier);
+        arena->state = D3D12_RESOURCE_STATE_GENERIC_READ;
+
+        upload_offset += dirty_bytes[a];
+        arena->dirty_begin = arena->capacity;
+        arena->dirty_end = 0;
+    }
+    pool->uploader->Unmap(0, nullptr);
+
+    char buf[256];
+    sprintf_s(buf, sizeof(buf), "[pool] upload %llu bytes, %u/%u vertices and %u/%u indices free\n",
+        total_bytes,
+        geometry_arena_free_count(&pool->vertex_arena), pool->vertex_arena.capacity,
+        geometry_arena_free_count(&pool->index_arena), pool->index_arena.capacity);
+    ::OutputDebugStringA(buf);
+}
+static void
+GeometryPool_Release (GeometryPool * pool) {
+    for (UINT i = 0; i < GEOMETRY_POOL_MAX_MESHES; ++i)
+        if (pool->allocations[i].in_use) {
+            pool->allocations[i].mesh->pool_vbv = nullptr;
+            pool->allocations[i].mesh->pool_ibv = nullptr;
+        }
+    GeometryArena * arenas [] = {&pool->vertex_arena, &pool->index_arena};
+    for (UINT a = 0; a < 2; ++a) {
+        if (arenas[a]->gpu)
+            arenas[a]->gpu->Release();
+        ::free(arenas[a]->cpu);
+    }
+    if (pool->uploader)
+        pool->uploader->Release();
+    *pool = {};
+}
@@ -11,6 +11,39 @@
 #include "headers/common.h"
 
 #define MAX_SUBMESH_COUNT    50
+#define MAX_LOD_COUNT        4
+
+// Vertex layout of a MeshGeometry
+enum VERTEX_ENCODING : UINT {
+    VERTEX_ENCODING_FLOAT32 = 0,
+    VERTEX_ENCODING_QUANTIZED = 1,
+
+    _COUNT_VERTEX_ENCODING
+};
+
+// Cluster of triangles stored contiguously in the index buffer (see headers/meshlet.h)
+struct Meshlet {
+    UINT start_index_location;      // relative to the submesh
+    UINT index_count;
+    UINT vertex_count;              // unique vertices referenced
+
+    // Bounding sphere
+    DirectX::XMFLOAT3 center;
+    float radius;
+
+    // Normal cone: the meshlet is backfacing from every view point (or direction)
+    // inside the cone at cone_apex around -cone_axis. cone_cutoff == 1 never culls.
+    DirectX::XMFLOAT3 cone_apex;
+    DirectX::XMFLOAT3 cone_axis;
+    float cone_cutoff;
+};
+
+// Level of detail of a submesh: a simplified index range into the same vertex buffer (see headers/mesh_lod.h)
+struct MeshLod {
+    UINT index_count;
+    UINT start_index_location;
+    float error;                    // object space deviation from the full resolution submesh
+};
 
 // Defines a subrange of geometry in a MeshGeometry.  This is for when multiple
 // geometries are stored in one vertex and index buffer.  It provides the offsets
@@ -24,6 +57,14 @@ struct SubmeshGeometry {
     // Bounding box of the geometry defined by this submesh. 
     // Not used for now
     DirectX::BoundingBox bounds;
+
+    // Meshlets of this submesh in MeshGeometry::meshlets (none if meshlet_count is 0)
+    UINT meshlet_offset;
+    UINT meshlet_count;
+
+    // LOD chain, lods[0] is the submesh itself (none if lod_count is 0)
+    UINT lod_count;
+    MeshLod lods [MAX_LOD_COUNT];
 };
 struct MeshGeometry {
     // Give it a name so we can look it up by name.
@@ -38,6 +79,9 @@ struct MeshGeometry {
     ID3DBlob * vb_cpu;
     ID3DBlob * ib_cpu;
 
+    // Triangle BVH over the system memory copies for ray queries (see headers/triangle_bvh.h), null if not built
+    struct TriangleBvh * triangle_bvh;
+
     ID3D12Resource * vb_gpu;
     ID3D12Resource * ib_gpu;
 
@@ -46,6 +90,19 @@ struct MeshGeometry {
 
     DXGI_FORMAT index_format;
 
+    // Quantized meshes store positions relative to each submesh's bounds,
+    // so the bounds are needed to decode them.
+    VERTEX_ENCODING vertex_encoding;
+
+    // Meshlets of all submeshes (malloc'ed), see SubmeshGeometry::meshlet_offset
+    Meshlet *       meshlets;
+    UINT            meshlet_count;
+
+    // Views of the shared buffers when the mesh lives in a GeometryPool (see headers/geometry_pool.h).
+    // The pool owns the GPU resources and the submesh locations are absolute in its buffers.
+    D3D12_VERTEX_BUFFER_VIEW const *    pool_vbv;
+    D3D12_INDEX_BUFFER_VIEW const *     pool_ibv;
+
     // A MeshGeometry may store multiple geometries in one vertex/index buffer.
     // Use this container to define the Submesh geometries so we can draw
     // the Submeshes individually.
@@ -55,6 +112,9 @@ struct MeshGeometry {
 
 inline D3D12_VERTEX_BUFFER_VIEW
 Mesh_GetVertexBufferView (MeshGeometry * mesh) {
+    if (mesh->pool_vbv)
+        return *mesh->pool_vbv;
+
     D3D12_VERTEX_BUFFER_VIEW vbv;
     vbv.BufferLocation = mesh->vb_gpu->GetGPUVirtualAddress();
     vbv.StrideInBytes = mesh->vb_byte_stide;
@@ -65,6 +125,9 @@ Mesh_GetVertexBufferView (MeshGeometry * mesh) {
 
 inline D3D12_INDEX_BUFFER_VIEW
 Mesh_GetIndexBufferView (MeshGeometry * mesh) {
+    if (mesh->pool_ibv)
+        return *mesh->pool_ibv;
+
     D3D12_INDEX_BUFFER_VIEW ibv;
     ibv.BufferLocation = mesh->ib_gpu->GetGPUVirtualAddress();
     ibv.Format = mesh->index_format;
@@ -79,6 +142,10 @@ Mesh_Dispose (MeshGeometry * mesh) {
     mesh->vb_cpu->Release();
     mesh->ib_cpu->Release();
 
+    // A pooled mesh only owns its blobs, the pool owns the GPU buffers
+    if (mesh->pool_vbv)
+        return;
+
     mesh->vb_gpu->Release();
     mesh->ib_gpu->Release();
 
@@ -0,0 +1,640 @@
+/* ===========================================================
+   #File: mesh_optimizer.h #
+   #Date: 17 Oct 2026 #
+   #Revision: 1.0 #
+   #Creator: Omid Miresmaeili #
+   #Description: index/vertex reordering for GPU vertex processing #
+   #Notice: (C) Copyright 2021 by Omid. All Rights Reserved. #
+   =========================================================== */
+#pragma once
+
+#include "common.h"
+#include "mesh_geometry.h"
+#include <float.h>
+
+using namespace DirectX;
+
+//
+// Post-transform vertex cache optimization
+//
+// Reorders triangles so that vertices shaded by the previous triangles are reused
+// while they are still in the post-transform cache.
+// Reference: Tom Forsyth, "Linear-Speed Vertex Cache Optimisation" (2006)
+//
+#define VCACHE_OPT_CACHE_SIZE       32      // LRU cache modelled by the scoring function
+#define VCACHE_OPT_MAX_VALENCE      255
+#define VCACHE_SIM_FIFO_SIZE        16      // FIFO cache used to measure ACMR/ATVR
+
+#define OVERDRAW_CLUSTER_THRESHOLD  1.05f   // clusters may raise ACMR by at most 5%
+#define OVERDRAW_VIEW_COUNT         16      // view directions used to measure overdraw
+#define OVERDRAW_VIEWPORT_SIZE      256
+
+#define VFETCH_CACHE_LINE_SIZE      64
+#define VFETCH_CACHE_LINE_COUNT     2048    // FIFO of cache lines (128KB) used to measure fetch efficiency
+
+struct VertexCacheStats {
+    UINT transformed;       // number of vertex shader invocations in the simulated FIFO
+    float acmr;             // average cache miss ratio: transformed vertices per triangle (0.5 is the ideal for a regular grid)
+    float atvr;             // average transform to vertex ratio: transformed vertices per referenced vertex (1.0 is ideal)
+};
+
+// Vertex score as a function of LRU cache position and number of not yet emitted triangles
+inline float
+vcache_vertex_score (int cache_pos, UINT remaining_valence) {
+    if (0 == remaining_valence)
+        return -1.0f;   // no triangle needs this vertex anymore
+
+    float score = 0.0f;
+    if (cache_pos >= 0) {
+        if (cache_pos < 3) {
+            // Vertices of the last triangle get a fixed score so that the next triangle
+            // doesn't just reuse the same edge (which would produce long thin strips).
+            score = 0.75f;
+        } else {
+            float const scaler = 1.0f / (VCACHE_OPT_CACHE_SIZE - 3);
+            score = powf(1.0f - (cache_pos - 3) * scaler, 1.5f);
+        }
+    }
+    // Bonus for vertices with few triangles left, so that lone triangles get cleaned up early
+    score += 2.0f * powf((float)remaining_valence, -0.5f);
+    return score;
+}
+template <typename T> static void
+analyze_vertex_cache (T const * indices, UINT index_count, UINT vertex_count, VertexCacheStats * out_stats) {
+    UINT * timestamps = (UINT *)::calloc(vertex_count, sizeof(UINT));   // 0 = never transformed
+    UINT transformed = 0;
+    UINT referenced = 0;
+
+    for (UINT i = 0; i < index_count; ++i) {
+        UINT v = indices[i];
+        // a FIFO hit means the vertex was inserted less than FIFO_SIZE misses ago
+        if (0 == timestamps[v] || transformed - timestamps[v] >= VCACHE_SIM_FIFO_SIZE) {
+            referenced += (0 == timestamps[v]);
+            timestamps[v] = ++transformed;
+        }
+    }
+    ::free(timestamps);
+
+    out_stats->transformed = transformed;
+    out_stats->acmr = index_count ? (float)transformed / (index_count / 3) : 0.0f;
+    out_stats->atvr = referenced ? (float)transformed / referenced : 0.0f;
+}
+// In-place triangle reordering. [vertex_count] must be greater than the largest index.
+template <typename T> static void
+optimize_vertex_cache (T * indices, UINT index_count, UINT vertex_count) {
+    UINT tri_count = index_count / 3;
+    if (tri_count < 2)
+        return;
+
+    // -- vertex -> triangle adjacency (CSR layout)
+    UINT * valence = (UINT *)::calloc(vertex_count, sizeof(UINT));     // remaining (not emitted) triangles
+    UINT * adj_offset = (UINT *)::malloc(sizeof(UINT) * (vertex_count + 1));
+    UINT * adj_tris = (UINT *)::malloc(sizeof(UINT) * tri_count * 3);
+    for (UINT i = 0; i < tri_count * 3; ++i)
+        ++valence[indices[i]];
+    adj_offset[0] = 0;
+    for (UINT v = 0; v < vertex_count; ++v)
+        adj_offset[v + 1] = adj_offset[v] + valence[v];
+    UINT * fill = (UINT *)::malloc(sizeof(UINT) * vertex_count);
+    memcpy(fill, adj_offset, sizeof(UINT) * vertex_count);
+    for (UINT t = 0; t < tri_count; ++t)
+        for (UINT k = 0; k < 3; ++k)
+            adj_tris[fill[indices[t * 3 + k]]++] = t;
+    ::free(fill);
+
+    // -- initial scores
+    float * vertex_score = (float *)::malloc(sizeof(float) * vertex_count);
+    for (UINT v = 0; v < vertex_count; ++v)
+        vertex_score[v] = vcache_vertex_score(-1, valence[v] < VCACHE_OPT_MAX_VALENCE ? valence[v] : VCACHE_OPT_MAX_VALENCE);
+    float * tri_score = (float *)::malloc(sizeof(float) * tri_count);
+    bool * emitted = (bool *)::calloc(tri_count, sizeof(bool));
+    for (UINT t = 0; t < tri_count; ++t)
+        tri_score[t] = vertex_score[indices[t * 3 + 0]] + vertex_score[indices[t * 3 + 1]] + vertex_score[indices[t * 3 + 2]];
+
+    T * out = (T *)::malloc(sizeof(T) * tri_count * 3);
+    UINT cache[VCACHE_OPT_CACHE_SIZE + 3];
+    UINT cache_count = 0;
+    UINT scan_cursor = 0;   // all triangles before this are emitted
+
+    int best_tri = 0;
+    for (UINT t = 1; t < tri_count; ++t)
+        if (tri_score[t] > tri_score[best_tri]) best_tri = t;
+
+    for (UINT n_emitted = 0; n_emitted < tri_count; ++n_emitted) {
+        if (best_tri < 0) {
+            // -- nothing adjacent to the cache: fall back to the best remaining triangle
+            while (emitted[scan_cursor]) ++scan_cursor;
+            best_tri = scan_cursor;
+            for (UINT t = scan_cursor + 1; t < tri_count; ++t)
+                if (!emitted[t] && tri_score[t] > tri_score[best_tri]) best_tri = t;
+        }
+
+        // -- emit triangle
+        UINT tri_idx[3] = {indices[best_tri * 3 + 0], indices[best_tri * 3 + 1], indices[best_tri * 3 + 2]};
+        emitted[best_tri] = true;
+        for (UINT k = 0; k < 3; ++k) {
+            out[n_emitted * 3 + k] = (T)tri_idx[k];
+
+            // remove the triangle from the vertex's adjacency (swap to the end of the live range)
+            UINT v = tri_idx[k];
+            UINT * adj = adj_tris + adj_offset[v];
+            for (UINT a = 0; a < valence[v]; ++a) {
+                if (adj[a] == (UINT)best_tri) {
+                    adj[a] = adj[valence[v] - 1];
+                    adj[valence[v] - 1] = best_tri;
+                    break;
+                }
+            }
+            --valence[v];
+        }
+
+        // -- move the triangle's vertices to the front of the LRU cache
+        UINT new_cache[VCACHE_OPT_CACHE_SIZE + 3];
+        UINT new_count = 0;
+        for (UINT k = 0; k < 3; ++k)
+            new_cache[new_count++] = tri_idx[k];
+        for (UINT c = 0; c < cache_count; ++c) {
+            UINT v = cache[c];
+            if (v != tri_idx[0] && v != tri_idx[1] && v != tri_idx[2])
+                new_cache[new_count++] = v;
+        }
+        cache_count = new_count < VCACHE_OPT_CACHE_SIZE ? new_count : VCACHE_OPT_CACHE_SIZE;
+        memcpy(cache, new_cache, sizeof(UINT) * cache_count);
+
+        // -- rescore cached vertices and their live triangles, pick the next best triangle among them
+        for (UINT c = 0; c < cache_count; ++c) {
+            UINT v = cache[c];
+            float new_score = vcache_vertex_score((int)c, valence[v] < VCACHE_OPT_MAX_VALENCE ? valence[v] : VCACHE_OPT_MAX_VALENCE);
+            float delta = new_score - vertex_score[v];
+            vertex_score[v] = new_score;
+            UINT const * adj = adj_tris + adj_offset[v];
+            for (UINT a = 0; a < valence[v]; ++a)
+                tri_score[adj[a]] += delta;
+        }
+        // vertices pushed out of the cache lose their position score
+        for (UINT c = VCACHE_OPT_CACHE_SIZE; c < new_count; ++c) {
+            UINT v = new_cache[c];
+            float new_score = vcache_vertex_score(-1, valence[v] < VCACHE_OPT_MAX_VALENCE ? valence[v] : VCACHE_OPT_MAX_VALENCE);
+            float delta = new_score - vertex_score[v];
+            vertex_score[v] = new_score;
+            UINT const * adj = adj_tris + adj_offset[v];
+            for (UINT a = 0; a < valence[v]; ++a)
+                tri_score[adj[a]] += delta;
+        }
+        best_tri = -1;
+        float best_score = -FLT_MAX;
+        for (UINT c = 0; c < cache_count; ++c) {
+            UINT v = cache[c];
+            UINT const * adj = adj_tris + adj_offset[v];
+            for (UINT a = 0; a < valence[v]; ++a) {
+                if (tri_score[adj[a]] > best_score) {
+                    best_score = tri_score[adj[a]];
+                    best_tri = (int)adj[a];
+                }
+            }
+        }
+    }
+    memcpy(indices, out, sizeof(T) * tri_count * 3);
+
+    ::free(out);
+    ::free(emitted);
+    ::free(tri_score);
+    ::free(vertex_score);
+    ::free(adj_tris);
+    ::free(adj_offset);
+    ::free(valence);
+}
+// Optimizes [indices] for the post-transform cache and prints ACMR/ATVR before and after.
+// Meshes exported in an already cache-friendly order are left untouched if the optimizer can't beat them.
+template <typename T> static void
+optimize_vertex_cache_and_report (char const * mesh_name, T * indices, UINT index_count, UINT vertex_count) {
+    VertexCacheStats before, after;
+    analyze_vertex_cache(indices, index_count, vertex_count, &before);
+
+    T * original = (T *)::malloc(sizeof(T) * index_count);
+    memcpy(original, indices, sizeof(T) * index_count);
+    optimize_vertex_cache(indices, index_count, vertex_count);
+    analyze_vertex_cache(indices, index_count, vertex_count, &after);
+
+    bool keep_original = after.transformed > before.transformed;
+    if (keep_original) {
+        memcpy(indices, original, sizeof(T) * index_count);
+        after = before;
+    }
+    ::free(original);
+
+    char buf[256];
+    ::sprintf_s(buf, sizeof(buf), "[vcache] %s: %u tris, ACMR %.3f -> %.3f, ATVR %.3f -> %.3f%s\n",
+                mesh_name, index_count / 3, before.acmr, after.acmr, before.atvr, after.atvr,
+                keep_original ? " (kept source order)" : "");
+    OutputDebugStringA(buf);
+}
+
+//
+// Overdraw optimization
+//
+// Splits the cache-optimized triangle order into clusters and draws the clusters
+// that face away from the mesh center (i.e. are likely to occlude the rest) first.
+// Reference: Sander, Nehab, Barczak, "Fast Triangle Reordering for Vertex Locality and Reduced Overdraw" (2007)
+//
+struct OverdrawCluster {
+    UINT start_tri;
+    UINT tri_count;
+    float sort_key;
+};
+inline XMFLOAT3 const *
+vertex_position (void const * vertices, UINT vertex_stride, UINT i) {
+    // position is the first member of every vertex format in the demos
+    return (XMFLOAT3 const *)((BYTE const *)vertices + (size_t)i * vertex_stride);
+}
+static int
+compare_overdraw_clusters (void const * a, void const * b) {
+    OverdrawCluster const * ca = (OverdrawCluster const *)a;
+    OverdrawCluster const * cb = (OverdrawCluster const *)b;
+    if (ca->sort_key != cb->sort_key)
+        return ca->sort_key > cb->sort_key ? -1 : 1;
+    return ca->start_tri < cb->start_tri ? -1 : 1;    // keep qsort stable
+}
+// Simulates one FIFO access, returns 1 on a miss
+inline UINT
+vcache_sim_access (UINT * timestamps, UINT * time, UINT v) {
+    if (0 == timestamps[v] || *time - timestamps[v] >= VCACHE_SIM_FIFO_SIZE) {
+        timestamps[v] = ++(*time);
+        return 1;
+    }
+    return 0;
+}
+// [indices] should already be in vertex cache optimized order. [vertex_count] must be greater than the largest index.
+template <typename T> static void
+optimize_overdraw (T * indices, UINT index_count, void const * vertices, UINT vertex_stride, UINT vertex_count, float threshold) {
+    UINT tri_count = index_count / 3;
+    if (tri_count < 2)
+        return;
+
+    UINT * timestamps = (UINT *)::calloc(vertex_count, sizeof(UINT));
+    UINT time = 0;
+
+    // -- hard boundaries: triangles that miss on all three vertices start a new cluster
+    UINT * cluster_starts = (UINT *)::malloc(sizeof(UINT) * (tri_count + 1));
+    UINT n_hard = 0;
+    for (UINT t = 0; t < tri_count; ++t) {
+        UINT misses = 0;
+        for (UINT k = 0; k < 3; ++k)
+            misses += vcache_sim_access(timestamps, &time, indices[t * 3 + k]);
+        if (0 == t || 3 == misses)
+            cluster_starts[n_hard++] = t;
+    }
+    cluster_starts[n_hard] = tri_count;
+
+    // -- soft boundaries: split hard clusters further while their ACMR stays within [threshold]
+    // of the ACMR the hard cluster has with a cold cache
+    OverdrawCluster * clusters = (OverdrawCluster *)::malloc(sizeof(OverdrawCluster) * tri_count);
+    UINT n_clusters = 0;
+    for (UINT h = 0; h < n_hard; ++h) {
+        UINT start = cluster_starts[h];
+        UINT end = cluster_starts[h + 1];
+
+        time += VCACHE_SIM_FIFO_SIZE;   // cold cache
+        UINT hard_misses = 0;
+        for (UINT t = start; t < end; ++t)
+            for (UINT k = 0; k < 3; ++k)
+                hard_misses += vcache_sim_access(timestamps, &time, indices[t * 3 + k]);
+        float cluster_threshold = threshold * ((float)hard_misses / (end - start));
+
+        time += VCACHE_SIM_FIFO_SIZE;
+        UINT first_cluster = n_clusters;
+        UINT running_misses = 0;
+        UINT cluster_start = start;
+        for (UINT t = start; t < end; ++t) {
+            for (UINT k = 0; k < 3; ++k)
+                running_misses += vcache_sim_access(timestamps, &time, indices[t * 3 + k]);
+            if (running_misses <= cluster_threshold * (t + 1 - cluster_start)) {
+                clusters[n_clusters++] = {cluster_start, t + 1 - cluster_start, 0.0f};
+                cluster_start = t + 1;
+                running_misses = 0;
+                time += VCACHE_SIM_FIFO_SIZE;
+            }
+        }
+        // the trailing triangles didn't reach the target ACMR: merge them into the last complete cluster
+        if (cluster_start < end) {
+            if (n_clusters > first_cluster)
+                clusters[n_clusters - 1].tri_count = end - clusters[n_clusters - 1].start_tri;
+            else
+                clusters[n_clusters++] = {cluster_start, end - cluster_start, 0.0f};
+        }
+    }
+
+    // -- sort key: how much the cluster faces away from the mesh centroid
+    XMFLOAT3 mesh_centroid = {0.0f, 0.0f, 0.0f};
+    float mesh_area = 0.0f;
+    for (UINT t = 0; t < tri_count * 3; t += 3) {
+        XMFLOAT3 const * p0 = vertex_position(vertices, vertex_stride, indices[t + 0]);
+        XMFLOAT3 const * p1 = vertex_position(vertices, vertex_stride, indices[t + 1]);
+        XMFLOAT3 const * p2 = vertex_position(vertices, vertex_stride, indices[t + 2]);
+        XMFLOAT3 e1 = {p1->x - p0->x, p1->y - p0->y, p1->z - p0->z};
+        XMFLOAT3 e2 = {p2->x - p0->x, p2->y - p0->y, p2->z - p0->z};
+        XMFLOAT3 n = {e1.y * e2.z - e1.z * e2.y, e1.z * e2.x - e1.x * e2.z, e1.x * e2.y - e1.y * e2.x};
+        float area = sqrtf(n.x * n.x + n.y * n.y + n.z * n.z);
+        mesh_centroid.x += area * (p0->x + p1->x + p2->x) / 3.0f;
+        mesh_centroid.y += area * (p0->y + p1->y + p2->y) / 3.0f;
+        mesh_centroid.z += area * (p0->z + p1->z + p2->z) / 3.0f;
+        mesh_area += area;
+    }
+    if (mesh_area > 0.0f) {
+        mesh_centroid.x /= mesh_area; mesh_centroid.y /= mesh_area; mesh_centroid.z /= mesh_area;
+    }
+    for (UINT c = 0; c < n_clusters; ++c) {
+        XMFLOAT3 centroid = {0.0f, 0.0f, 0.0f};
+        XMFLOAT3 normal = {0.0f, 0.0f, 0.0f};   // sum of unnormalized face normals, i.e. area weighted
+        float area_sum = 0.0f;
+        for (UINT t = clusters[c].start_tri; t < clusters[c].start_tri + clusters[c].tri_count; ++t) {
+            XMFLOAT3 const * p0 = vertex_position(vertices, vertex_stride, indices[t * 3 + 0]);
+            XMFLOAT3 const * p1 = vertex_position(vertices, vertex_stride, indices[t * 3 + 1]);
+            XMFLOAT3 const * p2 = vertex_position(vertices, vertex_stride, indices[t * 3 + 2]);
+            XMFLOAT3 e1 = {p1->x - p0->x, p1->y - p0->y, p1->z - p0->z};
+            XMFLOAT3 e2 = {p2->x - p0->x, p2->y - p0->y, p2->z - p0->z};
+            XMFLOAT3 n = {e1.y * e2.z - e1.z * e2.y, e1.z * e2.x - e1.x * e2.z, e1.x * e2.y - e1.y * e2.x};
+            float area = sqrtf(n.x * n.x + n.y * n.y + n.z * n.z);
+            centroid.x += area * (p0->x + p1->x + p2->x) / 3.0f;
+            centroid.y += area * (p0->y + p1->y + p2->y) / 3.0f;
+            centroid.z += area * (p0->z + p1->z + p2->z) / 3.0f;
+            normal.x += n.x; normal.y += n.y; normal.z += n.z;
+            area_sum += area;
+        }
+        float normal_len = sqrtf(normal.x * normal.x + normal.y * normal.y + normal.z * normal.z);
+        if (area_sum > 0.0f && normal_len > 0.0f) {
+            centroid.x /= area_sum; centroid.y /= area_sum; centroid.z /= area_sum;
+            clusters[c].sort_key =
+                ((centroid.x - mesh_centroid.x) * normal.x +
+                 (centroid.y - mesh_centroid.y) * normal.y +
+                 (centroid.z - mesh_centroid.z) * normal.z) / normal_len;
+        }
+    }
+    ::qsort(clusters, n_clusters, sizeof(OverdrawCluster), compare_overdraw_clusters);
+
+    T * out = (T *)::malloc(sizeof(T) * tri_count * 3);
+    UINT n_out = 0;
+    for (UINT c = 0; c < n_clusters; ++c) {
+        memcpy(out + n_out, indices + clusters[c].start_tri * 3, sizeof(T) * clusters[c].tri_count * 3);
+        n_out += clusters[c].tri_count * 3;
+    }
+    memcpy(indices, out, sizeof(T) * n_out);
+
+    ::free(out);
+    ::free(clusters);
+    ::free(cluster_starts);
+    ::free(timestamps);
+}
+// Rasterizes the mesh (back-face culled, depth tested, in submission order) from
+// OVERDRAW_VIEW_COUNT orthographic views and returns shaded pixels / covered pixels
+template <typename T> static float
+analyze_overdraw (T const * indices, UINT index_count, void const * vertices, UINT vertex_stride, UINT vertex_count) {
+    UINT const vp = OVERDRAW_VIEWPORT_SIZE;
+    float * depth = (float *)::malloc(sizeof(float) * vp * vp);
+    XMFLOAT3 * projected = (XMFLOAT3 *)::malloc(sizeof(XMFLOAT3) * vertex_count);
+
+    // bounding sphere (approx.) to fit every view into the viewport
+    XMFLOAT3 bmin = {+FLT_MAX, +FLT_MAX, +FLT_MAX};
+    XMFLOAT3 bmax = {-FLT_MAX, -FLT_MAX, -FLT_MAX};
+    for (UINT i = 0; i < vertex_count; ++i) {
+        XMFLOAT3 const * p = vertex_position(vertices, vertex_stride, i);
+        bmin = {fminf(bmin.x, p->x), fminf(bmin.y, p->y), fminf(bmin.z, p->z)};
+        bmax = {fmaxf(bmax.x, p->x), fmaxf(bmax.y, p->y), fmaxf(bmax.z, p->z)};
+    }
+    XMFLOAT3 center = {0.5f * (bmin.x + bmax.x), 0.5f * (bmin.y + bmax.y), 0.5f * (bmin.z + bmax.z)};
+    float radius = 0.5f * sqrtf(
+        (bmax.x - bmin.x) * (bmax.x - bmin.x) + (bmax.y - bmin.y) * (bmax.y - bmin.y) + (bmax.z - bmin.z) * (bmax.z - bmin.z));
+    if (radius <= 0.0f)
+        radius = 1.0f;
+
+    UINT64 shaded = 0;
+    UINT64 covered = 0;
+    for (UINT view = 0; view < OVERDRAW_VIEW_COUNT; ++view) {
+        // -- view direction on a fibonacci sphere
+        float fy = 1.0f - 2.0f * (view + 0.5f) / OVERDRAW_VIEW_COUNT;
+        float fr = sqrtf(1.0f - fy * fy);
+        float fphi = view * 2.39996323f;   // golden angle
+        XMFLOAT3 fwd = {fr * cosf(fphi), fy, fr * sinf(fphi)};
+        XMFLOAT3 up_hint = fabsf(fwd.y) < 0.99f ? XMFLOAT3(0.0f, 1.0f, 0.0f) : XMFLOAT3(1.0f, 0.0f, 0.0f);
+        // left-handed basis: right = up x forward, up = forward x right
+        XMFLOAT3 right = {up_hint.y * fwd.z - up_hint.z * fwd.y, up_hint.z * fwd.x - up_hint.x * fwd.z, up_hint.x * fwd.y - up_hint.y * fwd.x};
+        float rl = sqrtf(right.x * right.x + right.y * right.y + right.z * right.z);
+        right.x /= rl; right.y /= rl; right.z /= rl;
+        XMFLOAT3 up = {fwd.y * right.z - fwd.z * right.y, fwd.z * right.x - fwd.x * right.z, fwd.x * right.y - fwd.y * right.x};
+
+        float scale = 0.5f * (vp - 1) / radius;
+        for (UINT i = 0; i < vertex_count; ++i) {
+            XMFLOAT3 const * p = vertex_position(vertices, vertex_stride, i);
+            XMFLOAT3 d = {p->x - center.x, p->y - center.y, p->z - center.z};
+            projected[i].x = 0.5f * vp + scale * (d.x * right.x + d.y * right.y + d.z * right.z);
+            projected[i].y = 0.5f * vp + scale * (d.x * up.x + d.y * up.y + d.z * up.z);
+            projected[i].z = d.x * fwd.x + d.y * fwd.y + d.z * fwd.z;
+        }
+        for (UINT i = 0; i < vp * vp; ++i)
+            depth[i] = FLT_MAX;
+
+        for (UINT t = 0; t + 2 < index_count; t += 3) {
+            XMFLOAT3 a = projected[indices[t + 0]];
+            XMFLOAT3 b = projected[indices[t + 1]];
+            XMFLOAT3 c = projected[indices[t + 2]];
+
+            // clockwise triangles are front facing (D3D default), which is a negative area with y up
+            float area = (b.x - a.x) * (c.y - a.y) - (b.y - a.y) * (c.x - a.x);
+            if (area >= 0.0f)
+                continue;
+
+            int x0 = (int)floorf(fminf(a.x, fminf(b.x, c.x))), x1 = (int)ceilf(fmaxf(a.x, fmaxf(b.x, c.x)));
+            int y0 = (int)floorf(fminf(a.y, fminf(b.y, c.y))), y1 = (int)ceilf(fmaxf(a.y, fmaxf(b.y, c.y)));
+            x0 = x0 < 0 ? 0 : x0;
+            y0 = y0 < 0 ? 0 : y0;
+            x1 = x1 > (int)vp - 1 ? (int)vp - 1 : x1;
+            y1 = y1 > (int)vp - 1 ? (int)vp - 1 : y1;
+            float inv_area = 1.0f / area;
+            for (int y = y0; y <= y1; ++y) {
+                for (int x = x0; x <= x1; ++x) {
+                    float px = x + 0.5f, py = y + 0.5f;
+                    // barycentrics (all non-positive edge functions means inside for negative area)
+                    float w0 = ((b.x - px) * (c.y - py) - (b.y - py) * (c.x - px)) * inv_area;
+                    float w1 = ((c.x - px) * (a.y - py) - (c.y - py) * (a.x - px)) * inv_area;
+                    float w2 = 1.0f - w0 - w1;
+                    if (w0 < 0.0f || w1 < 0.0f || w2 < 0.0f)
+                        continue;
+                    float z = w0 * a.z + w1 * b.z + w2 * c.z;
+                    float * dst = &depth[y * vp + x];
+                    if (z < *dst) {
+                        covered += (FLT_MAX == *dst);
+                        *dst = z;
+                        ++shaded;
+                    }
+                }
+            }
+        }
+    }
+    ::free(projected);
+    ::free(depth);
+    return covered ? (float)shaded / covered : 1.0f;
+}
+
+//
+// Vertex fetch optimization
+//
+// Fraction of the fetched vertex memory that is actually used, with fetches going through
+// a FIFO of VFETCH_CACHE_LINE_COUNT cache lines. 1.0 means every vertex byte is fetched once.
+template <typename T> static float
+analyze_vertex_fetch (T const * indices, UINT index_count, UINT vertex_count, UINT vertex_stride) {
+    UINT line_count = (UINT)(((UINT64)vertex_count * vertex_stride + VFETCH_CACHE_LINE_SIZE - 1) / VFETCH_CACHE_LINE_SIZE);
+    UINT * timestamps = (UINT *)::calloc(line_count, sizeof(UINT));
+    bool * used = (bool *)::calloc(vertex_count, sizeof(bool));
+    UINT time = 0;
+    UINT unique = 0;
+    for (UINT i = 0; i < index_count; ++i) {
+        UINT v = indices[i];
+        unique += !used[v];
+        used[v] = true;
+
+        UINT64 first = (UINT64)v * vertex_stride / VFETCH_CACHE_LINE_SIZE;
+        UINT64 last = ((UINT64)v * vertex_stride + vertex_stride - 1) / VFETCH_CACHE_LINE_SIZE;
+        for (UINT64 l = first; l <= last; ++l) {
+            if (0 == timestamps[l] || time - timestamps[l] >= VFETCH_CACHE_LINE_COUNT)
+                timestamps[l] = ++time;
+        }
+    }
+    ::free(used);
+    ::free(timestamps);
+    return time ? (float)((UINT64)unique * vertex_stride) / ((UINT64)time * VFETCH_CACHE_LINE_SIZE) : 1.0f;
+}
+// Rewrites [vertices] in first-use order and renumbers [indices].
+// Unreferenced vertices are moved to the end. Returns the number of referenced vertices.
+template <typename T> static UINT
+optimize_vertex_fetch (void * vertices, UINT vertex_count, UINT vertex_stride, T * indices, UINT index_count) {
+    UINT * remap = (UINT *)::malloc(sizeof(UINT) * vertex_count);
+    for (UINT v = 0; v < vertex_count; ++v)
+        remap[v] = UINT_MAX;
+
+    UINT next = 0;
+    for (UINT i = 0; i < index_count; ++i) {
+        UINT v = indices[i];
+        if (UINT_MAX == remap[v])
+            remap[v] = next++;
+        indices[i] = (T)remap[v];
+    }
+    UINT referenced = next;
+    for (UINT v = 0; v < vertex_count; ++v)
+        if (UINT_MAX == remap[v])
+            remap[v] = next++;
+
+    BYTE * reordered = (BYTE *)::malloc((size_t)vertex_count * vertex_stride);
+    for (UINT v = 0; v < vertex_count; ++v)
+        memcpy(reordered + (size_t)remap[v] * vertex_stride, (BYTE *)vertices + (size_t)v * vertex_stride, vertex_stride);
+    memcpy(vertices, reordered, (size_t)vertex_count * vertex_stride);
+
+    ::free(reordered);
+    ::free(remap);
+    return referenced;
+}
+
+//
+// Full optimization pipeline and report
+//
+struct MeshOptimizeStats {
+    VertexCacheStats vcache;
+    float overdraw;
+    float fetch_efficiency;
+};
+template <typename T> static void
+analyze_mesh (T const * indices, UINT index_count, void const * vertices, UINT vertex_stride, UINT vertex_count, MeshOptimizeStats * out_stats) {
+    analyze_vertex_cache(indices, index_count, vertex_count, &out_stats->vcache);
+    out_stats->overdraw = analyze_overdraw(indices, index_count, vertices, vertex_stride, vertex_count);
+    out_stats->fetch_efficiency = analyze_vertex_fetch(indices, index_count, vertex_count, vertex_stride);
+}
+inline void
+print_mesh_optimize_report (char const * mesh_name, UINT tri_count, MeshOptimizeStats const * before, MeshOptimizeStats const * after) {
+    char buf[512];
+    ::sprintf_s(buf, sizeof(buf),
+                "[meshopt] %s: %u tris, ACMR %.3f -> %.3f, ATVR %.3f -> %.3f, overdraw %.3f -> %.3f (%d views), fetch efficiency %.1f%% -> %.1f%%\n",
+                mesh_name, tri_count,
+                before->vcache.acmr, after->vcache.acmr, before->vcache.atvr, after->vcache.atvr,
+                before->overdraw, after->overdraw, OVERDRAW_VIEW_COUNT,
+                100.0f * before->fetch_efficiency, 100.0f * after->fetch_efficiency);
+    OutputDebugStringA(buf);
+}
+// Overdraw clustering followed by vertex fetch remap on an already cache-optimized mesh.
+// [vertices] and [indices] are modified in place.
+template <typename T> static void
+optimize_overdraw_and_fetch (char const * mesh_name, void * vertices, UINT vertex_stride, UINT vertex_count, T * indices, UINT index_count) {
+    MeshOptimizeStats before, after;
+    analyze_mesh(indices, index_count, vertices, vertex_stride, vertex_count, &before);
+
+    optimize_overdraw(indices, index_count, vertices, vertex_stride, vertex_count, OVERDRAW_CLUSTER_THRESHOLD);
+    optimize_vertex_fetch(vertices, vertex_count, vertex_stride, indices, index_count);
+
+    analyze_mesh(indices, index_count, vertices, vertex_stride, vertex_count, &after);
+    print_mesh_optimize_report(mesh_name, index_count / 3, &before, &after);
+}
+// Runs the overdraw and vertex fetch passes on every submesh of [mesh] using its vb_cpu/ib_cpu blobs.
+// Must be called before the blobs are uploaded to vb_gpu/ib_gpu.
+// Submeshes are expected to reference disjoint vertex ranges (as the demos pack them);
+// otherwise only the triangle order is optimized.
+static void
+Mesh_OptimizeCpuBuffers (MeshGeometry * mesh, UINT submesh_count, char const * mesh_name) {
+    BYTE * vertices = (BYTE *)mesh->vb_cpu->GetBufferPointer();
+    BYTE * indices = (BYTE *)mesh->ib_cpu->GetBufferPointer();
+    UINT stride = mesh->vb_byte_stide;
+    UINT index_size = (DXGI_FORMAT_R16_UINT == mesh->index_format) ? sizeof(uint16_t) : sizeof(uint32_t);
+
+    // -- vertex range of each submesh
+    UINT range_first [MAX_SUBMESH_COUNT];
+    UINT range_last [MAX_SUBMESH_COUNT];
+    for (UINT s = 0; s < submesh_count; ++s) {
+        SubmeshGeometry const * sub = &mesh->submesh_geoms[s];
+        UINT lo = UINT_MAX, hi = 0;
+        for (UINT i = 0; i < sub->index_count; ++i) {
+            UINT ii = sub->start_index_location + i;
+            UINT v = (sizeof(uint16_t) == index_size) ? ((uint16_t *)indices)[ii] : ((uint32_t *)indices)[ii];
+            if (v < lo) lo = v;
+            if (v > hi) hi = v;
+        }
+        range_first[s] = sub->base_vertex_location + lo;
+        range_last[s] = sub->base_vertex_location + hi;
+    }
+    bool disjoint = true;
+    for (UINT s = 0; s < submesh_count; ++s)
+        for (UINT o = s + 1; o < submesh_count; ++o)
+            if (mesh->submesh_geoms[s].index_count && mesh->submesh_geoms[o].index_count &&
+                range_first[s] <= range_last[o] && range_first[o] <= range_last[s])
+                disjoint = false;
+
+    for (UINT s = 0; s < submesh_count; ++s) {
+        SubmeshGeometry const * sub = &mesh->submesh_geoms[s];
+        if (sub->index_count < 6)
+            continue;
+
+        // -- rebase the submesh so its indices start at 0
+        UINT lo = range_first[s] - sub->base_vertex_location;
+        UINT n_vtx = range_last[s] - range_first[s] + 1;
+        BYTE * sub_vertices = vertices + (size_t)range_first[s] * stride;
+        BYTE * sub_indices = indices + (size_t)sub->start_index_location * index_size;
+
+        char name[128];
+        ::sprintf_s(name, sizeof(name), "%s/%s", mesh_name, mesh->submesh_names[s] ? mesh->submesh_names[s] : "?");
+        if (sizeof(uint16_t) == index_size) {
+            uint16_t * idx = (uint16_t *)sub_indices;
+            for (UINT i = 0; i < sub->index_count; ++i) idx[i] -= (uint16_t)lo;
+            if (disjoint) {
+                optimize_overdraw_and_fetch(name, sub_vertices, stride, n_vtx, idx, sub->index_count);
+            } else {
+                optimize_overdraw(idx, sub->index_count, sub_vertices, stride, n_vtx, OVERDRAW_CLUSTER_THRESHOLD);
+            }
+            for (UINT i = 0; i < sub->index_count; ++i) idx[i] += (uint16_t)lo;
+        } else {
+            uint32_t * idx = (uint32_t *)sub_indices;
+            for (UINT i = 0; i < sub->index_count; ++i) idx[i] -= lo;
+            if (disjoint) {
+                optimize_overdraw_and_fetch(name, sub_vertices, stride, n_vtx, idx, sub->index_count);
+            } else {
+                optimize_overdraw(idx, sub->index_count, sub_vertices, stride, n_vtx, OVERDRAW_CLUSTER_THRESHOLD);
+            }
+            for (UINT i = 0; i < sub->index_count; ++i) idx[i] += lo;
+        }
+    }
+}
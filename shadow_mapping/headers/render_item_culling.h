@@ -0,0 +1,190 @@
+/* ===========================================================
+   #File: render_item_culling.h #
+   #Date: 17 Oct 2026 #
+   #Revision: 1.0 #
+   #Creator: Omid Miresmaeili #
+   #Description: SIMD culling of render item bounds for the camera and shadow caster passes #
+   #Notice: (C) Copyright 2021 by Omid. All Rights Reserved. #
+   =========================================================== */
+#pragma once
+
+#include "common.h"
+#include "utils.h"
+#include <immintrin.h>
+
+using namespace DirectX;
+
+//
+// Render item culling
+//
+// World space AABBs of the render items (SoA) tested four at a time against a set of planes.
+// The camera pass uses the six planes of the view frustum; the shadow pass uses the light
+// volume plus the camera frustum extruded toward the light, which keeps the casters outside
+// the view whose shadows still fall into it and drops those whose shadows cannot reach it.
+//
+#define RITEM_CULL_MAX_ITEMS    64
+#define RITEM_CULL_MAX_PLANES   24
+
+// Planes as n.p + d >= 0 inside
+struct CullPlaneSet {
+    alignas(16) float   nx [RITEM_CULL_MAX_PLANES];
+    alignas(16) float   ny [RITEM_CULL_MAX_PLANES];
+    alignas(16) float   nz [RITEM_CULL_MAX_PLANES];
+    alignas(16) float   d [RITEM_CULL_MAX_PLANES];
+    UINT                count;
+};
+struct RenderItemBounds {
+    alignas(16) float   center_x [RITEM_CULL_MAX_ITEMS];
+    alignas(16) float   center_y [RITEM_CULL_MAX_ITEMS];
+    alignas(16) float   center_z [RITEM_CULL_MAX_ITEMS];
+    alignas(16) float   extent_x [RITEM_CULL_MAX_ITEMS];
+    alignas(16) float   extent_y [RITEM_CULL_MAX_ITEMS];
+    alignas(16) float   extent_z [RITEM_CULL_MAX_ITEMS];
+    UINT                count;
+};
+
+// Local bounds of each item from the submesh of its geometry it draws
+static void
+render_item_bounds_from_submeshes (RenderItem * ritems, UINT count) {
+    for (UINT i = 0; i < count; ++i) {
+        if (!ritems[i].initialized)
+            continue;
+        for (UINT s = 0; s < MAX_SUBMESH_COUNT; ++s) {
+            SubmeshGeometry const * submesh = &ritems[i].geometry->submesh_geoms[s];
+            if (submesh->index_count == ritems[i].index_count && submesh->start_index_location == ritems[i].start_index_loc &&
+                submesh->base_vertex_location == ritems[i].base_vertex_loc) {
+                ritems[i].bounds = submesh->bounds;
+                break;
+            }
+        }
+    }
+}
+// Appends the plane (x, y, z, w) normalized
+inline void
+CullPlaneSet_Add (CullPlaneSet * set, XMVECTOR plane) {
+    _ASSERT_EXPR(set->count < RITEM_CULL_MAX_PLANES, _T("too many cull planes"));
+    XMFLOAT4 p;
+    XMStoreFloat4(&p, XMPlaneNormalize(plane));
+    set->nx[set->count] = p.x;
+    set->ny[set->count] = p.y;
+    set->nz[set->count] = p.z;
+    set->d[set->count] = p.w;
+    ++set->count;
+}
+// Appends the six planes of [view_proj] (perspective or orthographic) in the order
+// left, right, bottom, top, near, far
+static void
+CullPlaneSet_AddFrustum (CullPlaneSet * set, XMMATRIX const & view_proj) {
+    XMMATRIX m = XMMatrixTranspose(view_proj);
+    CullPlaneSet_Add(set, m.r[3] + m.r[0]);
+    CullPlaneSet_Add(set, m.r[3] - m.r[0]);
+    CullPlaneSet_Add(set, m.r[3] + m.r[1]);
+    CullPlaneSet_Add(set, m.r[3] - m.r[1]);
+    CullPlaneSet_Add(set, m.r[2]);
+    CullPlaneSet_Add(set, m.r[3] - m.r[2]);
+}
+// Appends the planes bounding the camera frustum [view_proj] extruded toward a directional light
+// shining along [light_dir]: every point whose shadow ray reaches the frustum is inside.
+// Frustum planes facing the light are dropped, and each edge between a kept and a dropped plane
+// (the silhouette seen from the light) is swept along the light direction into a new plane.
+static void
+CullPlaneSet_AddShadowCasters (CullPlaneSet * set, XMMATRIX const & view_proj, XMVECTOR light_dir) {
+    CullPlaneSet frustum = {};
+    CullPlaneSet_AddFrustum(&frustum, view_proj);
+    XMFLOAT3 l;
+    XMStoreFloat3(&l, light_dir);
+
+    // plane [axis * 2 + side] bounds the NDC axis at its low (side 0) or high (side 1) end
+    bool kept [6];
+    for (UINT p = 0; p < 6; ++p) {
+        kept[p] = frustum.nx[p] * l.x + frustum.ny[p] * l.y + frustum.nz[p] * l.z <= 0.0f;
+        if (kept[p])
+            CullPlaneSet_Add(set, XMVectorSet(frustum.nx[p], frustum.ny[p], frustum.nz[p], frustum.d[p]));
+    }
+
+    // corner [x | y << 1 | z << 2] of the frustum, and the centroid to orient the new planes
+    XMVECTOR det = XMMatrixDeterminant(view_proj);
+    XMMATRIX inv_view_proj = XMMatrixInverse(&det, view_proj);
+    XMVECTOR corners [8];
+    XMVECTOR centroid = XMVectorZero();
+    for (UINT c = 0; c < 8; ++c) {
+        XMVECTOR ndc = XMVectorSet((c & 1) ? 1.0f : -1.0f, (c & 2) ? 1.0f : -1.0f, (c & 4) ? 1.0f : 0.0f, 1.0f);
+        corners[c] = XMVector3TransformCoord(ndc, inv_view_proj);
+        centroid += corners[c];
+    }
+    centroid *= 0.125f;
+
+    // an edge runs along [axis] with the other two axes fixed at one of their ends
+    for (UINT axis = 0; axis < 3; ++axis) {
+        UINT a1 = (axis + 1) % 3;
+        UINT a2 = (axis + 2) % 3;
+        for (UINT s1 = 0; s1 < 2; ++s1) {
+            for (UINT s2 = 0; s2 < 2; ++s2) {
+                if (kept[a1 * 2 + s1] == kept[a2 * 2 + s2])
+                    continue;
+                UINT c0 = (s1 << a1) | (s2 << a2);
+                UINT c1 = c0 | (1 << axis);
+                XMVECTOR normal = XMVector3Cross(corners[c1] - corners[c0], light_dir);
+                if (XMVectorGetX(XMVector3LengthSq(normal)) < 1e-12f)
+                    continue;   // edge parallel to the light, the kept planes bound it
+                normal = XMVector3Normalize(normal);
+                float d = -XMVectorGetX(XMVector3Dot(normal, corners[c0]));
+                if (XMVectorGetX(XMVector3Dot(normal, centroid)) + d < 0.0f) {
+                    normal = -normal;
+                    d = -d;
+                }
+                CullPlaneSet_Add(set, XMVectorSetW(normal, d));
+            }
+        }
+    }
+}
+// World space AABBs of [ritems] (their local bounds moved by their world matrices)
+static void
+RenderItemBounds_Update (RenderItemBounds * bounds, RenderItem const * ritems, UINT count) {
+    _ASSERT_EXPR(count <= RITEM_CULL_MAX_ITEMS, _T("too many render items to cull"));
+    for (UINT i = 0; i < count; ++i) {
+        BoundingBox world_box;
+        ritems[i].bounds.Transform(world_box, XMLoadFloat4x4(&ritems[i].world));
+        bounds->center_x[i] = world_box.Center.x;
+        bounds->center_y[i] = world_box.Center.y;
+        bounds->center_z[i] = world_box.Center.z;
+        bounds->extent_x[i] = world_box.Extents.x;
+        bounds->extent_y[i] = world_box.Extents.y;
+        bounds->extent_z[i] = world_box.Extents.z;
+    }
+    bounds->count = count;
+}
+// Sets [visible] of every box that is not entirely outside one of [planes]; returns how many are
+static UINT
+RenderItemBounds_Cull (RenderItemBounds const * bounds, CullPlaneSet const * planes, bool * visible) {
+    UINT visible_count = 0;
+    __m128 zero = _mm_setzero_ps();
+    __m128 sign_mask = _mm_set1_ps(-0.0f);
+    for (UINT i = 0; i < bounds->count; i += 4) {
+        __m128 cx = _mm_load_ps(bounds->center_x + i);
+        __m128 cy = _mm_load_ps(bounds->center_y + i);
+        __m128 cz = _mm_load_ps(bounds->center_z + i);
+        __m128 ex = _mm_load_ps(bounds->extent_x + i);
+        __m128 ey = _mm_load_ps(bounds->extent_y + i);
+        __m128 ez = _mm_load_ps(bounds->extent_z + i);
+        __m128 inside = _mm_castsi128_ps(_mm_set1_epi32(-1));
+        for (UINT p = 0; p < planes->count; ++p) {
+            __m128 nx = _mm_set1_ps(planes->nx[p]);
+            __m128 ny = _mm_set1_ps(planes->ny[p]);
+            __m128 nz = _mm_set1_ps(planes->nz[p]);
+            __m128 dist = _mm_add_ps(_mm_add_ps(_mm_mul_ps(nx, cx), _mm_mul_ps(ny, cy)), _mm_add_ps(_mm_mul_ps(nz, cz), _mm_set1_ps(planes->d[p])));
+            __m128 radius = _mm_add_ps(_mm_add_ps(
+                _mm_mul_ps(_mm_andnot_ps(sign_mask, nx), ex),
+                _mm_mul_ps(_mm_andnot_ps(sign_mask, ny), ey)),
+                _mm_mul_ps(_mm_andnot_ps(sign_mask, nz), ez));
+            inside = _mm_and_ps(inside, _mm_cmpge_ps(_mm_add_ps(dist, radius), zero));
+        }
+        int mask = _mm_movemask_ps(inside);
+        UINT lanes = bounds->count - i < 4 ? bounds->count - i : 4;
+        for (UINT k = 0; k < lanes; ++k) {
+            visible[i + k] = 0 != (mask & (1 << k));
+            visible_count += visible[i + k];
+        }
+    }
+    return visible_count;
+}